@@ -44,6 +44,16 @@ option(MMO_BUILD_TOOLS "If checked, will try to build tools." OFF)
 # If enabled, unit tests will be built.
 option(MMO_BUILD_TESTS "If checked, will try to test programs." ON)
 
+# If enabled, the benchmark executable and the login_storm load generator will be built. The benchmarks are micro
+# benchmarks for performance critical code paths like the network receive path, login_storm measures the login
+# capacity of a login server. Turned OFF by default as they are only useful for development.
+option(MMO_BUILD_BENCHMARKS "If checked, will try to build benchmarks." OFF)
+
+# Minimum level of log statements which are compiled in (0 = debug, 1 = info, 2 = warning, 3 = error). If empty,
+# debug output is compiled in for debug builds only.
+set(MMO_LOG_MIN_LEVEL "" CACHE STRING "Minimum level of log statements which are compiled in (0 = debug, 1 = info, 2 = warning, 3 = error).")
+mark_as_advanced(MMO_LOG_MIN_LEVEL)
+
 # If enabled, unit tests will be built.
 set(MMO_SRP6_N "894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7" CACHE STRING "Hex representation of a prime number for srp6a calculations.")
 set(MMO_SRP6_g "07" CACHE STRING "Hex representation of a prime number for srp6a calculations.")
@@ -63,6 +73,10 @@ if (MMO_WITH_RELEASE_ASSERTS)
 	add_definitions("-DMMO_ALWAYS_ASSERT")
 endif()
 
+if (NOT MMO_LOG_MIN_LEVEL STREQUAL "")
+	add_definitions("-DMMO_LOG_MIN_LEVEL=${MMO_LOG_MIN_LEVEL}")
+endif()
+
 if (MMO_BUILD_TESTS)
 	enable_testing()
 	add_definitions("-DMMO_BUILD_TESTS=1")
@@ -88,6 +102,12 @@ else()
 	add_definitions("-DMMO_BUILD_TOOLS=0")
 endif()
 
+if (MMO_BUILD_BENCHMARKS)
+	add_definitions("-DMMO_BUILD_BENCHMARKS=1")
+else()
+	add_definitions("-DMMO_BUILD_BENCHMARKS=0")
+endif()
+
 if (MMO_BUILD_CLIENT)
 	add_definitions("-DMMO_BUILD_CLIENT=1")
 else()
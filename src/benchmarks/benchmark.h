@@ -0,0 +1,71 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+namespace mmo
+{
+	namespace mysql
+	{
+		struct DatabaseInfo;
+	}
+
+	namespace benchmarks
+	{
+		/// Gets the total number of heap allocations made by this process so far. Counted by a
+		/// replacement of the global operator new which is only part of the benchmark executable.
+		uint64 GetAllocationCount();
+
+		/// Simple wall clock stop watch used to measure benchmark runs.
+		class Stopwatch final
+		{
+		public:
+			Stopwatch()
+				: m_start(std::chrono::steady_clock::now())
+			{
+			}
+
+		public:
+			/// Gets the number of seconds that elapsed since this stop watch was created.
+			double getElapsedSeconds() const
+			{
+				return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+			}
+
+		private:
+			std::chrono::steady_clock::time_point m_start;
+		};
+
+		/// Prints a single named result line of a benchmark.
+		inline void PrintResult(const std::string &name, double value, const std::string &unit)
+		{
+			std::cout << "  " << std::left << std::setw(40) << name << std::right << std::setw(16)
+				<< std::fixed << std::setprecision(2) << value << " " << unit << "\n";
+		}
+
+		/// Compares the legacy receive path (std::string append / erase) with the ReceiveBuffer.
+		void RunReceiveBufferBenchmark();
+		/// Measures the echo round trips per second of an auth server with 1 to 16 network threads.
+		void RunNetworkScalingBenchmark();
+		/// Compares inserting, cancelling and expiring timers of the timer wheel with a priority queue.
+		void RunTimerWheelBenchmark();
+		/// Measures the cost of reading the different clocks.
+		void RunClockBenchmark();
+		/// Measures log calls per second of concurrent threads with a synchronous and an asynchronous file log,
+		/// and compares the text file format with the binary one.
+		void RunLogBenchmark();
+		/// Measures the server side srp6 handshake math per second on a single core.
+		void RunSrpBenchmark();
+		/// Compares adding, looking up and removing players of a player manager with 100k players using linearly
+		/// scanned lists and using sharded hash indices.
+		void RunPlayerIndexBenchmark();
+		/// Compares the queries per second of the login account lookup with the text protocol and with prepared
+		/// statements against a running MySQL server with a login database. Skipped if no host is given.
+		void RunDatabaseBenchmark(const mysql::DatabaseInfo &connectionInfo);
+	}
+}
@@ -0,0 +1,58 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "base/clock.h"
+
+#include <chrono>
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		namespace
+		{
+			/// Number of clock reads per measurement.
+			static constexpr size_t ReadCount = 10000000;
+
+			/// Receives the accumulated clock values so the reads can not be optimized away.
+			volatile uint64 s_sink = 0;
+
+			template<class ReadFunc>
+			void Measure(const std::string &name, ReadFunc read)
+			{
+				uint64 sum = 0;
+
+				const Stopwatch watch;
+				for (size_t i = 0; i < ReadCount; ++i)
+				{
+					sum += read();
+				}
+				const double seconds = watch.getElapsedSeconds();
+				s_sink = sum;
+
+				PrintResult(name, seconds * 1000000000.0 / static_cast<double>(ReadCount), "ns per read");
+			}
+		}
+
+		void RunClockBenchmark()
+		{
+			Measure("std::chrono::steady_clock", []() { return static_cast<uint64>(std::chrono::steady_clock::now().time_since_epoch().count()); });
+			Measure("GetAsyncTimeMs", []() { return static_cast<uint64>(GetAsyncTimeMs()); });
+			Measure("GetMonotonicTimeNs (system clock)", []() { return GetMonotonicTimeNs(); });
+
+			if (EnableTscClock())
+			{
+				Measure("GetMonotonicTimeNs (tsc)", []() { return GetMonotonicTimeNs(); });
+				DisableTscClock();
+			}
+			else
+			{
+				std::cout << "  No invariant time stamp counter available\n";
+			}
+
+			UpdateTickTime();
+			Measure("GetTickTimeNs", []() { return GetTickTimeNs(); });
+		}
+	}
+}
@@ -0,0 +1,110 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "mysql_wrapper/mysql_connection.h"
+#include "mysql_wrapper/mysql_row.h"
+#include "mysql_wrapper/mysql_select.h"
+#include "mysql_wrapper/mysql_statement.h"
+#include "mysql_wrapper/mysql_statement_cache.h"
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		namespace
+		{
+			/// Number of queries per measurement.
+			static constexpr size_t QueryCount = 10000;
+
+			/// The account lookup of a login, which is the hottest query of the login server.
+			static const String AccountQuery = "SELECT id,username,s,v FROM account WHERE username=? LIMIT 1";
+
+			/// Account lookup like the login server did it before: The query is built by string concatenation,
+			/// parsed by the server every time and the result is transferred and parsed as text.
+			void RunTextQuery(mysql::Connection &connection, const String &name)
+			{
+				mysql::Select select(connection, "SELECT id,username,s,v FROM account WHERE username='" + connection.EscapeString(name) + "' LIMIT 1");
+				mysql::Row row(select);
+				if (row)
+				{
+					uint64 id = 0;
+					String userName, s, v;
+					row.GetField(0, id);
+					row.GetField(1, userName);
+					row.GetField(2, s);
+					row.GetField(3, v);
+				}
+			}
+
+			/// Account lookup with the binary protocol, using a prepared statement.
+			void RunStatement(mysql::Statement &statement, const String &name)
+			{
+				statement.SetParameter(0, mysql::ConstStringPtr{ &name });
+
+				mysql::StatementResult result = statement.ExecuteSelect();
+				if (result.FetchResultRow())
+				{
+					result.GetInt(0);
+					result.GetString(1);
+					result.GetString(2);
+					result.GetString(3);
+				}
+			}
+
+			template<class Func>
+			void Measure(const std::string &name, Func func)
+			{
+				const Stopwatch watch;
+				for (size_t i = 0; i < QueryCount; ++i)
+				{
+					func();
+				}
+
+				PrintResult(name, static_cast<double>(QueryCount) / watch.getElapsedSeconds(), "queries/s");
+			}
+		}
+
+		void RunDatabaseBenchmark(const mysql::DatabaseInfo &connectionInfo)
+		{
+			if (connectionInfo.host.empty())
+			{
+				std::cout << "  skipped, no MySQL server given (see --db-host)\n";
+				return;
+			}
+
+			mysql::Connection connection;
+			if (!connection.Connect(connectionInfo))
+			{
+				std::cout << "  could not connect to MySQL: " << connection.GetErrorMessage() << "\n";
+				return;
+			}
+
+			// Look up an existing account so that every query returns a row
+			String accountName;
+			{
+				mysql::Select select(connection, "SELECT username FROM account LIMIT 1");
+				mysql::Row row(select);
+				if (!row || !row.GetField(0, accountName))
+				{
+					std::cout << "  skipped, the account table of the login database is empty\n";
+					return;
+				}
+			}
+
+			Measure("account lookup (text protocol)", [&]() { RunTextQuery(connection, accountName); });
+			Measure("account lookup (prepare per query)", [&]()
+			{
+				mysql::Statement statement{ connection, AccountQuery };
+				RunStatement(statement, accountName);
+			});
+
+			mysql::StatementCache statements{ connection, { AccountQuery } };
+			statements.Prepare();
+			Measure("account lookup (cached statement)", [&]()
+			{
+				statements.Execute(0, [&accountName](mysql::Statement &statement) { RunStatement(statement, accountName); });
+			});
+		}
+	}
+}
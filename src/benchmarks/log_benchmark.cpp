@@ -0,0 +1,186 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "log/async_log_sink.h"
+#include "log/default_log_levels.h"
+#include "log/log_binary_stream.h"
+#include "log/log_std_stream.h"
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		namespace
+		{
+			/// Number of log statements executed by each thread.
+			static constexpr size_t CallsPerThread = 50000;
+
+			/// Number of entries written by the file format comparison.
+			static constexpr size_t FileEntries = 500000;
+
+			/// Runs CallsPerThread log statements on each of threadCount threads and prints the total calls per second.
+			void RunLogThreads(const std::string &name, size_t threadCount)
+			{
+				const Stopwatch watch;
+
+				std::vector<std::thread> threads;
+				for (size_t thread = 0; thread < threadCount; ++thread)
+				{
+					threads.emplace_back([thread]()
+					{
+						for (size_t i = 0; i < CallsPerThread; ++i)
+						{
+							ILOG("Player " << i << " on thread " << thread << " entered world");
+						}
+					});
+				}
+
+				for (auto &thread : threads)
+				{
+					thread.join();
+				}
+
+				PrintResult(name + " " + std::to_string(threadCount) + " threads", static_cast<double>(CallsPerThread * threadCount) / watch.getElapsedSeconds() / 1000000.0, "M calls/s");
+			}
+
+			/// Compares the writer thread costs of the text file format with the binary one.
+			void RunLogFileFormats(const std::filesystem::path &fileName)
+			{
+				std::vector<LogEntry> textEntries, structuredEntries;
+				textEntries.reserve(FileEntries);
+				structuredEntries.reserve(FileEntries);
+				const LogTime now = std::chrono::system_clock::now();
+				for (size_t i = 0; i < FileEntries; ++i)
+				{
+					std::ostringstream formatter;
+					formatter << "Player " << i << " on thread " << (i % 8) << " entered world";
+					textEntries.emplace_back(InfoLevel, formatter.str(), now);
+					structuredEntries.push_back(makeLogEntry(InfoLevel, now, "Player {} on thread {} entered world", i, i % 8));
+				}
+
+				{
+					std::ofstream file{ fileName.string(), std::ios::trunc };
+					const Stopwatch watch;
+					for (const auto &entry : textEntries)
+					{
+						printLogEntry(file, entry, g_DefaultFileLogOptions);
+					}
+					file.flush();
+					PrintResult("file text", static_cast<double>(FileEntries) / watch.getElapsedSeconds() / 1000000.0, "M entries/s");
+					PrintResult("file text size", static_cast<double>(file.tellp()) / static_cast<double>(FileEntries), "bytes/entry");
+				}
+
+				for (const auto *entries : { &textEntries, &structuredEntries })
+				{
+					const String name = entries == &textEntries ? "file binary (text entries)" : "file binary (structured)";
+
+					std::ofstream file{ fileName.string(), std::ios::trunc | std::ios::binary };
+					BinaryLogWriter writer{ file };
+					const Stopwatch watch;
+					for (const auto &entry : *entries)
+					{
+						writer.write(entry);
+					}
+					file.flush();
+					PrintResult(name, static_cast<double>(FileEntries) / watch.getElapsedSeconds() / 1000000.0, "M entries/s");
+					PrintResult(name + " size", static_cast<double>(file.tellp()) / static_cast<double>(FileEntries), "bytes/entry");
+				}
+
+				// Producer side: Formatting text versus encoding the arguments
+				{
+					const Stopwatch watch;
+					size_t size = 0;
+					for (size_t i = 0; i < FileEntries; ++i)
+					{
+						std::ostringstream formatter;
+						formatter << "Player " << i << " on thread " << (i % 8) << " entered world";
+						size += formatter.str().size();
+					}
+					PrintResult("produce text", static_cast<double>(FileEntries) / watch.getElapsedSeconds() / 1000000.0, "M entries/s");
+				}
+				{
+					const Stopwatch watch;
+					size_t size = 0;
+					for (size_t i = 0; i < FileEntries; ++i)
+					{
+						size += encodeLogArguments(i, i % 8).size();
+					}
+					PrintResult("produce structured", static_cast<double>(FileEntries) / watch.getElapsedSeconds() / 1000000.0, "M entries/s");
+				}
+			}
+		}
+
+		void RunLogBenchmark()
+		{
+			const std::filesystem::path fileName = std::filesystem::temp_directory_path() / "mmo_log_benchmark.log";
+			const size_t threadCounts[] = { 1, 2, 4, 8 };
+
+			// Synchronous file log as used by the servers before: A mutex and a flush per entry
+			{
+				std::ofstream file{ fileName.string(), std::ios::trunc };
+				std::mutex fileMutex;
+				scoped_connection connection{ g_DefaultLog.signal().connect([&](const LogEntry &entry)
+				{
+					std::scoped_lock lock{ fileMutex };
+					printLogEntry(file, entry, g_DefaultFileLogOptions);
+					file.flush();
+				}) };
+
+				for (const size_t threadCount : threadCounts)
+				{
+					RunLogThreads("sync", threadCount);
+				}
+			}
+
+			// Asynchronous file log: Producers only queue the entry, the writer flushes once per batch
+			{
+				std::ofstream file{ fileName.string(), std::ios::trunc };
+				AsyncLogSink sink{
+					[&file](const LogEntry &entry) { printLogEntry(file, entry, g_DefaultFileLogOptions); },
+					[&file]() { file.flush(); }
+				};
+				scoped_connection connection{ g_DefaultLog.signal().connect([&sink](const LogEntry &entry) { sink.push(entry); }) };
+
+				for (const size_t threadCount : threadCounts)
+				{
+					RunLogThreads("async", threadCount);
+				}
+
+				const Stopwatch drainWatch;
+				sink.flush();
+				PrintResult("async drain after last call", drainWatch.getElapsedSeconds() * 1000.0, "ms");
+
+				const AsyncLogSinkStats stats = sink.getStats();
+				PrintResult("async entries per batch", static_cast<double>(stats.writtenEntries) / static_cast<double>(stats.batches), "");
+				PrintResult("async producer stalls", static_cast<double>(stats.producerStalls), "");
+			}
+
+			// Statements below the compile time minimum level
+			{
+				size_t received = 0;
+				scoped_connection connection{ g_DefaultLog.signal().connect([&received](const LogEntry &) { ++received; }) };
+
+				const Stopwatch watch;
+				for (size_t i = 0; i < CallsPerThread * 100; ++i)
+				{
+					DLOG("Player " << i << " moved");
+				}
+				PrintResult("DLOG", watch.getElapsedSeconds() * 1000000000.0 / static_cast<double>(CallsPerThread * 100), "ns/call");
+				PrintResult("DLOG compiled in", received > 0 ? 1.0 : 0.0, "");
+			}
+
+			RunLogFileFormats(fileName);
+
+			std::error_code error;
+			std::filesystem::remove(fileName, error);
+		}
+	}
+}
@@ -0,0 +1,131 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "base/constants.h"
+#include "mysql_wrapper/mysql_connection.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <new>
+
+#include "cxxopts/cxxopts.hpp"
+
+
+using namespace mmo;
+
+
+namespace
+{
+	/// Number of heap allocations made by this process.
+	std::atomic<uint64> s_allocationCount { 0 };
+}
+
+void *operator new(std::size_t size)
+{
+	s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void *const ptr = std::malloc(size ? size : 1))
+	{
+		return ptr;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		uint64 GetAllocationCount()
+		{
+			return s_allocationCount.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+/// Procedural entry point of the application.
+int main(int argc, char **argv)
+{
+	// Login database used by the database benchmark
+	mysql::DatabaseInfo databaseInfo{ "", constants::DefaultMySQLPort, "mmo", "", "mmo_login" };
+
+	// Available benchmarks by name
+	const std::map<std::string, std::function<void()>> benchmarkFuncs = {
+		{ "receive_buffer", benchmarks::RunReceiveBufferBenchmark },
+		{ "network_scaling", benchmarks::RunNetworkScalingBenchmark },
+		{ "timer_wheel", benchmarks::RunTimerWheelBenchmark },
+		{ "clock", benchmarks::RunClockBenchmark },
+		{ "log", benchmarks::RunLogBenchmark },
+		{ "srp", benchmarks::RunSrpBenchmark },
+		{ "player_index", benchmarks::RunPlayerIndexBenchmark },
+		{ "database", [&databaseInfo]() { benchmarks::RunDatabaseBenchmark(databaseInfo); } },
+	};
+
+	std::string benchmarkName;
+
+	// Prepare available command line options
+	cxxopts::Options options("Benchmarks, available options");
+	options.add_options()
+		("help", "produce help message")
+		("r,run", "name of the benchmark to run (runs all if not set)", cxxopts::value<std::string>(benchmarkName))
+		("l,list", "list all available benchmarks")
+		("db-host", "mysql host of a login database for the database benchmark, which is skipped if empty", cxxopts::value<std::string>(databaseInfo.host))
+		("db-port", "mysql port of the login database", cxxopts::value<uint16>(databaseInfo.port))
+		("db-user", "mysql user of the login database", cxxopts::value<std::string>(databaseInfo.user))
+		("db-password", "mysql password of the login database", cxxopts::value<std::string>(databaseInfo.password))
+		("db-name", "name of the login database", cxxopts::value<std::string>(databaseInfo.database))
+		;
+
+	try
+	{
+		// Parse command line arguments
+		cxxopts::ParseResult result = options.parse(argc, argv);
+
+		// Check for help output
+		if (result.count("help"))
+		{
+			std::cerr << options.help() << "\n";
+			return 0;
+		}
+
+		if (result.count("list"))
+		{
+			for (const auto &pair : benchmarkFuncs)
+			{
+				std::cout << pair.first << "\n";
+			}
+			return 0;
+		}
+	}
+	catch (const cxxopts::OptionException &e)
+	{
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+
+	for (const auto &pair : benchmarkFuncs)
+	{
+		if (!benchmarkName.empty() && benchmarkName != pair.first)
+		{
+			continue;
+		}
+
+		std::cout << pair.first << "\n";
+		pair.second();
+		std::cout << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,170 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "network/io_service_pool.h"
+#include "auth_protocol/auth_protocol.h"
+#include "auth_protocol/auth_server.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		namespace
+		{
+			/// Port used by the benchmark server.
+			static constexpr uint16 BenchmarkPort = 45917;
+			/// Number of concurrent client connections.
+			static constexpr size_t ClientCount = 256;
+			/// Number of client network threads.
+			static constexpr size_t ClientThreads = 4;
+			/// Time in milliseconds each thread count is measured.
+			static constexpr int32 MeasureTimeMs = 2000;
+
+			/// Server side session which echoes every packet back to the client.
+			class EchoSession final : public auth::IConnectionListener
+			{
+			public:
+				explicit EchoSession(std::shared_ptr<auth::Connection> connection)
+					: m_connection(std::move(connection))
+				{
+					m_connection->setListener(*this);
+				}
+
+			private:
+				void connectionLost() override { }
+				void connectionMalformedPacket() override { }
+				PacketParseResult connectionPacketReceived(auth::IncomingPacket &packet) override
+				{
+					uint32 value = 0;
+					packet >> io::read<uint32>(value);
+
+					m_connection->sendSinglePacket([value](auth::OutgoingPacket &outPacket) {
+						outPacket.Start(auth::login_client_packet::RealmList);
+						outPacket << io::write<uint32>(value);
+						outPacket.Finish();
+					});
+
+					return PacketParseResult::Pass;
+				}
+
+			private:
+				std::shared_ptr<auth::Connection> m_connection;
+			};
+
+			/// Client side session which sends a new request as soon as the last one was answered.
+			class PingSession final : public auth::IConnectionListener
+			{
+			public:
+				explicit PingSession(std::shared_ptr<auth::Connection> connection, std::atomic<uint64> &roundTrips, const std::atomic<bool> &stop)
+					: m_connection(std::move(connection))
+					, m_roundTrips(roundTrips)
+					, m_stop(stop)
+				{
+					m_connection->setListener(*this);
+				}
+
+				void sendPing()
+				{
+					m_connection->sendSinglePacket([](auth::OutgoingPacket &packet) {
+						packet.Start(auth::client_login_packet::RealmList);
+						packet << io::write<uint32>(0);
+						packet.Finish();
+					});
+				}
+
+			private:
+				void connectionLost() override { }
+				void connectionMalformedPacket() override { }
+				PacketParseResult connectionPacketReceived(auth::IncomingPacket &) override
+				{
+					m_roundTrips.fetch_add(1, std::memory_order_relaxed);
+					if (!m_stop)
+					{
+						sendPing();
+					}
+
+					return PacketParseResult::Pass;
+				}
+
+			private:
+				std::shared_ptr<auth::Connection> m_connection;
+				std::atomic<uint64> &m_roundTrips;
+				const std::atomic<bool> &m_stop;
+			};
+
+			/// Measures the number of round trips per second the server handles with the given number of threads.
+			double MeasureRoundTrips(size_t serverThreads)
+			{
+				IoServicePool serverServices{ serverThreads };
+				IoServicePool clientServices{ ClientThreads };
+
+				std::vector<std::unique_ptr<EchoSession>> serverSessions;
+				std::vector<std::unique_ptr<PingSession>> clientSessions;
+				std::mutex sessionMutex;
+
+				auth::Server server{ serverServices.getServices(), BenchmarkPort, std::bind(&auth::Connection::create, std::placeholders::_1, nullptr), 1024 };
+				const scoped_connection connected{ server.connected().connect([&](const std::shared_ptr<auth::Connection> &connection) {
+					{
+						std::scoped_lock lock{ sessionMutex };
+						serverSessions.emplace_back(std::make_unique<EchoSession>(connection));
+					}
+					connection->startReceiving();
+				}) };
+				server.startAccept();
+				serverServices.run();
+
+				std::atomic<uint64> roundTrips{ 0 };
+				std::atomic<bool> stop{ false };
+
+				const asio::ip::tcp::endpoint endpoint{ asio::ip::address_v4::loopback(), BenchmarkPort };
+				for (size_t i = 0; i < ClientCount; ++i)
+				{
+					auto connection = auth::Connection::create(clientServices.getService(i % ClientThreads), nullptr);
+					connection->getSocket().connect(endpoint);
+
+					clientSessions.emplace_back(std::make_unique<PingSession>(connection, roundTrips, stop));
+					connection->startReceiving();
+				}
+
+				clientServices.run();
+				for (auto &session : clientSessions)
+				{
+					session->sendPing();
+				}
+
+				// Skip the ramp up phase, then measure
+				std::this_thread::sleep_for(std::chrono::milliseconds(MeasureTimeMs / 4));
+				const uint64 startCount = roundTrips.load();
+				const Stopwatch watch;
+				std::this_thread::sleep_for(std::chrono::milliseconds(MeasureTimeMs));
+				const uint64 count = roundTrips.load() - startCount;
+				const double seconds = watch.getElapsedSeconds();
+
+				stop = true;
+				clientServices.stop();
+				clientServices.join();
+				serverServices.stop();
+				serverServices.join();
+
+				return static_cast<double>(count) / seconds;
+			}
+		}
+
+		void RunNetworkScalingBenchmark()
+		{
+			std::cout << "  " << ClientCount << " clients, " << std::thread::hardware_concurrency() << " hardware threads\n";
+
+			for (size_t threads = 1; threads <= 16; threads *= 2)
+			{
+				PrintResult(std::to_string(threads) + " server threads", MeasureRoundTrips(threads), "round trips/s");
+			}
+		}
+	}
+}
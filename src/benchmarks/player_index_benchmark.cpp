@@ -0,0 +1,201 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "base/sharded_map.h"
+
+#include <algorithm>
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		namespace
+		{
+			/// Number of simulated connected players.
+			static constexpr size_t PlayerCount = 100000;
+			/// Number of lookups by account name and id per run.
+			static constexpr size_t LookupCount = 2000;
+			/// Number of disconnects per run.
+			static constexpr size_t DisconnectCount = 10000;
+			/// Number of shards, like the player managers use.
+			static constexpr size_t ShardCount = 16;
+
+			/// Stands in for a player connection with the data the player managers look up.
+			struct SimulatedPlayer
+			{
+				uint64 accountId;
+				String accountName;
+			};
+
+			typedef std::vector<std::shared_ptr<SimulatedPlayer>> SimulatedPlayers;
+
+			/// Player manager as it was before the hash indices: Lists which are scanned linearly.
+			class ListPlayerManager final
+			{
+			public:
+				void add(std::shared_ptr<SimulatedPlayer> player)
+				{
+					Shard &shard = getShard(*player);
+					std::scoped_lock lock{ shard.mutex };
+					shard.players.push_back(std::move(player));
+				}
+
+				void remove(const SimulatedPlayer &player)
+				{
+					Shard &shard = getShard(player);
+					std::scoped_lock lock{ shard.mutex };
+					shard.players.erase(std::find_if(shard.players.begin(), shard.players.end(),
+						[&player](const std::shared_ptr<SimulatedPlayer> &p) { return p.get() == &player; }));
+				}
+
+				template<class Functor>
+				SimulatedPlayer *find(Functor predicate)
+				{
+					for (auto &shard : m_shards)
+					{
+						std::scoped_lock lock{ shard.mutex };
+						for (const auto &p : shard.players)
+						{
+							if (predicate(*p))
+							{
+								return p.get();
+							}
+						}
+					}
+
+					return nullptr;
+				}
+
+			private:
+				struct Shard
+				{
+					std::list<std::shared_ptr<SimulatedPlayer>> players;
+					std::mutex mutex;
+				};
+
+				Shard &getShard(const SimulatedPlayer &player)
+				{
+					return m_shards[PointerHash()(&player) % ShardCount];
+				}
+
+				std::array<Shard, ShardCount> m_shards;
+			};
+
+			/// Player manager with hash indices by connection, account name and account id.
+			class IndexedPlayerManager final
+			{
+			public:
+				void add(std::shared_ptr<SimulatedPlayer> player)
+				{
+					SimulatedPlayer &p = *player;
+					m_players.set(&p, std::move(player));
+					m_playersByAccountName.set(p.accountName, &p);
+					m_playersByAccountId.set(p.accountId, &p);
+				}
+
+				void remove(SimulatedPlayer &player)
+				{
+					m_playersByAccountName.erase(player.accountName, &player);
+					m_playersByAccountId.erase(player.accountId, &player);
+					m_players.erase(&player);
+				}
+
+				SimulatedPlayer *findByName(const String &accountName) const
+				{
+					return m_playersByAccountName.get(accountName).value_or(nullptr);
+				}
+
+				SimulatedPlayer *findById(uint64 accountId) const
+				{
+					return m_playersByAccountId.get(accountId).value_or(nullptr);
+				}
+
+			private:
+				ShardedMap<const SimulatedPlayer*, std::shared_ptr<SimulatedPlayer>, PointerHash, ShardCount> m_players;
+				ShardedMap<String, SimulatedPlayer*, std::hash<String>, ShardCount> m_playersByAccountName;
+				ShardedMap<uint64, SimulatedPlayer*, std::hash<uint64>, ShardCount> m_playersByAccountId;
+			};
+
+			/// Prints the operations per second of a part of a run.
+			void PrintRate(const std::string &name, size_t operations, const Stopwatch &watch)
+			{
+				PrintResult(name, static_cast<double>(operations) / watch.getElapsedSeconds(), "ops/s");
+			}
+
+			template<class Manager, class FindByName, class FindById>
+			void Run(const std::string &name, const SimulatedPlayers &players, const std::vector<size_t> &lookups,
+				FindByName findByName, FindById findById)
+			{
+				Manager manager;
+
+				const Stopwatch addWatch;
+				for (const auto &player : players)
+				{
+					manager.add(player);
+				}
+				PrintRate(name + " add", players.size(), addWatch);
+
+				size_t found = 0;
+				const Stopwatch nameWatch;
+				for (const size_t index : lookups)
+				{
+					found += (findByName(manager, players[index]->accountName) != nullptr);
+				}
+				PrintRate(name + " lookup by account name", lookups.size(), nameWatch);
+
+				const Stopwatch idWatch;
+				for (const size_t index : lookups)
+				{
+					found += (findById(manager, players[index]->accountId) != nullptr);
+				}
+				PrintRate(name + " lookup by account id", lookups.size(), idWatch);
+
+				if (found != lookups.size() * 2)
+				{
+					std::cout << "  " << name << " missed " << (lookups.size() * 2 - found) << " lookups\n";
+				}
+
+				const Stopwatch removeWatch;
+				for (size_t i = 0; i < DisconnectCount; ++i)
+				{
+					manager.remove(*players[i * (players.size() / DisconnectCount)]);
+				}
+				PrintRate(name + " disconnect", DisconnectCount, removeWatch);
+			}
+		}
+
+		void RunPlayerIndexBenchmark()
+		{
+			SimulatedPlayers players;
+			players.reserve(PlayerCount);
+			for (size_t i = 0; i < PlayerCount; ++i)
+			{
+				players.push_back(std::make_shared<SimulatedPlayer>(SimulatedPlayer{ i + 1, "ACCOUNT" + std::to_string(i + 1) }));
+			}
+
+			std::mt19937 random{ 42 };
+			std::uniform_int_distribution<size_t> indexDistribution{ 0, PlayerCount - 1 };
+			std::vector<size_t> lookups(LookupCount);
+			for (auto &index : lookups)
+			{
+				index = indexDistribution(random);
+			}
+
+			Run<ListPlayerManager>("list", players, lookups,
+				[](ListPlayerManager &manager, const String &accountName) { return manager.find([&accountName](const SimulatedPlayer &p) { return p.accountName == accountName; }); },
+				[](ListPlayerManager &manager, uint64 accountId) { return manager.find([accountId](const SimulatedPlayer &p) { return p.accountId == accountId; }); });
+
+			Run<IndexedPlayerManager>("sharded_map", players, lookups,
+				[](IndexedPlayerManager &manager, const String &accountName) { return manager.findByName(accountName); },
+				[](IndexedPlayerManager &manager, uint64 accountId) { return manager.findById(accountId); });
+		}
+	}
+}
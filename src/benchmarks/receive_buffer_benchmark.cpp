@@ -0,0 +1,163 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "network/buffer.h"
+#include "network/receive_buffer.h"
+#include "auth_protocol/auth_protocol.h"
+#include "binary_io/vector_sink.h"
+#include "binary_io/writer.h"
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		namespace
+		{
+			/// Number of times the whole packet stream is delivered per run.
+			static constexpr size_t StreamRepetitions = 200;
+
+			/// Builds a stream of auth packets of varying size to simulate incoming traffic.
+			std::vector<char> BuildPacketStream(size_t &out_packetCount)
+			{
+				std::vector<char> stream;
+				io::VectorSink sink{ stream };
+
+				out_packetCount = 0;
+				for (uint32 i = 0; i < 4096; ++i)
+				{
+					auth::OutgoingPacket packet{ sink };
+					packet.Start(auth::client_login_packet::RealmList);
+					packet << io::write<uint32>(i);
+
+					// Mix small packets with some larger ones
+					const size_t payloadSize = (i % 16 == 0) ? 1024 : (i % 64);
+					for (size_t j = 0; j < payloadSize; ++j)
+					{
+						packet << io::write<uint8>(static_cast<uint8>(j));
+					}
+
+					packet.Finish();
+					++out_packetCount;
+				}
+
+				return stream;
+			}
+
+			/// Parses all complete packets at the given position and returns the number of parsed bytes.
+			size_t ParsePackets(const char *data, size_t size, size_t &out_packetCount)
+			{
+				size_t parsedUntil = 0;
+				for (;;)
+				{
+					io::MemorySource source{ data + parsedUntil, data + size };
+
+					auth::IncomingPacket packet;
+					if (auth::IncomingPacket::Start(packet, source) != receive_state::Complete)
+					{
+						break;
+					}
+
+					++out_packetCount;
+					parsedUntil += source.getRead();
+				}
+
+				return parsedUntil;
+			}
+
+			/// Receive path as it was before the ReceiveBuffer: The socket reads into a fixed size
+			/// array which is then appended to a string, and parsed packets are erased from its front.
+			template<class ReadSizeFunc>
+			size_t RunLegacy(const std::vector<char> &stream, ReadSizeFunc readSize)
+			{
+				std::array<char, 4096> receiving;
+				size_t packetCount = 0;
+
+				for (size_t r = 0; r < StreamRepetitions; ++r)
+				{
+					Buffer received;
+
+					size_t offset = 0;
+					while (offset < stream.size())
+					{
+						const size_t size = std::min({ readSize(), receiving.size(), stream.size() - offset });
+						std::memcpy(receiving.data(), stream.data() + offset, size);
+						offset += size;
+
+						received.append(receiving.begin(), receiving.begin() + size);
+
+						const size_t parsedUntil = ParsePackets(&received[0], received.size(), packetCount);
+						received.erase(received.begin(), received.begin() + static_cast<std::ptrdiff_t>(parsedUntil));
+					}
+				}
+
+				return packetCount;
+			}
+
+			/// Receive path using the ReceiveBuffer, which is read into directly and consumed in place.
+			template<class ReadSizeFunc>
+			size_t RunReceiveBuffer(const std::vector<char> &stream, ReadSizeFunc readSize)
+			{
+				size_t packetCount = 0;
+
+				for (size_t r = 0; r < StreamRepetitions; ++r)
+				{
+					ReceiveBuffer received;
+
+					size_t offset = 0;
+					while (offset < stream.size())
+					{
+						char *const dest = received.prepare();
+						const size_t size = std::min({ readSize(), received.getWritableSize(), stream.size() - offset });
+						std::memcpy(dest, stream.data() + offset, size);
+						offset += size;
+
+						received.commit(size);
+
+						const size_t parsedUntil = ParsePackets(received.data(), received.size(), packetCount);
+						received.consume(parsedUntil);
+					}
+				}
+
+				return packetCount;
+			}
+
+			template<class RunFunc>
+			void Measure(const std::string &name, size_t streamSize, RunFunc run)
+			{
+				const uint64 allocationsBefore = GetAllocationCount();
+				const Stopwatch watch;
+
+				const size_t packetCount = run();
+
+				const double seconds = watch.getElapsedSeconds();
+				const uint64 allocations = GetAllocationCount() - allocationsBefore;
+
+				PrintResult(name + " throughput", static_cast<double>(streamSize * StreamRepetitions) / seconds / (1024.0 * 1024.0), "MB/s");
+				PrintResult(name + " allocations", static_cast<double>(allocations) * 1000.0 / static_cast<double>(packetCount), "per 1k packets");
+			}
+		}
+
+		void RunReceiveBufferBenchmark()
+		{
+			size_t packetCount = 0;
+			const std::vector<char> stream = BuildPacketStream(packetCount);
+
+			// Small reads like they happen during normal gameplay traffic
+			size_t counter = 0;
+			const auto smallReads = [&counter]() -> size_t { return 64 + (++counter % 7) * 97; };
+			Measure("legacy (small reads)", stream.size(), [&]() { return RunLegacy(stream, smallReads); });
+			Measure("receive_buffer (small reads)", stream.size(), [&]() { return RunReceiveBuffer(stream, smallReads); });
+
+			// Bulk traffic which always fills the whole read request
+			const auto bulkReads = []() -> size_t { return std::numeric_limits<size_t>::max(); };
+			Measure("legacy (bulk reads)", stream.size(), [&]() { return RunLegacy(stream, bulkReads); });
+			Measure("receive_buffer (bulk reads)", stream.size(), [&]() { return RunReceiveBuffer(stream, bulkReads); });
+		}
+	}
+}
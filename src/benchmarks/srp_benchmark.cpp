@@ -0,0 +1,141 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "base/big_number.h"
+#include "base/constants.h"
+#include "base/srp6.h"
+
+#include <openssl/bn.h>
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		namespace
+		{
+			/// Number of handshakes per measurement.
+			static constexpr size_t HandshakeCount = 2000;
+
+			/// Server side math of a handshake as BigNumber did it before: A fresh BN_CTX for every
+			/// operation and generic exponentiations which set up the montgomery context of N every time.
+			struct LegacyHandshake
+			{
+				BIGNUM *N = BN_new();
+				BIGNUM *g = BN_new();
+				BIGNUM *v = BN_new();
+				BIGNUM *A = BN_new();
+
+				LegacyHandshake(const BigNumber &v_, const BigNumber &A_)
+				{
+					BN_hex2bn(&N, constants::srp::N.asHexStr().c_str());
+					BN_hex2bn(&g, constants::srp::g.asHexStr().c_str());
+					BN_hex2bn(&v, v_.asHexStr().c_str());
+					BN_hex2bn(&A, A_.asHexStr().c_str());
+				}
+
+				~LegacyHandshake()
+				{
+					BN_free(N);
+					BN_free(g);
+					BN_free(v);
+					BN_free(A);
+				}
+
+				void run()
+				{
+					BIGNUM *b = BN_new(), *u = BN_new(), *gmod = BN_new(), *B = BN_new(), *vu = BN_new(), *S = BN_new();
+					BN_rand(b, 19 * 8, 0, 1);
+					BN_rand(u, 20 * 8, 0, 1);
+
+					// Challenge: B = (3v + g^b) % N
+					BN_CTX *ctx = BN_CTX_new();
+					BN_mod_exp(gmod, g, b, N, ctx);
+					BN_CTX_free(ctx);
+
+					ctx = BN_CTX_new();
+					BN_mul(B, v, BN_value_one(), ctx);
+					BN_CTX_free(ctx);
+					BN_mul_word(B, 3);
+					BN_add(B, B, gmod);
+
+					ctx = BN_CTX_new();
+					BN_mod(B, B, N, ctx);
+					BN_CTX_free(ctx);
+
+					// Proof: S = (A * v^u)^b % N
+					ctx = BN_CTX_new();
+					BN_mod_exp(vu, v, u, N, ctx);
+					BN_CTX_free(ctx);
+
+					ctx = BN_CTX_new();
+					BN_mul(vu, A, vu, ctx);
+					BN_CTX_free(ctx);
+
+					ctx = BN_CTX_new();
+					BN_mod_exp(S, vu, b, N, ctx);
+					BN_CTX_free(ctx);
+
+					BN_free(b);
+					BN_free(u);
+					BN_free(gmod);
+					BN_free(B);
+					BN_free(vu);
+					BN_free(S);
+				}
+			};
+
+			/// Server side math of a handshake as the login server does it now.
+			void RunHandshake(const BigNumber &v, const BigNumber &A)
+			{
+				BigNumber b, u;
+				b.setRand(19 * 8);
+				u.setRand(20 * 8);
+
+				// Challenge
+				const BigNumber gmod = srp6::ModExpG(b);
+				const BigNumber B = ((v * 3) + gmod) % constants::srp::N;
+
+				// Proof
+				const BigNumber S = srp6::ModExpN(A * srp6::ModExpN(v, u), b);
+			}
+
+			template<class Func>
+			void Measure(const std::string &name, Func func)
+			{
+				const Stopwatch watch;
+				for (size_t i = 0; i < HandshakeCount; ++i)
+				{
+					func();
+				}
+
+				PrintResult(name, static_cast<double>(HandshakeCount) / watch.getElapsedSeconds(), "per second");
+			}
+		}
+
+		void RunSrpBenchmark()
+		{
+			// A verifier and a client public value like they are used during a real login
+			BigNumber x, a;
+			x.setRand(20 * 8);
+			a.setRand(19 * 8);
+			const BigNumber v = constants::srp::g.modExp(x, constants::srp::N);
+			const BigNumber A = constants::srp::g.modExp(a, constants::srp::N);
+
+			// Create the cached contexts up front
+			srp6::ModExpG(x);
+
+			BigNumber exponent;
+			exponent.setRand(19 * 8);
+
+			Measure("g^b generic", [&]() { constants::srp::g.modExp(exponent, constants::srp::N); });
+			Measure("g^b fixed base", [&]() { srp6::ModExpG(exponent); });
+			Measure("v^u generic", [&]() { v.modExp(exponent, constants::srp::N); });
+			Measure("v^u cached montgomery", [&]() { srp6::ModExpN(v, exponent); });
+
+			LegacyHandshake legacy{ v, A };
+			Measure("server handshakes (legacy)", [&]() { legacy.run(); });
+			Measure("server handshakes", [&]() { RunHandshake(v, A); });
+		}
+	}
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "benchmark.h"
+
+#include "base/timer_wheel.h"
+
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace mmo
+{
+	namespace benchmarks
+	{
+		namespace
+		{
+			/// Number of timers scheduled per run.
+			static constexpr size_t TimerCount = 500000;
+			/// Maximum timer delay in ticks (milliseconds).
+			static constexpr uint64 MaxDelay = 60000;
+			/// Number of ticks the simulated io loop advances per wake up.
+			static constexpr uint64 TickStep = 16;
+
+			/// Timer queue as it was before the timer wheel: A priority queue without cancellation.
+			void RunPriorityQueue(const std::vector<uint64> &expiries)
+			{
+				struct Entry
+				{
+					uint64 time;
+					std::function<void()> callback;
+				};
+				const auto isLater = [](const Entry &left, const Entry &right) { return left.time > right.time; };
+				std::priority_queue<Entry, std::vector<Entry>, decltype(isLater)> queue{ isLater };
+
+				size_t expired = 0;
+
+				const Stopwatch insertWatch;
+				for (const uint64 expiry : expiries)
+				{
+					queue.push(Entry{ expiry, [&expired]() { ++expired; } });
+				}
+				PrintResult("priority_queue insert", static_cast<double>(expiries.size()) / insertWatch.getElapsedSeconds() / 1000000.0, "M/s");
+
+				const Stopwatch expireWatch;
+				for (uint64 now = 0; !queue.empty(); now += TickStep)
+				{
+					while (!queue.empty() && queue.top().time <= now)
+					{
+						const auto callback = queue.top().callback;
+						queue.pop();
+						callback();
+					}
+				}
+				PrintResult("priority_queue expire", static_cast<double>(expired) / expireWatch.getElapsedSeconds() / 1000000.0, "M/s");
+			}
+
+			void RunTimerWheel(const std::vector<uint64> &expiries)
+			{
+				TimerWheel wheel{ 0 };
+				std::vector<TimerHandle> handles;
+				handles.reserve(expiries.size());
+
+				size_t expired = 0;
+
+				const Stopwatch insertWatch;
+				for (const uint64 expiry : expiries)
+				{
+					handles.push_back(wheel.add([&expired]() { ++expired; }, expiry));
+				}
+				PrintResult("timer_wheel insert", static_cast<double>(expiries.size()) / insertWatch.getElapsedSeconds() / 1000000.0, "M/s");
+
+				// Cancel every second timer, like connection timeouts which are reset on activity
+				const Stopwatch cancelWatch;
+				for (size_t i = 0; i < handles.size(); i += 2)
+				{
+					wheel.cancel(handles[i]);
+				}
+				PrintResult("timer_wheel cancel", static_cast<double>(handles.size() / 2) / cancelWatch.getElapsedSeconds() / 1000000.0, "M/s");
+
+				const Stopwatch expireWatch;
+				for (uint64 now = 0; !wheel.empty(); now += TickStep)
+				{
+					wheel.advance(now);
+				}
+				PrintResult("timer_wheel expire", static_cast<double>(expired) / expireWatch.getElapsedSeconds() / 1000000.0, "M/s");
+
+				const TimerWheelStats stats = wheel.getStats();
+				PrintResult("timer_wheel cascaded per timer", static_cast<double>(stats.cascadedTimers) / static_cast<double>(stats.scheduledTimers), "");
+				PrintResult("timer_wheel largest batch", static_cast<double>(stats.largestBatch), "timers");
+			}
+		}
+
+		void RunTimerWheelBenchmark()
+		{
+			std::mt19937 random{ 42 };
+			std::uniform_int_distribution<uint64> delayDistribution{ 1, MaxDelay };
+
+			std::vector<uint64> expiries(TimerCount);
+			for (auto &expiry : expiries)
+			{
+				expiry = delayDistribution(random);
+			}
+
+			RunPriorityQueue(expiries);
+			RunTimerWheel(expiries);
+		}
+	}
+}
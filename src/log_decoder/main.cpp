@@ -0,0 +1,123 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "base/typedefs.h"
+#include "log/log_binary_stream.h"
+#include "log/log_entry.h"
+#include "log/log_level.h"
+#include "log/log_std_stream.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "cxxopts/cxxopts.hpp"
+
+
+using namespace mmo;
+
+
+/// String containing the version of this tool.
+static const std::string VersionStr = "1.0.0";
+
+
+namespace
+{
+	/// Prints all entries of a binary log file in the format of the text log files.
+	bool DecodeFile(const String &fileName, std::ostream &output, LogImportance minimumImportance)
+	{
+		std::ifstream file(fileName, std::ios::binary);
+		if (!file)
+		{
+			std::cerr << "Could not open log file " << fileName << "\n";
+			return false;
+		}
+
+		BinaryLogReader reader{ file };
+		if (!reader.isValid())
+		{
+			std::cerr << fileName << " is not a binary log file\n";
+			return false;
+		}
+
+		auto options = g_DefaultFileLogOptions;
+		options.minimumImportance = minimumImportance;
+
+		LogEntry entry;
+		while (reader.read(entry))
+		{
+			if (entry.level->importance >= options.minimumImportance)
+			{
+				printLogEntry(output, entry, options);
+			}
+		}
+
+		// A damaged record in the middle of the file is reported, a truncated last record is not
+		if (!reader.isValid())
+		{
+			std::cerr << fileName << " is damaged, stopped decoding\n";
+			return false;
+		}
+
+		return true;
+	}
+}
+
+/// Procedural entry point of the application.
+int main(int argc, char **argv)
+{
+	std::vector<String> fileNames;
+	String outputFileName;
+
+	// Prepare available command line options
+	cxxopts::Options options("Log Decoder " + VersionStr + ", available options");
+	options.add_options()
+		("help", "produce help message")
+		("f,file", "binary log files to decode", cxxopts::value<std::vector<std::string>>(fileNames))
+		("o,output", "text file to write to instead of stdout", cxxopts::value<std::string>(outputFileName))
+		("important", "only print entries of high importance like errors")
+		;
+
+	// Allow log_decoder file1 file2 ...
+	options.parse_positional({ "file" });
+
+	try
+	{
+		// Parse command line arguments
+		cxxopts::ParseResult result = options.parse(argc, argv);
+
+		// Check for help output
+		if (result.count("help") || fileNames.empty())
+		{
+			std::cerr << options.help() << "\n";
+			return fileNames.empty() ? 1 : 0;
+		}
+
+		const LogImportance minimumImportance = result.count("important") ? log_importance::High : log_importance::Low;
+
+		std::ofstream outputFile;
+		if (!outputFileName.empty())
+		{
+			outputFile.open(outputFileName, std::ios::out);
+			if (!outputFile)
+			{
+				std::cerr << "Could not open output file " << outputFileName << "\n";
+				return 1;
+			}
+		}
+
+		std::ostream &output = outputFile.is_open() ? static_cast<std::ostream&>(outputFile) : std::cout;
+
+		bool success = true;
+		for (const auto &fileName : fileNames)
+		{
+			success &= DecodeFile(fileName, output, minimumImportance);
+		}
+
+		return success ? 0 : 1;
+	}
+	catch (const cxxopts::OptionException &e)
+	{
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+}
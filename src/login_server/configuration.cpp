@@ -9,6 +9,7 @@
 #include "log/default_log_levels.h"
 #include "base/filesystem.h"
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 
@@ -22,14 +23,34 @@ namespace mmo
         , realmPort(mmo::constants::DefaultLoginRealmPort)
 		, maxPlayers((std::numeric_limits<decltype(maxPlayers)>::max)())
 		, maxRealms(constants::MaxRealmCount)
+		, sessionTableSize(100000)
+		, sessionTableTtl(3600)
 		, mysqlPort(mmo::constants::DefaultMySQLPort)
 		, mysqlHost("127.0.0.1")
 		, mysqlUser("mmo")
 		, mysqlPassword("")
 		, mysqlDatabase("mmo_login")
+		, mysqlConnections(4)
+		, mysqlKeepAliveInterval(60)
+		, mysqlWriteBehindInterval(10)
+		, networkThreads(0)
+		, listenBacklog(128)
+		, packetStatsInterval(0)
+		, isCorkEnabled(false)
+		, corkLatency(500)
+		, sendHighWatermark(256 * 1024)
+		, sendLowWatermark(64 * 1024)
+		, sendBufferLimit(4 * 1024 * 1024)
+		, isPauseOnCongestionEnabled(true)
+		, slowConsumerTimeout(10000)
+		, isTscClockEnabled(false)
+		, cryptoThreads(0)
+		, cryptoQueueLimit(1024)
 		, isLogActive(true)
 		, logFileName("logs/login")
 		, isLogFileBuffering(false)
+		, isLogAsync(true)
+		, isLogBinary(false)
 		, webPort(8090)
 		, webSSLPort(8091)
 		, webUser("mmo-web")
@@ -91,6 +112,9 @@ namespace mmo
 				mysqlUser = mysqlDatabaseTable->getString("user", mysqlUser);
 				mysqlPassword = mysqlDatabaseTable->getString("password", mysqlPassword);
 				mysqlDatabase = mysqlDatabaseTable->getString("database", mysqlDatabase);
+				mysqlConnections = std::max<size_t>(mysqlDatabaseTable->getInteger("connections", mysqlConnections), 1);
+				mysqlKeepAliveInterval = mysqlDatabaseTable->getInteger("keepAliveInterval", mysqlKeepAliveInterval);
+				mysqlWriteBehindInterval = std::max<uint32>(mysqlDatabaseTable->getInteger("writeBehindInterval", mysqlWriteBehindInterval), 1);
 			}
 
 			if (const Table *const mysqlDatabaseTable = global.getTable("webServer"))
@@ -105,6 +129,8 @@ namespace mmo
 			{
 				playerPort = playerManager->getInteger("port", playerPort);
 				maxPlayers = playerManager->getInteger("maxCount", maxPlayers);
+				sessionTableSize = playerManager->getInteger("sessionTableSize", sessionTableSize);
+				sessionTableTtl = playerManager->getInteger("sessionTableTtl", sessionTableTtl);
 			}
 
 			if (const Table *const realmManager = global.getTable("realmManager"))
@@ -121,11 +147,30 @@ namespace mmo
 				}
 			}
 
+			if (const Table *const network = global.getTable("network"))
+			{
+				networkThreads = network->getInteger("threads", networkThreads);
+				listenBacklog = network->getInteger("backlog", listenBacklog);
+				packetStatsInterval = network->getInteger("statsInterval", packetStatsInterval);
+				isCorkEnabled = network->getInteger("cork", static_cast<unsigned>(isCorkEnabled)) != 0;
+				corkLatency = network->getInteger("corkLatency", corkLatency);
+				sendHighWatermark = network->getInteger("sendHighWatermark", sendHighWatermark);
+				sendLowWatermark = network->getInteger("sendLowWatermark", sendLowWatermark);
+				sendBufferLimit = network->getInteger("sendBufferLimit", sendBufferLimit);
+				isPauseOnCongestionEnabled = network->getInteger("pauseOnCongestion", static_cast<unsigned>(isPauseOnCongestionEnabled)) != 0;
+				slowConsumerTimeout = network->getInteger("slowConsumerTimeout", slowConsumerTimeout);
+				isTscClockEnabled = network->getInteger("tscClock", static_cast<unsigned>(isTscClockEnabled)) != 0;
+				cryptoThreads = network->getInteger("cryptoThreads", cryptoThreads);
+				cryptoQueueLimit = network->getInteger("cryptoQueueLimit", cryptoQueueLimit);
+			}
+
 			if (const Table *const log = global.getTable("log"))
 			{
 				isLogActive = log->getInteger("active", static_cast<unsigned>(isLogActive)) != 0;
 				logFileName = log->getString("fileName", logFileName);
 				isLogFileBuffering = log->getInteger("buffering", static_cast<unsigned>(isLogFileBuffering)) != 0;
+				isLogAsync = log->getInteger("async", static_cast<unsigned>(isLogAsync)) != 0;
+				isLogBinary = log->getInteger("binary", static_cast<unsigned>(isLogBinary)) != 0;
 			}
 		}
 		catch (const sff::read::ParseException<Iterator> &e)
@@ -172,6 +217,9 @@ namespace mmo
 			mysqlDatabaseTable.addKey("user", mysqlUser);
 			mysqlDatabaseTable.addKey("password", mysqlPassword);
 			mysqlDatabaseTable.addKey("database", mysqlDatabase);
+			mysqlDatabaseTable.addKey("connections", mysqlConnections);
+			mysqlDatabaseTable.addKey("keepAliveInterval", mysqlKeepAliveInterval);
+			mysqlDatabaseTable.addKey("writeBehindInterval", mysqlWriteBehindInterval);
 			mysqlDatabaseTable.Finish();
 		}
 
@@ -192,6 +240,8 @@ namespace mmo
 			sff::write::Table<Char> playerManager(global, "playerManager", sff::write::MultiLine);
 			playerManager.addKey("port", playerPort);
 			playerManager.addKey("maxCount", maxPlayers);
+			playerManager.addKey("sessionTableSize", sessionTableSize);
+			playerManager.addKey("sessionTableTtl", sessionTableTtl);
 			playerManager.Finish();
 		}
 
@@ -206,11 +256,33 @@ namespace mmo
 		
 		global.writer.newLine();
 
+		{
+			sff::write::Table<Char> network(global, "network", sff::write::MultiLine);
+			network.addKey("threads", networkThreads);
+			network.addKey("backlog", listenBacklog);
+			network.addKey("statsInterval", packetStatsInterval);
+			network.addKey("cork", static_cast<unsigned>(isCorkEnabled));
+			network.addKey("corkLatency", corkLatency);
+			network.addKey("sendHighWatermark", sendHighWatermark);
+			network.addKey("sendLowWatermark", sendLowWatermark);
+			network.addKey("sendBufferLimit", sendBufferLimit);
+			network.addKey("pauseOnCongestion", static_cast<unsigned>(isPauseOnCongestionEnabled));
+			network.addKey("slowConsumerTimeout", slowConsumerTimeout);
+			network.addKey("tscClock", static_cast<unsigned>(isTscClockEnabled));
+			network.addKey("cryptoThreads", cryptoThreads);
+			network.addKey("cryptoQueueLimit", cryptoQueueLimit);
+			network.Finish();
+		}
+
+		global.writer.newLine();
+
 		{
 			sff::write::Table<Char> log(global, "log", sff::write::MultiLine);
 			log.addKey("active", static_cast<unsigned>(isLogActive));
 			log.addKey("fileName", logFileName);
 			log.addKey("buffering", isLogFileBuffering);
+			log.addKey("async", static_cast<unsigned>(isLogAsync));
+			log.addKey("binary", static_cast<unsigned>(isLogBinary));
 			log.Finish();
 		}
 
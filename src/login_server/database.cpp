@@ -2,16 +2,45 @@
 
 #include "database.h"
 
+#include "base/macros.h"
+
+#include <cctype>
+
 namespace mmo
 {
 	IDatabase::~IDatabase()
 	{
 	}
 
+	DatabaseKey::DatabaseKey(const std::string &name)
+		: hash(0)
+	{
+		// FNV-1a of the upper case name
+		uint64 value = 14695981039346656037ull;
+		for (const char c : name)
+		{
+			value ^= static_cast<uint8>(std::toupper(static_cast<unsigned char>(c)));
+			value *= 1099511628211ull;
+		}
+
+		hash = static_cast<size_t>(value);
+	}
+
+	DatabaseKey::DatabaseKey(uint64 id)
+		: hash(std::hash<uint64>()(id))
+	{
+	}
+
 	AsyncDatabase::AsyncDatabase(IDatabase &database, ActionDispatcher asyncWorker, ActionDispatcher resultDispatcher)
-		: m_database(database)
-		, m_asyncWorker(std::move(asyncWorker))
+		: m_workers{ Worker{ &database, std::move(asyncWorker) } }
+		, m_resultDispatcher(std::move(resultDispatcher))
+	{
+	}
+
+	AsyncDatabase::AsyncDatabase(std::vector<Worker> workers, ActionDispatcher resultDispatcher)
+		: m_workers(std::move(workers))
 		, m_resultDispatcher(std::move(resultDispatcher))
 	{
+		ASSERT(!m_workers.empty());
 	}
 }
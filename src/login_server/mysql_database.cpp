@@ -1,15 +1,146 @@
 // Copyright (C) 2019, Robin Klimonow. All rights reserved.
 
 #include "mysql_database.h"
-#include "mysql_wrapper/mysql_row.h"
-#include "mysql_wrapper/mysql_select.h"
 #include "mysql_wrapper/mysql_statement.h"
 #include "log/default_log_levels.h"
 
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
 namespace mmo
 {
+	namespace
+	{
+		/// Indices of the prepared statements in the statement cache.
+		enum Statements
+		{
+			AccountDataByName,
+			RealmAuthDataByName,
+			AccountSessionKeyByName,
+		};
+
+		/// Queries of the prepared statements, in the order of the Statements enum.
+		std::vector<String> GetStatementQueries()
+		{
+			return {
+				"SELECT id,username,s,v FROM account WHERE username=? LIMIT 1",
+				"SELECT id,name,s,v,address,port FROM realm WHERE name=? LIMIT 1",
+				"SELECT id,k FROM account WHERE username=? LIMIT 1",
+			};
+		}
+
+		/// Maximum number of accounts which are looked up by a single session key statement.
+		static constexpr size_t MaxAccountsPerSessionKeyQuery = 64;
+
+		/// Builds a statement which selects id, username and k of accountCount accounts by name.
+		String BuildSessionKeyQuery(size_t accountCount)
+		{
+			String query = "SELECT id,username,k FROM account WHERE username IN (";
+			for (size_t i = 0; i < accountCount; ++i)
+			{
+				query += (i == 0 ? "?" : ",?");
+			}
+			query += ")";
+
+			return query;
+		}
+
+		/// Compares account names like the database does.
+		bool AccountNamesEqual(const String &left, const String &right)
+		{
+			return left.size() == right.size() &&
+				std::equal(left.begin(), left.end(), right.begin(), [](char l, char r)
+				{
+					return std::toupper(static_cast<unsigned char>(l)) == std::toupper(static_cast<unsigned char>(r));
+				});
+		}
+
+		/// Maximum number of rows which are written by a single login update statement.
+		static constexpr size_t MaxRowsPerLoginUpdate = 64;
+
+		/// Builds a statement which updates rowCount rows of a table by id in one go. Each column is set to a
+		/// per row value and last_login is set to the current time. The parameters are, for every column, an
+		/// (id, value) pair per row, followed by the ids of all rows.
+		String BuildLoginUpdate(const char *table, const std::vector<const char *> &columns, size_t rowCount)
+		{
+			std::ostringstream query;
+			query << "UPDATE " << table << " SET ";
+
+			for (const char *column : columns)
+			{
+				query << column << "=CASE id";
+				for (size_t i = 0; i < rowCount; ++i)
+				{
+					query << " WHEN ? THEN ?";
+				}
+				query << " END, ";
+			}
+
+			query << "last_login=NOW() WHERE id IN (";
+			for (size_t i = 0; i < rowCount; ++i)
+			{
+				query << (i == 0 ? "?" : ",?");
+			}
+			query << ")";
+
+			return query.str();
+		}
+
+		/// Writes login updates with one statement per MaxRowsPerLoginUpdate rows. The statements are prepared
+		/// once per row count and remembered in statementsByRowCount.
+		template <class Update, class Id>
+		void ExecuteLoginUpdates(
+			mysql::StatementCache &statements,
+			std::map<size_t, size_t> &statementsByRowCount,
+			const char *table,
+			Id Update::*id,
+			const std::vector<std::pair<const char *, std::string Update::*>> &columns,
+			const std::vector<Update> &updates)
+		{
+			for (size_t offset = 0; offset < updates.size(); offset += MaxRowsPerLoginUpdate)
+			{
+				const size_t rowCount = std::min(MaxRowsPerLoginUpdate, updates.size() - offset);
+
+				auto it = statementsByRowCount.find(rowCount);
+				if (it == statementsByRowCount.end())
+				{
+					std::vector<const char *> columnNames;
+					for (const auto &column : columns)
+					{
+						columnNames.push_back(column.first);
+					}
+
+					it = statementsByRowCount.emplace(rowCount, statements.Add(BuildLoginUpdate(table, columnNames, rowCount))).first;
+				}
+
+				statements.Execute(it->second, [&](mysql::Statement &statement)
+				{
+					size_t parameter = 0;
+					for (const auto &column : columns)
+					{
+						for (size_t i = offset; i < offset + rowCount; ++i)
+						{
+							statement.SetInt(parameter++, static_cast<int64>(updates[i].*id));
+							statement.SetParameter(parameter++, mysql::ConstStringPtr{ &(updates[i].*(column.second)) });
+						}
+					}
+
+					for (size_t i = offset; i < offset + rowCount; ++i)
+					{
+						statement.SetInt(parameter++, static_cast<int64>(updates[i].*id));
+					}
+
+					statement.Execute();
+				});
+			}
+		}
+	}
+
 	MySQLDatabase::MySQLDatabase(const mysql::DatabaseInfo &connectionInfo)
 		: m_connectionInfo(connectionInfo)
+		, m_statements(m_connection, GetStatementQueries())
+		, m_isConnectionLost(false)
 	{
 	}
 
@@ -27,30 +158,62 @@ namespace mmo
 			m_connectionInfo.host << ":" <<
 			m_connectionInfo.port);
 
+		try
+		{
+			m_statements.Prepare();
+		}
+		catch (const mysql::Exception &e)
+		{
+			ELOG("Could not prepare the login database statements: " << e.what());
+			return false;
+		}
+
 		return true;
 	}
 
+	void MySQLDatabase::keepAlive()
+	{
+		if (m_connection.KeepAlive())
+		{
+			if (m_isConnectionLost)
+			{
+				ILOG("Reconnected to the login database");
+				m_isConnectionLost = false;
+			}
+			return;
+		}
+
+		if (!m_isConnectionLost)
+		{
+			WLOG("Lost connection to the login database: " << m_connection.GetErrorMessage());
+			m_isConnectionLost = true;
+		}
+	}
+
 	std::optional<AccountData> MySQLDatabase::getAccountDataByName(std::string name)
 	{
-		mysql::Select select(m_connection, "SELECT id,username,s,v FROM account WHERE username='" + m_connection.EscapeString(name) + "' LIMIT 1");
-		if (select.Success())
+		try
 		{
-			mysql::Row row(select);
-			if (row)
+			return m_statements.Execute(AccountDataByName, [&name](mysql::Statement &statement) -> std::optional<AccountData>
 			{
+				statement.SetParameter(0, mysql::ConstStringPtr{ &name });
+
+				mysql::StatementResult result = statement.ExecuteSelect();
+				if (!result.FetchResultRow())
+				{
+					return {};
+				}
+
 				// Account exists: Get data
 				AccountData data;
-				row.GetField(0, data.id);
-				row.GetField(1, data.name);
-				row.GetField(2, data.s);
-				row.GetField(3, data.v);
+				result.ReadRow(data, &AccountData::id, &AccountData::name, &AccountData::s, &AccountData::v);
 				return data;
-			}
+			});
 		}
-		else
+		catch (const mysql::Exception &e)
 		{
 			// There was an error
-			PrintDatabaseError();
+			PrintDatabaseError(e);
 		}
 
 		return {};
@@ -58,27 +221,29 @@ namespace mmo
 
 	std::optional<RealmAuthData> MySQLDatabase::getRealmAuthData(std::string name)
 	{
-		mysql::Select select(m_connection, "SELECT id,name,s,v,address,port FROM realm WHERE name = '" + m_connection.EscapeString(name) + "' LIMIT 1");
-		if (select.Success())
+		try
 		{
-			mysql::Row row(select);
-			if (row)
+			return m_statements.Execute(RealmAuthDataByName, [&name](mysql::Statement &statement) -> std::optional<RealmAuthData>
 			{
+				statement.SetParameter(0, mysql::ConstStringPtr{ &name });
+
+				mysql::StatementResult result = statement.ExecuteSelect();
+				if (!result.FetchResultRow())
+				{
+					return {};
+				}
+
 				// Create the structure and fill it with data
 				RealmAuthData data;
-				row.GetField(0, data.id);
-				row.GetField(1, data.name);
-				row.GetField(2, data.s);
-				row.GetField(3, data.v);
-				row.GetField(4, data.ipAddress);
-				row.GetField(5, data.port);
+				result.ReadRow(data, &RealmAuthData::id, &RealmAuthData::name, &RealmAuthData::s, &RealmAuthData::v,
+					&RealmAuthData::ipAddress, &RealmAuthData::port);
 				return data;
-			}
+			});
 		}
-		else
+		catch (const mysql::Exception &e)
 		{
 			// There was an error
-			PrintDatabaseError();
+			PrintDatabaseError(e);
 		}
 
 		return {};
@@ -86,54 +251,114 @@ namespace mmo
 
 	std::optional<std::pair<uint64, std::string>> MySQLDatabase::getAccountSessionKey(std::string accountName)
 	{
-		mysql::Select select(m_connection, "SELECT id,k FROM account WHERE username = '" + m_connection.EscapeString(accountName) + "' LIMIT 1");
-		if (select.Success())
+		try
 		{
-			mysql::Row row(select);
-			if (row)
+			return m_statements.Execute(AccountSessionKeyByName, [&accountName](mysql::Statement &statement) -> std::optional<std::pair<uint64, std::string>>
 			{
-				return std::make_pair<uint64, std::string>(std::atoll(row.GetField(0)), std::string(row.GetField(1)));
-			}
+				statement.SetParameter(0, mysql::ConstStringPtr{ &accountName });
+
+				mysql::StatementResult result = statement.ExecuteSelect();
+				if (!result.FetchResultRow())
+				{
+					return {};
+				}
+
+				std::pair<uint64, std::string> session;
+				result.ReadColumns(session.first, session.second);
+				return session;
+			});
 		}
-		else
+		catch (const mysql::Exception &e)
 		{
 			// There was an error
-			PrintDatabaseError();
+			PrintDatabaseError(e);
 		}
 
 		return {};
 	}
 
-	void MySQLDatabase::playerLogin(uint64 accountId, const std::string& sessionKey, const std::string& ip)
+	std::vector<std::optional<std::pair<uint64, std::string>>> MySQLDatabase::getAccountSessionKeys(const std::vector<std::string> &accountNames)
 	{
-		if (!m_connection.Execute("UPDATE account SET k = '"
-			+ m_connection.EscapeString(sessionKey)
-			+ "', last_login = NOW(), last_ip = '"
-			+ m_connection.EscapeString(ip)
-			+ "' WHERE id = " + std::to_string(accountId)))
+		std::vector<std::optional<std::pair<uint64, std::string>>> sessions(accountNames.size());
+
+		try
 		{
-			PrintDatabaseError();
+			for (size_t offset = 0; offset < accountNames.size(); offset += MaxAccountsPerSessionKeyQuery)
+			{
+				const size_t accountCount = std::min(MaxAccountsPerSessionKeyQuery, accountNames.size() - offset);
+
+				auto it = m_sessionKeyStatements.find(accountCount);
+				if (it == m_sessionKeyStatements.end())
+				{
+					it = m_sessionKeyStatements.emplace(accountCount, m_statements.Add(BuildSessionKeyQuery(accountCount))).first;
+				}
+
+				m_statements.Execute(it->second, [&](mysql::Statement &statement)
+				{
+					for (size_t i = 0; i < accountCount; ++i)
+					{
+						statement.SetParameter(i, mysql::ConstStringPtr{ &accountNames[offset + i] });
+					}
+
+					mysql::StatementResult result = statement.ExecuteSelect();
+
+					uint64 id = 0;
+					std::string name, k;
+					while (result.FetchResultRow())
+					{
+						result.ReadColumns(id, name, k);
+
+						// Rows are returned in no particular order, and an account might have been requested more than once
+						for (size_t i = offset; i < offset + accountCount; ++i)
+						{
+							if (AccountNamesEqual(accountNames[i], name))
+							{
+								sessions[i] = std::make_pair(id, k);
+							}
+						}
+					}
+				});
+			}
+		}
+		catch (const mysql::Exception &e)
+		{
+			// Accounts which couldn't be read are reported as missing
+			PrintDatabaseError(e);
+		}
+
+		return sessions;
+	}
+
+	void MySQLDatabase::playerLogins(const std::vector<PlayerLoginUpdate> &updates)
+	{
+		try
+		{
+			ExecuteLoginUpdates(m_statements, m_playerLoginStatements, "account", &PlayerLoginUpdate::accountId,
+				{ { "k", &PlayerLoginUpdate::sessionKey }, { "last_ip", &PlayerLoginUpdate::ip } }, updates);
+		}
+		catch (const mysql::Exception &e)
+		{
+			PrintDatabaseError(e);
 			throw mysql::Exception("Could not update account database on login");
 		}
 	}
 
-	void MySQLDatabase::realmLogin(uint32 realmId, const std::string & sessionKey, const std::string & ip, const std::string & build)
+	void MySQLDatabase::realmLogins(const std::vector<RealmLoginUpdate> &updates)
 	{
-		if (!m_connection.Execute("UPDATE realm SET k = '"
-			+ m_connection.EscapeString(sessionKey)
-			+ "', last_login = NOW(), last_ip = '"
-			+ m_connection.EscapeString(ip)
-			+ "', last_build = '"
-			+ m_connection.EscapeString(build)
-			+ "' WHERE id = " + std::to_string(realmId)))
-		{
-			PrintDatabaseError();
+		try
+		{
+			ExecuteLoginUpdates(m_statements, m_realmLoginStatements, "realm", &RealmLoginUpdate::realmId,
+				{ { "k", &RealmLoginUpdate::sessionKey }, { "last_ip", &RealmLoginUpdate::ip }, { "last_build", &RealmLoginUpdate::build } }, updates);
+		}
+		catch (const mysql::Exception &e)
+		{
+			PrintDatabaseError(e);
 			throw mysql::Exception("Could not update realm database on login");
 		}
 	}
 	
-	void MySQLDatabase::PrintDatabaseError()
+	void MySQLDatabase::PrintDatabaseError(const mysql::Exception &e)
 	{
-		ELOG("Login database error: " << m_connection.GetErrorMessage());
+		ELOG("Login database error: " << e.what());
 	}
 }
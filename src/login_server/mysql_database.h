@@ -4,6 +4,10 @@
 
 #include "database.h"
 #include "mysql_wrapper/mysql_connection.h"
+#include "mysql_wrapper/mysql_statement_cache.h"
+#include "mysql_wrapper/mysql_exception.h"
+
+#include <map>
 
 namespace mmo
 {
@@ -16,19 +20,32 @@ namespace mmo
 
 		/// Tries to establish a connection to the MySQL server.
 		bool load();
+		/// Checks the connection to the MySQL server and reestablishes it if it has been lost. Statements
+		/// are prepared again by the first request which uses them after a reconnect.
+		void keepAlive();
 
 	public:
 		std::optional<AccountData> getAccountDataByName(std::string name) override;
 		std::optional<RealmAuthData> getRealmAuthData(std::string name) override;
 		std::optional<std::pair<uint64, std::string>> getAccountSessionKey(std::string accountName) override;
-		void playerLogin(uint64 accountId, const std::string& sessionKey, const std::string& ip) override;
-		void realmLogin(uint32 realmId, const std::string& sessionKey, const std::string& ip, const std::string& build) override;
+		std::vector<std::optional<std::pair<uint64, std::string>>> getAccountSessionKeys(const std::vector<std::string> &accountNames) override;
+		void playerLogins(const std::vector<PlayerLoginUpdate> &updates) override;
+		void realmLogins(const std::vector<RealmLoginUpdate> &updates) override;
 
 	private:
-		void PrintDatabaseError();
+		void PrintDatabaseError(const mysql::Exception &e);
 
 	private:
 		mysql::DatabaseInfo m_connectionInfo;
 		mysql::Connection m_connection;
+		/// Prepared statements of all queries of this database, which belong to m_connection.
+		mysql::StatementCache m_statements;
+		/// Statement indices of the batched login updates by their row count.
+		std::map<size_t, size_t> m_playerLoginStatements;
+		std::map<size_t, size_t> m_realmLoginStatements;
+		/// Statement indices of the batched session key lookups by their account count.
+		std::map<size_t, size_t> m_sessionKeyStatements;
+		/// Set if the last keep alive check failed, to log only changes of the connection state.
+		bool m_isConnectionLost;
 	};
 }
@@ -5,11 +5,15 @@
 #include "realm_manager.h"
 #include "player_manager.h"
 #include "realm.h"
+#include "session_table.h"
+#include "write_behind_queue.h"
 
 #include "base/constants.h"
+#include "base/srp6.h"
 #include "base/sha1.h"
 #include "base/clock.h"
 #include "base/weak_ptr_function.h"
+#include "base/worker_pool.h"
 #include "log/default_log_levels.h"
 
 #include <iomanip>
@@ -21,19 +25,27 @@ namespace mmo
 		PlayerManager& playerManager,
 		RealmManager& realmManager,
 		AsyncDatabase& database, 
+		WorkerPool& cryptoWorkers,
+		SessionTable& sessions,
+		WriteBehindQueue& sessionWriter,
 		std::shared_ptr<Client> connection, 
 		const String & address)
 		: m_manager(playerManager)
 		, m_realmManager(realmManager)
 		, m_database(database)
+		, m_cryptoWorkers(cryptoWorkers)
+		, m_sessions(sessions)
+		, m_sessionWriter(sessionWriter)
 		, m_connection(std::move(connection))
 		, m_address(address)
+		, m_accountId(0)
+		, m_authenticated(false)
 	{
 		m_connection->setListener(*this);
 
 		// Listen for connect packets
 		RegisterPacketHandler(auth::client_login_packet::LogonChallenge, *this, &Player::handleLogonChallenge);
-		RegisterPacketHandler(auth::client_login_packet::ReconnectChallenge, *this, &Player::handleLogonChallenge);
+		RegisterPacketHandler(auth::client_login_packet::ReconnectChallenge, *this, &Player::handleReconnectChallenge);
 	}
 
 	void Player::destroy()
@@ -46,7 +58,7 @@ namespace mmo
 
 	void Player::connectionLost()
 	{
-		ILOG("Client " << m_address << " disconnected");
+		ILOGF("Client {} disconnected", m_address);
 		destroy();
 	}
 
@@ -58,28 +70,43 @@ namespace mmo
 
 	PacketParseResult Player::connectionPacketReceived(auth::IncomingPacket & packet)
 	{
-		const auto packetId = packet.GetId();
-		bool isValid = true;
+		// Execute the packet handler if it is currently enabled and return the result
+		PacketParseResult result = PacketParseResult::Disconnect;
+		if (!m_packetHandlers.dispatch(packet, result))
+		{
+			WLOG_RATE(10, "Packet 0x" << std::hex << (uint16)packet.GetId() << " is either unhandled or simply currently not handled");
+			return PacketParseResult::Disconnect;
+		}
 
-		PacketHandler handler = nullptr;
+		return result;
+	}
 
-		{
-			// Lock packet handler access
-			std::scoped_lock lock{ m_packetHandlerMutex };
+	void Player::SendLogonChallenge(auth::AuthResult result)
+	{
+		m_connection->sendSinglePacket([result, this](auth::OutgoingPacket& packet) {
+			packet.Start(auth::login_client_packet::LogonChallenge);
+			packet << io::write<uint8>(result);
 
-			// Check for packet handlers
-			auto handlerIt = m_packetHandlers.find(packetId);
-			if (handlerIt == m_packetHandlers.end())
+			// On success, there are more data values to write
+			if (result == auth::auth_result::Success)
 			{
-				WLOG("Packet 0x" << std::hex << (uint16)packetId << " is either unhandled or simply currently not handled");
-				return PacketParseResult::Disconnect;
+				// Write B with 32 byte length and g
+				std::vector<uint8> B_ = this->m_B.asByteArray(32);
+				packet
+					<< io::write_range(B_.begin(), B_.end())
+					<< io::write<uint8>(constants::srp::g.asUInt32());
+
+				// Write N with 32 byte length
+				const std::vector<uint8> N_ = constants::srp::N.asByteArray(32);
+				packet << io::write_range(N_.begin(), N_.end());
+
+				// Write s
+				const std::vector<uint8> s_ = this->m_s.asByteArray();
+				packet << io::write_range(s_.begin(), s_.end());
 			}
 
-			handler = handlerIt->second;
-		}
-
-		// Execute the packet handler and return the result
-		return handler(packet);
+			packet.Finish();
+		});
 	}
 
 	void Player::SendAuthProof(auth::AuthResult result)
@@ -101,72 +128,47 @@ namespace mmo
 		});
 	}
 
-	void Player::SendRealmList()
+	void Player::SendReconnectChallenge(auth::AuthResult result)
 	{
-		m_connection->sendSinglePacket([this](auth::OutgoingPacket& packet) {
-			packet.Start(mmo::auth::login_client_packet::RealmList);
-
-			// Remember realm count position and write placeholder value
-			const size_t realmCountPos = packet.sink().position();
-			packet << io::write<uint16>(0);
-
-			// The realm counter
-			uint16 realmCount = 0;
-
-			// Iterate through every realm and write it's data to the outgoing packet
-			m_realmManager.ForEachRealm([&realmCount, &packet](const Realm& realm) {
-				// Skip this realm if it is not authenticated
-				if (!realm.IsAuthentificated())
-				{
-					return;
-				}
-
-				// TODO: Probably check if the realm is otherwise not eligible? Account level / security groups / supported client versions?
-
-				// Write realm data
-				packet 
-					<< io::write<uint32>(realm.GetRealmId())
-					<< io::write_dynamic_range<uint8>(realm.GetRealmName())
-					<< io::write_dynamic_range<uint8>(realm.GetRealmListAddress())
-					<< io::write<uint16>(realm.GetRealmListPort())
-					;
+		m_connection->sendSinglePacket([result, this](auth::OutgoingPacket& packet) {
+			packet.Start(auth::login_client_packet::ReconnectChallenge);
+			packet << io::write<uint8>(result);
 
-				// Increase counter
-				realmCount++;
-			});
+			// On success, the client has to include the server nonce in its proof
+			if (result == auth::auth_result::Success)
+			{
+				packet << io::write_range(this->m_reconnectNonce.begin(), this->m_reconnectNonce.end());
+			}
 
-			// Now overwrite realm count with the actual realm count
-			packet.sink().overwrite(realmCountPos, reinterpret_cast<const char*>(&realmCount), sizeof(realmCount));
+			packet.Finish();
+		});
+	}
 
-			// Finish the packet
+	void Player::SendReconnectProof(auth::AuthResult result)
+	{
+		m_connection->sendSinglePacket([result](auth::OutgoingPacket& packet) {
+			packet.Start(auth::login_client_packet::ReconnectProof);
+			packet << io::write<uint8>(result);
 			packet.Finish();
 		});
 	}
 
-	void Player::RegisterPacketHandler(uint8 opCode, PacketHandler && handler)
+	void Player::SendRealmList()
 	{
-		std::scoped_lock lock{ m_packetHandlerMutex };
+		// The realm list is serialized once per change and shared by all players, so no realm has
+		// to be visited and no lock is held while the packet is queued
+		m_connection->sendSharedBuffer(m_realmManager.GetRealmListPacket());
+		m_connection->requestFlush();
+	}
 
-		auto it = m_packetHandlers.find(opCode);
-		if (it == m_packetHandlers.end())
-		{
-			m_packetHandlers.emplace(std::make_pair(opCode, std::forward<PacketHandler>(handler)));
-		}
-		else
-		{
-			it->second = std::forward<PacketHandler>(handler);
-		}
+	void Player::RegisterPacketHandler(uint8 opCode, PacketHandler && handler)
+	{
+		m_packetHandlers.registerHandler(opCode, std::move(handler));
 	}
 
 	void Player::ClearPacketHandler(uint8 opCode)
 	{
-		std::scoped_lock lock{ m_packetHandlerMutex };
-
-		auto it = m_packetHandlers.find(opCode);
-		if (it != m_packetHandlers.end())
-		{
-			m_packetHandlers.erase(it);
-		}
+		m_packetHandlers.clearHandler(opCode);
 	}
 
 	PacketParseResult Player::handleLogonChallenge(auth::IncomingPacket & packet)
@@ -176,90 +178,83 @@ namespace mmo
 		ClearPacketHandler(auth::client_login_packet::ReconnectChallenge);
 
 		// Read the packet data
-		if (!(packet
-			>> io::read<uint8>(m_version1)
-			>> io::read<uint8>(m_version2)
-			>> io::read<uint8>(m_version3)
-			>> io::read<uint16>(m_build)
-			>> m_platform
-			>> m_system
-			>> m_locale
-			>> io::read_container<uint8>(m_accountName)))
+		if (!readChallenge(packet))
 		{
 			return PacketParseResult::Disconnect;
 		}
 
 		// Write the login attempt to the logs
-		ILOG("Received logon challenge for account " << m_accountName << "...");
+		ILOGF("Received logon challenge for account {}...", m_accountName);
 		
 		// RequestHandler
 		std::weak_ptr<Player> weakThis{ shared_from_this() };
 		auto handler = [weakThis](std::optional<AccountData> result) {
 			if (auto strongThis = weakThis.lock())
 			{
-				// The temporary result
-				auth::AuthResult authResult = auth::auth_result::FailWrongCredentials;
-				if (result)
+				if (!result)
 				{
-					// Generate s and v bignumber values to calculate with
-					strongThis->m_s.setHexStr(result->s);
-					strongThis->m_v.setHexStr(result->v);
+					// Invalid account name display
+					WLOG_RATE(10, "Invalid account name " << strongThis->getAccountName());
+					strongThis->SendLogonChallenge(auth::auth_result::FailWrongCredentials);
+					return;
+				}
 
-					// Store account id
-					strongThis->m_accountId = result->id;
+				// Generate s and v bignumber values to calculate with
+				strongThis->m_s.setHexStr(result->s);
+				strongThis->m_v.setHexStr(result->v);
 
-					// We are NOT banned so continue
-					authResult = auth::auth_result::Success;
+				// Store account id
+				strongThis->m_accountId = result->id;
 
-					strongThis->m_b.setRand(19 * 8);
-					BigNumber gmod = constants::srp::g.modExp(strongThis->m_b, constants::srp::N);
-					strongThis->m_B = ((strongThis->m_v * 3) + gmod) % constants::srp::N;
+				// We are NOT banned so continue, but calculate B on a crypto worker thread
+				auto task = [weakThis, connection = strongThis->m_connection, v = strongThis->m_v]()
+				{
+					BigNumber b;
+					b.setRand(19 * 8);
 
+					BigNumber gmod = srp6::ModExpG(b);
 					assert(gmod.getNumBytes() <= 32);
-					strongThis->m_unk3.setRand(16 * 8);
+					BigNumber B = ((v * 3) + gmod) % constants::srp::N;
 
-					// Allow handling the logon proof packet now
-					strongThis->RegisterPacketHandler(auth::client_login_packet::LogonProof, *strongThis.get(), &Player::handleLogonProof);
-				}
-				else
+					connection->post([weakThis, b, B]()
+					{
+						if (auto strongThis = weakThis.lock())
+						{
+							strongThis->logonChallengeComputed(b, B);
+						}
+					});
+				};
+
+				if (!strongThis->m_cryptoWorkers.tryPost(std::move(task)))
 				{
-					// Invalid account name display
-					WLOG("Invalid account name " << strongThis->getAccountName());
+					WLOG_RATE(10, "Crypto workers are busy, rejecting logon challenge of account " << strongThis->getAccountName());
+					strongThis->SendLogonChallenge(auth::auth_result::FailDbBusy);
 				}
-
-				// Send packet with result
-				strongThis->m_connection->sendSinglePacket([authResult, &strongThis](auth::OutgoingPacket& packet) {
-					packet.Start(auth::login_client_packet::LogonChallenge);
-					packet << io::write<uint8>(authResult);
-
-					// On success, there are more data values to write
-					if (authResult == auth::auth_result::Success)
-					{
-						// Write B with 32 byte length and g
-						std::vector<uint8> B_ = strongThis->m_B.asByteArray(32);
-						packet
-							<< io::write_range(B_.begin(), B_.end())
-							<< io::write<uint8>(constants::srp::g.asUInt32());
-
-						// Write N with 32 byte length
-						const std::vector<uint8> N_ = constants::srp::N.asByteArray(32);
-						packet << io::write_range(N_.begin(), N_.end());
-
-						// Write s
-						const std::vector<uint8> s_ = strongThis->m_s.asByteArray();
-						packet << io::write_range(s_.begin(), s_.end());
-					}
-
-					packet.Finish();
-				});
 			}
 		};
 
-		// Execute
-		m_database.asyncRequest(std::move(handler), &IDatabase::getAccountDataByName, std::cref(m_accountName));
+		// Execute and handle the result on the connection strand
+		m_database.asyncRequest(m_accountName, bindToConnection(m_connection, std::move(handler)), &IDatabase::getAccountDataByName, std::cref(m_accountName));
 		return PacketParseResult::Pass;
 	}
 
+	void Player::logonChallengeComputed(BigNumber b, BigNumber B)
+	{
+		if (!m_connection)
+		{
+			return;
+		}
+
+		m_b = std::move(b);
+		m_B = std::move(B);
+		m_unk3.setRand(16 * 8);
+
+		// Allow handling the logon proof packet now
+		RegisterPacketHandler(auth::client_login_packet::LogonProof, *this, &Player::handleLogonProof);
+
+		SendLogonChallenge(auth::auth_result::Success);
+	}
+
 	PacketParseResult Player::handleLogonProof(auth::IncomingPacket & packet)
 	{
 		// No longer handle proof packet
@@ -285,149 +280,168 @@ namespace mmo
 			ELOG("[Logon Proof] SRP safeguard failed");
 			return PacketParseResult::Disconnect;
 		}
-		
-		// Build hash
-		SHA1Hash hash = Sha1_BigNumbers({ A, m_B });
 
-		// Calculate u and S
-		BigNumber u{ hash.data(), hash.size() };
-		BigNumber S = (A * (m_v.modExp(u, constants::srp::N))).modExp(m_b, constants::srp::N);
-
-		// Build t
-		const std::vector<uint8> t = S.asByteArray(32);
-		std::array<uint8, 16> t1;
-		for (size_t i = 0; i < t1.size(); ++i)
+		// Verify the proof on a crypto worker thread, which only works on copies of the srp6 values
+		std::weak_ptr<Player> weakThis{ shared_from_this() };
+		auto task = [weakThis, connection = m_connection, accountName = m_accountName, s = m_s, v = m_v, b = m_b, B = m_B, A, rec_M1]()
 		{
-			t1[i] = t[i * 2];
-		}
-		hash = sha1(reinterpret_cast<const char*>(t1.data()), t1.size());
+			auto result = srp6::CalculateServerProof(accountName, s, v, b, B, A, rec_M1);
+			connection->post([weakThis, result = std::move(result)]()
+			{
+				if (auto strongThis = weakThis.lock())
+				{
+					strongThis->logonProofComputed(result);
+				}
+			});
+		};
 
-		std::array<uint8, 40> vK;
-		for (size_t i = 0; i < 20; ++i)
+		if (!m_cryptoWorkers.tryPost(std::move(task)))
 		{
-			vK[i * 2] = hash[i];
-		}
-		for (size_t i = 0; i < 16; ++i)
-		{
-			t1[i] = t[i * 2 + 1];
+			WLOG_RATE(10, "Crypto workers are busy, rejecting logon proof of account " << m_accountName);
+			SendAuthProof(auth::auth_result::FailDbBusy);
 		}
 
-		hash = sha1(reinterpret_cast<const char*>(t1.data()), t1.size());
-		for (size_t i = 0; i < 20; ++i)
+		return PacketParseResult::Pass;
+	}
+
+	void Player::logonProofComputed(std::optional<srp6::ServerProof> result)
+	{
+		if (!m_connection)
 		{
-			vK[i * 2 + 1] = hash[i];
+			return;
 		}
 
-		BigNumber K{ vK.data(), vK.size() };
-
-		SHA1Hash h;
-		h = Sha1_BigNumbers({ constants::srp::N });
-		hash = Sha1_BigNumbers({ constants::srp::g });
-		for (size_t i = 0; i < h.size(); ++i)
+		if (!result)
 		{
-			h[i] ^= hash[i];
+			// Log error
+			WLOGF("Invalid password for account {}", m_accountName);
+
+			// Send proof result
+			SendAuthProof(auth::auth_result::FailWrongCredentials);
+			return;
 		}
 
-		BigNumber t3{ h.data(), h.size() };
+		// Remember the M2 hash value that is sent back to the client for verification as well.
+		m_m2 = result->M2;
 
-		HashGeneratorSha1 sha;
-		Sha1_Add_BigNumbers(sha, { t3 });
-		const auto t4 = sha1(reinterpret_cast<const char*>(m_accountName.data()), m_accountName.size());
-		sha.update(reinterpret_cast<const char*>(t4.data()), t4.size());
-		Sha1_Add_BigNumbers(sha, { m_s, A, m_B, K });
-		hash = sha.finalize();
+		// Store the caluclated session key value internally for later use
+		m_sessionKey = result->sessionKey;
 
-		// Proof result which will be sent to the client
-		auth::AuthResult proofResult = auth::auth_result::FailWrongCredentials;
+		// The session table is authoritative for the session key, so the client doesn't have to wait until
+		// the session key has been written to the account database in the background
+		String sessionKey = m_sessionKey.asHexStr();
+		m_sessions.set(m_accountName, AccountSession{ m_accountId, sessionKey, m_sessionKey.asByteArray() });
+		m_sessionWriter.playerLogin(PlayerLoginUpdate{ m_accountId, std::move(sessionKey), m_address, m_accountName });
 
-		// Calculate M1 hash on server using values sent by the client and compare it against
-		// the M1 hash sent by the client to see if the passwords do match.
-		const BigNumber M1{ hash.data(), hash.size() };
-		auto sArr = M1.asByteArray(20);
-		if (std::equal(sArr.begin(), sArr.end(), rec_M1.begin()))
-		{
-			// Finish SRP6 by calculating the M2 hash value that is sent back to the client for
-			// verification as well.
-			m_m2 = Sha1_BigNumbers({ A, M1, K});
+		// Add log entry about successful login as the hashes do indeed mach (and thus, so
+		// do the passwords)
+		ILOGF("User {} successfully authenticated", m_accountName);
 
-			// Store the caluclated session key value internally for later use, also store it in the 
-			// database maybe.
-			m_sessionKey = K;
+		authenticated();
+		SendAuthProof(auth::AuthResult::Success);
 
-			// Handler method
-			std::weak_ptr<Player> weakThis{ shared_from_this() };
-			auto handler = [weakThis](bool success)
-			{
-				if (auto strongThis = weakThis.lock())
-				{
-					if (success)
-					{
-						// Add log entry about successful login as the hashes do indeed mach (and thus, so
-						// do the passwords)
-						ILOG("User " << strongThis->m_accountName << " successfully authenticated");
-
-						// If the login attempt succeeded, then we will accept RealmList request packets from now
-						// on to send the realm list to the client on manual request
-						strongThis->RegisterPacketHandler(auth::client_login_packet::RealmList, *strongThis.get(), &Player::OnRealmList);
-						strongThis->SendAuthProof(auth::AuthResult::Success);
-
-						// Send the realm list as well
-						strongThis->SendRealmList();
-					}
-					else
-					{
-						strongThis->SendAuthProof(auth::AuthResult::FailDbBusy);
-					}
-				}
-			};
-
-			// Store session key in account database
-			m_database.asyncRequest<void>(
-				std::bind(&IDatabase::playerLogin, std::placeholders::_1, m_accountId, K.asHexStr(), m_address),
-				std::move(handler));
+		// Send the realm list as well
+		SendRealmList();
+	}
 
-			// Stop here since we wait for the database callback
-			return PacketParseResult::Pass;
-		}
-		else
-		{
-			// Log error
-			WLOG("Invalid password for account " << m_accountName);
-		}
+	void Player::authenticated()
+	{
+		m_authenticated = true;
+		m_manager.playerAuthenticated(*this);
 
-		// Send proof result
-		SendAuthProof(proofResult);
+		// If the login attempt succeeded, then we will accept RealmList request packets from now
+		// on to send the realm list to the client on manual request
+		RegisterPacketHandler(auth::client_login_packet::RealmList, *this, &Player::OnRealmList);
+	}
 
-		return PacketParseResult::Pass;
+	bool Player::readChallenge(auth::IncomingPacket & packet)
+	{
+		return (packet
+			>> io::read<uint8>(m_version1)
+			>> io::read<uint8>(m_version2)
+			>> io::read<uint8>(m_version3)
+			>> io::read<uint16>(m_build)
+			>> m_platform
+			>> m_system
+			>> m_locale
+			>> io::read_container<uint8>(m_accountName));
 	}
 
 	PacketParseResult Player::handleReconnectChallenge(auth::IncomingPacket & packet)
 	{
-		// No longer handle proof packet
+		// No longer handle these packets!
 		ClearPacketHandler(auth::client_login_packet::LogonChallenge);
 		ClearPacketHandler(auth::client_login_packet::ReconnectChallenge);
 
-		// TODO: Handle this packet properly
+		// Read the packet data
+		if (!readChallenge(packet))
+		{
+			return PacketParseResult::Disconnect;
+		}
+
+		ILOGF("Received reconnect challenge for account {}...", m_accountName);
+
+		// Only sessions which are known to this login server can be resumed, so neither the database nor
+		// the crypto workers are involved. Other clients have to do a full logon.
+		const auto session = m_sessions.get(m_accountName);
+		if (!session)
+		{
+			WLOG_RATE(10, "No session to reconnect to for account " << m_accountName);
+			SendReconnectChallenge(auth::auth_result::FailWrongCredentials);
+			return PacketParseResult::Pass;
+		}
+
+		m_accountId = session->accountId;
+		m_reconnectKey = session->sessionKeyData;
+		m_reconnectNonce = srp6::GenerateReconnectNonce();
 
 		// Handle reconnect proof packet now
-		RegisterPacketHandler(auth::client_login_packet::ReconnectProof, *this, &Player::handleLogonProof);
+		RegisterPacketHandler(auth::client_login_packet::ReconnectProof, *this, &Player::handleReconnectProof);
+		SendReconnectChallenge(auth::auth_result::Success);
 
-		return PacketParseResult::Disconnect;
+		return PacketParseResult::Pass;
 	}
 
 	PacketParseResult Player::handleReconnectProof(auth::IncomingPacket & packet)
 	{
-		// TODO: Handle this packet properly
+		// No longer handle proof packet
+		ClearPacketHandler(auth::client_login_packet::ReconnectProof);
 
-		// Handle realm list packet now
-		RegisterPacketHandler(auth::client_login_packet::RealmList, *this, &Player::OnRealmList);
+		// Read packet data
+		srp6::ReconnectNonce clientNonce;
+		HMACHash clientProof;
+		if (!(packet
+			>> io::read_range(clientNonce.begin(), clientNonce.end())
+			>> io::read_range(clientProof.begin(), clientProof.end())
+			))
+		{
+			return PacketParseResult::Disconnect;
+		}
 
-		return PacketParseResult::Disconnect;
+		// A single hash proves that the client knows the session key of its last login, so this is
+		// cheap enough to be done on the connection strand
+		if (!srp6::VerifyReconnectProof(m_accountName, clientNonce, m_reconnectNonce, m_reconnectKey, clientProof))
+		{
+			WLOGF("Invalid reconnect proof for account {}", m_accountName);
+			SendReconnectProof(auth::auth_result::FailWrongCredentials);
+			return PacketParseResult::Pass;
+		}
+
+		ILOGF("User {} successfully reconnected", m_accountName);
+
+		authenticated();
+		SendReconnectProof(auth::auth_result::Success);
+
+		// Send the realm list as well
+		SendRealmList();
+
+		return PacketParseResult::Pass;
 	}
 
 	PacketParseResult Player::OnRealmList(auth::IncomingPacket & packet)
 	{
-		// TODO: apply a rate limiter so the client cannot spam this packet (DDOS attack)
+		// Repeated requests only queue the shared realm list packet again, and a client which doesn't
+		// read its data is dropped by the send buffer limit
 
 		// Send the realm list with all currently connected realms in there
 		SendRealmList();
@@ -7,12 +7,15 @@
 #include "base/non_copyable.h"
 #include "auth_protocol/auth_protocol.h"
 #include "auth_protocol/auth_connection.h"
+#include "network/packet_dispatcher.h"
 #include "base/signal.h"
 #include "base/big_number.h"
+#include "base/srp6.h"
 
 #include <memory>
 #include <functional>
-#include <map>
+#include <optional>
+#include <vector>
 #include <cassert>
 
 
@@ -20,6 +23,9 @@ namespace mmo
 {
 	class AsyncDatabase;
 	class RealmManager;
+	class WorkerPool;
+	class SessionTable;
+	class WriteBehindQueue;
 
 
 	/// This class represents a player connction on the login server.
@@ -37,6 +43,9 @@ namespace mmo
 			PlayerManager &manager,
 			RealmManager &realmManager,
 			AsyncDatabase &database,
+			WorkerPool &cryptoWorkers,
+			SessionTable &sessions,
+			WriteBehindQueue &sessionWriter,
 			std::shared_ptr<Client> connection,
 			const std::string &address);
 
@@ -46,7 +55,7 @@ namespace mmo
 		inline PlayerManager &getManager() const { return m_manager; }
 		/// Determines whether the player is authentificated.
 		/// @returns true if the player is authentificated.
-		inline bool isAuthentificated() const { return false;/* (getSession() != nullptr);*/ }
+		inline bool isAuthentificated() const { return m_authenticated; }
 		/// Gets the account name the player is logged in with.
 		inline const std::string &getAccountName() const { return m_accountName; }
 		/// 
@@ -72,6 +81,12 @@ namespace mmo
 		PlayerManager &m_manager;
 		RealmManager &m_realmManager;
 		AsyncDatabase &m_database;
+		/// Executes the srp6 math so that logins don't block the network threads.
+		WorkerPool &m_cryptoWorkers;
+		/// Authoritative session keys of all logged in accounts.
+		SessionTable &m_sessions;
+		/// Writes session keys to the account database in the background.
+		WriteBehindQueue &m_sessionWriter;
 		std::shared_ptr<Client> m_connection;
 		std::string m_address;						// IP address in string format
 		std::string m_accountName;						// Account name in uppercase letters
@@ -83,16 +98,20 @@ namespace mmo
 		uint8 m_version3;						// Patch version: 0.0.X.00000
 		uint16 m_build;							// Build version: 0.0.0.XXXXX
 		uint32 m_accountId;						// Account ID
-		std::map<uint8, PacketHandler> m_packetHandlers;
-		std::mutex m_packetHandlerMutex;
+		bool m_authenticated;					// Whether the logon proof succeeded
+		/// Handlers of the packets which are expected in the current login step. Crypto worker and database
+		/// results swap them after posting themselves to the connection strand, so they need no mutex.
+		PacketDispatcher<auth::IncomingPacket, auth::client_login_packet::Count_> m_packetHandlers;
 
 	private:
 		BigNumber m_sessionKey;
 		BigNumber m_s, m_v;
 		BigNumber m_b, m_B;
 		BigNumber m_unk3;
-		BigNumber m_reconnectProof;
-		BigNumber m_reconnectKey;
+		/// Nonce sent with a reconnect challenge, which the reconnect proof has to include.
+		srp6::ReconnectNonce m_reconnectNonce;
+		/// Session key bytes of the last login of a reconnecting account.
+		std::vector<uint8> m_reconnectKey;
 		SHA1Hash m_m2;
 
 		/// Number of bytes used to store m_s.
@@ -111,9 +130,24 @@ namespace mmo
 		PacketParseResult connectionPacketReceived(auth::IncomingPacket &packet) override;
 
 	private:
+		void SendLogonChallenge(auth::AuthResult result);
 		void SendAuthProof(auth::AuthResult result);
+		void SendReconnectChallenge(auth::AuthResult result);
+		void SendReconnectProof(auth::AuthResult result);
 		void SendRealmList();
 
+	private:
+		/// Called on the connection strand when the crypto workers calculated the server challenge.
+		void logonChallengeComputed(BigNumber b, BigNumber B);
+		/// Called on the connection strand when the crypto workers verified the client proof.
+		/// @param result The session key and M2 hash or an empty value if the proof was invalid.
+		void logonProofComputed(std::optional<srp6::ServerProof> result);
+		/// Marks the player as authenticated and enables the realm list after a successful logon or reconnect.
+		void authenticated();
+		/// Reads the client information and the account name, which both challenge packets start with.
+		/// @returns false if the packet is malformed.
+		bool readChallenge(auth::IncomingPacket &packet);
+
 	private:
 
 		/// Handles an incoming packet with packet id LogonChallenge.
@@ -122,10 +156,10 @@ namespace mmo
 		/// Handles an incoming packet with packet id LogonProof.
 		/// @param packet The packet data.
 		PacketParseResult handleLogonProof(auth::IncomingPacket &packet);
-		/// Handles an incoming packet with packet id LogonChallenge.
+		/// Handles an incoming packet with packet id ReconnectChallenge.
 		/// @param packet The packet data.
 		PacketParseResult handleReconnectChallenge(auth::IncomingPacket &packet);
-		/// Handles an incoming packet with packet id LogonProof.
+		/// Handles an incoming packet with packet id ReconnectProof.
 		/// @param packet The packet data.
 		PacketParseResult handleReconnectProof(auth::IncomingPacket &packet);
 		/// Handles an incoming packet with packet id RealmList.
@@ -3,13 +3,15 @@
 #include "player_manager.h"
 #include "player.h"
 #include "binary_io/string_sink.h"
+
 #include <cassert>
 
 namespace mmo
 {
 	PlayerManager::PlayerManager(
 	    size_t playerCapacity)
-		: m_playerCapacity(playerCapacity)
+		: m_playerCount(0)
+		, m_playerCapacity(playerCapacity)
 	{
 	}
 
@@ -20,75 +22,57 @@ namespace mmo
 	void PlayerManager::playerDisconnected(
 		Player &player)
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-
-		const auto p = std::find_if(
-		                   m_players.begin(),
-		                   m_players.end(),
-		                   [&player](const std::shared_ptr<Player> &p)
+		// Only remove the account indices if they still refer to this player and not to a newer
+		// login of the same account
+		if (player.isAuthentificated())
 		{
-			return (&player == p.get());
-		});
-		assert(p != m_players.end());
-		m_players.erase(p);
+			m_playersByAccountName.erase(player.getAccountName(), &player);
+			m_playersByAccountId.erase(player.getAccountId(), &player);
+		}
+
+		const bool removed = m_players.erase(&player);
+		assert(removed);
+		(void)removed;
+
+		--m_playerCount;
+	}
+
+	void PlayerManager::playerAuthenticated(
+		Player &player)
+	{
+		m_playersByAccountName.set(player.getAccountName(), &player);
+		m_playersByAccountId.set(player.getAccountId(), &player);
 	}
 	
 	bool PlayerManager::hasPlayerCapacityBeenReached()
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-		return m_players.size() >= m_playerCapacity;
+		return m_playerCount >= m_playerCapacity;
 	}
 
 	void PlayerManager::addPlayer(
 		std::shared_ptr<Player> added)
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-
 		assert(added);
-		m_players.push_back(std::move(added));
+
+		const Player *const key = added.get();
+		m_players.set(key, std::move(added));
+		++m_playerCount;
 	}
 
 	Player * PlayerManager::getPlayerByAccountName(
 		const String &accountName)
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-
-		const auto p = std::find_if(
-			m_players.begin(),
-			m_players.end(),
-			[&accountName](const std::shared_ptr<Player> &p)
-		{
-			return (p->isAuthentificated() &&
-				accountName == p->getAccountName());
-		});
-
-		if (p != m_players.end())
-		{
-			return (*p).get();
-		}
-
-		return nullptr;
+		return m_playersByAccountName.get(accountName).value_or(nullptr);
 	}
 
 	Player * PlayerManager::getPlayerByAccountID(
 		uint32 accountId)
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-
-		const auto p = std::find_if(
-			m_players.begin(),
-			m_players.end(),
-			[accountId](const std::shared_ptr<Player> &p)
-		{
-			return (p->isAuthentificated() &&
-				accountId == p->getAccountId());
-		});
-
-		if (p != m_players.end())
-		{
-			return (*p).get();
-		}
+		return m_playersByAccountId.get(accountId).value_or(nullptr);
+	}
 
-		return nullptr;
+	size_t PlayerManager::getPlayerCount() const
+	{
+		return m_playerCount;
 	}
 }
@@ -4,21 +4,20 @@
 
 #include "base/typedefs.h"
 #include "base/non_copyable.h"
+#include "base/sharded_map.h"
+#include <atomic>
 #include <memory>
-#include <mutex>
-#include <list>
 
 namespace mmo
 {
 	class Player;
 
-	/// Manages all connected players.
+	/// Manages all connected players. Players are indexed by their connection and, once they are
+	/// authenticated, by their account name and id. The indices are hash maps which are split into
+	/// independently locked shards, so that network threads adding, removing and looking up players
+	/// rarely contend and no operation has to visit other players.
 	class PlayerManager final : public NonCopyable
 	{
-	public:
-
-		typedef std::list<std::shared_ptr<Player>> Players;
-
 	public:
 
 		/// Initializes a new instance of the player manager class.
@@ -31,19 +30,26 @@ namespace mmo
 		/// Notifies the manager that a player has been disconnected which will
 		/// delete the player instance.
 		void playerDisconnected(Player &player);
+		/// Notifies the manager that a player has been authenticated, which makes it available for
+		/// lookups by account name and id. A previous player of the same account is replaced.
+		void playerAuthenticated(Player &player);
 		/// Determines whether the player capacity limit has been reached.
 		bool hasPlayerCapacityBeenReached();
 		/// Adds a new player instance to the manager.
 		void addPlayer(std::shared_ptr<Player> added);
-		/// Gets a player by his account name.
+		/// Gets an authenticated player by his account name.
 		Player *getPlayerByAccountName(const String &accountName);
-		/// 
+		/// Gets an authenticated player by his account id.
 		Player *getPlayerByAccountID(uint32 accountId);
+		/// Gets the number of connected players.
+		size_t getPlayerCount() const;
 
 	private:
 
-		Players m_players;
+		ShardedMap<const Player*, std::shared_ptr<Player>, PointerHash> m_players;
+		ShardedMap<String, Player*> m_playersByAccountName;
+		ShardedMap<uint64, Player*> m_playersByAccountId;
+		std::atomic<size_t> m_playerCount;
 		size_t m_playerCapacity;
-		std::mutex m_playerMutex;
 	};
 }
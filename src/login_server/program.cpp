@@ -8,6 +8,8 @@
 #include "player.h"
 #include "realm_manager.h"
 #include "realm.h"
+#include "session_table.h"
+#include "write_behind_queue.h"
 
 #include "asio.hpp"
 
@@ -16,7 +18,11 @@
 #include "log/default_log_levels.h"
 #include "auth_protocol/auth_protocol.h"
 #include "auth_protocol/auth_server.h"
+#include "network/io_service_pool.h"
+#include "network/packet_statistics.h"
 #include "base/constants.h"
+#include "base/clock.h"
+#include "base/worker_pool.h"
 
 #include <fstream>
 #include <sstream>
@@ -35,7 +41,7 @@ namespace mmo
 
 	namespace
 	{
-		static std::string generateLogFileName(const std::string &prefix)
+		static std::string generateLogFileName(const std::string &prefix, const char *extension)
 		{
 			std::ostringstream logFileNameStrm;
 			logFileNameStrm << prefix << "_";
@@ -44,7 +50,7 @@ namespace mmo
 			logFileNameStrm
 				<< std::put_time(std::localtime(&timeT), "%Y-%b-%d_%H-%M-%S")
 				<< logFileNameStrm.widen(' ')
-				<< ".log";
+				<< extension;
 
 			// Try to create log directory if not existing yet
 			std::filesystem::create_directories(
@@ -52,6 +58,23 @@ namespace mmo
 
 			return logFileNameStrm.str();
 		}
+
+		/// Checks the connection of a database on its worker thread every interval, so that idle connections
+		/// are not closed by the mysql server and lost connections are reestablished before a request needs them.
+		static void ScheduleDatabaseKeepAlive(std::shared_ptr<asio::steady_timer> timer, MySQLDatabase &database, std::chrono::seconds interval)
+		{
+			timer->expires_after(interval);
+			timer->async_wait([timer, &database, interval](const asio::error_code &error)
+			{
+				if (error)
+				{
+					return;
+				}
+
+				database.keepAlive();
+				ScheduleDatabaseKeepAlive(timer, database, interval);
+			});
+		}
 	}
 
 	int32 Program::run()
@@ -59,11 +82,8 @@ namespace mmo
 		// This is the main ioService object
 		asio::io_service ioService;
 
-		// The database service object and keep-alive object
-		asio::io_service dbService;
-
-		// Keep the database service alive / busy until this object is alive
-		auto dbWork = std::make_shared<asio::io_context::work>(dbService);
+		// Keep the main service alive as well, since connections are served by the network threads
+		asio::io_context::work work{ ioService };
 
 
 
@@ -90,8 +110,66 @@ namespace mmo
 			logOptions.alwaysFlush = !config.isLogFileBuffering;
 
 			// Setup the log file connection after opening the log file
-			m_logFile.open(generateLogFileName(config.logFileName).c_str(), std::ios::app);
-			if (m_logFile)
+			if (config.isLogBinary)
+			{
+				m_logFile.open(generateLogFileName(config.logFileName, ".mlog").c_str(), std::ios::app | std::ios::binary);
+			}
+			else
+			{
+				m_logFile.open(generateLogFileName(config.logFileName, ".log").c_str(), std::ios::app);
+			}
+
+			if (m_logFile && config.isLogBinary)
+			{
+				// Records are encoded on the writer thread, without any text formatting
+				const bool flushBatches = logOptions.alwaysFlush;
+				m_binaryLog = std::make_unique<BinaryLogWriter>(m_logFile);
+
+				m_logSink = std::make_unique<AsyncLogSink>(
+					[this](const LogEntry & entry)
+				{
+					m_binaryLog->write(entry);
+				},
+					[this, flushBatches]()
+				{
+					if (flushBatches)
+					{
+						m_logFile.flush();
+					}
+				});
+
+				genericLogConnection = g_DefaultLog.signal().connect(
+					[this](const LogEntry & entry)
+				{
+					m_logSink->push(entry);
+				});
+			}
+			else if (m_logFile && config.isLogAsync)
+			{
+				// Write on a background thread and flush once per batch instead of once per entry
+				const bool flushBatches = logOptions.alwaysFlush;
+				logOptions.alwaysFlush = false;
+
+				m_logSink = std::make_unique<AsyncLogSink>(
+					[this, logOptions](const LogEntry & entry)
+				{
+					printLogEntry(m_logFile, entry, logOptions);
+				},
+					[this, flushBatches]()
+				{
+					if (flushBatches)
+					{
+						m_logFile.flush();
+					}
+				});
+
+				genericLogConnection = g_DefaultLog.signal().connect(
+					[this](const LogEntry & entry)
+				{
+					m_logSink->push(entry);
+				});
+			}
+			else if (m_logFile)
 			{
 				genericLogConnection = g_DefaultLog.signal().connect(
 					[this, logOptions](const LogEntry & entry)
@@ -105,28 +183,103 @@ namespace mmo
 		ILOG("Version " << Major << "." << Minor << "." << Build << "." << Revision << " (Commit: " << GitCommit << ")");
 		ILOG("Last Change: " << GitLastChange);
 
+		// Read the monotonic clock from the cpu time stamp counter if requested
+		if (config.isTscClockEnabled)
+		{
+			if (EnableTscClock())
+			{
+				ILOG("Using the cpu time stamp counter as monotonic clock");
+			}
+			else
+			{
+				WLOG("The cpu has no invariant time stamp counter, using the operating system clock");
+			}
+		}
+
 
 
 		/////////////////////////////////////////////////////////////////////////////////////////////////
 		// Database setup
 		/////////////////////////////////////////////////////////////////////////////////////////////////
 
-		auto database = std::make_unique<MySQLDatabase>(mmo::mysql::DatabaseInfo{
-			config.mysqlHost, 
+		// Every database worker thread runs its own io service and owns a mysql connection, so that requests
+		// of different accounts don't wait for each other
+		IoServicePool databaseServices{ config.mysqlConnections };
+
+		std::vector<std::unique_ptr<MySQLDatabase>> databases;
+		std::vector<AsyncDatabase::Worker> databaseWorkers;
+		for (size_t i = 0; i < databaseServices.size(); ++i)
+		{
+			auto database = std::make_unique<MySQLDatabase>(mmo::mysql::DatabaseInfo{
+				config.mysqlHost, 
+				config.mysqlPort,
+				config.mysqlUser, 
+				config.mysqlPassword, 
+				config.mysqlDatabase 
+			});
+			if (!database->load())
+			{
+				ELOG("Could not load the database");
+				return 1;
+			}
+
+			asio::io_service &databaseService = databaseServices.getService(i);
+			databaseWorkers.push_back({ database.get(), [&databaseService](const Action &action) { databaseService.post(action); } });
+			databases.push_back(std::move(database));
+		}
+
+		const auto sync = [&ioService](Action action) { ioService.post(std::move(action)); };
+		AsyncDatabase asyncDatabase{ std::move(databaseWorkers), sync };
+
+		// Check idle connections periodically on their worker threads
+		std::vector<std::shared_ptr<asio::steady_timer>> keepAliveTimers;
+		if (config.mysqlKeepAliveInterval > 0)
+		{
+			for (size_t i = 0; i < databases.size(); ++i)
+			{
+				keepAliveTimers.push_back(std::make_shared<asio::steady_timer>(databaseServices.getService(i)));
+				ScheduleDatabaseKeepAlive(keepAliveTimers.back(), *databases[i], std::chrono::seconds(config.mysqlKeepAliveInterval));
+			}
+		}
+
+		// Session keys of logins are written in batches by a connection of their own, while the session table
+		// serves them in the meantime
+		MySQLDatabase sessionDatabase{ mmo::mysql::DatabaseInfo{
+			config.mysqlHost,
 			config.mysqlPort,
-			config.mysqlUser, 
-			config.mysqlPassword, 
-			config.mysqlDatabase 
-		});
-		if (!database->load())
+			config.mysqlUser,
+			config.mysqlPassword,
+			config.mysqlDatabase
+		} };
+		if (!sessionDatabase.load())
 		{
 			ELOG("Could not load the database");
 			return 1;
 		}
 
-		const auto async = [&dbService](Action action) { dbService.post(std::move(action)); };
-		const auto sync = [&ioService](Action action) { ioService.post(std::move(action)); };
-		AsyncDatabase asyncDatabase{ *database, async, sync };
+		// Sessions stay in the table until they have been written, and are evicted by its limits afterwards
+		SessionTable sessions{ config.sessionTableSize, std::chrono::seconds(config.sessionTableTtl) };
+		WriteBehindQueue sessionWriter{ sessionDatabase, std::chrono::milliseconds(config.mysqlWriteBehindInterval),
+			[&sessions](const std::vector<PlayerLoginUpdate> &updates)
+			{
+				for (const auto &update : updates)
+				{
+					sessions.sessionWritten(update.accountName, update.sessionKey);
+				}
+			} };
+
+
+
+		/////////////////////////////////////////////////////////////////////////////////////////////////
+		// Network service setup
+		/////////////////////////////////////////////////////////////////////////////////////////////////
+
+		// Each network thread runs its own io service with its own acceptor per server
+		IoServicePool networkServices{ config.networkThreads };
+
+		// The srp6 math of logins is calculated by these threads, so that a login storm does not
+		// stall the network threads
+		WorkerPool cryptoWorkers{ config.cryptoThreads, config.cryptoQueueLimit };
 
 
 
@@ -140,7 +293,7 @@ namespace mmo
 		std::unique_ptr<auth::Server> realmServer;
 		try
 		{
-			realmServer.reset(new auth::Server(std::ref(ioService), constants::DefaultLoginRealmPort, std::bind(&auth::Connection::create, std::ref(ioService), nullptr)));
+			realmServer.reset(new auth::Server(networkServices.getServices(), constants::DefaultLoginRealmPort, std::bind(&auth::Connection::create, std::placeholders::_1, nullptr), config.listenBacklog));
 		}
 		catch (const BindFailedException &)
 		{
@@ -149,7 +302,7 @@ namespace mmo
 		}
 
 		// Careful: Called by multiple threads!
-		const auto createRealm = [&realmManager, &asyncDatabase](std::shared_ptr<Realm::Client> connection)
+		const auto createRealm = [&realmManager, &asyncDatabase, &sessions, &sessionWriter](std::shared_ptr<Realm::Client> connection)
 		{
 			asio::ip::address address;
 
@@ -163,7 +316,7 @@ namespace mmo
 				return;
 			}
 
-			auto realm = std::make_shared<Realm>(realmManager, asyncDatabase, connection, address.to_string());
+			auto realm = std::make_shared<Realm>(realmManager, asyncDatabase, sessions, sessionWriter, connection, address.to_string());
 			ILOG("Incoming realm connection from " << address);
 			realmManager.AddRealm(std::move(realm));
 
@@ -186,7 +339,7 @@ namespace mmo
 		std::unique_ptr<auth::Server> playerServer;
 		try
 		{
-			playerServer.reset(new mmo::auth::Server(std::ref(ioService), constants::DefaultLoginPlayerPort, std::bind(&mmo::auth::Connection::create, std::ref(ioService), nullptr)));
+			playerServer.reset(new mmo::auth::Server(networkServices.getServices(), constants::DefaultLoginPlayerPort, std::bind(&mmo::auth::Connection::create, std::placeholders::_1, nullptr), config.listenBacklog));
 		}
 		catch (const mmo::BindFailedException &)
 		{
@@ -194,8 +347,16 @@ namespace mmo
 			return 1;
 		}
 		
+		// Limit the amount of outgoing data a player may let pile up by not reading it
+		const SendWatermarks sendWatermarks{
+			config.sendHighWatermark,
+			std::min(config.sendLowWatermark, config.sendHighWatermark),
+			config.sendBufferLimit == 0 ? 0 : std::max(config.sendBufferLimit, config.sendHighWatermark),
+			config.isPauseOnCongestionEnabled,
+			std::chrono::milliseconds(config.slowConsumerTimeout) };
+
 		// Careful: Called by multiple threads!
-		const auto createPlayer = [&playerManager, &realmManager, &asyncDatabase](std::shared_ptr<Player::Client> connection)
+		const auto createPlayer = [&sendWatermarks, &playerManager, &realmManager, &asyncDatabase, &cryptoWorkers, &sessions, &sessionWriter, &config](std::shared_ptr<Player::Client> connection)
 		{
 			asio::ip::address address;
 
@@ -209,10 +370,17 @@ namespace mmo
 				return;
 			}
 
-			auto player = std::make_shared<Player>(playerManager, realmManager, asyncDatabase, connection, address.to_string());
+			auto player = std::make_shared<Player>(playerManager, realmManager, asyncDatabase, cryptoWorkers, sessions, sessionWriter, connection, address.to_string());
 			ILOG("Incoming player connection from " << address);
 			playerManager.addPlayer(std::move(player));
 
+			if (config.isCorkEnabled)
+			{
+				connection->setCorked(true, std::chrono::microseconds(config.corkLatency));
+			}
+
+			connection->setSendWatermarks(sendWatermarks);
+
 			// Now we can start receiving data
 			connection->startReceiving();
 		};
@@ -235,34 +403,53 @@ namespace mmo
 		// Launch worker threads
 		/////////////////////////////////////////////////////////////////////////////////////////////////
 
-		// Create worker threads to process networking asynchronously (may be 0 as well)
-		const auto maxNetworkThreads = 1u;
-		ILOG("Running with " << maxNetworkThreads + 1 << " network threads");
-
-		// Eventually generate worker threads
-		std::vector<std::thread> networkThreads{ maxNetworkThreads };
-		if (maxNetworkThreads > 0)
+		// Periodically log per op code packet statistics if enabled
+		std::unique_ptr<PacketStatisticsReporter> packetStatsReporter;
+		if (config.packetStatsInterval > 0)
 		{
-			std::generate_n(networkThreads.begin(), maxNetworkThreads, [&ioService]() {
-				return std::thread{ [&ioService] { ioService.run(); } };
-			});
+			ILOG("Logging packet statistics every " << config.packetStatsInterval << " seconds");
+			packetStatsReporter = std::make_unique<PacketStatisticsReporter>(ioService, std::chrono::seconds(config.packetStatsInterval));
 		}
 
-		// Run the database service thread
-		std::thread dbThread{ [&dbService]() { dbService.run(); } };
+		// Create one thread per network io service
+		ILOG("Running with " << networkServices.size() << " network threads (" << playerServer->getAcceptorCount() << " acceptors per port) and " << cryptoWorkers.size() << " crypto threads");
+		networkServices.run();
+
+		// Run the database worker threads
+		ILOG("Running with " << databaseServices.size() << " database connections");
+		databaseServices.run();
 
-		// Also run the io service on the main thread as well
+		// Run the main io service on the main thread, which processes database results
 		ioService.run();
 
-		// Wait for network threads to finish execution
-		for (auto& thread : networkThreads)
+		// Stop the network threads and wait for them to finish execution
+		networkServices.stop();
+		networkServices.join();
+
+		// Finish pending login calculations, their results are dropped with the network services
+		cryptoWorkers.stop();
+
+		const WorkerPoolStats cryptoStats = cryptoWorkers.getStats();
+		if (cryptoStats.rejectedTasks > 0)
 		{
-			thread.join();
+			WLOG("Rejected " << cryptoStats.rejectedTasks << " of " << (cryptoStats.acceptedTasks + cryptoStats.rejectedTasks) << " login calculations because the crypto threads were busy (peak queue size: " << cryptoStats.peakQueueSize << ")");
 		}
 
-		// Terminate the database worker and wait for pending database operations to finish
-		dbWork.reset();
-		dbThread.join();
+		// Write all pending session keys before the server goes down
+		if (sessionWriter.stop())
+		{
+			const WriteBehindStats sessionStats = sessionWriter.getStats();
+			ILOG("Wrote " << sessionStats.writtenUpdates << " login session updates in " << sessionStats.batches << " batches ("
+				<< sessionStats.coalescedUpdates << " coalesced, " << sessionStats.failedBatches << " failed batches retried)");
+		}
+
+		// Terminate the database workers and wait for pending database operations to finish
+		for (const auto &timer : keepAliveTimers)
+		{
+			asio::post(timer->get_executor(), [timer]() { timer->cancel(); });
+		}
+		databaseServices.release();
+		databaseServices.join();
 
 		return 0;
 	}
@@ -2,8 +2,11 @@
 
 #include "realm.h"
 #include "database.h"
+#include "session_table.h"
+#include "write_behind_queue.h"
 
 #include "base/constants.h"
+#include "base/srp6.h"
 #include "base/sha1.h"
 #include "base/clock.h"
 #include "base/weak_ptr_function.h"
@@ -17,10 +20,14 @@ namespace mmo
 	Realm::Realm(
 		RealmManager& realmManager, 
 		AsyncDatabase& database, 
+		SessionTable& sessions,
+		WriteBehindQueue& sessionWriter,
 		std::shared_ptr<Client> connection, 
 		const String & address)
 		: m_manager(realmManager)
 		, m_database(database)
+		, m_sessions(sessions)
+		, m_sessionWriter(sessionWriter)
 		, m_connection(std::move(connection))
 		, m_address(address)
 		, m_authenticated(false)
@@ -35,6 +42,7 @@ namespace mmo
 
 	void Realm::Destroy()
 	{
+		// The realm manager updates the realm list when the realm is removed
 		m_authenticated = false;
 
 		m_connection->resetListener();
@@ -57,28 +65,15 @@ namespace mmo
 
 	PacketParseResult Realm::connectionPacketReceived(auth::IncomingPacket & packet)
 	{
-		const auto packetId = packet.GetId();
-		bool isValid = true;
-
-		PacketHandler handler = nullptr;
-
+		// Execute the packet handler if it is currently enabled and return the result
+		PacketParseResult result = PacketParseResult::Disconnect;
+		if (!m_packetHandlers.dispatch(packet, result))
 		{
-			// Lock packet handler access
-			std::scoped_lock lock{ m_packetHandlerMutex };
-
-			// Check for packet handlers
-			auto handlerIt = m_packetHandlers.find(packetId);
-			if (handlerIt == m_packetHandlers.end())
-			{
-				WLOG("Packet 0x" << std::hex << (uint16)packetId << " is either unhandled or simply currently not handled");
-				return PacketParseResult::Disconnect;
-			}
-
-			handler = handlerIt->second;
+			WLOG("Packet 0x" << std::hex << (uint16)packet.GetId() << " is either unhandled or simply currently not handled");
+			return PacketParseResult::Disconnect;
 		}
 
-		// Execute the packet handler and return the result
-		return handler(packet);
+		return result;
 	}
 
 	void Realm::SendAuthProof(auth::AuthResult result)
@@ -100,62 +95,142 @@ namespace mmo
 		});
 	}
 
-	void Realm::SendAuthSessionResult(uint64 requestId, auth::AuthResult result, uint64 accountId, BigNumber sessionKey)
+	void Realm::SendAuthSessionResults(const std::vector<ClientAuthSessionResult> &results, bool batched)
 	{
-		if (result == auth::auth_result::Success)
+		for (const auto &result : results)
 		{
-			// Hash matched, client has a valid session key and thus is able to sign in on the realm
-			ILOG("Client successfully signed in on realm " << m_realmName << "...");
-		}
-		else
-		{
-			// Warn about this, as this might mean that someone is trying to log in on a realm without 
-			// having a valid session key.
-			WLOG("Auth session hash mismatch, client could not sign in on realm " << m_realmName << "!");
+			if (result.result == auth::auth_result::Success)
+			{
+				// Hash matched, client has a valid session key and thus is able to sign in on the realm
+				ILOG("Client successfully signed in on realm " << m_realmName << "...");
+			}
+			else
+			{
+				// Warn about this, as this might mean that someone is trying to log in on a realm without 
+				// having a valid session key.
+				WLOG_RATE(10, "Auth session hash mismatch, client could not sign in on realm " << m_realmName << "!");
+			}
 		}
 
-		// Send response packet to the realm server
-		m_connection->sendSinglePacket([requestId, result, accountId, &sessionKey](auth::OutgoingPacket& packet) {
-			packet.Start(auth::login_realm_packet::ClientAuthSessionResponse);
+		const auto writeResult = [](auth::OutgoingPacket &packet, const ClientAuthSessionResult &result)
+		{
 			packet
-				<< io::write<uint64>(requestId)
-				<< io::write<uint8>(result);
+				<< io::write<uint64>(result.requestId)
+				<< io::write<uint8>(result.result);
 
-			if (result == auth::auth_result::Success)
+			if (result.result == auth::auth_result::Success)
 			{
 				packet
-					<< io::write<uint64>(accountId)
-					<< io::write_dynamic_range<uint16>(sessionKey.asByteArray());
+					<< io::write<uint64>(result.accountId)
+					<< io::write_dynamic_range<uint16>(result.sessionKey.asByteArray());
 			}
+		};
 
-			packet.Finish();
-		});
+		// Send response packet to the realm server
+		if (batched)
+		{
+			m_connection->sendSinglePacket([&results, &writeResult](auth::OutgoingPacket& packet) {
+				packet.Start(auth::login_realm_packet::ClientAuthSessionBatchResponse);
+				packet << io::write<uint16>(results.size());
+				for (const auto &result : results)
+				{
+					writeResult(packet, result);
+				}
+				packet.Finish();
+			});
+			return;
+		}
+
+		for (const auto &result : results)
+		{
+			m_connection->sendSinglePacket([&result, &writeResult](auth::OutgoingPacket& packet) {
+				packet.Start(auth::login_realm_packet::ClientAuthSessionResponse);
+				writeResult(packet, result);
+				packet.Finish();
+			});
+		}
 	}
 
-	void Realm::RegisterPacketHandler(uint8 opCode, PacketHandler && handler)
+	Realm::ClientAuthSessionResult Realm::VerifyClientAuthSession(const ClientAuthSessionRequest &request, const AccountSessionKey &session)
 	{
-		std::scoped_lock lock{ m_packetHandlerMutex };
-
-		auto it = m_packetHandlers.find(opCode);
-		if (it == m_packetHandlers.end())
+		if (!session)
 		{
-			m_packetHandlers.emplace(std::make_pair(opCode, std::forward<PacketHandler>(handler)));
+			return ClientAuthSessionResult{ request.requestId, auth::auth_result::FailWrongCredentials, 0, BigNumber() };
 		}
-		else
+
+		// Reconstruct the client hash to verify that the data sent is valid
+		const BigNumber sessionKey{ session->second };
+		HashGeneratorSha1 gen;
+		gen.update(request.accountName.data(), request.accountName.length());
+		gen.update(request.serverSeed);
+		gen.update(request.clientSeed);
+		Sha1_Add_BigNumbers(gen, { sessionKey });
+		const SHA1Hash checkHash = gen.finalize();
+
+		// Verify that both hashes match
+		if (checkHash != request.clientHash)
 		{
-			it->second = std::forward<PacketHandler>(handler);
+			return ClientAuthSessionResult{ request.requestId, auth::auth_result::FailNoAccess, 0, BigNumber() };
 		}
+
+		return ClientAuthSessionResult{ request.requestId, auth::auth_result::Success, session->first, sessionKey };
 	}
 
-	void Realm::ClearPacketHandler(uint8 opCode)
+	void Realm::VerifyClientAuthSessions(std::vector<ClientAuthSessionRequest> requests, bool batched)
 	{
-		std::scoped_lock lock{ m_packetHandlerMutex };
+		std::vector<ClientAuthSessionResult> results;
+		results.reserve(requests.size());
+
+		// The session table knows the latest session key of every account which logged in recently, which
+		// might not have been written to the database yet
+		std::vector<ClientAuthSessionRequest> missing;
+		std::vector<std::string> missingAccountNames;
+		for (auto &request : requests)
+		{
+			if (const auto session = m_sessions.get(request.accountName))
+			{
+				results.push_back(VerifyClientAuthSession(request, std::make_pair(session->accountId, session->sessionKey)));
+				continue;
+			}
+
+			missingAccountNames.push_back(request.accountName);
+			missing.push_back(std::move(request));
+		}
 
-		auto it = m_packetHandlers.find(opCode);
-		if (it != m_packetHandlers.end())
+		if (missing.empty())
 		{
-			m_packetHandlers.erase(it);
+			SendAuthSessionResults(results, batched);
+			return;
 		}
+
+		// Otherwise read all missing session keys with a single database request
+		std::weak_ptr<Realm> weakThis{ shared_from_this() };
+		auto handler = [weakThis, results, missing, batched](const std::vector<AccountSessionKey> &sessions)
+		{
+			if (auto strongThis = weakThis.lock())
+			{
+				std::vector<ClientAuthSessionResult> allResults = results;
+				for (size_t i = 0; i < missing.size(); ++i)
+				{
+					allResults.push_back(VerifyClientAuthSession(missing[i], i < sessions.size() ? sessions[i] : AccountSessionKey()));
+				}
+
+				strongThis->SendAuthSessionResults(allResults, batched);
+			}
+		};
+
+		const DatabaseKey accountKey{ missingAccountNames.front() };
+		m_database.asyncRequest(accountKey, bindToConnection(m_connection, std::move(handler)), &IDatabase::getAccountSessionKeys, std::move(missingAccountNames));
+	}
+
+	void Realm::RegisterPacketHandler(uint8 opCode, PacketHandler && handler)
+	{
+		m_packetHandlers.registerHandler(opCode, std::move(handler));
+	}
+
+	void Realm::ClearPacketHandler(uint8 opCode)
+	{
+		m_packetHandlers.clearHandler(opCode);
 	}
 
 	PacketParseResult Realm::HandleLogonChallenge(auth::IncomingPacket & packet)
@@ -200,7 +275,7 @@ namespace mmo
 					authResult = auth::auth_result::Success;
 
 					strongThis->m_b.setRand(19 * 8);
-					BigNumber gmod = constants::srp::g.modExp(strongThis->m_b, constants::srp::N);
+					BigNumber gmod = srp6::ModExpG(strongThis->m_b);
 					strongThis->m_B = ((strongThis->m_v * 3) + gmod) % constants::srp::N;
 
 					assert(gmod.getNumBytes() <= 32);
@@ -243,8 +318,8 @@ namespace mmo
 			}
 		};
 
-		// Execute
-		m_database.asyncRequest(std::move(handler), &IDatabase::getRealmAuthData, std::cref(m_realmName));
+		// Execute and handle the result on the connection strand
+		m_database.asyncRequest(m_realmName, bindToConnection(m_connection, std::move(handler)), &IDatabase::getRealmAuthData, std::cref(m_realmName));
 		return PacketParseResult::Pass;
 	}
 
@@ -274,101 +349,19 @@ namespace mmo
 			return PacketParseResult::Disconnect;
 		}
 		
-		// Build hash
-		SHA1Hash hash = Sha1_BigNumbers({ A, m_B });
-
-		// Calculate u and S
-		BigNumber u{ hash.data(), hash.size() };
-		BigNumber S = (A * (m_v.modExp(u, constants::srp::N))).modExp(m_b, constants::srp::N);
-
-		// Build t
-		const std::vector<uint8> t = S.asByteArray(32);
-		std::array<uint8, 16> t1;
-		for (size_t i = 0; i < t1.size(); ++i)
-		{
-			t1[i] = t[i * 2];
-		}
-		hash = sha1(reinterpret_cast<const char*>(t1.data()), t1.size());
-
-		std::array<uint8, 40> vK;
-		for (size_t i = 0; i < 20; ++i)
-		{
-			vK[i * 2] = hash[i];
-		}
-		for (size_t i = 0; i < 16; ++i)
-		{
-			t1[i] = t[i * 2 + 1];
-		}
-
-		hash = sha1(reinterpret_cast<const char*>(t1.data()), t1.size());
-		for (size_t i = 0; i < 20; ++i)
-		{
-			vK[i * 2 + 1] = hash[i];
-		}
-
-		BigNumber K{ vK.data(), vK.size() };
-
-		SHA1Hash h;
-		h = Sha1_BigNumbers({ constants::srp::N });
-		hash = Sha1_BigNumbers({ constants::srp::g });
-		for (size_t i = 0; i < h.size(); ++i)
-		{
-			h[i] ^= hash[i];
-		}
-
-		BigNumber t3{ h.data(), h.size() };
-
-		HashGeneratorSha1 sha;
-		Sha1_Add_BigNumbers(sha, { t3 });
-		const auto t4 = sha1(reinterpret_cast<const char*>(m_realmName.data()), m_realmName.size());
-		sha.update(reinterpret_cast<const char*>(t4.data()), t4.size());
-		Sha1_Add_BigNumbers(sha, { m_s, A, m_B, K });
-		hash = sha.finalize();
-
 		// Proof result which will be sent to the client
 		auth::AuthResult proofResult = auth::auth_result::FailWrongCredentials;
 
 		// Calculate M1 hash on server using values sent by the client and compare it against
 		// the M1 hash sent by the client to see if the passwords do match.
-		const BigNumber M1{ hash.data(), hash.size() };
-		auto sArr = M1.asByteArray(20);
-		if (std::equal(sArr.begin(), sArr.end(), rec_M1.begin()))
+		const auto proof = srp6::CalculateServerProof(m_realmName, m_s, m_v, m_b, m_B, A, rec_M1);
+		if (proof)
 		{
-			// Finish SRP6 by calculating the M2 hash value that is sent back to the client for
-			// verification as well.
-			m_m2 = Sha1_BigNumbers({ A, M1, K});
-
-			// Store the caluclated session key value internally for later use, also store it in the 
-			// database maybe.
-			m_sessionKey = K;
+			// Remember the M2 hash value that is sent back to the client for verification as well.
+			m_m2 = proof->M2;
 
-			// Handler method
-			std::weak_ptr<Realm> weakThis{ shared_from_this() };
-			auto handler = [weakThis](bool success)
-			{
-				if (auto strongThis = weakThis.lock())
-				{
-					if (success)
-					{
-						// Add log entry about successful login as the hashes do indeed mach (and thus, so
-						// do the passwords)
-						ILOG("Realm server " << strongThis->m_realmName << " successfully authenticated");
-						strongThis->m_authenticated = true;
-
-						// From here on, accept ClientAuthSession packets
-						strongThis->RegisterPacketHandler(auth::realm_login_packet::ClientAuthSession, *strongThis.get(), &Realm::OnClientAuthSession);
-
-						// If the login attempt succeeded, then we will accept RealmList request packets from now
-						// on to send the realm list to the client on manual request
-						//strongThis->RegisterPacketHandler(auth::client_packet::RealmList, std::bind(&Realm::HandleRealmList, strongThis.get(), std::placeholders::_1));
-						strongThis->SendAuthProof(auth::AuthResult::Success);
-					}
-					else
-					{
-						strongThis->SendAuthProof(auth::AuthResult::FailDbBusy);
-					}
-				}
-			};
+			// Store the caluclated session key value internally for later use
+			m_sessionKey = proof->sessionKey;
 
 			// Build version string for database (cast to uint16 as ostringstream would otherwise treat uint8
 			// numbers as ascii character letters!)
@@ -382,12 +375,24 @@ namespace mmo
 				<< "." 
 				<< m_build;
 
-			// Store session key in account database
-			m_database.asyncRequest<void>(
-				std::bind(&IDatabase::realmLogin, std::placeholders::_1, m_realmId, K.asHexStr(), m_address, versionBuilder.str()),
-				std::move(handler));
+			// Store the session key in the realm database in the background
+			m_sessionWriter.realmLogin(RealmLoginUpdate{ m_realmId, m_sessionKey.asHexStr(), m_address, versionBuilder.str() });
+
+			// Add log entry about successful login as the hashes do indeed mach (and thus, so
+			// do the passwords)
+			ILOG("Realm server " << m_realmName << " successfully authenticated");
+			m_authenticated = true;
+			m_manager.RealmAuthenticated(*this);
+
+			// From here on, accept ClientAuthSession packets
+			RegisterPacketHandler(auth::realm_login_packet::ClientAuthSession, *this, &Realm::OnClientAuthSession);
+			RegisterPacketHandler(auth::realm_login_packet::ClientAuthSessionBatch, *this, &Realm::OnClientAuthSessionBatch);
+
+			// If the login attempt succeeded, then we will accept RealmList request packets from now
+			// on to send the realm list to the client on manual request
+			//RegisterPacketHandler(auth::client_packet::RealmList, std::bind(&Realm::HandleRealmList, this, std::placeholders::_1));
+			SendAuthProof(auth::AuthResult::Success);
 
-			// Stop here since we wait for the database callback
 			return PacketParseResult::Pass;
 		}
 		else
@@ -405,67 +410,52 @@ namespace mmo
 	PacketParseResult Realm::OnClientAuthSession(auth::IncomingPacket & packet)
 	{
 		// Read the packet data
-		uint64 requestId;
-		std::string accountName;
-		uint32 clientSeed;
-		uint32 serverSeed;
-		SHA1Hash clientHash;
-
+		ClientAuthSessionRequest request;
 		if (!(packet
-			>> io::read<uint64>(requestId)
-			>> io::read_container<uint8>(accountName)
-			>> io::read<uint32>(clientSeed)
-			>> io::read<uint32>(serverSeed)
-			>> io::read_range(clientHash)))
+			>> io::read<uint64>(request.requestId)
+			>> io::read_container<uint8>(request.accountName)
+			>> io::read<uint32>(request.clientSeed)
+			>> io::read<uint32>(request.serverSeed)
+			>> io::read_range(request.clientHash)))
 		{
 			// Failed to read packet correctly, disconnect
 			return PacketParseResult::Disconnect;
 		}
 
-		// Database handler method will validate the client hash
-		std::weak_ptr<Realm> weakThis{ shared_from_this() };
-		auto handler = [weakThis, requestId, accountName, clientSeed, serverSeed, clientHash](std::optional<std::pair<uint64, std::string>> result)
-		{
-			if (auto strongThis = weakThis.lock())
-			{
-				// This will store the session key
-				BigNumber sessionKey;
+		std::vector<ClientAuthSessionRequest> requests;
+		requests.push_back(std::move(request));
+		VerifyClientAuthSessions(std::move(requests), false);
 
-				// The result that will be sent
-				auth::AuthResult authResult = auth::auth_result::Success;
-				if (result.has_value())
-				{
-					// Reconstruct the client hash to verify that the data sent is valid
-					HashGeneratorSha1 gen;
-					gen.update(accountName.data(), accountName.length());
-					gen.update(serverSeed);
-					gen.update(clientSeed);
-					Sha1_Add_BigNumbers(gen, { BigNumber(result->second) });
-					SHA1Hash checkHash = gen.finalize();
-
-					// Verify that both hashes match
-					if (checkHash != clientHash)
-					{
-						authResult = auth::auth_result::FailNoAccess;
-					}
-					else
-					{
-						// Store the session key on match
-						sessionKey.setHexStr(result->second);
-					}
-				}
-				else
-				{
-					authResult = auth::auth_result::FailWrongCredentials;
-				}
+		return PacketParseResult::Pass;
+	}
+
+	PacketParseResult Realm::OnClientAuthSessionBatch(auth::IncomingPacket & packet)
+	{
+		uint16 requestCount = 0;
+		if (!(packet >> io::read<uint16>(requestCount)) ||
+			requestCount == 0 ||
+			requestCount > auth::MaxClientAuthSessionBatchSize)
+		{
+			return PacketParseResult::Disconnect;
+		}
 
-				// Send the response
-				strongThis->SendAuthSessionResult(requestId, authResult, result->first, sessionKey);
+		// Read the packet data
+		std::vector<ClientAuthSessionRequest> requests(requestCount);
+		for (auto &request : requests)
+		{
+			if (!(packet
+				>> io::read<uint64>(request.requestId)
+				>> io::read_container<uint8>(request.accountName)
+				>> io::read<uint32>(request.clientSeed)
+				>> io::read<uint32>(request.serverSeed)
+				>> io::read_range(request.clientHash)))
+			{
+				// Failed to read packet correctly, disconnect
+				return PacketParseResult::Disconnect;
 			}
-		};
+		}
 
-		// Now do a database request by account name to retrieve the session key
-		m_database.asyncRequest(std::move(handler), &IDatabase::getAccountSessionKey, std::move(accountName));
+		VerifyClientAuthSessions(std::move(requests), true);
 
 		return PacketParseResult::Pass;
 	}
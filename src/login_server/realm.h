@@ -6,16 +6,21 @@
 #include "base/non_copyable.h"
 #include "auth_protocol/auth_protocol.h"
 #include "auth_protocol/auth_connection.h"
+#include "network/packet_dispatcher.h"
 #include "base/signal.h"
 #include "base/big_number.h"
+#include <atomic>
 #include <memory>
 #include <functional>
-#include <map>
+#include <optional>
+#include <vector>
 #include <cassert>
 
 namespace mmo
 {
 	class AsyncDatabase;
+	class SessionTable;
+	class WriteBehindQueue;
 
 	/// This class represents a realm connction on the login server.
 	class Realm final
@@ -31,6 +36,8 @@ namespace mmo
 		explicit Realm(
 			RealmManager &manager,
 			AsyncDatabase &database,
+			SessionTable &sessions,
+			WriteBehindQueue &sessionWriter,
 			std::shared_ptr<Client> connection,
 			const std::string &address);
 
@@ -69,6 +76,10 @@ namespace mmo
 	private:
 		RealmManager &m_manager;
 		AsyncDatabase &m_database;
+		/// Authoritative session keys of all logged in accounts.
+		SessionTable &m_sessions;
+		/// Writes session keys to the realm database in the background.
+		WriteBehindQueue &m_sessionWriter;
 		std::shared_ptr<Client> m_connection;
 		std::string m_address;					// IP address of the realm server in string format
 		std::string m_realmName;				// Realm name
@@ -79,8 +90,9 @@ namespace mmo
 		uint8 m_version3;						// Patch version: 0.0.X.00000
 		uint16 m_build;							// Build version: 0.0.0.XXXXX
 		uint32 m_realmId;						// Realm ID
-		std::map<uint8, PacketHandler> m_packetHandlers;
-		std::mutex m_packetHandlerMutex;
+		/// Handlers of the packets which are expected in the current realm login step. The database result of
+		/// the logon challenge registers the proof handler through bindToConnection, so no mutex is needed.
+		PacketDispatcher<auth::IncomingPacket, auth::realm_login_packet::Count_> m_packetHandlers;
 
 	private:
 		BigNumber m_sessionKey;
@@ -90,7 +102,8 @@ namespace mmo
 		BigNumber m_reconnectProof;
 		BigNumber m_reconnectKey;
 		SHA1Hash m_m2;
-		bool m_authenticated;
+		/// Read by other threads when the realm list is serialized.
+		std::atomic<bool> m_authenticated;
 
 		/// Number of bytes used to store m_s.
 		static constexpr int ByteCountS = 32;
@@ -107,11 +120,41 @@ namespace mmo
 		/// @copydoc wow::auth::IConnectionListener::connectionPacketReceived()
 		PacketParseResult connectionPacketReceived(auth::IncomingPacket &packet) override;
 
+	private:
+		/// Data of a ClientAuthSession request of the realm server.
+		struct ClientAuthSessionRequest final
+		{
+			uint64 requestId;
+			std::string accountName;
+			uint32 clientSeed;
+			uint32 serverSeed;
+			SHA1Hash clientHash;
+		};
+
+		/// Result of a ClientAuthSession request which is sent back to the realm server.
+		struct ClientAuthSessionResult final
+		{
+			uint64 requestId;
+			auth::AuthResult result;
+			uint64 accountId;
+			BigNumber sessionKey;
+		};
+
+		typedef std::optional<std::pair<uint64, std::string>> AccountSessionKey;
+
 	private:
 		/// Send auth proof result to the realm server.
 		void SendAuthProof(auth::AuthResult result);
-		/// Send the auth session result back to the realm server.
-		void SendAuthSessionResult(uint64 requestId, auth::AuthResult result, uint64 accountId, BigNumber sessionKey);
+		/// Send the auth session results back to the realm server.
+		/// @param batched Whether the results are sent in a single ClientAuthSessionBatchResponse packet instead
+		///        of one ClientAuthSessionResponse packet per result.
+		void SendAuthSessionResults(const std::vector<ClientAuthSessionResult> &results, bool batched);
+		/// Verifies the client hashes of auth session requests. Session keys are taken from the session table
+		/// if possible, and all other session keys are read with a single database request. The results are
+		/// sent back to the realm server once all requests have been verified.
+		void VerifyClientAuthSessions(std::vector<ClientAuthSessionRequest> requests, bool batched);
+		/// Verifies the client hash of an auth session request against the session key of the account.
+		static ClientAuthSessionResult VerifyClientAuthSession(const ClientAuthSessionRequest &request, const AccountSessionKey &session);
 
 	private:
 
@@ -123,5 +166,7 @@ namespace mmo
 		PacketParseResult HandleLogonProof(auth::IncomingPacket &packet);
 		/// Handles incoming ClientAuthSession packets from a realm server.
 		PacketParseResult OnClientAuthSession(auth::IncomingPacket &packet);
+		/// Handles incoming ClientAuthSessionBatch packets from a realm server.
+		PacketParseResult OnClientAuthSessionBatch(auth::IncomingPacket &packet);
 	};
 }
\ No newline at end of file
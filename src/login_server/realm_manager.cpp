@@ -2,14 +2,18 @@
 
 #include "realm_manager.h"
 #include "realm.h"
+#include "auth_protocol/auth_protocol.h"
 #include "binary_io/string_sink.h"
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 namespace mmo
 {
 	RealmManager::RealmManager(
 	    size_t capacity)
 		: m_capacity(capacity)
+		, m_realmListPacket(std::bind(&RealmManager::WriteRealmList, this, std::placeholders::_1))
 	{
 	}
 
@@ -19,22 +23,33 @@ namespace mmo
 
 	void RealmManager::RealmDisconnected(Realm &client)
 	{
-		std::scoped_lock scopedLock{ m_realmsMutex };
-
-		const auto p = std::find_if(
-		                   m_realms.begin(),
-		                   m_realms.end(),
-		                   [&client](const std::shared_ptr<Realm> &p)
 		{
-			return (&client == p.get());
-		});
-		assert(p != m_realms.end());
-		m_realms.erase(p);
+			std::scoped_lock scopedLock{ m_realmsMutex };
+
+			// Only remove the name and id indices if they still refer to this realm
+			const auto byName = m_realmsByName.find(client.GetRealmName());
+			if (byName != m_realmsByName.end() && byName->second == &client)
+			{
+				m_realmsByName.erase(byName);
+			}
+
+			const auto byId = m_realmsById.find(client.GetRealmId());
+			if (byId != m_realmsById.end() && byId->second == &client)
+			{
+				m_realmsById.erase(byId);
+			}
+
+			const size_t removed = m_realms.erase(&client);
+			assert(removed == 1);
+			(void)removed;
+		}
+
+		m_realmListPacket.Invalidate();
 	}
 	
 	bool RealmManager::HasCapacityBeenReached()
 	{
-		std::scoped_lock scopedLock{ m_realmsMutex };
+		std::shared_lock scopedLock{ m_realmsMutex };
 		return m_realms.size() >= m_capacity;
 	}
 
@@ -43,46 +58,99 @@ namespace mmo
 		std::scoped_lock scopedLock{ m_realmsMutex };
 
 		assert(added);
-		m_realms.push_back(std::move(added));
+		const Realm *const key = added.get();
+		m_realms.emplace(key, std::move(added));
 	}
 
-	Realm * RealmManager::GetRealmByName(const String &name)
+	void RealmManager::RealmAuthenticated(Realm &realm)
 	{
-		std::scoped_lock scopedLock{ m_realmsMutex };
-
-		const auto p = std::find_if(
-			m_realms.begin(),
-			m_realms.end(),
-			[&name](const std::shared_ptr<Realm> &p)
 		{
-			return (p->IsAuthentificated() && name == p->GetRealmName());
-		});
+			std::scoped_lock scopedLock{ m_realmsMutex };
 
-		if (p != m_realms.end())
-		{
-			return (*p).get();
+			m_realmsByName[realm.GetRealmName()] = &realm;
+			m_realmsById[realm.GetRealmId()] = &realm;
 		}
 
-		return nullptr;
+		m_realmListPacket.Invalidate();
+	}
+
+	Realm * RealmManager::GetRealmByName(const String &name)
+	{
+		std::shared_lock scopedLock{ m_realmsMutex };
+
+		const auto p = m_realmsByName.find(name);
+		return (p != m_realmsByName.end()) ? p->second : nullptr;
 	}
 
 	Realm * RealmManager::GetRealmByID(uint32 id)
 	{
-		std::scoped_lock scopedLock{ m_realmsMutex };
+		std::shared_lock scopedLock{ m_realmsMutex };
+
+		const auto p = m_realmsById.find(id);
+		return (p != m_realmsById.end()) ? p->second : nullptr;
+	}
+
+	SharedBuffer RealmManager::GetRealmListPacket()
+	{
+		return m_realmListPacket.Get();
+	}
 
-		const auto p = std::find_if(
-			m_realms.begin(),
-			m_realms.end(),
-			[id](const std::shared_ptr<Realm> &p)
+	uint64 RealmManager::GetRealmListVersion() const
+	{
+		return m_realmListPacket.GetVersion();
+	}
+
+	void RealmManager::WriteRealmList(auth::OutgoingPacket &packet)
+	{
+		packet.Start(auth::login_client_packet::RealmList);
+
+		// Remember realm count position and write placeholder value
+		const size_t realmCountPos = packet.sink().position();
+		packet << io::write<uint16>(0);
+
+		// The realm counter
+		uint16 realmCount = 0;
+
+		// Realms are only referenced by the index, so the lock is held until the packet is written
+		std::shared_lock scopedLock{ m_realmsMutex };
+
+		// The realm list is ordered by id, so that it doesn't depend on the hash map order
+		std::vector<const Realm*> realms;
+		realms.reserve(m_realmsById.size());
+		for (const auto &realm : m_realmsById)
 		{
-			return (p->IsAuthentificated() && id == p->GetRealmId());
+			// Skip this realm if it is disconnecting
+			if (realm.second->IsAuthentificated())
+			{
+				realms.push_back(realm.second);
+			}
+		}
+		std::sort(realms.begin(), realms.end(), [](const Realm *left, const Realm *right)
+		{
+			return left->GetRealmId() < right->GetRealmId();
 		});
 
-		if (p != m_realms.end())
+		// Write the data of every authenticated realm to the outgoing packet
+		for (const Realm *realm : realms)
 		{
-			return (*p).get();
+			// TODO: Probably check if the realm is otherwise not eligible? Account level / security groups / supported client versions?
+
+			// Write realm data
+			packet
+				<< io::write<uint32>(realm->GetRealmId())
+				<< io::write_dynamic_range<uint8>(realm->GetRealmName())
+				<< io::write_dynamic_range<uint8>(realm->GetRealmListAddress())
+				<< io::write<uint16>(realm->GetRealmListPort())
+				;
+
+			// Increase counter
+			realmCount++;
 		}
 
-		return nullptr;
+		// Now overwrite realm count with the actual realm count
+		packet.sink().overwrite(realmCountPos, reinterpret_cast<const char*>(&realmCount), sizeof(realmCount));
+
+		// Finish the packet
+		packet.Finish();
 	}
 }
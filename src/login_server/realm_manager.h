@@ -4,20 +4,27 @@
 
 #include "base/typedefs.h"
 #include "base/non_copyable.h"
+#include "base/sharded_map.h"
+#include "auth_protocol/auth_shared_packet_cache.h"
 #include <memory>
 #include <mutex>
-#include <list>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace mmo
 {
 	class Realm;
 
-	/// Manages all connected players.
+	/// Manages all connected realms. Realms are indexed by their connection and, once they are
+	/// authenticated, by their name and id, so no operation has to visit other realms. There are
+	/// only a few realms and they are read far more often than they are added or removed, so all
+	/// indices share one lock which readers share. The realm list packet is serialized once per
+	/// change of the listed realms and shared by all players who request it.
 	class RealmManager final : public NonCopyable
 	{
 	public:
 
-		typedef std::list<std::shared_ptr<Realm>> Realms;
+		typedef std::unordered_map<const Realm*, std::shared_ptr<Realm>, PointerHash> Realms;
 
 	public:
 
@@ -35,27 +42,44 @@ namespace mmo
 		bool HasCapacityBeenReached();
 		/// Adds a new player instance to the manager.
 		void AddRealm(std::shared_ptr<Realm> added);
-		/// Gets a realm by it's name.
+		/// Gets an authenticated realm by it's name.
 		Realm *GetRealmByName(const String &realmName);
-		/// 
+		/// Gets an authenticated realm by it's id.
 		Realm *GetRealmByID(uint32 id);
 
+		/// Notifies the manager that a realm has been authenticated, which adds it to the realm list
+		/// and makes it available for lookups by name and id. A previous realm with the same name or
+		/// id is replaced in these indices.
+		void RealmAuthenticated(Realm &realm);
+		/// Gets the serialized realm list packet of all authenticated realms. The packet is only
+		/// serialized again if the realm list changed since the last call.
+		SharedBuffer GetRealmListPacket();
+		/// Gets the version of the realm list, which is increased by every change.
+		uint64 GetRealmListVersion() const;
+
 		/// Executes a function callback for each realm.
 		template<class Functor>
 		void ForEachRealm(Functor f)
 		{
-			std::scoped_lock lock{ m_realmsMutex };
+			std::shared_lock lock{ m_realmsMutex };
 
 			for (const auto& realm : m_realms)
 			{
-				f(*realm);
+				f(*realm.second);
 			}
 		}
 
 	private:
 
 		Realms m_realms;
+		std::unordered_map<String, Realm*> m_realmsByName;
+		std::unordered_map<uint32, Realm*> m_realmsById;
 		size_t m_capacity;
-		std::mutex m_realmsMutex;
+		std::shared_mutex m_realmsMutex;
+		auth::SharedPacketCache m_realmListPacket;
+
+	private:
+		/// Writes the realm list packet.
+		void WriteRealmList(auth::OutgoingPacket &packet);
 	};
 }
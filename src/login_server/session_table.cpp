@@ -0,0 +1,129 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "session_table.h"
+
+#include "base/clock.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace mmo
+{
+	SessionTable::SessionTable(size_t writtenCapacity, std::chrono::milliseconds writtenTimeToLive)
+		: m_writtenCapacityPerShard((writtenCapacity + ShardCount - 1) / ShardCount)
+		, m_writtenTimeToLive(writtenTimeToLive)
+	{
+	}
+
+	void SessionTable::set(const String &accountName, AccountSession session)
+	{
+		String key = getKey(accountName);
+		Shard &shard = getShard(key);
+		const uint64 now = GetMonotonicTimeMs();
+
+		std::lock_guard<std::mutex> lock{ shard.mutex };
+		evict(shard, now);
+
+		// The new session has not been written yet, so it may not be evicted
+		const auto it = shard.sessions.find(key);
+		if (it != shard.sessions.end())
+		{
+			if (it->second.isWritten)
+			{
+				shard.written.erase(it->second.writtenPosition);
+			}
+
+			it->second = Entry{ std::move(session), false, 0, {} };
+			return;
+		}
+
+		shard.sessions.emplace(std::move(key), Entry{ std::move(session), false, 0, {} });
+	}
+
+	void SessionTable::sessionWritten(const String &accountName, const String &sessionKey)
+	{
+		const String key = getKey(accountName);
+		Shard &shard = getShard(key);
+		const uint64 now = GetMonotonicTimeMs();
+
+		std::lock_guard<std::mutex> lock{ shard.mutex };
+
+		const auto it = shard.sessions.find(key);
+		if (it == shard.sessions.end() || it->second.isWritten || it->second.session.sessionKey != sessionKey)
+		{
+			return;
+		}
+
+		it->second.isWritten = true;
+		it->second.expiry = now + static_cast<uint64>(m_writtenTimeToLive.count());
+		it->second.writtenPosition = shard.written.insert(shard.written.end(), key);
+
+		evict(shard, now);
+	}
+
+	std::optional<AccountSession> SessionTable::get(const String &accountName) const
+	{
+		const String key = getKey(accountName);
+		const Shard &shard = getShard(key);
+
+		std::lock_guard<std::mutex> lock{ shard.mutex };
+
+		const auto it = shard.sessions.find(key);
+		if (it == shard.sessions.end())
+		{
+			return {};
+		}
+
+		// Expired sessions are evicted by the next modification of the shard
+		if (it->second.isWritten && it->second.expiry <= GetMonotonicTimeMs())
+		{
+			return {};
+		}
+
+		return it->second.session;
+	}
+
+	size_t SessionTable::size() const
+	{
+		size_t count = 0;
+		for (const auto &shard : m_shards)
+		{
+			std::lock_guard<std::mutex> lock{ shard.mutex };
+			count += shard.sessions.size();
+		}
+
+		return count;
+	}
+
+	String SessionTable::getKey(const String &accountName)
+	{
+		String key = accountName;
+		std::transform(key.begin(), key.end(), key.begin(), [](char c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+		return key;
+	}
+
+	const SessionTable::Shard &SessionTable::getShard(const String &key) const
+	{
+		return m_shards[std::hash<String>()(key) % ShardCount];
+	}
+
+	SessionTable::Shard &SessionTable::getShard(const String &key)
+	{
+		return m_shards[std::hash<String>()(key) % ShardCount];
+	}
+
+	void SessionTable::evict(Shard &shard, uint64 now) const
+	{
+		while (!shard.written.empty())
+		{
+			const auto it = shard.sessions.find(shard.written.front());
+			if (shard.written.size() <= m_writtenCapacityPerShard && it->second.expiry > now)
+			{
+				break;
+			}
+
+			shard.sessions.erase(it);
+			shard.written.pop_front();
+		}
+	}
+}
@@ -0,0 +1,104 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "base/non_copyable.h"
+
+#include <array>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace mmo
+{
+	/// Session of an account which has been established by a login.
+	struct AccountSession
+	{
+		/// The unique account id.
+		uint64 accountId;
+		/// The session key (hex str).
+		String sessionKey;
+		/// The session key bytes as they are hashed by reconnect proofs, so that a reconnect doesn't have to
+		/// convert the hex string.
+		std::vector<uint8> sessionKeyData;
+	};
+
+
+	/// Contains the sessions of the accounts which logged in recently. The table is authoritative for these
+	/// sessions: Their session keys are written to the account database in the background, so the database
+	/// might not contain the latest session key of an account yet.
+	/// A session is never evicted before it has been written to the database. Afterwards, it is kept for
+	/// reconnects and realm lookups until its time to live is over or until the table holds more written
+	/// sessions than its capacity, in which case the session which has been written first is evicted.
+	/// Realms read evicted sessions from the database again, but clients can no longer reconnect to them.
+	/// Accounts are identified by their name, which is compared case insensitive like the database does.
+	/// This class is thread safe.
+	class SessionTable final : public NonCopyable
+	{
+	public:
+
+		/// Number of independently locked shards.
+		static constexpr size_t ShardCount = 16;
+
+	public:
+		/// @param writtenCapacity Maximum number of sessions which are kept after they have been written to the
+		///        database. Sessions which have not been written yet are not limited.
+		/// @param writtenTimeToLive Time for which a session is kept after it has been written to the database.
+		explicit SessionTable(size_t writtenCapacity, std::chrono::milliseconds writtenTimeToLive);
+
+	public:
+		/// Stores the session of an account, replacing its previous session. The session is kept at least
+		/// until it has been written to the database.
+		void set(const String &accountName, AccountSession session);
+		/// Marks the session of an account as written to the database, so that it may be evicted. Nothing
+		/// happens if the account has another session by now, which still has to be written.
+		/// @param sessionKey The session key (hex str) which has been written.
+		void sessionWritten(const String &accountName, const String &sessionKey);
+		/// Gets the session of an account if it is still stored.
+		std::optional<AccountSession> get(const String &accountName) const;
+		/// Gets the number of stored sessions, including expired ones which have not been evicted yet.
+		size_t size() const;
+
+	private:
+
+		struct Entry
+		{
+			AccountSession session;
+			/// Whether the session has been written to the database.
+			bool isWritten;
+			/// Monotonic time in milliseconds at which a written session expires.
+			uint64 expiry;
+			/// Position in the written list of the shard, if the session has been written.
+			std::list<String>::iterator writtenPosition;
+		};
+
+		struct Shard
+		{
+			std::unordered_map<String, Entry> sessions;
+			/// Keys of the written sessions in the order they have been written, which is also the order in
+			/// which they expire.
+			std::list<String> written;
+			mutable std::mutex mutex;
+		};
+
+		/// Converts an account name into the key of the session map.
+		static String getKey(const String &accountName);
+		/// Gets the shard which stores the session of the given key.
+		const Shard &getShard(const String &key) const;
+		Shard &getShard(const String &key);
+		/// Evicts written sessions which expired or exceed the capacity of a shard. The caller has to lock the
+		/// mutex of the shard.
+		void evict(Shard &shard, uint64 now) const;
+
+	private:
+
+		/// Maximum number of written sessions per shard.
+		const size_t m_writtenCapacityPerShard;
+		const std::chrono::milliseconds m_writtenTimeToLive;
+		std::array<Shard, ShardCount> m_shards;
+	};
+}
@@ -0,0 +1,203 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "write_behind_queue.h"
+
+#include "log/default_log_levels.h"
+
+#include <vector>
+
+namespace mmo
+{
+	WriteBehindQueue::WriteBehindQueue(IDatabase &database, std::chrono::milliseconds flushInterval, PlayerLoginsWritten playerLoginsWritten)
+		: m_database(database)
+		, m_flushInterval(flushInterval)
+		, m_playerLoginsWritten(std::move(playerLoginsWritten))
+		, m_stopping(false)
+	{
+		m_thread = std::thread([this]() { run(); });
+	}
+
+	WriteBehindQueue::~WriteBehindQueue()
+	{
+		stop();
+	}
+
+	void WriteBehindQueue::playerLogin(PlayerLoginUpdate update)
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		const uint64 accountId = update.accountId;
+		if (!m_playerUpdates.insert_or_assign(accountId, std::move(update)).second)
+		{
+			m_stats.coalescedUpdates++;
+		}
+
+		m_stats.queuedUpdates++;
+	}
+
+	void WriteBehindQueue::realmLogin(RealmLoginUpdate update)
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		const uint32 realmId = update.realmId;
+		if (!m_realmUpdates.insert_or_assign(realmId, std::move(update)).second)
+		{
+			m_stats.coalescedUpdates++;
+		}
+
+		m_stats.queuedUpdates++;
+	}
+
+	bool WriteBehindQueue::stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_stopping = true;
+		}
+
+		m_stopRequested.notify_all();
+
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+
+		// Write everything which is still pending because the last batch failed or because it has been queued
+		// after the background thread stopped
+		for (size_t retry = 0; getPendingCount() > 0; ++retry)
+		{
+			if (flush())
+			{
+				continue;
+			}
+
+			if (retry >= StopRetryCount)
+			{
+				ELOG("Could not write " << getPendingCount() << " login session updates to the database, they are lost");
+				return false;
+			}
+
+			std::this_thread::sleep_for(StopRetryDelay);
+		}
+
+		return true;
+	}
+
+	size_t WriteBehindQueue::getPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_playerUpdates.size() + m_realmUpdates.size();
+	}
+
+	WriteBehindStats WriteBehindQueue::getStats() const
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_stats;
+	}
+
+	void WriteBehindQueue::run()
+	{
+		std::unique_lock<std::mutex> lock{ m_mutex };
+
+		while (!m_stopping)
+		{
+			if (m_stopRequested.wait_for(lock, m_flushInterval, [this]() { return m_stopping; }))
+			{
+				// The final batch is written by stop
+				break;
+			}
+
+			lock.unlock();
+			flush();
+			lock.lock();
+		}
+	}
+
+	bool WriteBehindQueue::flush()
+	{
+		std::unordered_map<uint64, PlayerLoginUpdate> playerUpdates;
+		std::unordered_map<uint32, RealmLoginUpdate> realmUpdates;
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			playerUpdates.swap(m_playerUpdates);
+			realmUpdates.swap(m_realmUpdates);
+		}
+
+		bool succeeded = true;
+
+		if (!playerUpdates.empty())
+		{
+			std::vector<PlayerLoginUpdate> batch;
+			batch.reserve(playerUpdates.size());
+			for (auto &pair : playerUpdates)
+			{
+				batch.emplace_back(std::move(pair.second));
+			}
+
+			try
+			{
+				m_database.playerLogins(batch);
+
+				{
+					std::lock_guard<std::mutex> lock{ m_mutex };
+					m_stats.writtenUpdates += batch.size();
+					m_stats.batches++;
+				}
+
+				if (m_playerLoginsWritten)
+				{
+					m_playerLoginsWritten(batch);
+				}
+			}
+			catch (const std::exception &e)
+			{
+				ELOG_RATE(1, "Could not write " << batch.size() << " player login updates, retrying later: " << e.what());
+				succeeded = false;
+
+				// Updates which have been queued in the meantime are newer and win
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				for (auto &update : batch)
+				{
+					const uint64 accountId = update.accountId;
+					m_playerUpdates.emplace(accountId, std::move(update));
+				}
+				m_stats.failedBatches++;
+			}
+		}
+
+		if (!realmUpdates.empty())
+		{
+			std::vector<RealmLoginUpdate> batch;
+			batch.reserve(realmUpdates.size());
+			for (auto &pair : realmUpdates)
+			{
+				batch.emplace_back(std::move(pair.second));
+			}
+
+			try
+			{
+				m_database.realmLogins(batch);
+
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				m_stats.writtenUpdates += batch.size();
+				m_stats.batches++;
+			}
+			catch (const std::exception &e)
+			{
+				ELOG_RATE(1, "Could not write " << batch.size() << " realm login updates, retrying later: " << e.what());
+				succeeded = false;
+
+				// Updates which have been queued in the meantime are newer and win
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				for (auto &update : batch)
+				{
+					const uint32 realmId = update.realmId;
+					m_realmUpdates.emplace(realmId, std::move(update));
+				}
+				m_stats.failedBatches++;
+			}
+		}
+
+		return succeeded;
+	}
+}
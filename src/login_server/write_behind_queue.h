@@ -0,0 +1,99 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "database.h"
+
+#include "base/typedefs.h"
+#include "base/non_copyable.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace mmo
+{
+	/// Counters of a write behind queue.
+	struct WriteBehindStats final
+	{
+		/// Number of updates which have been queued.
+		uint64 queuedUpdates = 0;
+		/// Number of queued updates which replaced a pending update of the same account or realm.
+		uint64 coalescedUpdates = 0;
+		/// Number of updates which have been written to the database.
+		uint64 writtenUpdates = 0;
+		/// Number of successful batch writes.
+		uint64 batches = 0;
+		/// Number of batch writes which failed and have been retried later.
+		uint64 failedBatches = 0;
+	};
+
+
+	/// Collects the session updates of successful logins and writes them to the database in batches on a
+	/// background thread, so that a login does not have to wait for the database. The session table is
+	/// authoritative for sessions which are still pending here.
+	/// A newer update of an account or realm replaces its pending update. If a batch could not be written,
+	/// its updates are kept and written again with the next batch. Stopping the queue writes all pending
+	/// updates before the background thread ends.
+	/// This class is thread safe.
+	class WriteBehindQueue final : public NonCopyable
+	{
+	public:
+
+		/// Callback which is executed with the player updates of every batch which has been written.
+		typedef std::function<void(const std::vector<PlayerLoginUpdate> &updates)> PlayerLoginsWritten;
+
+		/// Number of times the final batch is written again on stop if it failed.
+		static constexpr size_t StopRetryCount = 5;
+		/// Time to wait before the final batch is written again, which gives the connection time to recover.
+		static constexpr std::chrono::seconds StopRetryDelay{ 1 };
+
+	public:
+		/// Launches the background thread.
+		/// @param database The database which the updates are written to. It is only used by this queue,
+		///        so it should have a connection of its own.
+		/// @param flushInterval Time between two batch writes.
+		/// @param playerLoginsWritten Optional callback which is executed by the thread which wrote a batch, for
+		///        example to let the session table know which sessions may be evicted now.
+		explicit WriteBehindQueue(IDatabase &database, std::chrono::milliseconds flushInterval, PlayerLoginsWritten playerLoginsWritten = nullptr);
+		/// Stops the queue after all pending updates have been written.
+		~WriteBehindQueue();
+
+	public:
+		/// Queues the session update of a player login.
+		void playerLogin(PlayerLoginUpdate update);
+		/// Queues the session update of a realm login.
+		void realmLogin(RealmLoginUpdate update);
+		/// Writes all pending updates and stops the background thread. Updates which are queued afterwards
+		/// are only written by another call to this method. Calling this more than once is allowed.
+		/// @returns false if some updates could not be written, even after retrying.
+		bool stop();
+		/// Gets the number of updates which have not been written yet.
+		size_t getPendingCount() const;
+		/// Gets a snapshot of the counters of this queue.
+		WriteBehindStats getStats() const;
+
+	private:
+		/// Entry point of the background thread.
+		void run();
+		/// Writes all pending updates to the database.
+		/// @returns false if the batch could not be written. Its updates are pending again in that case.
+		bool flush();
+
+	private:
+
+		IDatabase &m_database;
+		const std::chrono::milliseconds m_flushInterval;
+		const PlayerLoginsWritten m_playerLoginsWritten;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_stopRequested;
+		std::unordered_map<uint64, PlayerLoginUpdate> m_playerUpdates;
+		std::unordered_map<uint32, RealmLoginUpdate> m_realmUpdates;
+		bool m_stopping;
+		WriteBehindStats m_stats;
+		std::thread m_thread;
+	};
+}
@@ -0,0 +1,113 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "login_storm.h"
+#include "stub_database.h"
+
+#include "base/clock.h"
+
+#include "asio/post.hpp"
+
+#include <algorithm>
+
+namespace mmo
+{
+	uint64 LoginStormResults::getPercentileNs(size_t percent) const
+	{
+		if (latenciesNs.empty())
+		{
+			return 0;
+		}
+
+		return latenciesNs[std::min(latenciesNs.size() - 1, latenciesNs.size() * percent / 100)];
+	}
+
+	LoginStorm::LoginStorm(IoServicePool &services, String host, uint16 port, String accountPrefix, size_t accountCount, size_t concurrency, size_t loginCount, bool reconnect)
+		: m_services(services)
+		, m_host(std::move(host))
+		, m_port(port)
+		, m_accountPrefix(std::move(accountPrefix))
+		, m_accountCount(std::max<size_t>(accountCount, 1))
+		, m_loginCount(loginCount)
+		, m_reconnect(reconnect)
+		, m_sessionKeys(reconnect ? m_accountCount : 0)
+		, m_clients(std::max<size_t>(std::min(concurrency, loginCount), 1))
+		, m_startedLogins(0)
+		, m_completedLogins(0)
+	{
+		m_results.latenciesNs.reserve(loginCount);
+	}
+
+	LoginStormResults LoginStorm::run()
+	{
+		const uint64 startNs = GetMonotonicTimeNs();
+
+		for (size_t slot = 0; slot < m_clients.size(); ++slot)
+		{
+			asio::post(m_services.getService(slot % m_services.size()), [this, slot]() { startNextLogin(slot); });
+		}
+
+		std::unique_lock<std::mutex> lock{ m_mutex };
+		m_finished.wait(lock, [this]() { return m_completedLogins >= m_loginCount; });
+
+		m_results.seconds = static_cast<double>(GetMonotonicTimeNs() - startNs) / 1000000000.0;
+		std::sort(m_results.latenciesNs.begin(), m_results.latenciesNs.end());
+		return m_results;
+	}
+
+	void LoginStorm::startNextLogin(size_t slot)
+	{
+		size_t account = 0;
+		std::vector<uint8> sessionKey;
+		{
+			std::scoped_lock lock{ m_mutex };
+			if (m_startedLogins >= m_loginCount)
+			{
+				m_clients[slot].reset();
+				return;
+			}
+
+			account = m_startedLogins++ % m_accountCount;
+			if (m_reconnect)
+			{
+				sessionKey = m_sessionKeys[account];
+			}
+		}
+
+		// Destroys the client of the previous login of this slot, which is safe since it no longer listens
+		auto &service = m_services.getService(slot % m_services.size());
+		const bool reconnect = !sessionKey.empty();
+		m_clients[slot] = std::make_unique<StormClient>(
+			service,
+			StubDatabase::GetAccountName(m_accountPrefix, account),
+			std::move(sessionKey),
+			[this, slot, account, reconnect](StormResult result, uint64 latencyNs, const std::vector<uint8> &sessionKey) { loginCompleted(slot, account, reconnect, result, latencyNs, sessionKey); });
+		m_clients[slot]->start(m_host, m_port);
+	}
+
+	void LoginStorm::loginCompleted(size_t slot, size_t account, bool reconnect, StormResult result, uint64 latencyNs, const std::vector<uint8> &sessionKey)
+	{
+		{
+			std::scoped_lock lock{ m_mutex };
+			m_results.resultCounts[static_cast<size_t>(result)]++;
+			if (result == StormResult::Success)
+			{
+				m_results.latenciesNs.push_back(latencyNs);
+				m_results.reconnects += reconnect;
+			}
+
+			// A failed login forgets the session, so that the next login of the account does a full logon
+			if (m_reconnect)
+			{
+				m_sessionKeys[account] = sessionKey;
+			}
+
+			if (++m_completedLogins >= m_loginCount)
+			{
+				m_finished.notify_all();
+			}
+		}
+
+		// The client which reported the result may not be destroyed inside its own callback
+		asio::post(m_services.getService(slot % m_services.size()), [this, slot]() { startNextLogin(slot); });
+	}
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "storm_client.h"
+
+#include "base/typedefs.h"
+#include "base/non_copyable.h"
+#include "network/io_service_pool.h"
+
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mmo
+{
+	/// Outcome of a login storm.
+	struct LoginStormResults final
+	{
+		/// Number of logins per result.
+		std::array<uint64, static_cast<size_t>(StormResult::Count_)> resultCounts{};
+		/// Number of successful logins which reconnected with the session key of a previous login.
+		uint64 reconnects = 0;
+		/// Sorted duration of all successful logins in nanoseconds.
+		std::vector<uint64> latenciesNs;
+		/// Time in seconds from the first connection attempt until the last login finished.
+		double seconds = 0.0;
+
+		/// Gets the number of logins with the given result.
+		uint64 getCount(StormResult result) const { return resultCounts[static_cast<size_t>(result)]; }
+		/// Gets the latency in nanoseconds below which the given share (0-100) of successful logins completed.
+		uint64 getPercentileNs(size_t percent) const;
+	};
+
+
+	/// Keeps a fixed number of simulated clients logging in until the requested number of logins completed.
+	/// Every client slot is bound to one io service, so that it is only accessed by that service's thread.
+	/// In reconnect mode, a login reconnects if an earlier login of the same account succeeded.
+	class LoginStorm final
+		: public NonCopyable
+	{
+	public:
+		/// @param services The running io services used for client connections.
+		/// @param concurrency Number of clients which are logging in at the same time.
+		/// @param loginCount Total number of logins.
+		/// @param reconnect Whether logins reconnect with the session key of an earlier login of their account.
+		explicit LoginStorm(IoServicePool &services, String host, uint16 port, String accountPrefix, size_t accountCount, size_t concurrency, size_t loginCount, bool reconnect);
+
+	public:
+		/// Runs the login storm and blocks until all logins finished.
+		LoginStormResults run();
+
+	private:
+		/// Starts the next login in the given client slot, if there are logins left.
+		void startNextLogin(size_t slot);
+		/// Records the result of a login and starts the next one.
+		void loginCompleted(size_t slot, size_t account, bool reconnect, StormResult result, uint64 latencyNs, const std::vector<uint8> &sessionKey);
+
+	private:
+		IoServicePool &m_services;
+		const String m_host;
+		const uint16 m_port;
+		const String m_accountPrefix;
+		const size_t m_accountCount;
+		const size_t m_loginCount;
+		const bool m_reconnect;
+		/// Session key of the last successful login per account, which is empty if there is none.
+		std::vector<std::vector<uint8>> m_sessionKeys;
+		std::vector<std::unique_ptr<StormClient>> m_clients;
+		std::mutex m_mutex;
+		std::condition_variable m_finished;
+		size_t m_startedLogins;
+		size_t m_completedLogins;
+		LoginStormResults m_results;
+	};
+}
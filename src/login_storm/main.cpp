@@ -0,0 +1,286 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "login_storm.h"
+#include "stub_database.h"
+
+#include "player.h"
+#include "player_manager.h"
+#include "realm_manager.h"
+#include "session_table.h"
+#include "write_behind_queue.h"
+
+#include "base/constants.h"
+#include "base/worker_pool.h"
+#include "auth_protocol/auth_server.h"
+#include "network/io_service_pool.h"
+#include "log/default_log_levels.h"
+#include "log/log_std_stream.h"
+#include "log/async_log_sink.h"
+
+#include "asio.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include "cxxopts/cxxopts.hpp"
+
+
+using namespace mmo;
+
+
+/// String containing the version of this tool.
+static const std::string VersionStr = "1.0.0";
+
+
+namespace
+{
+	/// Settings of the login server which is hosted in this process if no remote server is used.
+	struct EmbeddedServerOptions final
+	{
+		size_t networkThreads = 1;
+		size_t cryptoThreads = 0;
+		size_t cryptoQueueLimit = 1024;
+		size_t databaseConnections = 4;
+		std::chrono::milliseconds writeBehindInterval{ 10 };
+		size_t accountCount = 1000;
+		String accountPrefix;
+		std::chrono::microseconds databaseLatency{ 0 };
+	};
+
+	/// Login server with the real player handling code, but a stub database instead of mysql.
+	class EmbeddedLoginServer final
+		: public NonCopyable
+	{
+	public:
+		explicit EmbeddedLoginServer(const EmbeddedServerOptions &options, uint16 port)
+			: m_database(options.accountCount, options.accountPrefix, options.databaseLatency)
+			, m_databaseServices(options.databaseConnections)
+			, m_asyncDatabase(createDatabaseWorkers(),
+				// Player results are posted to their connection strand by the player itself
+				[](const Action &action) { action(); })
+			, m_networkServices(options.networkThreads)
+			, m_cryptoWorkers(options.cryptoThreads, options.cryptoQueueLimit)
+			, m_sessions(100000, std::chrono::hours(1))
+			, m_sessionWriter(m_database, options.writeBehindInterval, [this](const std::vector<PlayerLoginUpdate> &updates)
+			{
+				for (const auto &update : updates)
+				{
+					m_sessions.sessionWritten(update.accountName, update.sessionKey);
+				}
+			})
+			, m_realmManager(constants::MaxRealmCount)
+			, m_playerManager((std::numeric_limits<size_t>::max)())
+			, m_server(m_networkServices.getServices(), port, std::bind(&auth::Connection::create, std::placeholders::_1, nullptr), 1024)
+		{
+			m_playerConnected = m_server.connected().connect([this](std::shared_ptr<Player::Client> connection)
+			{
+				asio::ip::address address;
+				try
+				{
+					address = connection->getRemoteAddress();
+				}
+				catch (const asio::system_error &error)
+				{
+					ELOG(error.what());
+					return;
+				}
+
+				m_playerManager.addPlayer(std::make_shared<Player>(m_playerManager, m_realmManager, m_asyncDatabase, m_cryptoWorkers, m_sessions, m_sessionWriter, connection, address.to_string()));
+				connection->startReceiving();
+			});
+
+			m_server.startAccept();
+			m_networkServices.run();
+			m_databaseServices.run();
+		}
+
+		~EmbeddedLoginServer()
+		{
+			m_networkServices.stop();
+			m_networkServices.join();
+			m_cryptoWorkers.stop();
+			m_sessionWriter.stop();
+
+			m_databaseServices.release();
+			m_databaseServices.join();
+		}
+
+	public:
+		size_t getNetworkThreadCount() const { return m_networkServices.size(); }
+		const WorkerPool &getCryptoWorkers() const { return m_cryptoWorkers; }
+		const StubDatabase &getDatabase() const { return m_database; }
+		size_t getDatabaseConnectionCount() const { return m_databaseServices.size(); }
+		WriteBehindQueue &getSessionWriter() { return m_sessionWriter; }
+
+	private:
+		/// Creates one database worker per database io service. The stub database is thread safe, so all
+		/// workers share it like they would share a mysql server with their own connections.
+		std::vector<AsyncDatabase::Worker> createDatabaseWorkers()
+		{
+			std::vector<AsyncDatabase::Worker> workers;
+			for (size_t i = 0; i < m_databaseServices.size(); ++i)
+			{
+				asio::io_service &service = m_databaseServices.getService(i);
+				workers.push_back({ &m_database, [&service](const Action &action) { service.post(action); } });
+			}
+
+			return workers;
+		}
+
+	private:
+		StubDatabase m_database;
+		IoServicePool m_databaseServices;
+		AsyncDatabase m_asyncDatabase;
+		IoServicePool m_networkServices;
+		WorkerPool m_cryptoWorkers;
+		SessionTable m_sessions;
+		WriteBehindQueue m_sessionWriter;
+		RealmManager m_realmManager;
+		PlayerManager m_playerManager;
+		auth::Server m_server;
+		scoped_connection m_playerConnected;
+	};
+
+	/// Formats a duration in nanoseconds as milliseconds.
+	String FormatMs(uint64 ns)
+	{
+		std::ostringstream stream;
+		stream << std::fixed << std::setprecision(2) << static_cast<double>(ns) / 1000000.0 << " ms";
+		return stream.str();
+	}
+
+	void PrintResults(const LoginStormResults &results)
+	{
+		const uint64 successes = results.getCount(StormResult::Success);
+
+		std::cout << "Results\n"
+			<< "  handshakes/s:       " << std::fixed << std::setprecision(2) << static_cast<double>(successes) / results.seconds << "\n"
+			<< "  successful logins:  " << successes << " in " << results.seconds << " s (" << results.reconnects << " reconnects)\n"
+			<< "  latency p50:        " << FormatMs(results.getPercentileNs(50)) << "\n"
+			<< "  latency p99:        " << FormatMs(results.getPercentileNs(99)) << "\n"
+			<< "  latency max:        " << FormatMs(results.latenciesNs.empty() ? 0 : results.latenciesNs.back()) << "\n"
+			<< "Failures\n"
+			<< "  connect failed:     " << results.getCount(StormResult::ConnectFailed) << "\n"
+			<< "  connection lost:    " << results.getCount(StormResult::ConnectionLost) << "\n"
+			<< "  server busy:        " << results.getCount(StormResult::Busy) << "\n"
+			<< "  rejected:           " << results.getCount(StormResult::Rejected) << "\n"
+			<< "  proof mismatch:     " << results.getCount(StormResult::ProofMismatch) << "\n";
+	}
+}
+
+/// Procedural entry point of the application.
+int main(int argc, char **argv)
+{
+	EmbeddedServerOptions serverOptions;
+	String host;
+	uint16 port = constants::DefaultLoginPlayerPort;
+	size_t clientCount = 1000;
+	size_t loginCount = 20000;
+	size_t clientThreads = 1;
+	uint32 databaseLatencyUs = 0;
+	bool reconnect = false;
+	serverOptions.accountPrefix = "storm";
+
+	// Prepare available command line options
+	cxxopts::Options options("Login Storm " + VersionStr + ", available options");
+	options.add_options()
+		("help", "produce help message")
+		("c,clients", "number of clients logging in at the same time", cxxopts::value<size_t>(clientCount))
+		("n,logins", "total number of logins", cxxopts::value<size_t>(loginCount))
+		("t,threads", "number of client network threads, 0 for one per hardware thread", cxxopts::value<size_t>(clientThreads))
+		("r,reconnect", "reconnect with the session key of the previous login of an account instead of a full logon", cxxopts::value<bool>(reconnect))
+		("a,accounts", "number of accounts named <prefix><index> with the account name as password", cxxopts::value<size_t>(serverOptions.accountCount))
+		("prefix", "account name prefix", cxxopts::value<std::string>(serverOptions.accountPrefix))
+		("host", "address of a running login server, hosts a login server with generated accounts if empty", cxxopts::value<std::string>(host))
+		("port", "player port of the login server", cxxopts::value<uint16>(port))
+		("server-threads", "network threads of the hosted login server, 0 for one per hardware thread", cxxopts::value<size_t>(serverOptions.networkThreads))
+		("crypto-threads", "crypto threads of the hosted login server, 0 for one per hardware thread", cxxopts::value<size_t>(serverOptions.cryptoThreads))
+		("crypto-queue", "crypto queue limit of the hosted login server", cxxopts::value<size_t>(serverOptions.cryptoQueueLimit))
+		("db-latency", "time in microseconds every request of the hosted login server's database takes", cxxopts::value<uint32>(databaseLatencyUs))
+		("db-connections", "database worker threads of the hosted login server, 0 for one per hardware thread", cxxopts::value<size_t>(serverOptions.databaseConnections))
+		("v,verbose", "print all log output instead of only warnings and errors")
+		;
+
+	try
+	{
+		// Parse command line arguments
+		cxxopts::ParseResult result = options.parse(argc, argv);
+
+		// Check for help output
+		if (result.count("help"))
+		{
+			std::cerr << options.help() << "\n";
+			return 0;
+		}
+
+		// Every login writes log entries on the server side, so only print important ones by default
+		const bool verbose = result.count("verbose") != 0;
+		auto logOptions = g_DefaultConsoleLogOptions;
+		logOptions.alwaysFlush = false;
+
+		AsyncLogSink coutLogSink{
+			[&logOptions](const LogEntry & entry) { printLogEntry(std::cout, entry, logOptions); },
+			[]() { std::cout.flush(); }
+		};
+		scoped_connection coutLogConnection{ g_DefaultLog.signal().connect([&coutLogSink, verbose](const LogEntry & entry) {
+			if (verbose || (entry.level != &DebugLevel && entry.level != &InfoLevel))
+			{
+				coutLogSink.push(entry);
+			}
+		}) };
+
+		serverOptions.databaseLatency = std::chrono::microseconds(databaseLatencyUs);
+
+		std::unique_ptr<EmbeddedLoginServer> server;
+		if (host.empty())
+		{
+			std::cout << "Generating " << serverOptions.accountCount << " accounts...\n";
+			server = std::make_unique<EmbeddedLoginServer>(serverOptions, port);
+			host = "127.0.0.1";
+
+			std::cout << "Hosting a login server with " << server->getNetworkThreadCount() << " network threads and "
+				<< server->getCryptoWorkers().size() << " crypto threads and " << server->getDatabaseConnectionCount() << " database threads on port " << port << "\n";
+		}
+
+		std::cout << "Running " << loginCount << (reconnect ? " logins and reconnects" : " logins") << " with " << clientCount << " concurrent clients against " << host << ":" << port << "...\n";
+
+		LoginStormResults results;
+		{
+			IoServicePool clientServices{ clientThreads };
+			clientServices.run();
+
+			LoginStorm storm{ clientServices, host, port, serverOptions.accountPrefix, serverOptions.accountCount, clientCount, loginCount, reconnect };
+			results = storm.run();
+
+			clientServices.stop();
+			clientServices.join();
+		}
+
+		PrintResults(results);
+
+		if (server)
+		{
+			// Write the pending session keys, so that the database counters are complete
+			server->getSessionWriter().stop();
+
+			const WorkerPoolStats cryptoStats = server->getCryptoWorkers().getStats();
+			const WriteBehindStats sessionStats = server->getSessionWriter().getStats();
+			std::cout << "Hosted server\n"
+				<< "  crypto tasks:       " << cryptoStats.acceptedTasks << " (" << cryptoStats.rejectedTasks << " rejected, peak queue size " << cryptoStats.peakQueueSize << ")\n"
+				<< "  database logins:    " << server->getDatabase().getPlayerLoginCount() << " in " << sessionStats.batches << " batches (" << sessionStats.coalescedUpdates << " coalesced)\n";
+		}
+
+		return results.getCount(StormResult::Success) == loginCount ? 0 : 1;
+	}
+	catch (const cxxopts::OptionException &e)
+	{
+		std::cerr << e.what() << "\n";
+		return 1;
+	}
+	catch (const BindFailedException &)
+	{
+		std::cerr << "Could not bind on tcp port " << port << "! Maybe there is a login server running on this port?\n";
+		return 1;
+	}
+}
@@ -0,0 +1,277 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "storm_client.h"
+
+#include "base/big_number.h"
+#include "base/clock.h"
+#include "base/constants.h"
+#include "base/srp6.h"
+
+#include <algorithm>
+
+namespace mmo
+{
+	StormClient::StormClient(asio::io_service &ioService, String accountName, std::vector<uint8> sessionKey, CompletionCallback callback)
+		: m_ioService(ioService)
+		, m_connection(std::make_shared<auth::Connector>(std::make_unique<asio::ip::tcp::socket>(ioService), nullptr))
+		, m_accountName(std::move(accountName))
+		, m_sessionKey(std::move(sessionKey))
+		, m_reconnect(!m_sessionKey.empty())
+		, m_callback(std::move(callback))
+		, m_startNs(0)
+		, m_finished(false)
+	{
+		// Generated accounts use their name as password
+		const String authString = m_accountName + ":" + m_accountName;
+		m_authHash = sha1(authString.c_str(), authString.size());
+		m_M2.fill(0);
+	}
+
+	StormClient::~StormClient()
+	{
+		m_connection->resetListener();
+		m_connection->close();
+	}
+
+	void StormClient::start(const String &host, uint16 port)
+	{
+		m_startNs = GetMonotonicTimeNs();
+		m_connection->connect(host, port, *this, m_ioService);
+	}
+
+	bool StormClient::connectionEstablished(bool success)
+	{
+		if (!success)
+		{
+			finish(StormResult::ConnectFailed);
+			return false;
+		}
+
+		if (m_reconnect)
+		{
+			registerPacketHandler(auth::login_client_packet::ReconnectChallenge, &StormClient::OnReconnectChallenge);
+			sendChallenge(auth::client_login_packet::ReconnectChallenge);
+		}
+		else
+		{
+			registerPacketHandler(auth::login_client_packet::LogonChallenge, &StormClient::OnLogonChallenge);
+			sendChallenge(auth::client_login_packet::LogonChallenge);
+		}
+
+		return true;
+	}
+
+	void StormClient::sendChallenge(uint8 opCode)
+	{
+		m_connection->sendSinglePacket([this, opCode](auth::OutgoingPacket &packet)
+		{
+			packet.Start(opCode);
+			packet
+				<< io::write<uint8>(0)			// Version
+				<< io::write<uint8>(0)
+				<< io::write<uint8>(0)
+				<< io::write<uint16>(0)
+				<< io::write<uint32>(0x00783836)	// Platform: x86
+				<< io::write<uint32>(0x0057696e)	// System: Win
+				<< io::write<uint32>(0x656e5553)	// Locale: enUS
+				<< io::write_dynamic_range<uint8>(m_accountName);
+			packet.Finish();
+		});
+	}
+
+	void StormClient::connectionLost()
+	{
+		finish(StormResult::ConnectionLost);
+	}
+
+	void StormClient::connectionMalformedPacket()
+	{
+		finish(StormResult::ConnectionLost);
+	}
+
+	PacketParseResult StormClient::connectionPacketReceived(auth::IncomingPacket &packet)
+	{
+		PacketParseResult result = PacketParseResult::Disconnect;
+		if (!m_packetHandlers.dispatch(packet, result))
+		{
+			finish(StormResult::Rejected);
+			return PacketParseResult::Disconnect;
+		}
+
+		return result;
+	}
+
+	PacketParseResult StormClient::OnLogonChallenge(auth::IncomingPacket &packet)
+	{
+		m_packetHandlers.clearHandler(auth::login_client_packet::LogonChallenge);
+
+		uint8 result = 0;
+		if (!(packet >> io::read<uint8>(result)))
+		{
+			finish(StormResult::ConnectionLost);
+			return PacketParseResult::Disconnect;
+		}
+
+		if (result != auth::auth_result::Success)
+		{
+			finish(result == auth::auth_result::FailDbBusy ? StormResult::Busy : StormResult::Rejected);
+			return PacketParseResult::Disconnect;
+		}
+
+		std::array<uint8, 32> B, N, s;
+		uint8 g = 0;
+		if (!(packet
+			>> io::read_range(B)
+			>> io::read<uint8>(g)
+			>> io::read_range(N)
+			>> io::read_range(s)))
+		{
+			finish(StormResult::ConnectionLost);
+			return PacketParseResult::Disconnect;
+		}
+
+		BigNumber numB, numS;
+		numB.setBinary(B.data(), B.size());
+		numS.setBinary(s.data(), s.size());
+
+		const srp6::ClientProof proof = srp6::CalculateClientProof(m_accountName, m_authHash, numS, numB);
+		m_M2 = proof.M2;
+		m_sessionKey = proof.sessionKey.asByteArray();
+
+		registerPacketHandler(auth::login_client_packet::LogonProof, &StormClient::OnLogonProof);
+
+		m_connection->sendSinglePacket([&proof](auth::OutgoingPacket &packet)
+		{
+			packet.Start(auth::client_login_packet::LogonProof);
+			packet << io::write_range(proof.A.asByteArray(32));
+			packet << io::write_range(proof.M1);
+			packet.Finish();
+		});
+
+		return PacketParseResult::Pass;
+	}
+
+	PacketParseResult StormClient::OnLogonProof(auth::IncomingPacket &packet)
+	{
+		m_packetHandlers.clearHandler(auth::login_client_packet::LogonProof);
+
+		uint8 result = 0;
+		if (!(packet >> io::read<uint8>(result)))
+		{
+			finish(StormResult::ConnectionLost);
+			return PacketParseResult::Disconnect;
+		}
+
+		if (result != auth::auth_result::Success)
+		{
+			finish(result == auth::auth_result::FailDbBusy ? StormResult::Busy : StormResult::Rejected);
+			return PacketParseResult::Disconnect;
+		}
+
+		SHA1Hash serverM2;
+		if (!(packet >> io::read_range(serverM2)) ||
+			!std::equal(m_M2.begin(), m_M2.end(), serverM2.begin()))
+		{
+			finish(StormResult::ProofMismatch);
+			return PacketParseResult::Disconnect;
+		}
+
+		// The server sends the realm list right after a successful proof
+		registerPacketHandler(auth::login_client_packet::RealmList, &StormClient::OnRealmList);
+		return PacketParseResult::Pass;
+	}
+
+	PacketParseResult StormClient::OnReconnectChallenge(auth::IncomingPacket &packet)
+	{
+		m_packetHandlers.clearHandler(auth::login_client_packet::ReconnectChallenge);
+
+		uint8 result = 0;
+		if (!(packet >> io::read<uint8>(result)))
+		{
+			finish(StormResult::ConnectionLost);
+			return PacketParseResult::Disconnect;
+		}
+
+		if (result != auth::auth_result::Success)
+		{
+			finish(result == auth::auth_result::FailDbBusy ? StormResult::Busy : StormResult::Rejected);
+			return PacketParseResult::Disconnect;
+		}
+
+		srp6::ReconnectNonce serverNonce;
+		if (!(packet >> io::read_range(serverNonce)))
+		{
+			finish(StormResult::ConnectionLost);
+			return PacketParseResult::Disconnect;
+		}
+
+		const srp6::ReconnectNonce clientNonce = srp6::GenerateReconnectNonce();
+		const HMACHash proof = srp6::CalculateReconnectProof(m_accountName, clientNonce, serverNonce, m_sessionKey);
+
+		registerPacketHandler(auth::login_client_packet::ReconnectProof, &StormClient::OnReconnectProof);
+
+		m_connection->sendSinglePacket([&clientNonce, &proof](auth::OutgoingPacket &packet)
+		{
+			packet.Start(auth::client_login_packet::ReconnectProof);
+			packet << io::write_range(clientNonce);
+			packet << io::write_range(proof);
+			packet.Finish();
+		});
+
+		return PacketParseResult::Pass;
+	}
+
+	PacketParseResult StormClient::OnReconnectProof(auth::IncomingPacket &packet)
+	{
+		m_packetHandlers.clearHandler(auth::login_client_packet::ReconnectProof);
+
+		uint8 result = 0;
+		if (!(packet >> io::read<uint8>(result)))
+		{
+			finish(StormResult::ConnectionLost);
+			return PacketParseResult::Disconnect;
+		}
+
+		if (result != auth::auth_result::Success)
+		{
+			// The server only rejects a proof of a known session if it was calculated with another key
+			finish(result == auth::auth_result::FailDbBusy ? StormResult::Busy : StormResult::ProofMismatch);
+			return PacketParseResult::Disconnect;
+		}
+
+		// The server sends the realm list right after a successful proof
+		registerPacketHandler(auth::login_client_packet::RealmList, &StormClient::OnRealmList);
+		return PacketParseResult::Pass;
+	}
+
+	PacketParseResult StormClient::OnRealmList(auth::IncomingPacket &)
+	{
+		m_packetHandlers.clearHandler(auth::login_client_packet::RealmList);
+
+		finish(StormResult::Success);
+		return PacketParseResult::Disconnect;
+	}
+
+	void StormClient::registerPacketHandler(uint8 opCode, PacketParseResult(StormClient::*method)(auth::IncomingPacket &))
+	{
+		m_packetHandlers.registerHandler(opCode, [this, method](auth::IncomingPacket &packet) { return (this->*method)(packet); });
+	}
+
+	void StormClient::finish(StormResult result)
+	{
+		if (m_finished)
+		{
+			return;
+		}
+
+		m_finished = true;
+		m_connection->resetListener();
+
+		if (result != StormResult::Success)
+		{
+			m_sessionKey.clear();
+		}
+
+		m_callback(result, GetMonotonicTimeNs() - m_startNs, m_sessionKey);
+	}
+}
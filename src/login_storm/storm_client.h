@@ -0,0 +1,99 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "base/non_copyable.h"
+#include "base/sha1.h"
+#include "base/srp6.h"
+#include "auth_protocol/auth_connector.h"
+#include "network/packet_dispatcher.h"
+
+#include "asio/io_service.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mmo
+{
+	/// Enumerates the possible outcomes of a simulated login.
+	enum class StormResult : uint8
+	{
+		/// The client received the realm list after verifying the server proof.
+		Success,
+		/// No connection could be established.
+		ConnectFailed,
+		/// The connection was lost before the login completed.
+		ConnectionLost,
+		/// The server answered with FailDbBusy, for example because its crypto workers were busy.
+		Busy,
+		/// The server rejected the login with any other result.
+		Rejected,
+		/// The M2 hash sent by the server did not match.
+		ProofMismatch,
+
+		Count_
+	};
+
+	/// Simulates a game client which does a full LogonChallenge, LogonProof and RealmList flow, or a
+	/// ReconnectChallenge, ReconnectProof and RealmList flow with the session key of a previous login,
+	/// and then disconnects. Only accessed on the strand of its connection.
+	class StormClient final
+		: public NonCopyable
+		, public auth::IConnectorListener
+	{
+	public:
+		/// Callback which is executed once when the login completed or failed. The session key is the one
+		/// which a later login of the account can reconnect with, and empty if the login failed.
+		typedef std::function<void(StormResult result, uint64 latencyNs, const std::vector<uint8> &sessionKey)> CompletionCallback;
+
+	public:
+		/// @param accountName The uppercase account name, which is used as password as well.
+		/// @param sessionKey Session key bytes of a previous login to reconnect with, or empty for a full logon.
+		explicit StormClient(asio::io_service &ioService, String accountName, std::vector<uint8> sessionKey, CompletionCallback callback);
+		~StormClient();
+
+	public:
+		/// Connects to the login server and starts the login.
+		void start(const String &host, uint16 port);
+
+	public:
+		// ~ Begin IConnectorListener
+		bool connectionEstablished(bool success) override;
+		void connectionLost() override;
+		void connectionMalformedPacket() override;
+		PacketParseResult connectionPacketReceived(auth::IncomingPacket &packet) override;
+		// ~ End IConnectorListener
+
+	private:
+		PacketParseResult OnLogonChallenge(auth::IncomingPacket &packet);
+		PacketParseResult OnLogonProof(auth::IncomingPacket &packet);
+		PacketParseResult OnReconnectChallenge(auth::IncomingPacket &packet);
+		PacketParseResult OnReconnectProof(auth::IncomingPacket &packet);
+		PacketParseResult OnRealmList(auth::IncomingPacket &packet);
+
+		/// Sends a LogonChallenge or ReconnectChallenge packet, which share their layout.
+		void sendChallenge(uint8 opCode);
+		/// Enables the handler of a login server packet.
+		void registerPacketHandler(uint8 opCode, PacketParseResult(StormClient::*method)(auth::IncomingPacket &));
+		/// Stops listening to the connection and reports the result.
+		void finish(StormResult result);
+
+	private:
+		asio::io_service &m_ioService;
+		std::shared_ptr<auth::Connector> m_connection;
+		const String m_accountName;
+		SHA1Hash m_authHash;
+		SHA1Hash m_M2;
+		/// Session key bytes to reconnect with, or of the completed logon.
+		std::vector<uint8> m_sessionKey;
+		/// Whether the client reconnects instead of doing a full logon.
+		const bool m_reconnect;
+		CompletionCallback m_callback;
+		/// Handlers of the packets which are expected next.
+		PacketDispatcher<auth::IncomingPacket, auth::login_client_packet::Count_> m_packetHandlers;
+		uint64 m_startNs;
+		bool m_finished;
+	};
+}
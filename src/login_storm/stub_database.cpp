@@ -0,0 +1,92 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "stub_database.h"
+
+#include "base/big_number.h"
+#include "base/sha1.h"
+#include "base/srp6.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace mmo
+{
+	StubDatabase::StubDatabase(size_t accountCount, const String &namePrefix, std::chrono::microseconds latency)
+		: m_latency(latency)
+		, m_playerLogins(0)
+	{
+		m_accounts.reserve(accountCount);
+
+		for (size_t i = 0; i < accountCount; ++i)
+		{
+			const String name = GetAccountName(namePrefix, i);
+
+			// Same hash as the client builds from the uppercase name and password
+			const String authString = name + ":" + name;
+			const SHA1Hash authHash = sha1(authString.c_str(), authString.size());
+
+			// Clients expect a salt of exactly 32 bytes, which setRand guarantees by setting the top bit
+			BigNumber s;
+			s.setRand(32 * 8);
+
+			m_accounts.emplace(name, AccountData{ i + 1, name, s.asHexStr(), srp6::CalculateVerifier(s, authHash).asHexStr() });
+		}
+	}
+
+	String StubDatabase::GetAccountName(const String &namePrefix, size_t index)
+	{
+		String name = namePrefix + std::to_string(index);
+		std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+		return name;
+	}
+
+	std::optional<AccountData> StubDatabase::getAccountDataByName(std::string name)
+	{
+		simulateLatency();
+
+		const auto it = m_accounts.find(name);
+		if (it == m_accounts.end())
+		{
+			return {};
+		}
+
+		return it->second;
+	}
+
+	std::optional<RealmAuthData> StubDatabase::getRealmAuthData(std::string name)
+	{
+		simulateLatency();
+		return {};
+	}
+
+	std::optional<std::pair<uint64, std::string>> StubDatabase::getAccountSessionKey(std::string accountName)
+	{
+		simulateLatency();
+		return {};
+	}
+
+	std::vector<std::optional<std::pair<uint64, std::string>>> StubDatabase::getAccountSessionKeys(const std::vector<std::string> &accountNames)
+	{
+		simulateLatency();
+		return std::vector<std::optional<std::pair<uint64, std::string>>>(accountNames.size());
+	}
+
+	void StubDatabase::playerLogins(const std::vector<PlayerLoginUpdate> &updates)
+	{
+		simulateLatency();
+		m_playerLogins.fetch_add(updates.size(), std::memory_order_relaxed);
+	}
+
+	void StubDatabase::realmLogins(const std::vector<RealmLoginUpdate> &updates)
+	{
+		simulateLatency();
+	}
+
+	void StubDatabase::simulateLatency() const
+	{
+		if (m_latency.count() > 0)
+		{
+			std::this_thread::sleep_for(m_latency);
+		}
+	}
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "database.h"
+
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
+namespace mmo
+{
+	/// In-process implementation of the login server database with generated accounts, so that the login
+	/// server code can be put under load without a mysql server. Every account uses its name as password.
+	/// Accounts are only generated on construction, so lookups are thread safe.
+	class StubDatabase final
+		: public IDatabase
+	{
+	public:
+		/// Generates the accounts.
+		/// @param accountCount Number of accounts to generate.
+		/// @param namePrefix Prefix of the account names, which are followed by the account index.
+		/// @param latency Time every request blocks the calling thread to simulate a database round trip.
+		explicit StubDatabase(size_t accountCount, const String &namePrefix, std::chrono::microseconds latency);
+
+	public:
+		/// Gets the uppercase name of a generated account.
+		static String GetAccountName(const String &namePrefix, size_t index);
+		/// Gets the number of player login updates which have been written.
+		uint64 getPlayerLoginCount() const { return m_playerLogins.load(std::memory_order_relaxed); }
+
+	public:
+		std::optional<AccountData> getAccountDataByName(std::string name) override;
+		std::optional<RealmAuthData> getRealmAuthData(std::string name) override;
+		std::optional<std::pair<uint64, std::string>> getAccountSessionKey(std::string accountName) override;
+		std::vector<std::optional<std::pair<uint64, std::string>>> getAccountSessionKeys(const std::vector<std::string> &accountNames) override;
+		void playerLogins(const std::vector<PlayerLoginUpdate> &updates) override;
+		void realmLogins(const std::vector<RealmLoginUpdate> &updates) override;
+
+	private:
+		/// Blocks the calling thread for the configured latency.
+		void simulateLatency() const;
+
+	private:
+		std::unordered_map<String, AccountData> m_accounts;
+		const std::chrono::microseconds m_latency;
+		std::atomic<uint64> m_playerLogins;
+	};
+}
@@ -341,7 +341,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	std::mutex logMutex;
 	mmo::g_DefaultLog.signal().connect([&logMutex](const mmo::LogEntry & entry) {
 		std::scoped_lock lock{ logMutex };
-		OutputDebugStringA((entry.message + "\n").c_str());
+		OutputDebugStringA((entry.getMessage() + "\n").c_str());
 	});
 #endif
 
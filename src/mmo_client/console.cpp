@@ -308,7 +308,7 @@ namespace mmo
 			}
 
 			// Push log entry
-			s_consoleLog.push_front({ color, entry.message });
+			s_consoleLog.push_front({ color, entry.getMessage() });
 
 			// Ensure log size doesn't explode
 			if (s_consoleLog.size() > 50)
@@ -5,6 +5,7 @@
 #include "version.h"
 
 #include "base/constants.h"
+#include "base/srp6.h"
 #include "log/default_log_levels.h"
 
 #include <iomanip>
@@ -89,90 +90,11 @@ namespace mmo
 
 	void LoginConnector::DoSRP6ACalculation()
 	{
-		// Generate a
-		m_a.setRand(19 * 8);
-		assert(m_a.asUInt32() > 0);
-
-		// Hash generator
-		HashGeneratorSha1 gen;
-
-		// Calculate x
-		gen.update((const char*)m_s.asByteArray().data(), m_s.getNumBytes());
-		gen.update((const char*)m_authHash.data(), m_authHash.size());
-		SHA1Hash xHash = gen.finalize();
-		m_x.setBinary(xHash.data(), xHash.size());
-
-		// Calculate v
-		m_v = constants::srp::g.modExp(m_x, constants::srp::N);
-
-		// Calculate A
-		m_A = constants::srp::g.modExp(m_a, constants::srp::N);
-
-		// Calculate u
-		SHA1Hash uHash = Sha1_BigNumbers({ m_A, m_B });
-		m_u.setBinary(uHash.data(), uHash.size());
-
-		// Calcualte S
-		BigNumber k{ 3 };
-		m_S = (m_B - k * constants::srp::g.modExp(m_x, constants::srp::N)).modExp((m_a + m_u * m_x), constants::srp::N);
-		assert(m_S.asUInt32() > 0);
-
-		// Calculate proof hashes M1 (client) and M2 (server)
-		
-		// Split it into 2 seperate strings, interleaved
-		// Leave space for terminating 0
-		char S1[16 + 1], S2[16 + 1];
-		auto arrS = m_S.asByteArray(32);
-		for (uint32 i = 0; i < 16; i++) 
-		{
-			S1[i] = arrS[i * 2];
-			S2[i] = arrS[i * 2 + 1];
-		}
-
-		// Calculate the hash for each string
-		gen.update((const char*)S1, 16);
-		SHA1Hash S1hash = gen.finalize();
-		gen.update((const char*)S2, 16);
-		SHA1Hash S2hash = gen.finalize();
-
-		// Re-combine them to form the session key
-		uint8 S_hash[40];
-		for (uint32 i = 0; i < 20; i++) 
-		{
-			S_hash[i * 2] = S1hash[i];
-			S_hash[i * 2 + 1] = S2hash[i];
-		}
-
-		// Store the session key as BigNumber so that we can use it for 
-		// calculations later on.
-		m_sessionKey.setBinary((uint8*)S_hash, 40);
-		
-		// Generate hash of plain username
-		gen.update((const char*)m_accountName.c_str(), m_accountName.size());
-		SHA1Hash userhash2 = gen.finalize();
-
-		// Generate N and g hashes
-		SHA1Hash Nhash = Sha1_BigNumbers({ constants::srp::N });
-		SHA1Hash ghash = Sha1_BigNumbers({ constants::srp::g });
-
-		// Combine N and g hash like this: (N ^ g)
-		uint8 Ng_hash[20];
-		for (uint32 i = 0; i < 20; i++) Ng_hash[i] = Nhash[i] ^ ghash[i];
-
-		// Convert hashes into bignumbers so we can calculate easier
-		BigNumber t_acc{ userhash2.data(), userhash2.size() };
-		BigNumber t_Ng_hash{ Ng_hash, 20 };
-
-		// Caluclate M1 hash sent to the server
-		Sha1_Add_BigNumbers(gen, { t_Ng_hash, t_acc, m_s, m_A, m_B});
-		gen.update((const char*)S_hash, 40);
-		M1hash = gen.finalize();
-
-		// Calculate M2 hash to store for later comparison on server answer
-		Sha1_Add_BigNumbers(gen, { m_A });
-		gen.update((const char*)M1hash.data(), M1hash.size());
-		gen.update((const char*)S_hash, 40);
-		M2hash = gen.finalize();
+		const srp6::ClientProof proof = srp6::CalculateClientProof(m_accountName, m_authHash, m_s, m_B);
+		m_A = proof.A;
+		m_sessionKey = proof.sessionKey;
+		M1hash = proof.M1;
+		M2hash = proof.M2;
 	}
 
 	PacketParseResult LoginConnector::OnLogonChallenge(auth::Protocol::IncomingPacket & packet)
@@ -219,7 +141,7 @@ namespace mmo
 			{
 				// Proof packet contains only A and M1 hash value
 				packet.Start(auth::client_login_packet::LogonProof);
-				packet << io::write_range(m_A.asByteArray());
+				packet << io::write_range(m_A.asByteArray(32));
 				packet << io::write_range(M1hash);
 				packet.Finish();
 			});
@@ -40,12 +40,7 @@ namespace mmo
 		BigNumber m_unk;
 
 		// Client srp6 numbers
-		BigNumber m_a;
-		BigNumber m_x;
-		BigNumber m_v;
-		BigNumber m_u;
 		BigNumber m_A;
-		BigNumber m_S;
 
 		// Session key
 		BigNumber m_sessionKey;
@@ -19,6 +19,11 @@ namespace mmo
 		uint16 worldPort;
 		/// Maximum number of player connections.
 		size_t maxPlayers;
+		/// Maximum number of session keys verified by the login server which are cached to verify reconnects
+		/// locally. 0 disables the cache.
+		size_t sessionCacheSize;
+		/// Time in seconds for which a verified session key is cached. 0 disables the cache.
+		uint32 sessionCacheTtl;
 		/// Maximum number of world node connections.
 		size_t maxWorlds;
 
@@ -32,6 +37,35 @@ namespace mmo
 		String mysqlPassword;
 		/// The mysql database to be used.
 		String mysqlDatabase;
+		/// Number of database worker threads, each with its own mysql connection.
+		size_t mysqlConnections;
+		/// Interval in seconds in which idle mysql connections are checked and reestablished if needed. 0 disables the check.
+		uint32 mysqlKeepAliveInterval;
+
+		/// Number of network threads, each running its own io service and acceptor.
+		/// 0 means one thread per available hardware thread.
+		size_t networkThreads;
+		/// Maximum number of pending connections per acceptor.
+		int32 listenBacklog;
+		/// Interval in seconds in which packet statistics are written to the log. 0 disables packet statistics.
+		uint32 packetStatsInterval;
+		/// Indicates whether player connections collect outgoing packets and send them once at the end of
+		/// each io batch instead of using one write per packet.
+		bool isCorkEnabled;
+		/// Maximum time in microseconds a packet may wait for its write if corking is enabled. 0 disables the cap.
+		uint32 corkLatency;
+		/// Queued outgoing bytes at which a player connection is considered congested. 0 disables send limits.
+		uint32 sendHighWatermark;
+		/// Queued outgoing bytes at which a congested player connection is considered drained again.
+		uint32 sendLowWatermark;
+		/// Queued outgoing bytes at which a player connection is dropped immediately. 0 means no hard limit.
+		uint32 sendBufferLimit;
+		/// Indicates whether incoming packets of a congested player connection are held back until it has been drained.
+		bool isPauseOnCongestionEnabled;
+		/// Time in milliseconds after which a player connection which is still congested is dropped. 0 means never.
+		uint32 slowConsumerTimeout;
+		/// Indicates whether the cpu time stamp counter should be used as monotonic clock if it is invariant.
+		bool isTscClockEnabled;
 
 		/// Indicates whether or not file logging is enabled.
 		bool isLogActive;
@@ -40,6 +74,11 @@ namespace mmo
 		/// If enabled, the log contents will be buffered before they are written to
 		/// the file, which could be more efficient..
 		bool isLogFileBuffering;
+		/// If enabled, log entries are written by a background thread instead of the logging thread.
+		bool isLogAsync;
+		/// If enabled, the log file contains binary records which can be read with the log_decoder tool.
+		/// Binary log files are always written by a background thread.
+		bool isLogBinary;
 
 		/// The port to be used for a web connection.
 		uint16 webPort;
@@ -87,12 +87,35 @@ namespace mmo
 
 	static constexpr NullHandler dbNullHandler;
 
+	/// Decides which database worker executes a request. Requests with the same key are executed by the
+	/// same worker in the order in which they have been issued, so for example a session key which has
+	/// been written by a login is visible to a later session key lookup of the same account.
+	struct DatabaseKey final
+	{
+		/// Creates a key from a name. Names are compared case insensitive by the database, and so are keys.
+		DatabaseKey(const std::string &name);
+		/// Creates a key from a numeric id.
+		DatabaseKey(uint64 id);
+
+		/// Hash of the key which selects the worker.
+		size_t hash;
+	};
+
 	/// Helper class for async database operations
 	class AsyncDatabase final : public NonCopyable
 	{
 	public:
 		typedef std::function<void(const std::function<void()> &)> ActionDispatcher;
 
+		/// A database and the callback which queues a request to the thread that uses this database.
+		struct Worker final
+		{
+			/// The database which is only used by the thread of this worker.
+			IDatabase *database;
+			/// Callback which should queue a request to the thread of this worker.
+			ActionDispatcher asyncWorker;
+		};
+
 		/// Initializes this class by assigning a database and worker callbacks.
 		/// 
 		/// @param database The linked database which will be passed in to database operations.
@@ -101,16 +124,28 @@ namespace mmo
 		explicit AsyncDatabase(IDatabase &database,
 			ActionDispatcher asyncWorker,
 			ActionDispatcher resultDispatcher);
+		/// Initializes this class with multiple workers, which usually each own a database connection.
+		/// Requests are distributed between the workers by their key.
+		/// 
+		/// @param workers The workers which execute database operations. Must not be empty.
+		/// @param resultDispatcher Callback which should queue a result callback to the main worker queue.
+		explicit AsyncDatabase(std::vector<Worker> workers,
+			ActionDispatcher resultDispatcher);
 
 	public:
+		/// Gets the number of workers which execute database operations.
+		size_t getWorkerCount() const { return m_workers.size(); }
+
 		/// Performs an async database request and allows passing exactly one argument to the database request.
 		/// 
+		/// @param key Key which decides on which worker the request is executed.
 		/// @param method A request callback which will be executed on the database thread without blocking the caller.
 		/// @param b0 Argument which will be forwarded to the handler.
 		template <class A0, class B0_>
-		void asyncRequest(void(IDatabase::*method)(A0), B0_ &&b0)
+		void asyncRequest(const DatabaseKey &key, void(IDatabase::*method)(A0), B0_ &&b0)
 		{
-			auto request = std::bind(method, &m_database, std::forward<B0_>(b0));
+			const Worker &worker = getWorker(key);
+			auto request = std::bind(method, worker.database, std::forward<B0_>(b0));
 			auto processor = [request]() -> void {
 				try
 				{
@@ -121,47 +156,56 @@ namespace mmo
 					defaultLogException(ex);
 				}
 			};
-			m_asyncWorker(processor);
+			worker.asyncWorker(processor);
 		}
 
 		/// Performs an async database request and allows passing exactly one argument to the database request.
 		/// 
+		/// @param key Key which decides on which worker the request is executed.
 		/// @param handler A handler callback which will be executed after the request was successful.
 		/// @param method A request callback which will be executed on the database thread without blocking the caller.
 		/// @param b0 Argument which will be forwarded to the handler.
 		template <class ResultHandler, class Result, class A0, class... Args>
-		void asyncRequest(ResultHandler &&handler, Result(IDatabase::*method)(A0), Args&&... b0)
+		void asyncRequest(const DatabaseKey &key, ResultHandler &&handler, Result(IDatabase::*method)(A0), Args&&... b0)
 		{
-			auto request = std::bind(method, &m_database, std::forward<Args>(b0)...);
+			const Worker &worker = getWorker(key);
+			auto request = std::bind(method, worker.database, std::forward<Args>(b0)...);
 			auto processor = [this, request, handler]() -> void
 			{
 				detail::RequestProcessor<Result> proc;
 				proc(m_resultDispatcher, request, handler);
 			};
-			m_asyncWorker(processor);
+			worker.asyncWorker(processor);
 		}
 
 		/// Performs an async database request.
 		/// 
+		/// @param key Key which decides on which worker the request is executed.
 		/// @param request A request callback which will be executed on the database thread without blocking the caller.
 		/// @param handler A handler callback which will be executed after the request was successful.
 		template <class Result, class ResultHandler, class RequestFunction>
-		void asyncRequest(RequestFunction &&request, ResultHandler &&handler)
+		void asyncRequest(const DatabaseKey &key, RequestFunction &&request, ResultHandler &&handler)
 		{
-			auto processor = [this, request, handler]() -> void
+			const Worker &worker = getWorker(key);
+			auto processor = [this, database = worker.database, request, handler]() -> void
 			{
 				detail::RequestProcessor<Result> proc;
-				auto boundRequest = std::bind(request, &m_database);
+				auto boundRequest = std::bind(request, database);
 				proc(m_resultDispatcher, boundRequest, handler);
 			};
-			m_asyncWorker(std::move(processor));
+			worker.asyncWorker(std::move(processor));
+		}
+
+	private:
+		/// Gets the worker which executes all requests with the given key.
+		const Worker &getWorker(const DatabaseKey &key) const
+		{
+			return m_workers[key.hash % m_workers.size()];
 		}
 
 	private:
-		/// The database instance to perform 
-		IDatabase &m_database;
-		/// Callback which will queue a request to the async worker queue.
-		const ActionDispatcher m_asyncWorker;
+		/// The workers which execute database operations, each with its own database instance.
+		const std::vector<Worker> m_workers;
 		/// Callback which will queue a result callback to the main worker queue.
 		const ActionDispatcher m_resultDispatcher;
 	};
@@ -4,6 +4,7 @@
 #include "version.h"
 
 #include "base/constants.h"
+#include "base/srp6.h"
 #include "base/timer_queue.h"
 #include "base/clock.h"
 #include "log/default_log_levels.h"
@@ -15,6 +16,7 @@ namespace mmo
 		, m_ioService(io)
 		, m_timerQueue(queue)
 		, m_willTerminate(false)
+		, m_authSessionBatchTimer(io)
 	{
 	}
 
@@ -75,6 +77,10 @@ namespace mmo
 			m_pendingClientAuthSessionReqs.clear();
 		}
 
+		// Drop the batch which has not been sent yet
+		m_queuedClientAuthSessionReqs.clear();
+		m_authSessionBatchTimer.cancel();
+
 		// Reset authentication status
 		Reset();
 
@@ -115,11 +121,12 @@ namespace mmo
 		}
 
 		// Create a pending request entry
+		uint64 requestId = 0;
 		{
 			std::scoped_lock lock{ m_authSessionReqMutex };
 
 			// Generate request id
-			const uint64 requestId = m_clientAuthSessionReqIdGen.GenerateId();
+			requestId = m_clientAuthSessionReqIdGen.GenerateId();
 
 			// Setup request entry
 			ClientAuthSessionRequest req
@@ -132,111 +139,116 @@ namespace mmo
 			};
 
 			// Assign pending request with new id
-			m_pendingClientAuthSessionReqs[requestId] = std::move(req);
-
-			// Send packet to the login server
-			sendSinglePacket([&accountName, clientSeed, serverSeed, &clientHash, requestId](auth::OutgoingPacket& packet) {
-				packet.Start(auth::realm_login_packet::ClientAuthSession);
-				packet
-					<< io::write<uint64>(requestId)
-					<< io::write_dynamic_range<uint8>(accountName)
-					<< io::write<uint32>(serverSeed)
-					<< io::write<uint32>(clientSeed)
-					<< io::write_range(clientHash);
-				packet.Finish();
-			});
+			m_pendingClientAuthSessionReqs.emplace(requestId, std::move(req));
 		}
 
+		// The batch is sent through the connection, so it has to be collected on the connection strand
+		const auto strongThis = std::static_pointer_cast<LoginConnector>(shared_from_this());
+		post([strongThis, requestId]()
+		{
+			strongThis->BatchClientAuthSession(requestId);
+		});
+
 		// Successfully queued client auth session request
 		return true;
 	}
 
-	void LoginConnector::DoSRP6ACalculation()
+	void LoginConnector::BatchClientAuthSession(uint64 requestId)
 	{
-		// Generate a
-		m_a.setRand(19 * 8);
-		assert(m_a.asUInt32() > 0);
-
-		// Hash generator
-		HashGeneratorSha1 gen;
-
-		// Calculate x
-		gen.update((const char*)m_s.asByteArray().data(), m_s.getNumBytes());
-		gen.update((const char*)m_authHash.data(), m_authHash.size());
-		SHA1Hash xHash = gen.finalize();
-		m_x.setBinary(xHash.data(), xHash.size());
+		// Requests which have been cancelled by a connection loss in the meantime are not sent anymore
+		ClientAuthSessionCallback callback = nullptr;
+		{
+			std::scoped_lock lock{ m_authSessionReqMutex };
 
-		// Calculate v
-		m_v = constants::srp::g.modExp(m_x, constants::srp::N);
+			const auto it = m_pendingClientAuthSessionReqs.find(requestId);
+			if (it == m_pendingClientAuthSessionReqs.end())
+			{
+				return;
+			}
 
-		// Calculate A
-		m_A = constants::srp::g.modExp(m_a, constants::srp::N);
+			if (!IsConnected())
+			{
+				callback = std::move(it->second.callback);
+				m_pendingClientAuthSessionReqs.erase(it);
+			}
+		}
 
-		// Calculate u
-		SHA1Hash uHash = Sha1_BigNumbers({ m_A, m_B });
-		m_u.setBinary(uHash.data(), uHash.size());
+		// The connection has been lost after the request has been registered
+		if (callback)
+		{
+			callback(false, 0, BigNumber{ 0 });
+			return;
+		}
 
-		// Calcualte S
-		BigNumber k{ 3 };
-		m_S = (m_B - k * constants::srp::g.modExp(m_x, constants::srp::N)).modExp((m_a + m_u * m_x), constants::srp::N);
-		assert(m_S.asUInt32() > 0);
+		m_queuedClientAuthSessionReqs.push_back(requestId);
 
-		// Calculate proof hashes M1 (client) and M2 (server)
-		
-		// Split it into 2 seperate strings, interleaved
-		// Leave space for terminating 0
-		char S1[16 + 1], S2[16 + 1];
-		auto arrS = m_S.asByteArray(32);
-		for (uint32 i = 0; i < 16; i++) 
+		if (m_queuedClientAuthSessionReqs.size() >= MaxClientAuthSessionBatchSize)
 		{
-			S1[i] = arrS[i * 2];
-			S2[i] = arrS[i * 2 + 1];
+			// The batch is full, so send it right away
+			SendQueuedClientAuthSessions();
 		}
+		else if (m_queuedClientAuthSessionReqs.size() == 1)
+		{
+			// First request of a new batch: Send the batch after a short delay, so that requests of
+			// other clients which arrive in the meantime share the packet and the database request of
+			// the login server
+			const auto strongThis = std::static_pointer_cast<LoginConnector>(shared_from_this());
+			m_authSessionBatchTimer.expires_after(ClientAuthSessionBatchDelay);
+			m_authSessionBatchTimer.async_wait([strongThis](const asio::error_code &error)
+			{
+				if (error)
+				{
+					return;
+				}
 
-		// Calculate the hash for each string
-		gen.update((const char*)S1, 16);
-		SHA1Hash S1hash = gen.finalize();
-		gen.update((const char*)S2, 16);
-		SHA1Hash S2hash = gen.finalize();
+				strongThis->post([strongThis]()
+				{
+					strongThis->SendQueuedClientAuthSessions();
+				});
+			});
+		}
+	}
 
-		// Re-combine them to form the session key
-		uint8 S_hash[40];
-		for (uint32 i = 0; i < 20; i++) 
+	void LoginConnector::SendQueuedClientAuthSessions()
+	{
+		if (m_queuedClientAuthSessionReqs.empty())
 		{
-			S_hash[i * 2] = S1hash[i];
-			S_hash[i * 2 + 1] = S2hash[i];
+			return;
 		}
 
-		// Store the session key as BigNumber so that we can use it for 
-		// calculations later on.
-		m_sessionKey.setBinary((uint8*)S_hash, 40);
-		
-		// Generate hash of plain username
-		gen.update((const char*)m_realmName.c_str(), m_realmName.size());
-		SHA1Hash userhash2 = gen.finalize();
-
-		// Generate N and g hashes
-		SHA1Hash Nhash = Sha1_BigNumbers({ constants::srp::N });
-		SHA1Hash ghash = Sha1_BigNumbers({ constants::srp::g });
-
-		// Combine N and g hash like this: (N ^ g)
-		uint8 Ng_hash[20];
-		for (uint32 i = 0; i < 20; i++) Ng_hash[i] = Nhash[i] ^ ghash[i];
-
-		// Convert hashes into bignumbers so we can calculate easier
-		BigNumber t_acc{ userhash2.data(), userhash2.size() };
-		BigNumber t_Ng_hash{ Ng_hash, 20 };
-
-		// Caluclate M1 hash sent to the server
-		Sha1_Add_BigNumbers(gen, { t_Ng_hash, t_acc, m_s, m_A, m_B});
-		gen.update((const char*)S_hash, 40);
-		M1hash = gen.finalize();
-
-		// Calculate M2 hash to store for later comparison on server answer
-		Sha1_Add_BigNumbers(gen, { m_A });
-		gen.update((const char*)M1hash.data(), M1hash.size());
-		gen.update((const char*)S_hash, 40);
-		M2hash = gen.finalize();
+		// Send packet to the login server
+		sendSinglePacket([this](auth::OutgoingPacket& packet) {
+			packet.Start(auth::realm_login_packet::ClientAuthSessionBatch);
+			packet << io::write<uint16>(m_queuedClientAuthSessionReqs.size());
+
+			std::scoped_lock lock{ m_authSessionReqMutex };
+			for (const uint64 requestId : m_queuedClientAuthSessionReqs)
+			{
+				const auto it = m_pendingClientAuthSessionReqs.find(requestId);
+				assert(it != m_pendingClientAuthSessionReqs.end());
+
+				const ClientAuthSessionRequest &req = it->second;
+				packet
+					<< io::write<uint64>(requestId)
+					<< io::write_dynamic_range<uint8>(req.accountName)
+					<< io::write<uint32>(req.serverSeed)
+					<< io::write<uint32>(req.clientSeed)
+					<< io::write_range(req.clientHash);
+			}
+
+			packet.Finish();
+		});
+
+		m_queuedClientAuthSessionReqs.clear();
+	}
+
+	void LoginConnector::DoSRP6ACalculation()
+	{
+		const srp6::ClientProof proof = srp6::CalculateClientProof(m_realmName, m_authHash, m_s, m_B);
+		m_A = proof.A;
+		m_sessionKey = proof.sessionKey;
+		M1hash = proof.M1;
+		M2hash = proof.M2;
 	}
 
 	PacketParseResult LoginConnector::OnLogonChallenge(auth::Protocol::IncomingPacket & packet)
@@ -283,7 +295,7 @@ namespace mmo
 			{
 				// Proof packet contains only A and M1 hash value
 				packet.Start(auth::realm_login_packet::LogonProof);
-				packet << io::write_range(m_A.asByteArray());
+				packet << io::write_range(m_A.asByteArray(32));
 				packet << io::write_range(M1hash);
 				packet.Finish();
 			});
@@ -320,6 +332,7 @@ namespace mmo
 
 				// Register required packet handlers
 				RegisterPacketHandler(auth::login_realm_packet::ClientAuthSessionResponse, *this, &LoginConnector::OnClientAuthSessionResponse);
+				RegisterPacketHandler(auth::login_realm_packet::ClientAuthSessionBatchResponse, *this, &LoginConnector::OnClientAuthSessionBatchResponse);
 			}
 			else
 			{
@@ -340,6 +353,38 @@ namespace mmo
 	}
 
 	PacketParseResult LoginConnector::OnClientAuthSessionResponse(auth::IncomingPacket & packet)
+	{
+		if (!ReadClientAuthSessionResult(packet))
+		{
+			ELOG("Failed to read ClientAuthSessionResponse packet from login server!");
+			return PacketParseResult::Disconnect;
+		}
+
+		return PacketParseResult::Pass;
+	}
+
+	PacketParseResult LoginConnector::OnClientAuthSessionBatchResponse(auth::IncomingPacket & packet)
+	{
+		uint16 resultCount = 0;
+		if (!(packet >> io::read<uint16>(resultCount)))
+		{
+			ELOG("Failed to read ClientAuthSessionBatchResponse packet from login server!");
+			return PacketParseResult::Disconnect;
+		}
+
+		for (uint16 i = 0; i < resultCount; ++i)
+		{
+			if (!ReadClientAuthSessionResult(packet))
+			{
+				ELOG("Failed to read ClientAuthSessionBatchResponse packet from login server!");
+				return PacketParseResult::Disconnect;
+			}
+		}
+
+		return PacketParseResult::Pass;
+	}
+
+	bool LoginConnector::ReadClientAuthSessionResult(auth::IncomingPacket & packet)
 	{
 		// Read response
 		uint64 requestId = 0;
@@ -349,33 +394,37 @@ namespace mmo
 			>> io::read<uint64>(requestId)
 			>> io::read<uint8>(result)))
 		{
-			ELOG("Failed to read ClientAuthSessionResponse packet from login server!");
-			return PacketParseResult::Disconnect;
+			return false;
 		}
 
-		// Read account id on success
+		// Will store the session key on success packet
+		BigNumber sessionKey;
+
+		// Read account id and session key on success
 		if (result == auth::auth_result::Success)
 		{
-			if (!(packet >> io::read<uint64>(accountId)))
+			std::vector<uint8> sessionKeyData;
+			if (!(packet
+				>> io::read<uint64>(accountId)
+				>> io::read_container<uint16>(sessionKeyData)))
 			{
-				ELOG("Failed to read ClientAuthSessionResponse packet from login server!");
-				return PacketParseResult::Disconnect;
+				return false;
 			}
+
+			// Generate SessionKey BigNumber from binary data
+			sessionKey.setBinary(sessionKeyData);
 		}
 
 		// Check for valid result code
 		if (result >= auth::auth_result::Count_)
 		{
 			WLOG("Received unknown or invalid client auth session result code from login server!");
-			return PacketParseResult::Disconnect;
+			return false;
 		}
 
 		// The callback for the request if there is any
 		ClientAuthSessionCallback callback = nullptr;
 
-		// Will store the session key on success packet
-		BigNumber sessionKey;
-
 		// This scope exists to minimize the time of the lock
 		{
 			// Find the respective pending request
@@ -386,21 +435,7 @@ namespace mmo
 			if (it == m_pendingClientAuthSessionReqs.end())
 			{
 				ELOG("Received unknown request id from login server!");
-				return PacketParseResult::Pass;
-			}
-
-			// Try to read the session key
-			if (result == auth::auth_result::Success)
-			{
-				std::vector<uint8> sessionKeyData;
-				if (!(packet >> io::read_container<uint16>(sessionKeyData)))
-				{
-					ELOG("Failed to read ClientAuthSessionResponse packet from login server!");
-					return PacketParseResult::Disconnect;
-				}
-
-				// Generate SessionKey BigNumber from binary data
-				sessionKey.setBinary(sessionKeyData);
+				return true;
 			}
 
 			// Execute the callback
@@ -414,7 +449,7 @@ namespace mmo
 			callback(result == auth::auth_result::Success, accountId, sessionKey);
 		}
 
-		return PacketParseResult::Pass;
+		return true;
 	}
 
 	void LoginConnector::OnLoginError(auth::AuthResult result)
@@ -430,12 +465,7 @@ namespace mmo
 		m_B = 0;
 		m_s = 0;
 		m_unk = 0;
-		m_a = 0;
-		m_x = 0;
-		m_v = 0;
-		m_u = 0;
 		m_A = 0;
-		m_S = 0;
 
 		// Reset session key
 		m_sessionKey = 0;
@@ -450,7 +480,8 @@ namespace mmo
 		if (!m_willTerminate)
 		{
 			// Reconnect in 5 seconds from now on
-			m_timerQueue.AddEvent(std::bind(&LoginConnector::OnReconnectTimer, this), m_timerQueue.GetNow() + constants::OneSecond * 5);
+			m_timerQueue.CancelEvent(m_reconnectTimer);
+			m_reconnectTimer = m_timerQueue.AddEvent(std::bind(&LoginConnector::OnReconnectTimer, this), m_timerQueue.GetNow() + constants::OneSecond * 5);
 		}
 	}
 
@@ -477,6 +508,9 @@ namespace mmo
 			m_ioService.stop();
 		};
 
+		// No need to reconnect anymore
+		m_timerQueue.CancelEvent(m_reconnectTimer);
+
 		// Notify the user
 		WLOG("Server will terminate in 5 seconds...");
 		m_timerQueue.AddEvent(std::move(termination), m_timerQueue.GetNow() + constants::OneSecond * 5);
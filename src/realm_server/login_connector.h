@@ -8,10 +8,16 @@
 #include "base/big_number.h"
 #include "base/sha1.h"
 #include "base/id_generator.h"
+#include "base/timer_wheel.h"
 
 #include "asio/io_service.hpp"
+#include "asio/steady_timer.hpp"
 
+#include <chrono>
 #include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 
 namespace mmo
@@ -25,6 +31,12 @@ namespace mmo
 		: public auth::Connector
 		, public auth::IConnectorListener
 	{
+	public:
+		/// Maximum number of queued client auth session requests which are sent to the login server at once.
+		static constexpr size_t MaxClientAuthSessionBatchSize = 64;
+		/// Maximum time a client auth session request is queued before it is sent to the login server.
+		static constexpr std::chrono::milliseconds ClientAuthSessionBatchDelay{ 2 };
+
 	public:
 		/// Callback for ClientAuthSession results.
 		typedef std::function<void(bool success, uint64 accountId, const BigNumber& sessionKey)> ClientAuthSessionCallback;
@@ -49,6 +61,8 @@ namespace mmo
 		// Internal io service
 		asio::io_service& m_ioService;
 		TimerQueue& m_timerQueue;
+		/// Pending reconnect timer, so that connection losses do not queue multiple reconnects.
+		TimerHandle m_reconnectTimer;
 
 		// Server srp6 numbers
 		BigNumber m_B;
@@ -56,12 +70,7 @@ namespace mmo
 		BigNumber m_unk;
 
 		// Client srp6 numbers
-		BigNumber m_a;
-		BigNumber m_x;
-		BigNumber m_v;
-		BigNumber m_u;
 		BigNumber m_A;
-		BigNumber m_S;
 
 		// Session key
 		BigNumber m_sessionKey;
@@ -86,10 +95,17 @@ namespace mmo
 
 		/// Generator for client auth session request ids.
 		IdGenerator<uint64> m_clientAuthSessionReqIdGen;
-		/// Pending client auth session requests by id.
-		std::map<uint64, ClientAuthSessionRequest> m_pendingClientAuthSessionReqs;
-		/// Mutex for accessing m_pendingClientAuthSessionReqs
+		/// Pending client auth session requests by id, which wait for their response.
+		std::unordered_map<uint64, ClientAuthSessionRequest> m_pendingClientAuthSessionReqs;
+		/// Mutex for m_clientAuthSessionReqIdGen and m_pendingClientAuthSessionReqs, as player threads add
+		/// requests while the connection strand completes them.
 		std::mutex m_authSessionReqMutex;
+		/// Ids of pending client auth session requests which have not been sent to the login server yet. The
+		/// batch is collected on the connection strand, as sending it writes to the connection.
+		std::vector<uint64> m_queuedClientAuthSessionReqs;
+		/// Sends the queued client auth session requests once the batch delay passed. Started and cancelled
+		/// on the connection strand, and its handler posts the send back to it.
+		asio::steady_timer m_authSessionBatchTimer;
 
 	public:
 		/// Initializes a new instance of the TestConnector class.
@@ -106,6 +122,9 @@ namespace mmo
 
 	public:
 		/// Queues a client auth session request for the login connector and waits for response from a login server.
+		/// Requests are collected and sent in batches, either when MaxClientAuthSessionBatchSize requests are queued
+		/// or ClientAuthSessionBatchDelay after the first one has been queued. This method may be called from any
+		/// thread: The request is registered right away, while it is batched and sent on the connection strand.
 		/// @returns false if the request couldn't be queued.
 		bool QueueClientAuthSession(const std::string& accountName, uint32 clientSeed, uint32 serverSeed, const SHA1Hash& clientHash, ClientAuthSessionCallback callback);
 
@@ -122,6 +141,11 @@ namespace mmo
 		void OnReconnectTimer();
 		/// Queues app termination in case of errors.
 		void QueueTermination();
+		/// Adds a registered client auth session request to the current batch. Executed on the connection strand.
+		void BatchClientAuthSession(uint64 requestId);
+		/// Sends all queued client auth session requests to the login server in a single packet. Executed on
+		/// the connection strand.
+		void SendQueuedClientAuthSessions();
 
 	private:
 		// Handles the LogonChallenge packet from the server.
@@ -130,6 +154,11 @@ namespace mmo
 		PacketParseResult OnLogonProof(auth::IncomingPacket &packet);
 		// Handles the ClientAuthSessionResponse packet from the login server.
 		PacketParseResult OnClientAuthSessionResponse(auth::IncomingPacket &packet);
+		// Handles the ClientAuthSessionBatchResponse packet from the login server.
+		PacketParseResult OnClientAuthSessionBatchResponse(auth::IncomingPacket &packet);
+		/// Reads a single client auth session result and executes the callback of its request.
+		/// @returns false if the result could not be read.
+		bool ReadClientAuthSessionResult(auth::IncomingPacket &packet);
 
 	public:
 		/// Tries to connect to the default login server. After a connection has been established,
@@ -4,6 +4,7 @@
 #include "base/service.h"
 #include "log/default_log_levels.h"
 #include "log/log_std_stream.h"
+#include "log/async_log_sink.h"
 #include "cxxopts/cxxopts.hpp"
 
 #include "program.h"
@@ -11,7 +12,6 @@
 #include "player.h"
 
 #include <iostream>
-#include <mutex>
 #include <cstring>
 
 
@@ -66,12 +66,15 @@ int main(int argc, char* argv[])
 	auto logOptions = mmo::g_DefaultConsoleLogOptions;
 	logOptions.alwaysFlush = false;
 
-	// Add cout to the list of log output streams
-	std::mutex coutLogMutex;
-	mmo::g_DefaultLog.signal().connect([&coutLogMutex, &logOptions](const mmo::LogEntry & entry) {
-		std::scoped_lock lock{ coutLogMutex };
-		mmo::printLogEntry(std::cout, entry, logOptions);
-	});
+	// Add cout to the list of log output streams. Entries are printed by a background thread, so that
+	// logging threads neither wait for the console nor for each other.
+	mmo::AsyncLogSink coutLogSink{
+		[&logOptions](const mmo::LogEntry & entry) { mmo::printLogEntry(std::cout, entry, logOptions); },
+		[]() { std::cout.flush(); }
+	};
+	mmo::scoped_connection coutLogConnection{ mmo::g_DefaultLog.signal().connect([&coutLogSink](const mmo::LogEntry & entry) {
+		coutLogSink.push(entry);
+	}) };
 
 	// Notify about the start of the login server application
 	if (runAsService)
@@ -2,8 +2,6 @@
 
 #include "mysql_database.h"
 
-#include "mysql_wrapper/mysql_row.h"
-#include "mysql_wrapper/mysql_select.h"
 #include "mysql_wrapper/mysql_statement.h"
 #include "log/default_log_levels.h"
 #include "game/character_flags.h"
@@ -11,8 +9,27 @@
 
 namespace mmo
 {
+	namespace
+	{
+		/// Indices of the prepared statements in the statement cache.
+		enum Statements
+		{
+			CharacterViewsByAccountId,
+		};
+
+		/// Queries of the prepared statements, in the order of the Statements enum.
+		std::vector<String> GetStatementQueries()
+		{
+			return {
+				"SELECT id,name,level,map,zone,race,class,gender,flags FROM characters WHERE account_id=?",
+			};
+		}
+	}
+
 	MySQLDatabase::MySQLDatabase(const mysql::DatabaseInfo &connectionInfo)
 		: m_connectionInfo(connectionInfo)
+		, m_statements(m_connection, GetStatementQueries())
+		, m_isConnectionLost(false)
 	{
 	}
 
@@ -30,63 +47,87 @@ namespace mmo
 			m_connectionInfo.host << ":" <<
 			m_connectionInfo.port);
 
+		try
+		{
+			m_statements.Prepare();
+		}
+		catch (const mysql::Exception &e)
+		{
+			ELOG("Could not prepare the realm database statements: " << e.what());
+			return false;
+		}
+
 		return true;
 	}
 
-	std::optional<std::vector<CharacterView>> MySQLDatabase::GetCharacterViewsByAccountId(uint64 accountId)
+	void MySQLDatabase::keepAlive()
 	{
-		mysql::Select select(m_connection, "SELECT id,name,level,map,zone,race,class,gender,flags FROM characters WHERE account_id=" + std::to_string(accountId));
-		if (select.Success())
+		if (m_connection.KeepAlive())
 		{
-			std::vector<CharacterView> result;
+			if (m_isConnectionLost)
+			{
+				ILOG("Reconnected to the realm database");
+				m_isConnectionLost = false;
+			}
+			return;
+		}
 
-			mysql::Row row(select);
-			while (row)
+		if (!m_isConnectionLost)
+		{
+			WLOG("Lost connection to the realm database: " << m_connection.GetErrorMessage());
+			m_isConnectionLost = true;
+		}
+	}
+
+	std::optional<std::vector<CharacterView>> MySQLDatabase::GetCharacterViewsByAccountId(uint64 accountId)
+	{
+		try
+		{
+			return m_statements.Execute(CharacterViewsByAccountId, [accountId](mysql::Statement &statement)
 			{
+				statement.SetInt(0, static_cast<int64>(accountId));
+
+				mysql::StatementResult result = statement.ExecuteSelect();
+
+				std::vector<CharacterView> views;
+
 				uint64 guid = 0;
 				std::string name;
-				uint8 level = 1, gender = 0;
-				uint32 map = 0, zone = 0, race = 0, charClass = 0, flags = 0;
-
-				uint32 index = 0;
-				row.GetField(index++, guid);
-				row.GetField(index++, name);
-				row.GetField<uint8, uint16>(index++, level);
-				row.GetField(index++, map);
-				row.GetField(index++, zone);
-				row.GetField(index++, race);
-				row.GetField(index++, charClass);
-				row.GetField(index++, flags);
-
-				result.emplace_back(
-					CharacterView(
-						guid, 
-						std::move(name), 
-						level, 
-						map, 
-						zone, 
-						race, 
-						charClass, 
-						gender, 
-						(flags & character_flags::Dead) != 0));
-
-				// Next line entry
-				row = row.Next(select);
-			}
+				uint8 level = 0;
+				uint32 map = 0, zone = 0, race = 0, charClass = 0;
+				uint8 gender = 0;
+				uint32 flags = 0;
+				while (result.FetchResultRow())
+				{
+					result.ReadColumns(guid, name, level, map, zone, race, charClass, gender, flags);
+
+					views.emplace_back(
+						CharacterView(
+							guid, 
+							name, 
+							level, 
+							map, 
+							zone, 
+							race, 
+							charClass, 
+							gender, 
+							(flags & character_flags::Dead) != 0));
+				}
 
-			return result;
+				return std::optional<std::vector<CharacterView>>(std::move(views));
+			});
 		}
-		else
+		catch (const mysql::Exception &e)
 		{
 			// There was an error
-			PrintDatabaseError();
+			PrintDatabaseError(e);
 		}
 
 		return {};
 	}
 	
-	void MySQLDatabase::PrintDatabaseError()
+	void MySQLDatabase::PrintDatabaseError(const mysql::Exception &e)
 	{
-		ELOG("Realm database error: " << m_connection.GetErrorMessage());
+		ELOG("Realm database error: " << e.what());
 	}
 }
@@ -4,6 +4,8 @@
 
 #include "database.h"
 #include "mysql_wrapper/mysql_connection.h"
+#include "mysql_wrapper/mysql_statement_cache.h"
+#include "mysql_wrapper/mysql_exception.h"
 
 
 namespace mmo
@@ -17,6 +19,9 @@ namespace mmo
 
 		/// Tries to establish a connection to the MySQL server.
 		bool load();
+		/// Checks the connection to the MySQL server and reestablishes it if it has been lost. Statements
+		/// are prepared again by the first request which uses them after a reconnect.
+		void keepAlive();
 
 	public:
 		// ~ Begin IDatabase
@@ -24,10 +29,14 @@ namespace mmo
 		// ~ End IDatabase
 
 	private:
-		void PrintDatabaseError();
+		void PrintDatabaseError(const mysql::Exception &e);
 
 	private:
 		mysql::DatabaseInfo m_connectionInfo;
 		mysql::Connection m_connection;
+		/// Prepared statements of all queries of this database, which belong to m_connection.
+		mysql::StatementCache m_statements;
+		/// Set if the last keep alive check failed, to log only changes of the connection state.
+		bool m_isConnectionLost;
 	};
 }
@@ -4,6 +4,7 @@
 #include "player_manager.h"
 #include "login_connector.h"
 #include "database.h"
+#include "session_cache.h"
 #include "version.h"
 
 #include "base/random.h"
@@ -23,11 +24,13 @@ namespace mmo
 		PlayerManager& playerManager,
 		LoginConnector &loginConnector,
 		AsyncDatabase& database, 
+		SessionCache& sessionCache,
 		std::shared_ptr<Client> connection, 
 		const String & address)
 		: m_manager(playerManager)
 		, m_loginConnector(loginConnector)
 		, m_database(database)
+		, m_sessionCache(sessionCache)
 		, m_connection(std::move(connection))
 		, m_address(address)
 		, m_accountId(0)
@@ -62,28 +65,15 @@ namespace mmo
 
 	PacketParseResult Player::connectionPacketReceived(game::IncomingPacket & packet)
 	{
-		const auto packetId = packet.GetId();
-		bool isValid = true;
-
-		PacketHandler handler = nullptr;
-
+		// Execute the packet handler if it is currently enabled and return the result
+		PacketParseResult result = PacketParseResult::Disconnect;
+		if (!m_packetHandlers.dispatch(packet, result))
 		{
-			// Lock packet handler access
-			std::scoped_lock lock{ m_packetHandlerMutex };
-
-			// Check for packet handlers
-			auto handlerIt = m_packetHandlers.find(packetId);
-			if (handlerIt == m_packetHandlers.end())
-			{
-				WLOG("Packet 0x" << std::hex << packetId << " is either unhandled or simply currently not handled");
-				return PacketParseResult::Disconnect;
-			}
-
-			handler = handlerIt->second;
+			WLOG_RATE(10, "Packet 0x" << std::hex << packet.GetId() << " is either unhandled or simply currently not handled");
+			return PacketParseResult::Disconnect;
 		}
 
-		// Execute the packet handler and return the result
-		return handler(packet);
+		return result;
 	}
 
 	PacketParseResult Player::OnAuthSession(game::IncomingPacket & packet)
@@ -108,6 +98,13 @@ namespace mmo
 			return PacketParseResult::Disconnect;
 		}
 
+		// A client which reconnects shortly after the login server verified its session can be verified
+		// without another round trip to the login server
+		if (TryCachedAuthSession())
+		{
+			return PacketParseResult::Pass;
+		}
+
 		// Setup a weak callback handler
 		std::weak_ptr<Player> weakThis{ shared_from_this() };
 		auto callbackHandler = [weakThis](bool succeeded, uint64 accountId, const BigNumber& sessionKey) {
@@ -120,7 +117,9 @@ namespace mmo
 				{
 					// Store session key
 					strongThis->m_accountId = accountId;
+					strongThis->m_sessionCache.set(strongThis->m_accountName, CachedSession{ accountId, sessionKey });
 					strongThis->InitializeSession(sessionKey);
+					strongThis->m_manager.PlayerAuthenticated(*strongThis);
 				}
 				else
 				{
@@ -132,7 +131,7 @@ namespace mmo
 
 		// Since we can't verify the client hash, as we don't have the client's session key just yet,
 		// we need to ask the login server for verification.
-		if (!m_loginConnector.QueueClientAuthSession(m_accountName, m_clientSeed, m_seed, m_clientHash, callbackHandler))
+		if (!m_loginConnector.QueueClientAuthSession(m_accountName, m_clientSeed, m_seed, m_clientHash, bindToConnection(m_connection, std::move(callbackHandler))))
 		{
 			// Could not queue session, there is probably something wrong with the login server 
 			// connection, so we close the client connection at this point
@@ -144,6 +143,33 @@ namespace mmo
 		return PacketParseResult::Pass;
 	}
 
+	bool Player::TryCachedAuthSession()
+	{
+		const auto session = m_sessionCache.get(m_accountName);
+		if (!session)
+		{
+			return false;
+		}
+
+		// Same hash as the login server builds to verify the client
+		HashGeneratorSha1 gen;
+		gen.update(m_accountName.data(), m_accountName.length());
+		gen.update(m_seed);
+		gen.update(m_clientSeed);
+		Sha1_Add_BigNumbers(gen, { session->sessionKey });
+		if (gen.finalize() != m_clientHash)
+		{
+			// The account might have logged in again with a new session key, which only the login server knows
+			m_sessionCache.erase(m_accountName);
+			return false;
+		}
+
+		m_accountId = session->accountId;
+		InitializeSession(session->sessionKey);
+		m_manager.PlayerAuthenticated(*this);
+		return true;
+	}
+
 	PacketParseResult Player::OnCharEnum(game::IncomingPacket & packet)
 	{
 		// RequestHandler
@@ -169,7 +195,7 @@ namespace mmo
 
 		// Execute
 		ASSERT(m_accountId != 0);
-		m_database.asyncRequest(std::move(handler), &IDatabase::GetCharacterViewsByAccountId, m_accountId);
+		m_database.asyncRequest(m_accountId, bindToConnection(m_connection, std::move(handler)), &IDatabase::GetCharacterViewsByAccountId, m_accountId);
 
 		return PacketParseResult::Pass;
 	}
@@ -236,27 +262,11 @@ namespace mmo
 
 	void Player::RegisterPacketHandler(uint16 opCode, PacketHandler && handler)
 	{
-		std::scoped_lock lock{ m_packetHandlerMutex };
-
-		auto it = m_packetHandlers.find(opCode);
-		if (it == m_packetHandlers.end())
-		{
-			m_packetHandlers.emplace(std::make_pair(opCode, std::forward<PacketHandler>(handler)));
-		}
-		else
-		{
-			it->second = std::forward<PacketHandler>(handler);
-		}
+		m_packetHandlers.registerHandler(opCode, std::move(handler));
 	}
 
 	void Player::ClearPacketHandler(uint16 opCode)
 	{
-		std::scoped_lock lock{ m_packetHandlerMutex };
-
-		auto it = m_packetHandlers.find(opCode);
-		if (it != m_packetHandlers.end())
-		{
-			m_packetHandlers.erase(it);
-		}
+		m_packetHandlers.clearHandler(opCode);
 	}
 }
@@ -7,12 +7,12 @@
 #include "base/non_copyable.h"
 #include "game_protocol/game_protocol.h"
 #include "game_protocol/game_connection.h"
+#include "network/packet_dispatcher.h"
 #include "base/signal.h"
 #include "base/big_number.h"
 
 #include <memory>
 #include <functional>
-#include <map>
 #include <cassert>
 
 
@@ -20,6 +20,7 @@ namespace mmo
 {
 	class AsyncDatabase;
 	class LoginConnector;
+	class SessionCache;
 
 
 	/// This class represents a player connction on the login server.
@@ -37,6 +38,7 @@ namespace mmo
 			PlayerManager &manager,
 			LoginConnector &loginConnector,
 			AsyncDatabase &database,
+			SessionCache &sessionCache,
 			std::shared_ptr<Client> connection,
 			const std::string &address);
 
@@ -49,6 +51,8 @@ namespace mmo
 		inline bool IsAuthentificated() const { return !m_sessionKey.isZero(); }
 		/// Gets the account name the player is logged in with.
 		inline const std::string &GetAccountName() const { return m_accountName; }
+		/// Gets the id of the account the player is logged in with.
+		inline uint64 GetAccountId() const { return m_accountId; }
 
 	public:
 		/// Send an auth challenge packet to the client in order to ask it for authentication data.
@@ -75,12 +79,15 @@ namespace mmo
 		PlayerManager &m_manager;
 		LoginConnector &m_loginConnector;
 		AsyncDatabase &m_database;
+		/// Session keys which the login server verified recently, used to verify reconnects locally.
+		SessionCache &m_sessionCache;
 		std::shared_ptr<Client> m_connection;
 		std::string m_address;						// IP address in string format
 		std::string m_accountName;					// Account name in uppercase letters
 		uint32 m_build;								// Build version: 0.0.0.XXXXX
-		std::map<uint16, PacketHandler> m_packetHandlers;
-		std::mutex m_packetHandlerMutex;
+		/// Handlers of the game packets which are expected in the current state. The login server callback
+		/// of OnAuthSession enables the character packets through bindToConnection, so no mutex is needed.
+		PacketDispatcher<game::IncomingPacket, game::client_realm_packet::Count_> m_packetHandlers;
 		uint32 m_seed;								// Random generated seed used for packet header encryption
 		uint32 m_clientSeed;
 		uint64 m_accountId;
@@ -100,6 +107,11 @@ namespace mmo
 		/// @copydoc wow::auth::IConnectionListener::connectionPacketReceived()
 		PacketParseResult connectionPacketReceived(game::IncomingPacket &packet) override;
 
+	private:
+		/// Verifies the client hash of the auth session request against a cached session key.
+		/// @returns true if the session key matches, in which case the session has been initialized.
+		bool TryCachedAuthSession();
+
 	private:
 		PacketParseResult OnAuthSession(game::IncomingPacket& packet);
 		PacketParseResult OnCharEnum(game::IncomingPacket& packet);
@@ -12,7 +12,8 @@ namespace mmo
 {
 	PlayerManager::PlayerManager(
 	    size_t playerCapacity)
-		: m_playerCapacity(playerCapacity)
+		: m_playerCount(0)
+		, m_playerCapacity(playerCapacity)
 	{
 	}
 
@@ -22,54 +23,56 @@ namespace mmo
 
 	void PlayerManager::PlayerDisconnected(Player &player)
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-
-		const auto p = std::find_if(
-		                   m_players.begin(),
-		                   m_players.end(),
-		                   [&player](const std::shared_ptr<Player> &p)
+		// Only remove the account indices if they still refer to this player and not to a newer
+		// login of the same account
+		if (player.IsAuthentificated())
 		{
-			return (&player == p.get());
-		});
-		assert(p != m_players.end());
-		m_players.erase(p);
+			m_playersByAccountName.erase(player.GetAccountName(), &player);
+			m_playersByAccountId.erase(player.GetAccountId(), &player);
+		}
+
+		const bool removed = m_players.erase(&player);
+		assert(removed);
+		(void)removed;
+
+		--m_playerCount;
+	}
+
+	void PlayerManager::PlayerAuthenticated(Player &player)
+	{
+		m_playersByAccountName.set(player.GetAccountName(), &player);
+		m_playersByAccountId.set(player.GetAccountId(), &player);
 	}
 	
 	bool PlayerManager::HasPlayerCapacityBeenReached()
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-		return m_players.size() >= m_playerCapacity;
+		return m_playerCount >= m_playerCapacity;
 	}
 
 	void PlayerManager::AddPlayer(std::shared_ptr<Player> added)
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-
 		assert(added);
-		m_players.push_back(added);
+
+		Player &player = *added;
+		m_players.set(&player, std::move(added));
+		++m_playerCount;
 
 		// Challenge the newly connected client for authentication
-		added->SendAuthChallenge();
+		player.SendAuthChallenge();
 	}
 
 	Player * PlayerManager::GetPlayerByAccountName(const String &accountName)
 	{
-		std::scoped_lock playerLock{ m_playerMutex };
-
-		const auto p = std::find_if(
-			m_players.begin(),
-			m_players.end(),
-			[&accountName](const std::shared_ptr<Player> &p)
-		{
-			return (p->IsAuthentificated() &&
-				accountName == p->GetAccountName());
-		});
+		return m_playersByAccountName.get(accountName).value_or(nullptr);
+	}
 
-		if (p != m_players.end())
-		{
-			return (*p).get();
-		}
+	Player * PlayerManager::GetPlayerByAccountId(uint64 accountId)
+	{
+		return m_playersByAccountId.get(accountId).value_or(nullptr);
+	}
 
-		return nullptr;
+	size_t PlayerManager::GetPlayerCount() const
+	{
+		return m_playerCount;
 	}
 }
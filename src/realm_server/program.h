@@ -4,6 +4,8 @@
 
 #include "base/typedefs.h"
 #include "base/non_copyable.h"
+#include "log/async_log_sink.h"
+#include "log/log_binary_stream.h"
 
 #include <fstream>
 
@@ -22,5 +24,9 @@ namespace mmo
 
 	private:
 		std::ofstream m_logFile;
+		/// Encodes log entries for m_logFile if binary logging is enabled.
+		std::unique_ptr<BinaryLogWriter> m_binaryLog;
+		/// Writes to m_logFile on a background thread if asynchronous logging is enabled.
+		std::unique_ptr<AsyncLogSink> m_logSink;
 	};
 }
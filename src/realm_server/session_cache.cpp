@@ -0,0 +1,104 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "session_cache.h"
+
+#include "base/clock.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace mmo
+{
+	SessionCache::SessionCache(size_t capacity, std::chrono::milliseconds timeToLive)
+		: m_capacity(capacity)
+		, m_timeToLive(timeToLive)
+	{
+	}
+
+	void SessionCache::set(const String &accountName, CachedSession session)
+	{
+		if (!isEnabled())
+		{
+			return;
+		}
+
+		String key = getKey(accountName);
+		const uint64 now = GetMonotonicTimeMs();
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		removeExpired(now);
+
+		// The entry is moved to the end, as it expires last now
+		const auto it = m_entriesByKey.find(key);
+		if (it != m_entriesByKey.end())
+		{
+			m_entries.erase(it->second);
+			m_entriesByKey.erase(it);
+		}
+		else if (m_entries.size() >= m_capacity)
+		{
+			m_entriesByKey.erase(m_entries.front().key);
+			m_entries.pop_front();
+		}
+
+		m_entries.push_back(Entry{ key, std::move(session), now + static_cast<uint64>(m_timeToLive.count()) });
+		m_entriesByKey.emplace(std::move(key), std::prev(m_entries.end()));
+	}
+
+	std::optional<CachedSession> SessionCache::get(const String &accountName)
+	{
+		if (!isEnabled())
+		{
+			return {};
+		}
+
+		const String key = getKey(accountName);
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		removeExpired(GetMonotonicTimeMs());
+
+		const auto it = m_entriesByKey.find(key);
+		if (it == m_entriesByKey.end())
+		{
+			return {};
+		}
+
+		return it->second->session;
+	}
+
+	void SessionCache::erase(const String &accountName)
+	{
+		const String key = getKey(accountName);
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		const auto it = m_entriesByKey.find(key);
+		if (it != m_entriesByKey.end())
+		{
+			m_entries.erase(it->second);
+			m_entriesByKey.erase(it);
+		}
+	}
+
+	size_t SessionCache::size() const
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_entries.size();
+	}
+
+	String SessionCache::getKey(const String &accountName)
+	{
+		String key = accountName;
+		std::transform(key.begin(), key.end(), key.begin(), [](char c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+		return key;
+	}
+
+	void SessionCache::removeExpired(uint64 now)
+	{
+		while (!m_entries.empty() && m_entries.front().expiry <= now)
+		{
+			m_entriesByKey.erase(m_entries.front().key);
+			m_entries.pop_front();
+		}
+	}
+}
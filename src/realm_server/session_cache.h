@@ -0,0 +1,80 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "base/non_copyable.h"
+#include "base/big_number.h"
+
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace mmo
+{
+	/// Session of an account which has been verified by the login server.
+	struct CachedSession
+	{
+		/// The unique account id.
+		uint64 accountId;
+		/// The session key which has been established by the login.
+		BigNumber sessionKey;
+	};
+
+
+	/// Remembers the session keys which the login server verified for a limited time, so that a client which
+	/// reconnects to this realm can be verified without asking the login server again. Sessions expire after
+	/// a fixed time to live, which limits how long a session stays valid on this realm after it has been
+	/// replaced or revoked on the login server. If the cache is full, the session which expires next is
+	/// evicted, so every operation is O(1).
+	/// Accounts are identified by their name, which is compared case insensitive.
+	/// This class is thread safe.
+	class SessionCache final : public NonCopyable
+	{
+	public:
+		/// @param capacity Maximum number of cached sessions. 0 disables the cache.
+		/// @param timeToLive Time after which a cached session expires. 0 disables the cache.
+		explicit SessionCache(size_t capacity, std::chrono::milliseconds timeToLive);
+
+	public:
+		/// Stores the verified session of an account, replacing its previous session. The time to live of the
+		/// session starts now.
+		void set(const String &accountName, CachedSession session);
+		/// Gets the session of an account if it has not expired yet.
+		std::optional<CachedSession> get(const String &accountName);
+		/// Removes the session of an account, for example because it didn't match the client's proof.
+		void erase(const String &accountName);
+		/// Gets the number of cached sessions, including expired ones which have not been removed yet.
+		size_t size() const;
+		/// Determines whether sessions are cached at all.
+		bool isEnabled() const { return m_capacity > 0 && m_timeToLive.count() > 0; }
+
+	private:
+
+		struct Entry
+		{
+			String key;
+			CachedSession session;
+			/// Monotonic time in milliseconds at which the session expires.
+			uint64 expiry;
+		};
+
+		/// Entries ordered by expiry, as all entries have the same time to live and are appended when stored.
+		typedef std::list<Entry> Entries;
+
+		/// Converts an account name into the key of the session map.
+		static String getKey(const String &accountName);
+		/// Removes all expired entries. The caller has to lock m_mutex.
+		void removeExpired(uint64 now);
+
+	private:
+
+		const size_t m_capacity;
+		const std::chrono::milliseconds m_timeToLive;
+		Entries m_entries;
+		std::unordered_map<String, Entries::iterator> m_entriesByKey;
+		mutable std::mutex m_mutex;
+	};
+}
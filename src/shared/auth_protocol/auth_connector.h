@@ -4,13 +4,13 @@
 
 #include "auth_protocol.h"
 #include "network/connector.h"
+#include "network/packet_dispatcher.h"
 
 #include "log/default_log_levels.h"
 
 #include <functional>
 #include <iomanip>
-#include <mutex>
-#include <map>
+#include <limits>
 
 
 namespace mmo
@@ -18,7 +18,7 @@ namespace mmo
 	namespace auth
 	{
 		/// Basic connector implementation using the Auth protocol. Extends the Connector class
-		/// by thread safe PacketHandler management methods.
+		/// by PacketHandler management methods.
 		class AuthConnector 
 			: public mmo::Connector<Protocol>
 		{
@@ -36,8 +36,7 @@ namespace mmo
 			/// Registers a packet handler for a given op code.
 			void RegisterPacketHandler(uint8 opCode, PacketHandler&& handler)
 			{
-				std::scoped_lock lock{ m_packetHandlerMutex };
-				m_packetHandlers[opCode] = handler;
+				m_packetHandlers.registerHandler(opCode, std::move(handler));
 			}
 			/// Syntactic sugar implementation of RegisterPacketHandler to avoid having to use std::bind.
 			template <class Instance, class Class, class... Args1>
@@ -50,48 +49,32 @@ namespace mmo
 			/// Removes a registered packet handler for a given op code.
 			void ClearPacketHandler(uint8 opCode)
 			{
-				std::scoped_lock lock{ m_packetHandlerMutex };
-				
-				auto it = m_packetHandlers.find(opCode);
-				if (it != m_packetHandlers.end())
-				{
-					m_packetHandlers.erase(it);
-				}
+				m_packetHandlers.clearHandler(opCode);
 			}
 			/// Removes all registered packet handlers.
 			void ClearPacketHandlers()
 			{
-				std::scoped_lock lock{ m_packetHandlerMutex };
-				m_packetHandlers.clear();
+				m_packetHandlers.clearHandlers();
 			}
 
 		protected:
 			virtual PacketParseResult HandleIncomingPacket(auth::IncomingPacket &packet)
 			{
-				// Try to retrieve the packet handler in a thread-safe way
-				PacketHandler handler = nullptr;
+				// Call the packet handler if one is enabled for this op code
+				PacketParseResult result = PacketParseResult::Disconnect;
+				if (!m_packetHandlers.dispatch(packet, result))
 				{
-					std::scoped_lock lock{ m_packetHandlerMutex };
-
-					// Try to find a registered packet handler
-					auto it = m_packetHandlers.find(packet.GetId());
-					if (it == m_packetHandlers.end())
-					{
-						// Received unhandled server packet
-						WLOG("Received unhandled server op code: 0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint16>(packet.GetId()));
-						return PacketParseResult::Disconnect;
-					}
-
-					handler = it->second;
+					// Received unhandled server packet
+					WLOG("Received unhandled server op code: 0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<uint16>(packet.GetId()));
+					return PacketParseResult::Disconnect;
 				}
 
-				// Call the packet handler
-				return handler(packet);
+				return result;
 			}
 
 		protected:
-			std::mutex m_packetHandlerMutex;
-			std::map<uint8, PacketHandler> m_packetHandlers;
+			/// Handlers for every possible op code. Only accessed on the connection strand.
+			PacketDispatcher<auth::IncomingPacket, std::numeric_limits<uint8>::max() + 1> m_packetHandlers;
 		};
 
 		typedef AuthConnector Connector;
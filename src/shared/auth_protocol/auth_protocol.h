@@ -14,6 +14,9 @@ namespace mmo
 		{
 			typedef auth::IncomingPacket IncomingPacket;
 			typedef auth::OutgoingPacket OutgoingPacket;
+
+			/// Name of the protocol used for diagnostics like packet statistics.
+			static constexpr const char *Name = "auth";
 		};
 
 
@@ -29,13 +32,17 @@ namespace mmo
 				LogonChallenge		= 0x00,
 				/// Sent by the client after auth_result::Success was received from the server.
 				LogonProof			= 0x01,
-				/// <Not sent at the moment>
+				/// Sent by a client which logged in before instead of LogonChallenge. Same layout as LogonChallenge.
 				ReconnectChallenge	= 0x02,
-				/// <Not sent at the moment>
+				/// Sent by the client after auth_result::Success was received on a ReconnectChallenge. Contains
+				/// a client nonce and the reconnect proof hash (see srp6::CalculateReconnectProof).
 				ReconnectProof		= 0x03,
 				/// Sent by the client after receive of successful LogonProof from the server to retrieve
 				/// the current realm list.
 				RealmList			= 0x04,
+
+				/// Counter constant
+				Count_,
 			};
 		}
 
@@ -48,12 +55,15 @@ namespace mmo
 				LogonChallenge		= 0x00,
 				/// Sent as answer on a clients LogonProof packet.
 				LogonProof			= 0x01,
-				/// TODO: Packet not yet implemented
+				/// Sent as answer on a clients ReconnectChallenge packet. Contains the server nonce on success.
 				ReconnectChallenge	= 0x02,
-				/// TODO: Packet not yet implemented
+				/// Sent as answer on a clients ReconnectProof packet, followed by the realm list on success.
 				ReconnectProof		= 0x03,
 				/// Packet contains realm list data.
 				RealmList			= 0x04,
+
+				/// Counter constant
+				Count_,
 			};
 		}
 
@@ -74,6 +84,12 @@ namespace mmo
 				/// Sent as response to a realms ClientAuthSession packet and contains authentication results (succeeded or failed,
 				/// as well as additional client session details that might be required).
 				ClientAuthSessionResponse = 0x02,
+				/// Sent as response to a realms ClientAuthSessionBatch packet and contains the results of all requests of
+				/// the batch in the same format as ClientAuthSessionResponse, prefixed by the number of results.
+				ClientAuthSessionBatchResponse = 0x03,
+
+				/// Counter constant
+				Count_,
 			};
 		}
 
@@ -89,9 +105,18 @@ namespace mmo
 
 				/// Sent to the login server to verify a clients AuthSession request.
 				ClientAuthSession = 0x02,
+				/// Sent to the login server to verify multiple clients AuthSession requests at once. Contains the
+				/// number of requests followed by the requests in the same format as ClientAuthSession.
+				ClientAuthSessionBatch = 0x03,
+
+				/// Counter constant
+				Count_,
 			};
 		}
 
+		/// Maximum number of requests in a ClientAuthSessionBatch packet.
+		static constexpr size_t MaxClientAuthSessionBatchSize = 256;
+
 
 
 		////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,101 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "auth_outgoing_packet.h"
+#include "base/typedefs.h"
+#include "base/non_copyable.h"
+#include "binary_io/string_sink.h"
+#include "network/send_queue.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <cassert>
+
+namespace mmo
+{
+	namespace auth
+	{
+		/// Holds a serialized packet which is sent to many connections, like the realm list. Unlike
+		/// PacketCache, the packet is versioned: Invalidate() marks the data of the packet as changed,
+		/// and the packet is serialized again when it is requested the next time. The serialized packet
+		/// is an immutable shared buffer, so it can be queued on any number of connections without
+		/// being copied.
+		/// This class is thread safe. Getting an up to date packet only copies a shared pointer.
+		class SharedPacketCache final : public NonCopyable
+		{
+		public:
+
+			typedef std::function<void(OutgoingPacket &)> Generator;
+
+		public:
+			/// @param createPacket Writes the packet. It is executed by the thread which requests the
+			///        packet after an invalidation, and never concurrently.
+			explicit SharedPacketCache(Generator createPacket)
+				: m_createPacket(std::move(createPacket))
+				, m_version(1)
+			{
+			}
+
+		public:
+			/// Marks the packet as outdated. This has to be called after the data of the packet changed.
+			void Invalidate()
+			{
+				m_version.fetch_add(1, std::memory_order_acq_rel);
+			}
+
+			/// Gets the current version of the packet data, which is increased by every invalidation.
+			uint64 GetVersion() const
+			{
+				return m_version.load(std::memory_order_acquire);
+			}
+
+			/// Gets the serialized packet, which is rebuilt first if it has been invalidated.
+			SharedBuffer Get()
+			{
+				std::shared_ptr<const Entry> entry = std::atomic_load(&m_entry);
+				if (entry && entry->version == GetVersion())
+				{
+					return entry->buffer;
+				}
+
+				std::lock_guard<std::mutex> lock{ m_rebuildMutex };
+
+				// Another thread might have rebuilt the packet while we were waiting for the lock
+				const uint64 version = GetVersion();
+				entry = std::atomic_load(&m_entry);
+				if (entry && entry->version == version)
+				{
+					return entry->buffer;
+				}
+
+				// The version is read before the packet is written, so an invalidation during the rebuild
+				// only causes another rebuild with the next request
+				auto buffer = std::make_shared<Buffer>();
+				io::StringSink sink(*buffer);
+				OutgoingPacket packet(sink);
+				m_createPacket(packet);
+				assert(!buffer->empty());
+
+				entry = std::make_shared<const Entry>(Entry{ version, std::move(buffer) });
+				std::atomic_store(&m_entry, entry);
+				return entry->buffer;
+			}
+
+		private:
+
+			struct Entry
+			{
+				uint64 version;
+				SharedBuffer buffer;
+			};
+
+			Generator m_createPacket;
+			std::atomic<uint64> m_version;
+			std::shared_ptr<const Entry> m_entry;
+			std::mutex m_rebuildMutex;
+		};
+	}
+}
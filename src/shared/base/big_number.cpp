@@ -4,9 +4,35 @@
 #include <openssl/ssl.h>
 #include <openssl/bn.h>
 #include <algorithm>
+#include <cassert>
 
 namespace mmo
 {
+	namespace
+	{
+		/// Owns the BN_CTX of a thread, which holds the temporary values of big number operations.
+		struct ThreadContext
+		{
+			BN_CTX *ctx;
+
+			ThreadContext()
+				: ctx(BN_CTX_new())
+			{
+			}
+			~ThreadContext()
+			{
+				BN_CTX_free(ctx);
+			}
+		};
+
+		/// Gets the BN_CTX of the calling thread instead of allocating a new one for every operation.
+		BN_CTX *GetThreadContext()
+		{
+			thread_local ThreadContext s_context;
+			return s_context.ctx;
+		}
+	}
+
 	BigNumber::BigNumber()
 	{
 		m_bn = BN_new();
@@ -85,20 +111,23 @@ namespace mmo
 	{
 		BigNumber ret;
 
-		BN_CTX *bnctx = BN_CTX_new();
-		BN_mod_exp(ret.m_bn, m_bn, bn1.m_bn, bn2.m_bn, bnctx);
-		BN_CTX_free(bnctx);
+		BN_mod_exp(ret.m_bn, m_bn, bn1.m_bn, bn2.m_bn, GetThreadContext());
 
 		return ret;
 	}
 
+	BigNumber BigNumber::modExp(const BigNumber &exponent, const MontgomeryModulus &modulus) const
+	{
+		BigNumber ret;
+		BN_mod_exp_mont(ret.m_bn, m_bn, exponent.m_bn, modulus.m_modulus.m_bn, GetThreadContext(), modulus.m_ctx);
+		return ret;
+	}
+
 	BigNumber BigNumber::exp(const BigNumber &Other) const
 	{
 		BigNumber ret;
 
-		BN_CTX *bnctx = BN_CTX_new();
-		BN_exp(ret.m_bn, m_bn, Other.m_bn, bnctx);
-		BN_CTX_free(bnctx);
+		BN_exp(ret.m_bn, m_bn, Other.m_bn, GetThreadContext());
 
 		return ret;
 	}
@@ -128,7 +157,9 @@ namespace mmo
 			std::fill(ret.begin(), ret.end(), 0);
 		}
 
-		BN_bn2bin(m_bn, ret.data());
+		// Write the big endian value to the end, so that the padding ends up in the most significant
+		// bytes of the little endian result
+		BN_bn2bin(m_bn, ret.data() + (len - numBytes));
 		std::reverse(ret.begin(), ret.end());
 
 		return ret;
@@ -178,27 +209,21 @@ namespace mmo
 
 	BigNumber BigNumber::operator*=(const BigNumber &Other)
 	{
-		BN_CTX *bnctx = BN_CTX_new();
-		BN_mul(m_bn, m_bn, Other.m_bn, bnctx);
-		BN_CTX_free(bnctx);
+		BN_mul(m_bn, m_bn, Other.m_bn, GetThreadContext());
 
 		return *this;
 	}
 
 	BigNumber BigNumber::operator/=(const BigNumber &Other)
 	{
-		BN_CTX *bnctx = BN_CTX_new();
-		BN_div(m_bn, nullptr, m_bn, Other.m_bn, bnctx);
-		BN_CTX_free(bnctx);
+		BN_div(m_bn, nullptr, m_bn, Other.m_bn, GetThreadContext());
 
 		return *this;
 	}
 
 	BigNumber BigNumber::operator%=(const BigNumber &Other)
 	{
-		BN_CTX *bnctx = BN_CTX_new();
-		BN_mod(m_bn, m_bn, Other.m_bn, bnctx);
-		BN_CTX_free(bnctx);
+		BN_mod(m_bn, m_bn, Other.m_bn, GetThreadContext());
 
 		return *this;
 	}
@@ -208,6 +233,101 @@ namespace mmo
 		return BN_cmp(m_bn, Other.m_bn) == 0;
 	}
 
+	MontgomeryModulus::MontgomeryModulus(const BigNumber &modulus)
+		: m_modulus(modulus)
+		, m_ctx(BN_MONT_CTX_new())
+	{
+		BN_MONT_CTX_set(m_ctx, m_modulus.m_bn, GetThreadContext());
+	}
+
+	MontgomeryModulus::~MontgomeryModulus()
+	{
+		BN_MONT_CTX_free(m_ctx);
+	}
+
+
+	FixedBaseExponentiation::FixedBaseExponentiation(const BigNumber &base, const MontgomeryModulus &modulus, int maxExponentBits, int windowBits)
+		: m_base(base)
+		, m_modulus(modulus)
+		, m_maxExponentBits(maxExponentBits)
+		, m_windowBits(windowBits)
+		, m_one(BN_new())
+	{
+		assert(windowBits > 0 && windowBits <= 8);
+
+		BN_CTX *ctx = GetThreadContext();
+		const int digits = 1 << m_windowBits;
+		const int windows = (m_maxExponentBits + m_windowBits - 1) / m_windowBits;
+		m_table.resize(static_cast<size_t>(windows) * digits, nullptr);
+
+		BN_to_montgomery(m_one, BigNumber(1).m_bn, m_modulus.m_ctx, ctx);
+
+		// The first power of each window is the last power of the previous window multiplied by
+		// the first one, all other powers are successive multiplications with the first power
+		BIGNUM *windowBase = BN_new();
+		BN_nnmod(windowBase, m_base.m_bn, m_modulus.m_modulus.m_bn, ctx);
+		BN_to_montgomery(windowBase, windowBase, m_modulus.m_ctx, ctx);
+
+		for (int window = 0; window < windows; ++window)
+		{
+			BIGNUM **row = &m_table[static_cast<size_t>(window) * digits];
+			row[0] = BN_dup(m_one);
+			row[1] = BN_dup(windowBase);
+			for (int digit = 2; digit < digits; ++digit)
+			{
+				row[digit] = BN_new();
+				BN_mod_mul_montgomery(row[digit], row[digit - 1], row[1], m_modulus.m_ctx, ctx);
+			}
+
+			BN_mod_mul_montgomery(windowBase, row[digits - 1], row[1], m_modulus.m_ctx, ctx);
+		}
+
+		BN_free(windowBase);
+	}
+
+	FixedBaseExponentiation::~FixedBaseExponentiation()
+	{
+		for (BIGNUM *entry : m_table)
+		{
+			BN_free(entry);
+		}
+
+		BN_free(m_one);
+	}
+
+	BigNumber FixedBaseExponentiation::modExp(const BigNumber &exponent) const
+	{
+		if (BN_is_negative(exponent.m_bn) || BN_num_bits(exponent.m_bn) > m_maxExponentBits)
+		{
+			return m_base.modExp(exponent, m_modulus);
+		}
+
+		BN_CTX *ctx = GetThreadContext();
+		const int digits = 1 << m_windowBits;
+		const int bits = BN_num_bits(exponent.m_bn);
+
+		BigNumber ret;
+		BN_copy(ret.m_bn, m_one);
+
+		for (int window = 0; window * m_windowBits < bits; ++window)
+		{
+			int digit = 0;
+			for (int bit = m_windowBits - 1; bit >= 0; --bit)
+			{
+				digit = (digit << 1) | BN_is_bit_set(exponent.m_bn, window * m_windowBits + bit);
+			}
+
+			if (digit != 0)
+			{
+				BN_mod_mul_montgomery(ret.m_bn, ret.m_bn, m_table[static_cast<size_t>(window) * digits + digit], m_modulus.m_ctx, ctx);
+			}
+		}
+
+		BN_from_montgomery(ret.m_bn, ret.m_bn, m_modulus.m_ctx, ctx);
+		return ret;
+	}
+
+
 	SHA1Hash Sha1_BigNumbers(std::initializer_list<BigNumber> args)
 	{
 		HashGeneratorSha1 gen;
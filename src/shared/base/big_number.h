@@ -3,15 +3,26 @@
 #pragma once
 
 #include "typedefs.h"
+#include "non_copyable.h"
 #include <vector>
 #include "sha1.h"
 
 struct bignum_st;
+struct bn_mont_ctx_st;
 
 namespace mmo
 {
+	class MontgomeryModulus;
+	class FixedBaseExponentiation;
+
+
+	/// Arbitrary precision integer. Temporary values of the arithmetic operations are allocated from
+	/// a context which is reused per thread.
 	class BigNumber final
 	{
+		friend class MontgomeryModulus;
+		friend class FixedBaseExponentiation;
+
 	public:
 
 		/// Initializes an empty number (zero).
@@ -42,6 +53,8 @@ namespace mmo
 		bool isZero() const;
 		/// Modular exponentiation.
 		BigNumber modExp(const BigNumber &bn1, const BigNumber &bn2) const;
+		/// Modular exponentiation with a precomputed montgomery context of the modulus.
+		BigNumber modExp(const BigNumber &exponent, const MontgomeryModulus &modulus) const;
 		/// Exponential function.
 		BigNumber exp(const BigNumber &Other) const;
 		/// Gets the number of bytes this number needs.
@@ -59,31 +72,31 @@ namespace mmo
 
 		BigNumber operator=(const BigNumber &Other);
 		BigNumber operator+=(const BigNumber &Other);
-		BigNumber operator+(const BigNumber &Other)
+		BigNumber operator+(const BigNumber &Other) const
 		{
 			BigNumber t(*this);
 			return t += Other;
 		}
 		BigNumber operator-=(const BigNumber &Other);
-		BigNumber operator-(const BigNumber &Other)
+		BigNumber operator-(const BigNumber &Other) const
 		{
 			BigNumber t(*this);
 			return t -= Other;
 		}
 		BigNumber operator*=(const BigNumber &Other);
-		BigNumber operator*(const BigNumber &Other)
+		BigNumber operator*(const BigNumber &Other) const
 		{
 			BigNumber t(*this);
 			return t *= Other;
 		}
 		BigNumber operator/=(const BigNumber &Other);
-		BigNumber operator/(const BigNumber &Other)
+		BigNumber operator/(const BigNumber &Other) const
 		{
 			BigNumber t(*this);
 			return t /= Other;
 		}
 		BigNumber operator%=(const BigNumber &Other);
-		BigNumber operator%(const BigNumber &Other)
+		BigNumber operator%(const BigNumber &Other) const
 		{
 			BigNumber t(*this);
 			return t %= Other;
@@ -96,6 +109,63 @@ namespace mmo
 		bignum_st *m_bn;
 	};
 
+
+	/// Precomputed montgomery context of an odd modulus. Speeds up repeated modular exponentiations
+	/// with the same modulus, like the ones against the srp6 prime N. Can be shared between threads.
+	class MontgomeryModulus final : public NonCopyable
+	{
+		friend class BigNumber;
+		friend class FixedBaseExponentiation;
+
+	public:
+		explicit MontgomeryModulus(const BigNumber &modulus);
+		~MontgomeryModulus();
+
+	public:
+		/// Gets the modulus.
+		const BigNumber &getModulus() const { return m_modulus; }
+
+	private:
+
+		BigNumber m_modulus;
+		bn_mont_ctx_st *m_ctx;
+	};
+
+
+	/// Modular exponentiation of a fixed base with precomputed powers of the base. The exponent is
+	/// processed in windows of a few bits, and each window only costs one multiplication with a
+	/// table entry, so that no squarings are needed at all. The table lookup depends on the exponent,
+	/// like OpenSSL's own exponentiation of single word bases which it replaces. Can be shared
+	/// between threads.
+	class FixedBaseExponentiation final : public NonCopyable
+	{
+	public:
+		/// Precomputes the table.
+		/// @param base The fixed base.
+		/// @param modulus Montgomery context of the modulus, has to outlive this object.
+		/// @param maxExponentBits Maximum size of exponents which use the table. Larger exponents
+		///        fall back to a regular exponentiation.
+		/// @param windowBits Number of exponent bits per table lookup.
+		explicit FixedBaseExponentiation(const BigNumber &base, const MontgomeryModulus &modulus, int maxExponentBits, int windowBits = 4);
+		~FixedBaseExponentiation();
+
+	public:
+		/// Calculates base^exponent mod modulus.
+		BigNumber modExp(const BigNumber &exponent) const;
+
+	private:
+
+		BigNumber m_base;
+		const MontgomeryModulus &m_modulus;
+		const int m_maxExponentBits;
+		const int m_windowBits;
+		/// base^(digit * 2^(window * windowBits)) in montgomery form, indexed by window * (2^windowBits) + digit.
+		std::vector<bignum_st *> m_table;
+		/// One in montgomery form.
+		bignum_st *m_one;
+	};
+
+
 	/// Helper method to build a sha1 hash out of a list of BigNumber objects.
 	SHA1Hash Sha1_BigNumbers(std::initializer_list<BigNumber> args);
 
@@ -1,53 +1,169 @@
 // Copyright (C) 2019, Robin Klimonow. All rights reserved.
 
 #include "clock.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <thread>
+
 #if defined(WIN32) || defined(_WIN32)
 #	include <Windows.h>
-#	include <mmsystem.h>
-#	pragma comment(lib, "winmm.lib")
 #else
-#	include <sys/time.h>
+#	include <time.h>
 #	include <unistd.h>
 #	ifdef __MACH__
-#		include <mach/clock.h>
-#		include <mach/mach.h>
+#		include <mach/mach_time.h>
 #	endif
 #endif
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#	include <cpuid.h>
+#	include <x86intrin.h>
+#	define MMO_HAS_TSC_CLOCK 1
+#endif
+
 namespace mmo
 {
-	GameTime GetAsyncTimeMs()
+	namespace
 	{
+		/// Reads the monotonic clock of the operating system.
+		uint64 GetSystemMonotonicTimeNs()
+		{
 #if defined(WIN32) || defined(_WIN32)
-		static double s_qpcScaleToMs = 0.0;
+			static const LARGE_INTEGER s_frequency = []() {
+				LARGE_INTEGER frequency;
+				QueryPerformanceFrequency(&frequency);
+				return frequency;
+			}();
 
-		static bool s_qpcExistsTested = false;
-		static bool s_qpcExists = false;
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
+
+			// Split the conversion to avoid overflowing 64 bits
+			const uint64 frequency = static_cast<uint64>(s_frequency.QuadPart);
+			const uint64 ticks = static_cast<uint64>(counter.QuadPart);
+			return (ticks / frequency) * 1000000000 + (ticks % frequency) * 1000000000 / frequency;
+#elif defined(__MACH__)
+			static const mach_timebase_info_data_t s_timebase = []() {
+				mach_timebase_info_data_t timebase;
+				mach_timebase_info(&timebase);
+				return timebase;
+			}();
+
+			return mach_absolute_time() * s_timebase.numer / s_timebase.denom;
+#else
+			struct timespec time;
+			clock_gettime(CLOCK_MONOTONIC, &time);
+			return static_cast<uint64>(time.tv_sec) * 1000000000 + static_cast<uint64>(time.tv_nsec);
+#endif
+		}
 
-		LARGE_INTEGER timestamp;
-		if (!s_qpcExistsTested)
+#ifdef MMO_HAS_TSC_CLOCK
+		/// Conversion of time stamp counter values to nanoseconds.
+		struct TscCalibration
 		{
-			if (QueryPerformanceFrequency(&timestamp))
+			/// Counter value at the time of calibration.
+			uint64 baseTsc;
+			/// Monotonic time at the time of calibration.
+			uint64 baseNs;
+			/// Nanoseconds per counter tick as 32.32 fixed point value.
+			uint64 nsPerTick;
+		};
+
+		/// Guards the calibration, which is measured by the first successful EnableTscClock call.
+		std::mutex s_tscCalibrationMutex;
+		/// Never changes once it has been measured, so readers can't see a partially written calibration.
+		std::optional<TscCalibration> s_tscCalibration;
+		/// Calibration which GetMonotonicTimeNs uses, or nullptr if the operating system clock is used.
+		std::atomic<const TscCalibration*> s_activeTscCalibration{ nullptr };
+
+		/// Determines whether the time stamp counter runs at a constant rate in all power states.
+		bool HasInvariantTsc()
+		{
+			unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+			if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
 			{
-				s_qpcScaleToMs = 1000.0 / timestamp.QuadPart;
-				s_qpcExists = true;
+				return false;
 			}
 
-			s_qpcExistsTested = true;
+			__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+			return (edx & (1u << 8)) != 0;
+		}
+#endif
+	}
+
+	uint64 GetMonotonicTimeNs()
+	{
+#ifdef MMO_HAS_TSC_CLOCK
+		if (const TscCalibration *calibration = s_activeTscCalibration.load(std::memory_order_acquire))
+		{
+			const uint64 ticks = __rdtsc() - calibration->baseTsc;
+			return calibration->baseNs + static_cast<uint64>((static_cast<unsigned __int128>(ticks) * calibration->nsPerTick) >> 32);
+		}
+#endif
+
+		return GetSystemMonotonicTimeNs();
+	}
+
+	GameTime GetAsyncTimeMs()
+	{
+		return static_cast<GameTime>(GetMonotonicTimeMs());
+	}
+
+	bool EnableTscClock()
+	{
+#ifdef MMO_HAS_TSC_CLOCK
+		if (s_activeTscCalibration.load(std::memory_order_acquire))
+		{
+			return true;
 		}
 
-		if (s_qpcExists)
+		std::lock_guard<std::mutex> lock{ s_tscCalibrationMutex };
+		if (!s_tscCalibration)
 		{
-			QueryPerformanceCounter(&timestamp);
-			return timestamp.QuadPart * s_qpcScaleToMs;
+			if (!HasInvariantTsc())
+			{
+				return false;
+			}
+
+			// Measure the counter rate against the operating system clock
+			const uint64 startNs = GetSystemMonotonicTimeNs();
+			const uint64 startTsc = __rdtsc();
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			const uint64 endNs = GetSystemMonotonicTimeNs();
+			const uint64 endTsc = __rdtsc();
+
+			if (endTsc <= startTsc || endNs <= startNs)
+			{
+				return false;
+			}
+
+			s_tscCalibration = TscCalibration{ endTsc, endNs, static_cast<uint64>((static_cast<unsigned __int128>(endNs - startNs) << 32) / (endTsc - startTsc)) };
 		}
 
-		return ::GetTickCount64();
+		// Enabling the clock again reuses the calibration, so the counter time continues where it left off
+		s_activeTscCalibration.store(&*s_tscCalibration, std::memory_order_release);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void DisableTscClock()
+	{
+#ifdef MMO_HAS_TSC_CLOCK
+		s_activeTscCalibration.store(nullptr, std::memory_order_release);
+#endif
+	}
+
+	bool IsTscClockEnabled()
+	{
+#ifdef MMO_HAS_TSC_CLOCK
+		return s_activeTscCalibration.load(std::memory_order_acquire) != nullptr;
 #else
-        struct timeval tp;
-        gettimeofday(&tp, nullptr);
-        return uint32(
-            (tp.tv_sec * 1000) + (tp.tv_usec / 1000) % uint64(0x00000000FFFFFFFF));
+		return false;
 #endif
-    }
+	}
 }
@@ -28,5 +28,57 @@ namespace mmo
 	}
 
 
+	/// Gets a monotonic timestamp in nanoseconds. The timestamp is not affected by changes of the
+	/// system time and does not wrap, so it is suitable for timers and latency measurement.
+	uint64 GetMonotonicTimeNs();
+
+	/// Gets a monotonic timestamp in milliseconds.
+	inline uint64 GetMonotonicTimeMs()
+	{
+		return GetMonotonicTimeNs() / 1000000;
+	}
+
+	/// Gets a monotonic timestamp in milliseconds, truncated to the game time type.
 	GameTime GetAsyncTimeMs();
+
+	/// Lets GetMonotonicTimeNs read the time stamp counter of the cpu instead of asking the
+	/// operating system, which is considerably cheaper. The counter is calibrated against the
+	/// operating system clock by the first call, which blocks the calling thread for a few milliseconds.
+	/// Later calls reuse that calibration, so the clock may be switched while other threads read it.
+	/// @returns false if the cpu has no invariant time stamp counter, in which case the operating
+	///          system clock is still used.
+	bool EnableTscClock();
+
+	/// Lets GetMonotonicTimeNs ask the operating system again. The two clocks drift apart slightly,
+	/// so timestamps taken before and after the switch should not be compared.
+	void DisableTscClock();
+
+	/// Determines whether GetMonotonicTimeNs reads the time stamp counter.
+	bool IsTscClockEnabled();
+
+	namespace detail
+	{
+		/// Cached monotonic time of the current thread, 0 if it has never been updated.
+		inline thread_local uint64 tickTimeNs = 0;
+	}
+
+	/// Refreshes the cached tick time of the calling thread. This is called once at the start of
+	/// every network and timer completion handler.
+	inline void UpdateTickTime()
+	{
+		detail::tickTimeNs = GetMonotonicTimeNs();
+	}
+
+	/// Gets the cached tick time of the calling thread in nanoseconds. This is the time of the
+	/// last UpdateTickTime call of this thread and costs no clock read, so it is meant for hot
+	/// paths which are fine with a time that is as old as the currently executed handler.
+	inline uint64 GetTickTimeNs()
+	{
+		if (detail::tickTimeNs == 0)
+		{
+			UpdateTickTime();
+		}
+
+		return detail::tickTimeNs;
+	}
 }
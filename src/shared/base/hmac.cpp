@@ -26,11 +26,11 @@ namespace mmo
 			: Ctx(nullptr)
 		{
 		}
-		Context(const std::array<unsigned char, 16>& key)
+		Context(const std::vector<unsigned char>& key)
 			: Ctx(nullptr)
 		{
 			Ctx = HMAC_CTX_new();
-			HMAC_Init_ex(Ctx, key.data(), key.size(), EVP_sha1(), nullptr);
+			HMAC_Init_ex(Ctx, key.data(), static_cast<int>(key.size()), EVP_sha1(), nullptr);
 		}
 		~Context()
 		{
@@ -165,6 +165,13 @@ namespace mmo
 
 
 	HashGeneratorHmac::HashGeneratorHmac() noexcept
+		: m_key{ 0x38, 0xA7, 0x83, 0x15, 0xF8, 0x92, 0x25, 0x30, 0x71, 0x98, 0x67, 0xB1, 0x8C, 0x04, 0xE2, 0xAA }
+	{
+		EnsureContextCreated();
+	}
+
+	HashGeneratorHmac::HashGeneratorHmac(const unsigned char *key, size_t keyLength)
+		: m_key(key, key + keyLength)
 	{
 		EnsureContextCreated();
 	}
@@ -173,32 +180,13 @@ namespace mmo
 	{
 		if (!m_context)
 		{
-			// Setup key
-			size_t i = 0;
-			m_key[i++] = 0x38;
-			m_key[i++] = 0xA7;
-			m_key[i++] = 0x83;
-			m_key[i++] = 0x15;
-			m_key[i++] = 0xF8;
-			m_key[i++] = 0x92;
-			m_key[i++] = 0x25;
-			m_key[i++] = 0x30;
-			m_key[i++] = 0x71;
-			m_key[i++] = 0x98;
-			m_key[i++] = 0x67;
-			m_key[i++] = 0xB1;
-			m_key[i++] = 0x8C;
-			m_key[i++] = 0x04;
-			m_key[i++] = 0xE2;
-			m_key[i++] = 0xAA;
-
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 			m_context = std::make_shared<Context>();
 			HMAC_CTX_init(m_context.get());
 #ifdef __APPLE__
-			HMAC_Init_ex(m_context.get(), m_key.data(), m_key.size(), EVP_sha1(), nullptr);
+			HMAC_Init_ex(m_context.get(), m_key.data(), static_cast<int>(m_key.size()), EVP_sha1(), nullptr);
 #else
-			if (!HMAC_Init_ex(m_context.get(), m_key.data(), m_key.size(), EVP_sha1(), nullptr))
+			if (!HMAC_Init_ex(m_context.get(), m_key.data(), static_cast<int>(m_key.size()), EVP_sha1(), nullptr))
 			{
 				throw std::runtime_error("HMAC_Init_ex failed");
 			}
@@ -7,6 +7,7 @@
 #include <memory>
 #include <array>
 #include <istream>
+#include <vector>
 
 #include <openssl/opensslv.h>
 
@@ -16,7 +17,7 @@ namespace mmo
 	/// Represents a SHA1 hash in it's binary form
 	typedef std::array<unsigned char, 20> HMACHash;
 
-	/// 
+	/// Generates HMAC-SHA1 hashes.
 	class HashGeneratorHmac final
 		: public NonCopyable
 	{
@@ -25,7 +26,10 @@ namespace mmo
 		struct Context;
 
 	public:
+		/// Uses the built-in key of the game protocol encryption.
 		explicit HashGeneratorHmac() noexcept;
+		/// Uses the given key, for example a session key.
+		explicit HashGeneratorHmac(const unsigned char *key, size_t keyLength);
 
 	public:
 		void Update(const char* data, size_t len);
@@ -47,7 +51,7 @@ namespace mmo
 
 	private:
 		std::shared_ptr<Context> m_context;
-		std::array<unsigned char, 16> m_key;
+		std::vector<unsigned char> m_key;
 
 	private:
 		void EnsureContextCreated();
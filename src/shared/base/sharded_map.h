@@ -0,0 +1,167 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "typedefs.h"
+#include "non_copyable.h"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace mmo
+{
+	/// Hashes object addresses. Objects are aligned, so the lowest bits of an address carry no
+	/// information and are shifted out before the address is distributed across shards.
+	struct PointerHash final
+	{
+		template<class T>
+		size_t operator()(const T *pointer) const
+		{
+			return std::hash<const T*>()(pointer) >> 4;
+		}
+	};
+
+
+	/// Hash map which is split into independently locked shards, so that threads accessing different
+	/// keys rarely contend. Every operation is O(1) on average and only locks the shard of its key.
+	/// This class is thread safe.
+	template<class Key, class Value, class Hash = std::hash<Key>, size_t ShardCount = 16>
+	class ShardedMap final : public NonCopyable
+	{
+		static_assert(ShardCount > 0 && (ShardCount & (ShardCount - 1)) == 0, "ShardCount has to be a power of two");
+
+	public:
+		/// Gets the index of the shard which stores the keys with the given hash. The inner maps bucket
+		/// their keys by the low bits of the same hash, so the shard is picked from the high bits of the
+		/// remixed hash instead. Otherwise all keys of a shard would share their low bits and only use a
+		/// fraction of the buckets.
+		static size_t getShardIndex(size_t hash)
+		{
+			// A single shard selects no bits, and shifting by the full width is undefined
+			if constexpr (ShardBits == 0)
+			{
+				return 0;
+			}
+			else
+			{
+				return static_cast<size_t>((static_cast<uint64>(hash) * 0x9E3779B97F4A7C15ull) >> (64 - ShardBits));
+			}
+		}
+
+	public:
+		/// Stores a value, replacing the previous value of the key.
+		void set(const Key &key, Value value)
+		{
+			Shard &shard = getShard(key);
+			std::lock_guard<std::mutex> lock{ shard.mutex };
+			shard.values.insert_or_assign(key, std::move(value));
+		}
+
+		/// Gets a copy of the value of a key.
+		std::optional<Value> get(const Key &key) const
+		{
+			const Shard &shard = getShard(key);
+			std::lock_guard<std::mutex> lock{ shard.mutex };
+
+			const auto it = shard.values.find(key);
+			if (it == shard.values.end())
+			{
+				return {};
+			}
+
+			return it->second;
+		}
+
+		/// Removes a key.
+		/// @returns false if the key didn't exist.
+		bool erase(const Key &key)
+		{
+			Shard &shard = getShard(key);
+			std::lock_guard<std::mutex> lock{ shard.mutex };
+			return shard.values.erase(key) != 0;
+		}
+
+		/// Removes a key only if it still has the given value, so that removing an outdated entry
+		/// doesn't remove a newer value of the same key.
+		/// @returns false if the key didn't exist or had another value.
+		bool erase(const Key &key, const Value &expected)
+		{
+			Shard &shard = getShard(key);
+			std::lock_guard<std::mutex> lock{ shard.mutex };
+
+			const auto it = shard.values.find(key);
+			if (it == shard.values.end() || !(it->second == expected))
+			{
+				return false;
+			}
+
+			shard.values.erase(it);
+			return true;
+		}
+
+		/// Gets the number of stored keys. Keys which are added or removed concurrently might or might
+		/// not be counted.
+		size_t size() const
+		{
+			size_t count = 0;
+			for (const auto &shard : m_shards)
+			{
+				std::lock_guard<std::mutex> lock{ shard.mutex };
+				count += shard.values.size();
+			}
+
+			return count;
+		}
+
+		/// Executes a function callback for each key and value. Only one shard is locked at a time,
+		/// and the callback must not access this map.
+		template<class Functor>
+		void forEach(Functor f) const
+		{
+			for (const auto &shard : m_shards)
+			{
+				std::lock_guard<std::mutex> lock{ shard.mutex };
+				for (const auto &pair : shard.values)
+				{
+					f(pair.first, pair.second);
+				}
+			}
+		}
+
+	private:
+
+		/// Number of hash bits which select a shard.
+		static constexpr size_t ShardBits = []()
+		{
+			size_t bits = 0;
+			while ((size_t(1) << bits) < ShardCount)
+			{
+				++bits;
+			}
+			return bits;
+		}();
+
+		struct Shard
+		{
+			std::unordered_map<Key, Value, Hash> values;
+			mutable std::mutex mutex;
+		};
+
+		const Shard &getShard(const Key &key) const
+		{
+			return m_shards[getShardIndex(Hash()(key))];
+		}
+
+		Shard &getShard(const Key &key)
+		{
+			return m_shards[getShardIndex(Hash()(key))];
+		}
+
+	private:
+
+		std::array<Shard, ShardCount> m_shards;
+	};
+}
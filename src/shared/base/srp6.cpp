@@ -0,0 +1,234 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "srp6.h"
+#include "constants.h"
+#include "hmac.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+
+namespace mmo
+{
+	namespace srp6
+	{
+		namespace
+		{
+			/// Exponents of g are random 152 bit values or sha1 hashes, so cover everything up to the size of N.
+			constexpr int MaxExponentBits = 256;
+
+			/// Calculates x = H(s | authHash).
+			BigNumber CalculateX(const BigNumber &s, const SHA1Hash &authHash)
+			{
+				HashGeneratorSha1 gen;
+				gen.update((const char*)s.asByteArray().data(), s.getNumBytes());
+				gen.update((const char*)authHash.data(), authHash.size());
+				const SHA1Hash xHash = gen.finalize();
+
+				BigNumber x;
+				x.setBinary(xHash.data(), xHash.size());
+				return x;
+			}
+		}
+
+		const MontgomeryModulus &GetModulusN()
+		{
+			static const MontgomeryModulus s_modulus{ constants::srp::N };
+			return s_modulus;
+		}
+
+		BigNumber ModExpG(const BigNumber &exponent)
+		{
+			static const FixedBaseExponentiation s_exponentiation{ constants::srp::g, GetModulusN(), MaxExponentBits };
+			return s_exponentiation.modExp(exponent);
+		}
+
+		BigNumber ModExpN(const BigNumber &base, const BigNumber &exponent)
+		{
+			return base.modExp(exponent, GetModulusN());
+		}
+
+		BigNumber CalculateVerifier(const BigNumber &s, const SHA1Hash &authHash)
+		{
+			return ModExpG(CalculateX(s, authHash));
+		}
+
+		ClientProof CalculateClientProof(const String &userName, const SHA1Hash &authHash, const BigNumber &s, const BigNumber &B)
+		{
+			ClientProof proof;
+
+			// Generate a
+			BigNumber a;
+			a.setRand(19 * 8);
+			assert(a.asUInt32() > 0);
+
+			// Calculate x and v
+			const BigNumber x = CalculateX(s, authHash);
+			const BigNumber v = ModExpG(x);
+
+			// Calculate A
+			proof.A = ModExpG(a);
+
+			// Calculate u
+			const SHA1Hash uHash = Sha1_BigNumbers({ proof.A, B });
+			BigNumber u;
+			u.setBinary(uHash.data(), uHash.size());
+
+			// Calcualte S
+			const BigNumber k{ 3 };
+			const BigNumber S = ModExpN(B - k * v, a + u * x);
+			assert(S.asUInt32() > 0);
+
+			// Calculate proof hashes M1 (client) and M2 (server)
+
+			// Split it into 2 seperate strings, interleaved
+			char S1[16], S2[16];
+			auto arrS = S.asByteArray(32);
+			for (uint32 i = 0; i < 16; i++)
+			{
+				S1[i] = arrS[i * 2];
+				S2[i] = arrS[i * 2 + 1];
+			}
+
+			// Calculate the hash for each string
+			HashGeneratorSha1 gen;
+			gen.update((const char*)S1, 16);
+			const SHA1Hash S1hash = gen.finalize();
+			gen.update((const char*)S2, 16);
+			const SHA1Hash S2hash = gen.finalize();
+
+			// Re-combine them to form the session key
+			uint8 S_hash[40];
+			for (uint32 i = 0; i < 20; i++)
+			{
+				S_hash[i * 2] = S1hash[i];
+				S_hash[i * 2 + 1] = S2hash[i];
+			}
+
+			// Store the session key as BigNumber so that it can be used for calculations later on.
+			proof.sessionKey.setBinary(S_hash, 40);
+
+			// Generate hash of plain username
+			gen.update(userName.c_str(), userName.size());
+			const SHA1Hash userHash = gen.finalize();
+
+			// Generate N and g hashes
+			const SHA1Hash Nhash = Sha1_BigNumbers({ constants::srp::N });
+			const SHA1Hash ghash = Sha1_BigNumbers({ constants::srp::g });
+
+			// Combine N and g hash like this: (N ^ g)
+			uint8 Ng_hash[20];
+			for (uint32 i = 0; i < 20; i++) Ng_hash[i] = Nhash[i] ^ ghash[i];
+			const BigNumber t_Ng_hash{ Ng_hash, 20 };
+
+			// Caluclate M1 hash sent to the server. The values are hashed exactly like the login server
+			// does it: The user hash as raw bytes, all other values as big numbers without leading zeros.
+			Sha1_Add_BigNumbers(gen, { t_Ng_hash });
+			gen.update((const char*)userHash.data(), userHash.size());
+			Sha1_Add_BigNumbers(gen, { s, proof.A, B, proof.sessionKey });
+			proof.M1 = gen.finalize();
+
+			// Calculate M2 hash to store for later comparison on server answer
+			const BigNumber M1{ proof.M1.data(), proof.M1.size() };
+			proof.M2 = Sha1_BigNumbers({ proof.A, M1, proof.sessionKey });
+
+			return proof;
+		}
+
+		std::optional<ServerProof> CalculateServerProof(const String &userName, const BigNumber &s, const BigNumber &v, const BigNumber &b, const BigNumber &B, const BigNumber &A, const SHA1Hash &clientM1)
+		{
+			// Build hash
+			SHA1Hash hash = Sha1_BigNumbers({ A, B });
+
+			// Calculate u and S
+			BigNumber u{ hash.data(), hash.size() };
+			BigNumber S = ModExpN(A * ModExpN(v, u), b);
+
+			// Build t
+			const std::vector<uint8> t = S.asByteArray(32);
+			std::array<uint8, 16> t1;
+			for (size_t i = 0; i < t1.size(); ++i)
+			{
+				t1[i] = t[i * 2];
+			}
+			hash = sha1(reinterpret_cast<const char*>(t1.data()), t1.size());
+
+			std::array<uint8, 40> vK;
+			for (size_t i = 0; i < 20; ++i)
+			{
+				vK[i * 2] = hash[i];
+			}
+			for (size_t i = 0; i < 16; ++i)
+			{
+				t1[i] = t[i * 2 + 1];
+			}
+
+			hash = sha1(reinterpret_cast<const char*>(t1.data()), t1.size());
+			for (size_t i = 0; i < 20; ++i)
+			{
+				vK[i * 2 + 1] = hash[i];
+			}
+
+			BigNumber K{ vK.data(), vK.size() };
+
+			SHA1Hash h;
+			h = Sha1_BigNumbers({ constants::srp::N });
+			hash = Sha1_BigNumbers({ constants::srp::g });
+			for (size_t i = 0; i < h.size(); ++i)
+			{
+				h[i] ^= hash[i];
+			}
+
+			BigNumber t3{ h.data(), h.size() };
+
+			HashGeneratorSha1 sha;
+			Sha1_Add_BigNumbers(sha, { t3 });
+			const auto t4 = sha1(reinterpret_cast<const char*>(userName.data()), userName.size());
+			sha.update(reinterpret_cast<const char*>(t4.data()), t4.size());
+			Sha1_Add_BigNumbers(sha, { s, A, B, K });
+			hash = sha.finalize();
+
+			// Calculate M1 hash on server using values sent by the client and compare it against
+			// the M1 hash sent by the client to see if the passwords do match.
+			const BigNumber M1{ hash.data(), hash.size() };
+			auto sArr = M1.asByteArray(20);
+			if (!std::equal(sArr.begin(), sArr.end(), clientM1.begin()))
+			{
+				return {};
+			}
+
+			// Finish SRP6 by calculating the M2 hash value that is sent back to the client for
+			// verification as well.
+			return ServerProof{ K, Sha1_BigNumbers({ A, M1, K }) };
+		}
+
+		ReconnectNonce GenerateReconnectNonce()
+		{
+			ReconnectNonce nonce;
+			if (RAND_bytes(nonce.data(), static_cast<int>(nonce.size())) != 1)
+			{
+				throw std::runtime_error("Could not generate a random reconnect nonce");
+			}
+
+			return nonce;
+		}
+
+		HMACHash CalculateReconnectProof(const String &userName, const ReconnectNonce &clientNonce, const ReconnectNonce &serverNonce, const std::vector<uint8> &sessionKey)
+		{
+			HashGeneratorHmac gen{ sessionKey.data(), sessionKey.size() };
+			gen.Update(userName.data(), userName.size());
+			gen.Update(reinterpret_cast<const char*>(clientNonce.data()), clientNonce.size());
+			gen.Update(reinterpret_cast<const char*>(serverNonce.data()), serverNonce.size());
+			return gen.Finalize();
+		}
+
+		bool VerifyReconnectProof(const String &userName, const ReconnectNonce &clientNonce, const ReconnectNonce &serverNonce, const std::vector<uint8> &sessionKey, const HMACHash &clientProof)
+		{
+			const HMACHash proof = CalculateReconnectProof(userName, clientNonce, serverNonce, sessionKey);
+			return CRYPTO_memcmp(proof.data(), clientProof.data(), proof.size()) == 0;
+		}
+	}
+}
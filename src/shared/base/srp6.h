@@ -0,0 +1,88 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "big_number.h"
+#include "hmac.h"
+#include "sha1.h"
+#include "typedefs.h"
+
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace mmo
+{
+	namespace srp6
+	{
+		/// Gets the montgomery context of constants::srp::N, which is created on first use.
+		const MontgomeryModulus &GetModulusN();
+
+		/// Calculates g^exponent mod N with precomputed powers of constants::srp::g.
+		BigNumber ModExpG(const BigNumber &exponent);
+
+		/// Calculates base^exponent mod N using the cached montgomery context of N.
+		BigNumber ModExpN(const BigNumber &base, const BigNumber &exponent);
+
+
+		/// Values calculated by a client from the challenge of a server.
+		struct ClientProof final
+		{
+			/// Public ephemeral value of the client which is sent to the server.
+			BigNumber A;
+			/// The session key shared with the server.
+			BigNumber sessionKey;
+			/// Proof hash which is sent to the server.
+			SHA1Hash M1;
+			/// Proof hash which the server has to answer with.
+			SHA1Hash M2;
+		};
+
+		/// Calculates the verifier v which a server stores for an account.
+		/// @param s The password salt of the account.
+		/// @param authHash Hash of the uppercase "NAME:PASSWORD" string.
+		BigNumber CalculateVerifier(const BigNumber &s, const SHA1Hash &authHash);
+
+		/// Calculates the client side of a handshake from the salt and the public value B sent by the server.
+		/// @param userName The uppercase name which is used to log in.
+		/// @param authHash Hash of the uppercase "NAME:PASSWORD" string.
+		ClientProof CalculateClientProof(const String &userName, const SHA1Hash &authHash, const BigNumber &s, const BigNumber &B);
+
+
+		/// Values calculated by a server from a valid client proof.
+		struct ServerProof final
+		{
+			/// The session key shared with the client.
+			BigNumber sessionKey;
+			/// Proof hash which is sent back to the client so that it can verify the server as well.
+			SHA1Hash M2;
+		};
+
+		/// Verifies the proof hash M1 sent by a client and calculates the session key.
+		/// @param userName The uppercase name the client logs in with.
+		/// @param b The private ephemeral value of the server.
+		/// @param B The public ephemeral value of the server, which has been sent to the client.
+		/// @param A The public ephemeral value sent by the client.
+		/// @returns An empty value if the client proof is invalid, which means that the password is wrong.
+		std::optional<ServerProof> CalculateServerProof(const String &userName, const BigNumber &s, const BigNumber &v, const BigNumber &b, const BigNumber &B, const BigNumber &A, const SHA1Hash &clientM1);
+
+
+		/// Random data which the client and the server contribute to a reconnect proof.
+		typedef std::array<uint8, 16> ReconnectNonce;
+
+		/// Generates a cryptographically secure random nonce for a reconnect.
+		ReconnectNonce GenerateReconnectNonce();
+
+		/// Calculates the proof which shows that a reconnecting client still knows the session key of its
+		/// last login: HMAC-SHA1 keyed with K over (userName | clientNonce | serverNonce). Unlike a logon,
+		/// this takes a single hash.
+		/// @param userName The uppercase name the client logs in with.
+		/// @param sessionKey The session key bytes as returned by BigNumber::asByteArray().
+		HMACHash CalculateReconnectProof(const String &userName, const ReconnectNonce &clientNonce, const ReconnectNonce &serverNonce, const std::vector<uint8> &sessionKey);
+
+		/// Verifies the reconnect proof sent by a client. The proofs are compared in constant time, so that
+		/// the comparison doesn't reveal how many bytes of a forged proof are correct.
+		/// @returns false if the client doesn't know the session key.
+		bool VerifyReconnectProof(const String &userName, const ReconnectNonce &clientNonce, const ReconnectNonce &serverNonce, const std::vector<uint8> &sessionKey, const HMACHash &clientProof);
+	}
+}
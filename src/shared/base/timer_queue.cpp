@@ -4,11 +4,14 @@
 #include "macros.h"
 #include "clock.h"
 
+#include <algorithm>
+
 
 namespace mmo
 {
 	TimerQueue::TimerQueue(asio::io_service &service)
 		: m_timer(service)
+		, m_wheel(GetMonotonicTimeMs())
 	{
 	}
 
@@ -17,10 +20,38 @@ namespace mmo
 		return GetAsyncTimeMs();
 	}
 
-	void TimerQueue::AddEvent(EventCallback callback, GameTime time)
+	TimerHandle TimerQueue::AddEvent(EventCallback callback, GameTime time)
 	{
-		m_queue.push(EventEntry(callback, time));
-		SetTimer();
+		// Game time stamps wrap, so only their distance to the current time is meaningful
+		const uint64 now = GetMonotonicTimeMs();
+		const int32 delay = static_cast<int32>(time - static_cast<GameTime>(now));
+		const uint64 expiryTime = now + static_cast<uint64>(std::max(delay, 0));
+
+		const TimerHandle handle = m_wheel.add(std::move(callback), expiryTime);
+
+		// Only re-arm the timer if the new event expires before the next wake up
+		if (!m_timerTime || expiryTime < *m_timerTime)
+		{
+			SetTimer();
+		}
+
+		return handle;
+	}
+
+	bool TimerQueue::CancelEvent(TimerHandle handle)
+	{
+		// The timer stays armed, waking up once more without any expired event is cheaper than re-arming
+		return m_wheel.cancel(handle);
+	}
+
+	bool TimerQueue::IsQueued(TimerHandle handle) const
+	{
+		return m_wheel.isScheduled(handle);
+	}
+
+	TimerWheelStats TimerQueue::GetStats() const
+	{
+		return m_wheel.getStats();
 	}
 
 	void TimerQueue::Update(const asio::system_error &error)
@@ -33,29 +64,23 @@ namespace mmo
 		}
 
 		m_timerTime.reset();
+		UpdateTickTime();
 
-		const auto now = GetNow();
-		while (!m_queue.empty())
-		{
-			const auto &next = m_queue.top();
+		// Executes all expired events as one batch
+		m_wheel.advance(GetMonotonicTimeMs());
 
-			if (now >= next.time)
-			{
-				const auto callback = next.callback;
-				m_queue.pop();
-				callback();
-			}
-			else
-			{
-				SetTimer();
-				break;
-			}
-		}
+		SetTimer();
 	}
 
 	void TimerQueue::SetTimer()
 	{
-		const auto nextEventTime = m_queue.top().time;
+		const auto nextTick = m_wheel.getNextTick();
+		if (!nextTick)
+		{
+			return;
+		}
+
+		const uint64 nextEventTime = *nextTick;
 
 		// Is the timer active?
 		if (m_timerTime)
@@ -70,7 +95,7 @@ namespace mmo
 			}
 		}
 
-		const auto now = GetNow();
+		const uint64 now = GetMonotonicTimeMs();
 		m_timerTime = nextEventTime;
 
 		const auto delay = (std::max(nextEventTime, now) - now);
@@ -4,18 +4,20 @@
 
 #include "typedefs.h"
 #include "non_copyable.h"
+#include "timer_wheel.h"
 
 #include "asio/io_service.hpp"
 #include "asio/high_resolution_timer.hpp"
 
 #include <functional>
 #include <optional>
-#include <queue>
 
 
 namespace mmo
 {
-	/// Provides a class for managing timers.
+	/// Provides a class for managing timers. Timers are kept in a hierarchical timer wheel with
+	/// millisecond ticks of the monotonic clock, so adding and cancelling timers is O(1), and the
+	/// underlying asio timer is only re-armed if a new timer expires before the next scheduled wake up.
 	class TimerQueue
 		: NonCopyable
 	{
@@ -34,43 +36,23 @@ namespace mmo
 		/// Adds a new event to the timer queue to expire at a given timestamp value.
 		/// @param callback The callback to be executed on expiration.
 		/// @param time The timestamp at which the event shoud expire.
-		void AddEvent(EventCallback callback, GameTime time);
+		/// @returns Handle which can be used to cancel the event.
+		TimerHandle AddEvent(EventCallback callback, GameTime time);
+		/// Cancels an event. Cancelling an event which already expired or has been cancelled is allowed.
+		/// @returns true if the event was cancelled, false if it was no longer queued.
+		bool CancelEvent(TimerHandle handle);
+		/// Determines whether an event is still queued.
+		bool IsQueued(TimerHandle handle) const;
+		/// Gets the counters of the underlying timer wheel.
+		TimerWheelStats GetStats() const;
 
 	private:
-		/// Contains data of a queued event entry.
-		struct EventEntry
-		{
-			/// The callback to execute.
-			EventCallback callback;
-			/// The timestamp at which the event has been queued.
-			GameTime time;
-
-			/// Helper for comparison purposes.
-			struct IsLater
-			{
-				inline bool operator ()(const EventEntry &left, const EventEntry &right) const
-				{
-					return (left.time > right.time);
-				}
-			};
-
-			EventEntry()
-			{
-			}
-
-			EventEntry(const EventCallback &callback, GameTime time)
-				: callback(callback)
-				, time(time)
-			{
-			}
-		};
-
-		typedef std::priority_queue<EventEntry, std::vector<EventEntry>, EventEntry::IsLater> Queue;
 		typedef asio::high_resolution_timer Timer;
 
 		Timer m_timer;
-		std::optional<GameTime> m_timerTime;
-		Queue m_queue;
+		/// Monotonic time in milliseconds at which the timer is armed to expire.
+		std::optional<uint64> m_timerTime;
+		TimerWheel m_wheel;
 
 	private:
 		void Update(const asio::system_error &error);
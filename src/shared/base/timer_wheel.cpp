@@ -0,0 +1,359 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "timer_wheel.h"
+#include "assign_on_exit.h"
+#include "macros.h"
+
+#include <algorithm>
+
+
+namespace mmo
+{
+	TimerWheel::TimerWheel(uint64 startTick)
+		: m_currentTick(startTick)
+		, m_activeCount(0)
+		, m_isAdvancing(false)
+		, m_stats()
+	{
+		m_slotHeads.fill(NoEntry);
+		m_slotTails.fill(NoEntry);
+		m_levelCounts.fill(0);
+	}
+
+	TimerHandle TimerWheel::add(Callback callback, uint64 expiryTick)
+	{
+		ASSERT(callback);
+
+		uint32 index;
+		if (!m_freeEntries.empty())
+		{
+			index = m_freeEntries.back();
+			m_freeEntries.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32>(m_entries.size());
+			m_entries.emplace_back();
+		}
+
+		Entry &entry = m_entries[index];
+		entry.callback = std::move(callback);
+		entry.expiryTick = expiryTick;
+		link(index);
+
+		++m_activeCount;
+		++m_stats.scheduledTimers;
+
+		return TimerHandle(index, entry.generation);
+	}
+
+	bool TimerWheel::cancel(TimerHandle handle)
+	{
+		if (handle.index >= m_entries.size())
+		{
+			return false;
+		}
+
+		Entry &entry = m_entries[handle.index];
+		if (entry.generation != handle.generation)
+		{
+			return false;
+		}
+
+		switch (entry.state)
+		{
+		case EntryState::Scheduled:
+			unlink(handle.index);
+			release(handle.index);
+			--m_activeCount;
+			break;
+		case EntryState::Expiring:
+			// Part of the batch which is currently executed: The batch releases the entry
+			if (!entry.callback)
+			{
+				return false;
+			}
+			entry.callback = nullptr;
+			break;
+		default:
+			return false;
+		}
+
+		++m_stats.cancelledTimers;
+		return true;
+	}
+
+	bool TimerWheel::isScheduled(TimerHandle handle) const
+	{
+		return handle.index < m_entries.size() &&
+			m_entries[handle.index].generation == handle.generation &&
+			m_entries[handle.index].state == EntryState::Scheduled;
+	}
+
+	size_t TimerWheel::advance(uint64 nowTick)
+	{
+		// Callbacks must not advance the wheel they are executed by
+		ASSERT(!m_isAdvancing);
+		m_isAdvancing = true;
+		AssignOnExit<bool> isAdvancingResetter(m_isAdvancing, false);
+
+		constexpr uint64 firstLevelMask = FirstLevelSlots - 1;
+
+		size_t executed = 0;
+		while (m_currentTick <= nowTick)
+		{
+			if (m_activeCount == 0)
+			{
+				m_currentTick = nowTick + 1;
+				break;
+			}
+
+			// Without timers in the first level, nothing happens until the next cascade
+			if (m_levelCounts[0] == 0 && (m_currentTick & firstLevelMask) != 0)
+			{
+				const uint64 nextCascadeTick = (m_currentTick | firstLevelMask) + 1;
+				if (nextCascadeTick > nowTick)
+				{
+					m_currentTick = nowTick + 1;
+					break;
+				}
+
+				m_currentTick = nextCascadeTick;
+			}
+
+			// Cascade the coarsest levels first, so that their timers end up in the finer slots
+			// which are cascaded afterwards
+			if ((m_currentTick & firstLevelMask) == 0)
+			{
+				for (size_t level = LevelCount - 1; level > 0; --level)
+				{
+					const uint64 levelMask = (uint64(1) << getLevelShift(level)) - 1;
+					if ((m_currentTick & levelMask) == 0 && m_levelCounts[level] > 0)
+					{
+						cascade(level);
+					}
+				}
+			}
+
+			executed += expireCurrentSlot();
+		}
+
+		return executed;
+	}
+
+	std::optional<uint64> TimerWheel::getNextTick() const
+	{
+		if (m_activeCount == 0)
+		{
+			return std::nullopt;
+		}
+
+		std::optional<uint64> nextTick;
+
+		if (m_levelCounts[0] > 0)
+		{
+			for (uint64 tick = m_currentTick; tick < m_currentTick + FirstLevelSlots; ++tick)
+			{
+				if (m_slotHeads[tick & (FirstLevelSlots - 1)] != NoEntry)
+				{
+					nextTick = tick;
+					break;
+				}
+			}
+		}
+
+		for (size_t level = 1; level < LevelCount; ++level)
+		{
+			if (m_levelCounts[level] == 0)
+			{
+				continue;
+			}
+
+			// Slots of coarser levels are due once the current tick reaches their start
+			const uint32 shift = getLevelShift(level);
+			const uint64 firstRotation = (m_currentTick + (uint64(1) << shift) - 1) >> shift;
+			for (uint64 rotation = firstRotation; rotation < firstRotation + LevelSlots; ++rotation)
+			{
+				if (m_slotHeads[getLevelOffset(level) + (rotation & (LevelSlots - 1))] != NoEntry)
+				{
+					const uint64 tick = rotation << shift;
+					if (!nextTick || tick < *nextTick)
+					{
+						nextTick = tick;
+					}
+					break;
+				}
+			}
+		}
+
+		return nextTick;
+	}
+
+	TimerWheelStats TimerWheel::getStats() const
+	{
+		TimerWheelStats stats = m_stats;
+		stats.activeTimers = m_activeCount;
+		return stats;
+	}
+
+	uint32 TimerWheel::getLevelShift(size_t level)
+	{
+		return (level == 0) ? 0 : FirstLevelBits + static_cast<uint32>(level - 1) * LevelBits;
+	}
+
+	size_t TimerWheel::getLevelOffset(size_t level)
+	{
+		return (level == 0) ? 0 : FirstLevelSlots + (level - 1) * LevelSlots;
+	}
+
+	size_t TimerWheel::getSlotLevel(size_t slot)
+	{
+		return (slot < FirstLevelSlots) ? 0 : 1 + (slot - FirstLevelSlots) / LevelSlots;
+	}
+
+	void TimerWheel::link(uint32 index)
+	{
+		Entry &entry = m_entries[index];
+
+		// Timers which are already due expire with the current tick
+		uint64 expiryTick = std::max(entry.expiryTick, m_currentTick);
+		const uint64 delta = expiryTick - m_currentTick;
+
+		size_t level = 0;
+		while (level < LevelCount - 1 && delta >= (uint64(1) << (getLevelShift(level + 1))))
+		{
+			++level;
+		}
+
+		// Timers beyond the range of the wheel are parked in the coarsest level and relinked
+		// with their real expiry tick when that slot is cascaded
+		const uint32 shift = getLevelShift(level);
+		const uint64 levelRange = uint64(1) << (shift + (level == 0 ? FirstLevelBits : LevelBits));
+		if (delta >= levelRange)
+		{
+			expiryTick = m_currentTick + levelRange - 1;
+		}
+
+		const size_t slotMask = (level == 0 ? FirstLevelSlots : LevelSlots) - 1;
+		const size_t slot = getLevelOffset(level) + ((expiryTick >> shift) & slotMask);
+
+		// Append to keep timers which expire on the same tick in the order they have been added
+		entry.prev = m_slotTails[slot];
+		entry.next = NoEntry;
+		if (entry.prev != NoEntry)
+		{
+			m_entries[entry.prev].next = index;
+		}
+		else
+		{
+			m_slotHeads[slot] = index;
+		}
+		m_slotTails[slot] = index;
+
+		entry.slot = static_cast<uint16>(slot);
+		entry.state = EntryState::Scheduled;
+		++m_levelCounts[level];
+	}
+
+	void TimerWheel::unlink(uint32 index)
+	{
+		Entry &entry = m_entries[index];
+		ASSERT(entry.state == EntryState::Scheduled);
+
+		if (entry.prev != NoEntry)
+		{
+			m_entries[entry.prev].next = entry.next;
+		}
+		else
+		{
+			m_slotHeads[entry.slot] = entry.next;
+		}
+
+		if (entry.next != NoEntry)
+		{
+			m_entries[entry.next].prev = entry.prev;
+		}
+		else
+		{
+			m_slotTails[entry.slot] = entry.prev;
+		}
+
+		--m_levelCounts[getSlotLevel(entry.slot)];
+	}
+
+	void TimerWheel::release(uint32 index)
+	{
+		Entry &entry = m_entries[index];
+		entry.callback = nullptr;
+		entry.state = EntryState::Free;
+
+		// Invalidates all handles of this entry
+		++entry.generation;
+		m_freeEntries.push_back(index);
+	}
+
+	void TimerWheel::cascade(size_t level)
+	{
+		const size_t slot = getLevelOffset(level) + ((m_currentTick >> getLevelShift(level)) & (LevelSlots - 1));
+
+		uint32 index = m_slotHeads[slot];
+		m_slotHeads[slot] = NoEntry;
+		m_slotTails[slot] = NoEntry;
+
+		while (index != NoEntry)
+		{
+			const uint32 next = m_entries[index].next;
+
+			--m_levelCounts[level];
+			link(index);
+			++m_stats.cascadedTimers;
+
+			index = next;
+		}
+	}
+
+	size_t TimerWheel::expireCurrentSlot()
+	{
+		const size_t slot = static_cast<size_t>(m_currentTick & (FirstLevelSlots - 1));
+
+		m_batch.clear();
+		for (uint32 index = m_slotHeads[slot]; index != NoEntry; index = m_entries[index].next)
+		{
+			m_entries[index].state = EntryState::Expiring;
+			m_batch.push_back(index);
+		}
+
+		m_slotHeads[slot] = NoEntry;
+		m_slotTails[slot] = NoEntry;
+		m_levelCounts[0] -= m_batch.size();
+		m_activeCount -= m_batch.size();
+
+		// Timers added by the callbacks below must not end up in the slot which is just processed
+		++m_currentTick;
+
+		if (m_batch.empty())
+		{
+			return 0;
+		}
+
+		++m_stats.expiryBatches;
+		m_stats.largestBatch = std::max(m_stats.largestBatch, m_batch.size());
+
+		size_t executed = 0;
+		for (const uint32 index : m_batch)
+		{
+			// The callback may add timers, which could reallocate the entries
+			Callback callback = std::move(m_entries[index].callback);
+			release(index);
+
+			if (callback)
+			{
+				callback();
+				++executed;
+			}
+		}
+
+		m_stats.expiredTimers += executed;
+		return executed;
+	}
+}
@@ -0,0 +1,176 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "typedefs.h"
+#include "non_copyable.h"
+
+#include <array>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <vector>
+
+
+namespace mmo
+{
+	/// Identifies a timer of a TimerWheel. A handle stays safe to use after its timer expired or
+	/// has been cancelled, since entries are versioned and reused entries get a new version.
+	struct TimerHandle
+	{
+		/// Index of the timer entry.
+		uint32 index;
+		/// Version of the timer entry at the time the timer has been added.
+		uint32 generation;
+
+		TimerHandle()
+			: index(std::numeric_limits<uint32>::max())
+			, generation(0)
+		{
+		}
+
+		explicit TimerHandle(uint32 index, uint32 generation)
+			: index(index)
+			, generation(generation)
+		{
+		}
+
+		/// Determines whether this handle has ever been assigned to a timer.
+		bool isValid() const
+		{
+			return index != std::numeric_limits<uint32>::max();
+		}
+	};
+
+
+	/// Counters of a TimerWheel.
+	struct TimerWheelStats
+	{
+		/// Number of timers which are currently scheduled.
+		size_t activeTimers;
+		/// Total number of added timers.
+		uint64 scheduledTimers;
+		/// Total number of expired timers whose callbacks have been executed.
+		uint64 expiredTimers;
+		/// Total number of cancelled timers.
+		uint64 cancelledTimers;
+		/// Total number of timers which have been moved to a finer wheel level.
+		uint64 cascadedTimers;
+		/// Total number of non-empty batches of expired timers.
+		uint64 expiryBatches;
+		/// Largest number of timers which expired in a single batch.
+		size_t largestBatch;
+	};
+
+
+	/// Hierarchical timing wheel with a resolution of one tick. Adding and cancelling a timer are
+	/// O(1) operations. Timers which are further away than the first level are kept in coarser
+	/// levels and cascaded down once they come close, so that every timer is only touched a few
+	/// times no matter how many timers are scheduled. All timers which expire on the same tick are
+	/// executed as one batch. This class is not thread safe.
+	class TimerWheel
+		: NonCopyable
+	{
+	public:
+		/// Callback that is executed on expiration of a timer.
+		typedef std::function<void ()> Callback;
+
+		/// Number of wheel levels.
+		static constexpr size_t LevelCount = 4;
+		/// Number of bits of a tick which are covered by the first level.
+		static constexpr uint32 FirstLevelBits = 8;
+		/// Number of bits of a tick which are covered by each further level.
+		static constexpr uint32 LevelBits = 6;
+
+	public:
+		/// Creates an empty wheel.
+		/// @param startTick The current tick. Timers expire relative to this tick.
+		explicit TimerWheel(uint64 startTick);
+
+	public:
+		/// Adds a new timer. Timers expiring at a tick which has already been processed expire
+		/// with the next tick.
+		/// @param callback The callback to execute on expiration.
+		/// @param expiryTick The tick at which the timer should expire.
+		/// @returns Handle which can be used to cancel the timer.
+		TimerHandle add(Callback callback, uint64 expiryTick);
+		/// Cancels a timer. Cancelling a timer which already expired or has been cancelled is allowed.
+		/// @returns true if the timer was cancelled, false if it was no longer scheduled.
+		bool cancel(TimerHandle handle);
+		/// Determines whether a timer is scheduled and has neither expired nor been cancelled yet.
+		bool isScheduled(TimerHandle handle) const;
+		/// Processes all ticks up to and including a given tick and executes the callbacks of all
+		/// expired timers. Callbacks may add and cancel timers.
+		/// @returns Number of executed callbacks.
+		size_t advance(uint64 nowTick);
+		/// Gets the tick at which the wheel has to be advanced next, either because a timer expires
+		/// or because timers have to be cascaded down. Empty if no timer is scheduled.
+		std::optional<uint64> getNextTick() const;
+		/// Gets the next tick which has not been processed yet.
+		uint64 getCurrentTick() const { return m_currentTick; }
+		/// Gets the number of scheduled timers.
+		size_t size() const { return m_activeCount; }
+		/// Determines whether there are no scheduled timers.
+		bool empty() const { return m_activeCount == 0; }
+		/// Gets a copy of the counters of this wheel.
+		TimerWheelStats getStats() const;
+
+	private:
+		static constexpr uint32 NoEntry = std::numeric_limits<uint32>::max();
+		static constexpr size_t FirstLevelSlots = size_t(1) << FirstLevelBits;
+		static constexpr size_t LevelSlots = size_t(1) << LevelBits;
+		static constexpr size_t SlotCount = FirstLevelSlots + (LevelCount - 1) * LevelSlots;
+
+		/// Enumerates the states of a timer entry.
+		enum class EntryState : uint8
+		{
+			/// The entry is unused and in the free list.
+			Free,
+			/// The entry is linked into a slot.
+			Scheduled,
+			/// The entry is part of the batch which is currently executed.
+			Expiring
+		};
+
+		/// A timer entry, which is linked into the doubly linked list of its slot.
+		struct Entry
+		{
+			Callback callback;
+			uint64 expiryTick;
+			uint32 generation;
+			uint32 prev;
+			uint32 next;
+			uint16 slot;
+			EntryState state;
+		};
+
+		std::vector<Entry> m_entries;
+		std::vector<uint32> m_freeEntries;
+		std::array<uint32, SlotCount> m_slotHeads;
+		std::array<uint32, SlotCount> m_slotTails;
+		std::array<size_t, LevelCount> m_levelCounts;
+		std::vector<uint32> m_batch;
+		uint64 m_currentTick;
+		size_t m_activeCount;
+		bool m_isAdvancing;
+		TimerWheelStats m_stats;
+
+	private:
+		/// Gets the number of tick bits covered by all levels below a given level.
+		static uint32 getLevelShift(size_t level);
+		/// Gets the index of the first slot of a level.
+		static size_t getLevelOffset(size_t level);
+		/// Gets the level which contains a slot.
+		static size_t getSlotLevel(size_t slot);
+		/// Links an entry into the slot matching its expiry tick.
+		void link(uint32 index);
+		/// Removes an entry from its slot.
+		void unlink(uint32 index);
+		/// Puts an entry back into the free list.
+		void release(uint32 index);
+		/// Moves all entries of a slot of a coarser level down to the finer levels.
+		void cascade(size_t level);
+		/// Executes all timers of the first level slot of the current tick.
+		size_t expireCurrentSlot();
+	};
+}
@@ -0,0 +1,102 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "worker_pool.h"
+
+#include <algorithm>
+
+namespace mmo
+{
+	WorkerPool::WorkerPool(size_t threadCount, size_t queueCapacity)
+		: m_threadCount(threadCount > 0 ? threadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1))
+		, m_queueCapacity(std::max<size_t>(queueCapacity, 1))
+		, m_stopping(false)
+		, m_completedTasks(0)
+	{
+		m_threads.reserve(m_threadCount);
+		for (size_t i = 0; i < m_threadCount; ++i)
+		{
+			m_threads.emplace_back([this]() { run(); });
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		stop();
+	}
+
+	bool WorkerPool::tryPost(Task task)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			if (m_stopping || m_tasks.size() >= m_queueCapacity)
+			{
+				m_stats.rejectedTasks++;
+				return false;
+			}
+
+			m_tasks.emplace_back(std::move(task));
+			m_stats.acceptedTasks++;
+			m_stats.peakQueueSize = std::max(m_stats.peakQueueSize, m_tasks.size());
+		}
+
+		m_taskAvailable.notify_one();
+		return true;
+	}
+
+	void WorkerPool::stop()
+	{
+		// Concurrent calls must not join the same threads, so the first call takes them
+		std::vector<std::thread> threads;
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_stopping = true;
+			threads.swap(m_threads);
+		}
+
+		m_taskAvailable.notify_all();
+
+		for (auto &thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	size_t WorkerPool::getQueueSize() const
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_tasks.size();
+	}
+
+	WorkerPoolStats WorkerPool::getStats() const
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+
+		WorkerPoolStats stats = m_stats;
+		stats.completedTasks = m_completedTasks.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void WorkerPool::run()
+	{
+		for (;;)
+		{
+			Task task;
+			{
+				std::unique_lock<std::mutex> lock{ m_mutex };
+				m_taskAvailable.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+				// Queued tasks are still executed after the pool has been stopped
+				if (m_tasks.empty())
+				{
+					return;
+				}
+
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+
+			task();
+			m_completedTasks.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
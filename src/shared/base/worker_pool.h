@@ -0,0 +1,89 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "typedefs.h"
+#include "non_copyable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mmo
+{
+	/// Counters of a worker pool.
+	struct WorkerPoolStats final
+	{
+		/// Number of tasks which have been accepted.
+		uint64 acceptedTasks = 0;
+		/// Number of tasks which have been executed.
+		uint64 completedTasks = 0;
+		/// Number of tasks which have been rejected because the queue was full or the pool was stopped.
+		uint64 rejectedTasks = 0;
+		/// Maximum number of tasks which have been queued at once.
+		size_t peakQueueSize = 0;
+	};
+
+
+	/// Executes cpu heavy tasks, like the big number math of a login, on a fixed number of threads so
+	/// that they don't block the network threads. The task queue is bounded: If it is full, new tasks are
+	/// rejected instead of letting the latency of every queued task grow without limit, so the caller
+	/// can tell the client to try again later. Tasks which need to touch a connection have to post their
+	/// result back to the strand of that connection.
+	/// This class is thread safe.
+	class WorkerPool final
+		: public NonCopyable
+	{
+	public:
+
+		typedef std::function<void()> Task;
+
+	public:
+		/// Launches the worker threads.
+		/// @param threadCount Number of worker threads. If 0, one thread per available hardware
+		///        thread is used.
+		/// @param queueCapacity Maximum number of tasks which may wait for a worker thread.
+		explicit WorkerPool(size_t threadCount, size_t queueCapacity);
+		/// Stops the pool after all queued tasks have been executed.
+		~WorkerPool();
+
+	public:
+		/// Queues a task for execution on one of the worker threads.
+		/// @returns false if the task has been rejected because the queue is full or the pool has
+		///          been stopped. The task is not executed in that case.
+		bool tryPost(Task task);
+		/// Executes all queued tasks, then stops and joins the worker threads. New tasks are rejected
+		/// from now on. Calling this more than once is allowed: Only the first call joins the threads,
+		/// later calls don't wait for it.
+		void stop();
+		/// Gets the number of worker threads the pool has been launched with.
+		size_t size() const { return m_threadCount; }
+		/// Gets the maximum number of queued tasks.
+		size_t getQueueCapacity() const { return m_queueCapacity; }
+		/// Gets the number of tasks which are currently waiting for a worker thread.
+		size_t getQueueSize() const;
+		/// Gets a snapshot of the counters of this pool.
+		WorkerPoolStats getStats() const;
+
+	private:
+		/// Entry point of a worker thread.
+		void run();
+
+	private:
+
+		const size_t m_threadCount;
+		const size_t m_queueCapacity;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_taskAvailable;
+		std::deque<Task> m_tasks;
+		/// Worker threads which have not been joined yet. Taken by the stop call which joins them.
+		std::vector<std::thread> m_threads;
+		bool m_stopping;
+		WorkerPoolStats m_stats;
+		std::atomic<uint64> m_completedTasks;
+	};
+}
@@ -5,6 +5,7 @@
 #include "sink.h"
 
 #include <string>
+#include <cstring>
 #include <cassert>
 
 namespace io
@@ -33,11 +33,15 @@ namespace mmo
 
 			explicit EncryptedConnection(std::unique_ptr<Socket> Socket_, Listener *Listener_)
 				: m_socket(std::move(Socket_))
+				, m_strand(m_socket->get_executor())
 				, m_listener(Listener_)
+				, m_slowConsumerTimer(m_socket->get_executor())
 				, m_isParsingIncomingData(false)
 				, m_isClosedOnParsing(false)
 				, m_decryptedUntil(0)
 				, m_isReceiving(false)
+				, m_isBlockedByListener(false)
+				, m_isDroppingSlowConsumer(false)
 			{
 			}
 			virtual ~EncryptedConnection() = default;
@@ -55,7 +59,7 @@ namespace mmo
 
 				m_crypt.EncryptSend(reinterpret_cast<uint8*>(&m_sendBuffer[bufferPos]), game::Crypt::CryptedSendLength);
 
-				flush();
+				requestFlush();
 			}
 
 		public:
@@ -87,30 +91,112 @@ namespace mmo
 			}
 			void resumeParsing() override
 			{
+				m_isBlockedByListener = false;
 				ParsePackets();
 			}
-			void flush() override
+			/// Queues a shared buffer without copying it. The buffer is sent as is, so it must not
+			/// contain packet headers since those need to be encrypted for each connection.
+			void sendSharedBuffer(SharedBuffer buffer) override
 			{
-				if (m_sendBuffer.empty())
+				if (m_isDroppingSlowConsumer)
 				{
+					m_sendBuffer.clear();
 					return;
 				}
 
-				if (!m_sending.empty())
+				m_sendQueue.push(m_sendBuffer);
+				m_sendQueue.push(std::move(buffer));
+				UpdateBackpressure();
+			}
+			void flush() override
+			{
+				m_cork.flushed();
+
+				// Data written while a send is in progress is sent when the current send completed
+				if (m_sendQueue.isSending())
 				{
 					return;
 				}
 
-				m_sending = m_sendBuffer;
-				m_sendBuffer.clear();
+				m_sendQueue.push(m_sendBuffer);
+				if (!m_sendQueue.hasPending())
+				{
+					return;
+				}
 
 				ASSERT(m_sendBuffer.empty());
-				ASSERT(!m_sending.empty());
 
 				BeginSend();
 			}
+			void requestFlush() override
+			{
+				// Nothing is sent anymore to a slow consumer which is being dropped
+				if (m_isDroppingSlowConsumer)
+				{
+					m_sendBuffer.clear();
+					return;
+				}
+
+				if (!m_cork.isEnabled())
+				{
+					flush();
+					UpdateBackpressure();
+					return;
+				}
+
+				switch (m_cork.packetWritten(GetMonotonicTimeNs()))
+				{
+				case SendCork::Action::FlushNow:
+					flush();
+					break;
+				case SendCork::Action::ScheduleFlush:
+					asio::post(m_strand, std::bind(&EncryptedConnection<P, Socket>::CorkedFlush, this->shared_from_this()));
+					break;
+				case SendCork::Action::None:
+					break;
+				}
+
+				UpdateBackpressure();
+			}
+			void setCorked(bool corked, std::chrono::microseconds maxLatency) override
+			{
+				if (corked)
+				{
+					m_cork.enable(maxLatency);
+				}
+				else
+				{
+					m_cork.disable();
+					flush();
+				}
+			}
+			void setSendWatermarks(const SendWatermarks &watermarks) override
+			{
+				m_backpressure.setWatermarks(watermarks);
+			}
+			size_t getQueuedSendSize() const override
+			{
+				return m_sendBuffer.size() + m_sendQueue.getQueuedSize();
+			}
+			size_t getPeakQueuedSendSize() const override
+			{
+				return m_backpressure.getPeakSize();
+			}
+			void post(std::function<void()> handler) override
+			{
+				asio::post(m_strand, [handler = std::move(handler)]()
+				{
+					UpdateTickTime();
+					handler();
+				});
+			}
 			void close() override
 			{
+				if (m_cork.isPending())
+				{
+					flush();
+				}
+
 				if (m_isParsingIncomingData)
 				{
 					m_isClosedOnParsing = true;
@@ -150,44 +236,166 @@ namespace mmo
 			}
 
 		private:
-			typedef std::array<char, 4096> ReceiveBuffer;
-
 			std::unique_ptr<Socket> m_socket;
+			asio::strand<typename Socket::executor_type> m_strand;
 			Listener *m_listener;
-			Buffer m_sending;
+			SendQueue m_sendQueue;
 			Buffer m_sendBuffer;
-			Buffer m_received;
+			SendCork m_cork;
+			SendBackpressure m_backpressure;
+			asio::steady_timer m_slowConsumerTimer;
+			ReceiveBuffer m_received;
 			game::Crypt m_crypt;
-			ReceiveBuffer m_receiving;
 			bool m_isParsingIncomingData;
 			bool m_isClosedOnParsing;
 			size_t m_decryptedUntil;
 			bool m_isReceiving;
+			bool m_isBlockedByListener;
+			bool m_isDroppingSlowConsumer;
 
 		private:
+			void CorkedFlush()
+			{
+				if (m_cork.scheduledFlushExecuted())
+				{
+					flush();
+				}
+			}
+
+			void UpdateBackpressure()
+			{
+				if (!m_backpressure.isEnabled())
+				{
+					return;
+				}
+
+				const size_t queuedSize = getQueuedSendSize();
+				switch (m_backpressure.update(queuedSize, GetTickTimeNs()))
+				{
+				case SendBackpressure::Event::HighWatermarkReached:
+					if (PacketStatistics::isEnabled())
+					{
+						PacketStatistics::get<P>().recordHighWatermark();
+					}
+
+					if (m_backpressure.getWatermarks().slowConsumerTimeout.count() > 0)
+					{
+						m_slowConsumerTimer.expires_after(m_backpressure.getWatermarks().slowConsumerTimeout);
+						m_slowConsumerTimer.async_wait(
+							asio::bind_executor(m_strand, std::bind(&EncryptedConnection<P, Socket>::SlowConsumerTimerExpired, this->shared_from_this(), std::placeholders::_1)));
+					}
+
+					if (m_listener)
+					{
+						m_listener->connectionSendBufferHigh(queuedSize);
+					}
+					break;
+				case SendBackpressure::Event::LowWatermarkReached:
+					m_slowConsumerTimer.cancel();
+
+					if (m_listener)
+					{
+						m_listener->connectionSendBufferLow(queuedSize);
+					}
+
+					// Continue with the packets which have been received while parsing was paused
+					if (m_backpressure.getWatermarks().pauseParsing && !m_isBlockedByListener && !m_isParsingIncomingData)
+					{
+						ParsePackets();
+					}
+					break;
+				case SendBackpressure::Event::LimitExceeded:
+					DropSlowConsumer();
+					break;
+				case SendBackpressure::Event::None:
+					break;
+				}
+			}
+
+			void SlowConsumerTimerExpired(const asio::error_code &error)
+			{
+				if (error)
+				{
+					return;
+				}
+
+				// The timer might have expired right before the connection has been drained
+				if (m_backpressure.isSlowConsumer(GetMonotonicTimeNs()))
+				{
+					DropSlowConsumer();
+				}
+			}
+
+			void DropSlowConsumer()
+			{
+				// The limit is exceeded by every packet which is written until the connection is closed
+				if (m_isDroppingSlowConsumer)
+				{
+					return;
+				}
+
+				m_isDroppingSlowConsumer = true;
+
+				WLOG("Dropping slow consumer connection with " << getQueuedSendSize() << " bytes of unsent data");
+
+				if (PacketStatistics::isEnabled())
+				{
+					PacketStatistics::get<P>().recordSlowConsumerDropped();
+				}
+
+				m_sendBuffer.clear();
+
+				// Disconnecting would destroy the listener while its packet handler is still running
+				if (m_isParsingIncomingData)
+				{
+					m_isClosedOnParsing = true;
+					return;
+				}
+
+				// Packets are also sent outside of the parse loop, for example by database callbacks, and the
+				// listener which is sending might be destroyed by the disconnect as well
+				if (m_socket)
+				{
+					asio::post(m_strand, std::bind(&EncryptedConnection<P, Socket>::Disconnected, this->shared_from_this()));
+				}
+			}
+
 			void BeginSend()
 			{
-				ASSERT(!m_sending.empty());
+				ASSERT(m_sendQueue.hasPending());
 
 				if (!m_socket)
 					return;
 
 				asio::async_write(
 					*m_socket,
-					asio::buffer(m_sending),
-					std::bind(&EncryptedConnection<P, Socket>::Sent, this->shared_from_this(), std::placeholders::_1));
+					m_sendQueue.beginSend(),
+					asio::bind_executor(m_strand, std::bind(&EncryptedConnection<P, Socket>::Sent, this->shared_from_this(), std::placeholders::_1)));
 			}
 
 			void Sent(const asio::system_error &error)
 			{
+				UpdateTickTime();
+
 				if (error.code())
 				{
 					Disconnected();
 					return;
 				}
 
-				m_sending.clear();
+				if (PacketStatistics::isEnabled())
+				{
+					PacketStatistics::get<P>().recordDataSent(m_sendQueue.getSendingSize());
+				}
+
+				if (m_listener)
+				{
+					m_listener->connectionDataSent(m_sendQueue.getSendingSize());
+				}
+
+				m_sendQueue.sendCompleted();
 				flush();
+				UpdateBackpressure();
 			}
 
 			void BeginReceive()
@@ -199,31 +407,40 @@ namespace mmo
 					return;
 
 				m_isReceiving = true;
+
+				// Read directly into the free space at the end of the receive buffer
+				char *const receiveBegin = m_received.prepare();
 				m_socket->async_read_some(
-					asio::buffer(m_receiving.data(), m_receiving.size()),
-					std::bind(&EncryptedConnection<P, Socket>::Received, this->shared_from_this(), std::placeholders::_2));
+					asio::buffer(receiveBegin, m_received.getWritableSize()),
+					asio::bind_executor(m_strand, std::bind(&EncryptedConnection<P, Socket>::Received, this->shared_from_this(), std::placeholders::_2)));
 			}
 
 			void Received(std::size_t size)
 			{
+				UpdateTickTime();
+
 				m_isReceiving = false;
 
-				ASSERT(size <= m_receiving.size());
+				ASSERT(size <= m_received.getWritableSize());
 				if (size == 0)
 				{
 					Disconnected();
 					return;
 				}
 
-				m_received.append(
-					m_receiving.begin(),
-					m_receiving.begin() + size);
+				m_received.commit(size);
 
 				ParsePackets();
 			}
 
 			void ParsePackets()
 			{
+				// Neither parse nor receive anything until the peer read the data which is queued already
+				if (m_backpressure.isParsingPaused())
+				{
+					return;
+				}
+
 				m_isParsingIncomingData = true;
 				AssignOnExit<bool> isParsingIncomingDataResetter(
 					m_isParsingIncomingData, false);
@@ -240,14 +457,14 @@ namespace mmo
 					if (m_decryptedUntil <= parsedUntil &&
 						availableSize >= game::Crypt::CryptedReceiveLength)
 					{
-						m_crypt.DecryptReceive(reinterpret_cast<uint8 *>(&m_received[0] + parsedUntil), game::Crypt::CryptedReceiveLength);
+						m_crypt.DecryptReceive(reinterpret_cast<uint8 *>(m_received.data() + parsedUntil), game::Crypt::CryptedReceiveLength);
 
 						// This will prevent double-decryption of the header (which would produce
 						// invalid packet sizes)
 						m_decryptedUntil = parsedUntil + game::Crypt::CryptedReceiveLength;
 					}
 
-					const char *const packetBegin = &m_received[0] + parsedUntil;
+					const char *const packetBegin = m_received.data() + parsedUntil;
 					const char *const streamEnd = packetBegin + availableSize;
 
 					io::MemorySource source(packetBegin, streamEnd);
@@ -262,13 +479,25 @@ namespace mmo
 					case receive_state::Complete:
 						if (m_listener)
 						{
+							// Measure the handler only if statistics are enabled to keep the cost near zero otherwise
+							const bool recordStatistics = PacketStatistics::isEnabled();
+							const auto handlerStart = recordStatistics ? PacketStatistics::Clock::now() : PacketStatistics::Clock::time_point();
+
 							auto result = m_listener->connectionPacketReceived(packet);
+
+							if (recordStatistics)
+							{
+								PacketStatistics::get<P>().recordPacketReceived(packet.GetId(), static_cast<size_t>(source.getPosition() - source.getBegin()),
+									PacketStatistics::Clock::now() - handlerStart);
+							}
+
 							switch (result)
 							{
 							case PacketParseResult::Pass:
 								nextPacket = true;
 								break;
 							case PacketParseResult::Block:
+								m_isBlockedByListener = true;
 								nextPacket = false;
 								break;
 							case PacketParseResult::Disconnect:
@@ -281,6 +510,11 @@ namespace mmo
 								}
 								break;
 							}
+
+							if (m_backpressure.isParsingPaused())
+							{
+								nextPacket = false;
+							}
 						}
 						parsedUntil += static_cast<std::size_t>(source.getPosition() - source.getBegin());
 						break;
@@ -306,26 +540,29 @@ namespace mmo
 				{
 					ASSERT(parsedUntil <= m_received.size());
 
-					m_received.erase(
-						m_received.begin(),
-						m_received.begin() + static_cast<std::ptrdiff_t>(parsedUntil));
+					m_received.consume(parsedUntil);
 
-					// Reset
-					m_decryptedUntil = 0;
+					// The decrypted header offset is relative to the first unconsumed byte
+					m_decryptedUntil = (m_decryptedUntil > parsedUntil) ? (m_decryptedUntil - parsedUntil) : 0;
 				}
 
-				BeginReceive();
+				if (!m_backpressure.isParsingPaused())
+				{
+					BeginReceive();
+				}
 			}
 
 			void Disconnected()
 			{
+				m_slowConsumerTimer.cancel();
+
 				if (m_listener)
 				{
 					m_listener->connectionLost();
 					m_listener = nullptr;
 				}
 
-				if (m_socket->is_open())
+				if (m_socket && m_socket->is_open())
 				{
 					asio::error_code error;
 					m_socket->shutdown(asio::ip::tcp::socket::shutdown_both, error);
@@ -7,13 +7,12 @@
 #include "game_crypt.h"
 
 #include "network/connector.h"
+#include "network/packet_dispatcher.h"
 
 #include "log/default_log_levels.h"
 
 #include <functional>
 #include <iomanip>
-#include <mutex>
-#include <map>
 
 
 namespace mmo
@@ -52,8 +51,7 @@ namespace mmo
 			/// Registers a packet handler for a given op code.
 			void RegisterPacketHandler(uint16 opCode, PacketHandler&& handler)
 			{
-				std::scoped_lock lock{ m_packetHandlerMutex };
-				m_packetHandlers[opCode] = handler;
+				m_packetHandlers.registerHandler(opCode, std::move(handler));
 			}
 			/// Syntactic sugar implementation of RegisterPacketHandler to avoid having to use std::bind.
 			template <class Instance, class Class, class... Args1>
@@ -66,48 +64,35 @@ namespace mmo
 			/// Removes a registered packet handler for a given op code.
 			void ClearPacketHandler(uint16 opCode)
 			{
-				std::scoped_lock lock{ m_packetHandlerMutex };
-
-				auto it = m_packetHandlers.find(opCode);
-				if (it != m_packetHandlers.end())
-				{
-					m_packetHandlers.erase(it);
-				}
+				m_packetHandlers.clearHandler(opCode);
 			}
 			/// Removes all registered packet handlers.
 			void ClearPacketHandlers()
 			{
-				std::scoped_lock lock{ m_packetHandlerMutex };
-				m_packetHandlers.clear();
+				m_packetHandlers.clearHandlers();
 			}
 
 		protected:
 			virtual PacketParseResult HandleIncomingPacket(game::IncomingPacket &packet)
 			{
-				// Try to retrieve the packet handler in a thread-safe way
-				PacketHandler handler = nullptr;
+				// Call the packet handler if one is enabled for this op code
+				PacketParseResult result = PacketParseResult::Disconnect;
+				if (!m_packetHandlers.dispatch(packet, result))
 				{
-					std::scoped_lock lock{ m_packetHandlerMutex };
-
-					// Try to find a registered packet handler
-					auto it = m_packetHandlers.find(packet.GetId());
-					if (it == m_packetHandlers.end())
-					{
-						// Received unhandled server packet
-						WLOG("Received unhandled server op code: 0x" << std::hex << std::setw(2) << std::setfill('0') << packet.GetId());
-						return PacketParseResult::Disconnect;
-					}
-
-					handler = it->second;
+					// Received unhandled server packet
+					WLOG("Received unhandled server op code: 0x" << std::hex << std::setw(2) << std::setfill('0') << packet.GetId());
+					return PacketParseResult::Disconnect;
 				}
 
-				// Call the packet handler
-				return handler(packet);
+				return result;
 			}
 
 		protected:
-			std::mutex m_packetHandlerMutex;
-			std::map<uint16, PacketHandler> m_packetHandlers;
+			/// Number of op codes that can be handled. Packets with higher op codes are reported as unhandled.
+			static constexpr size_t MaxOpCodeCount = 256;
+
+			/// Handlers for every supported op code. Only accessed on the connection strand.
+			PacketDispatcher<game::IncomingPacket, MaxOpCodeCount> m_packetHandlers;
 
 		public:
 			void connect(const std::string &host, uint16 port, Listener &listener,
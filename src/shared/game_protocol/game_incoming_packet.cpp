@@ -22,12 +22,15 @@ namespace mmo
 				>> io::read<uint16>(packet.m_id)
 				>> io::read<uint32>(packet.m_size))
 			{
-				std::size_t size = source.getRest();
-				if (size < packet.m_size)
+				if (source.getRest() < packet.m_size)
 				{
 					return receive_state::Incomplete;
 				}
 
+				// Only consume this packet's body so that following packets in the same
+				// buffer can be parsed in place
+				const std::size_t size = packet.m_size;
+
 				const char *const body = source.getPosition();
 				source.skip(size);
 				packet.m_body = io::MemorySource(body, body + size);
@@ -14,6 +14,9 @@ namespace mmo
 		{
 			typedef game::IncomingPacket IncomingPacket;
 			typedef game::OutgoingPacket OutgoingPacket;
+
+			/// Name of the protocol used for diagnostics like packet statistics.
+			static constexpr const char *Name = "game";
 		};
 
 
@@ -0,0 +1,311 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "async_log_sink.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+
+namespace mmo
+{
+	namespace
+	{
+		/// Source of unique sink ids. 0 is never used so that an empty cache entry never matches.
+		std::atomic<uint64> s_nextSinkId{ 1 };
+
+		/// Maximum time the writer thread sleeps without being notified.
+		constexpr std::chrono::milliseconds MaxWriterSleep{ 100 };
+
+		size_t roundUpToPowerOfTwo(size_t value)
+		{
+			size_t result = 1;
+			while (result < value)
+			{
+				result <<= 1;
+			}
+
+			return result;
+		}
+	}
+
+
+	/// Bounded single producer / single consumer ring buffer of log entries.
+	class AsyncLogSink::ProducerQueue final
+	{
+	public:
+
+		explicit ProducerQueue(size_t capacity, std::thread::id owner)
+			: m_owner(owner)
+			, m_slots(capacity)
+			, m_mask(capacity - 1)
+			, m_head(0)
+			, m_tail(0)
+			, m_cachedHead(0)
+		{
+			assert((capacity & m_mask) == 0);
+		}
+
+	public:
+		/// Gets the id of the thread which pushes into this queue.
+		std::thread::id getOwner() const
+		{
+			return m_owner;
+		}
+		/// Moves an entry into the queue. Must only be called by the owning thread.
+		/// @returns false if the queue is full, in which case entry is left untouched.
+		bool tryPush(LogEntry &entry)
+		{
+			const size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_cachedHead == m_slots.size())
+			{
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+				if (tail - m_cachedHead == m_slots.size())
+				{
+					return false;
+				}
+			}
+
+			m_slots[tail & m_mask].swap(entry);
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+		/// Passes all queued entries to the write function. Must only be called by the writer thread.
+		size_t consume(const WriteFunction &write)
+		{
+			const size_t head = m_head.load(std::memory_order_relaxed);
+			const size_t tail = m_tail.load(std::memory_order_acquire);
+
+			for (size_t i = head; i != tail; ++i)
+			{
+				LogEntry &slot = m_slots[i & m_mask];
+				write(slot);
+
+				// Free the message here so that producers never release memory of previous entries
+				String().swap(slot.message);
+				String().swap(slot.arguments);
+			}
+
+			m_head.store(tail, std::memory_order_release);
+			return tail - head;
+		}
+		/// Determines whether the queue is empty.
+		bool isEmpty() const
+		{
+			return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+		}
+
+	private:
+
+		const std::thread::id m_owner;
+		std::vector<LogEntry> m_slots;
+		const size_t m_mask;
+		/// Index of the next entry to consume, written by the writer thread.
+		alignas(64) std::atomic<size_t> m_head;
+		/// Index of the next free slot, written by the producer thread.
+		alignas(64) std::atomic<size_t> m_tail;
+		/// Last value of m_head seen by the producer, avoids reading the shared head on every push.
+		size_t m_cachedHead;
+	};
+
+
+	AsyncLogSink::AsyncLogSink(WriteFunction write, FlushFunction flush, size_t queueCapacity)
+		: m_write(std::move(write))
+		, m_flush(std::move(flush))
+		, m_queueCapacity(roundUpToPowerOfTwo(std::max<size_t>(queueCapacity, 2)))
+		, m_id(s_nextSinkId.fetch_add(1, std::memory_order_relaxed))
+		, m_queueCount(0)
+		, m_isWriterWaiting(false)
+		, m_isStopping(false)
+		, m_enqueuedEntries(0)
+		, m_writtenEntries(0)
+		, m_batches(0)
+		, m_producerStalls(0)
+	{
+		assert(m_write);
+
+		m_writer = std::thread([this]() { run(); });
+	}
+
+	AsyncLogSink::~AsyncLogSink()
+	{
+		{
+			std::scoped_lock lock{ m_mutex };
+			m_isStopping = true;
+		}
+
+		m_writerCondition.notify_one();
+		m_writer.join();
+	}
+
+	void AsyncLogSink::push(LogEntry entry)
+	{
+		ProducerQueue &queue = getQueue();
+		while (!queue.tryPush(entry))
+		{
+			m_producerStalls.fetch_add(1, std::memory_order_relaxed);
+			notifyWriter();
+			std::this_thread::yield();
+		}
+
+		m_enqueuedEntries.fetch_add(1, std::memory_order_relaxed);
+		notifyWriter();
+	}
+
+	void AsyncLogSink::flush()
+	{
+		const uint64 target = m_enqueuedEntries.load(std::memory_order_acquire);
+
+		std::unique_lock lock{ m_mutex };
+		m_writerCondition.notify_one();
+		m_flushedCondition.wait(lock, [this, target]() {
+			return m_writtenEntries.load(std::memory_order_acquire) >= target;
+		});
+	}
+
+	AsyncLogSinkStats AsyncLogSink::getStats() const
+	{
+		AsyncLogSinkStats stats;
+		stats.enqueuedEntries = m_enqueuedEntries.load(std::memory_order_relaxed);
+		stats.writtenEntries = m_writtenEntries.load(std::memory_order_relaxed);
+		stats.batches = m_batches.load(std::memory_order_relaxed);
+		stats.producerStalls = m_producerStalls.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	AsyncLogSink::ProducerQueue &AsyncLogSink::getQueue()
+	{
+		// A thread usually logs into more than one sink (console and file), so remember a few
+		struct CacheEntry
+		{
+			uint64 sinkId = 0;
+			ProducerQueue *queue = nullptr;
+		};
+		thread_local std::array<CacheEntry, 4> s_cache;
+		thread_local size_t s_nextCacheEntry = 0;
+
+		for (const CacheEntry &entry : s_cache)
+		{
+			if (entry.sinkId == m_id)
+			{
+				return *entry.queue;
+			}
+		}
+
+		const std::thread::id threadId = std::this_thread::get_id();
+
+		ProducerQueue *queue = nullptr;
+		{
+			std::scoped_lock lock{ m_mutex };
+
+			// Queues are never removed, so a thread which has been evicted from the cache gets its old
+			// queue back. A new thread with the id of a finished one may safely take over its queue too.
+			for (const auto &existing : m_queues)
+			{
+				if (existing->getOwner() == threadId)
+				{
+					queue = existing.get();
+					break;
+				}
+			}
+
+			if (!queue)
+			{
+				m_queues.push_back(std::make_unique<ProducerQueue>(m_queueCapacity, threadId));
+				queue = m_queues.back().get();
+				m_queueCount.store(m_queues.size(), std::memory_order_release);
+			}
+		}
+
+		CacheEntry &entry = s_cache[s_nextCacheEntry++ % s_cache.size()];
+		entry.sinkId = m_id;
+		entry.queue = queue;
+		return *queue;
+	}
+
+	void AsyncLogSink::notifyWriter()
+	{
+		// Pairs with the store of m_isWriterWaiting in run(): Either the writer sees the new entry
+		// before it goes to sleep, or we see that it is waiting and wake it up.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_isWriterWaiting.load(std::memory_order_relaxed))
+		{
+			std::scoped_lock lock{ m_mutex };
+			m_writerCondition.notify_one();
+		}
+	}
+
+	void AsyncLogSink::run()
+	{
+		for (;;)
+		{
+			const size_t written = drain();
+			if (written > 0)
+			{
+				if (m_flush)
+				{
+					m_flush();
+				}
+
+				m_batches.fetch_add(1, std::memory_order_relaxed);
+				{
+					std::scoped_lock lock{ m_mutex };
+					m_writtenEntries.fetch_add(written, std::memory_order_release);
+				}
+				m_flushedCondition.notify_all();
+				continue;
+			}
+
+			std::unique_lock lock{ m_mutex };
+
+			m_isWriterWaiting.store(true, std::memory_order_seq_cst);
+			if (!hasPendingEntries())
+			{
+				// Only stop once everything has been written
+				if (m_isStopping)
+				{
+					break;
+				}
+
+				m_writerCondition.wait_for(lock, MaxWriterSleep);
+			}
+			m_isWriterWaiting.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	size_t AsyncLogSink::drain()
+	{
+		const size_t queueCount = m_queueCount.load(std::memory_order_acquire);
+		if (queueCount != m_writerQueues.size())
+		{
+			std::scoped_lock lock{ m_mutex };
+
+			m_writerQueues.clear();
+			for (const auto &queue : m_queues)
+			{
+				m_writerQueues.push_back(queue.get());
+			}
+		}
+
+		size_t written = 0;
+		for (ProducerQueue *queue : m_writerQueues)
+		{
+			written += queue->consume(m_write);
+		}
+
+		return written;
+	}
+
+	bool AsyncLogSink::hasPendingEntries() const
+	{
+		for (const auto &queue : m_queues)
+		{
+			if (!queue->isEmpty())
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,110 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "base/non_copyable.h"
+#include "log_entry.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mmo
+{
+	/// Counters of an asynchronous log sink.
+	struct AsyncLogSinkStats
+	{
+		/// Number of entries pushed by producers.
+		uint64 enqueuedEntries = 0;
+		/// Number of entries handed to the write function.
+		uint64 writtenEntries = 0;
+		/// Number of batches after which the flush function has been called.
+		uint64 batches = 0;
+		/// Number of times a producer had to wait because its queue was full.
+		uint64 producerStalls = 0;
+	};
+
+
+	/// Moves the output of log entries off the threads which produce them. Every producing thread
+	/// owns a bounded single producer / single consumer queue, so that pushing an entry is lock free
+	/// and threads never contend with each other. A background thread drains all queues, hands each
+	/// entry to the write function and calls the flush function once per batch instead of once per
+	/// entry. Entries of a single thread keep their order, entries of different threads are only
+	/// ordered by the batch in which they are collected.
+	class AsyncLogSink final : public NonCopyable
+	{
+	public:
+
+		typedef std::function<void(const LogEntry &)> WriteFunction;
+		typedef std::function<void()> FlushFunction;
+
+		/// Default number of entries a single producer may have queued before it has to wait.
+		static constexpr size_t DefaultQueueCapacity = 4096;
+
+	public:
+		/// Starts the writer thread.
+		/// @param write Called on the writer thread for every entry.
+		/// @param flush Called on the writer thread after every batch. May be empty.
+		/// @param queueCapacity Capacity of each per thread queue, rounded up to a power of two.
+		explicit AsyncLogSink(WriteFunction write, FlushFunction flush = FlushFunction(), size_t queueCapacity = DefaultQueueCapacity);
+		/// Writes all remaining entries and stops the writer thread.
+		~AsyncLogSink();
+
+	public:
+		/// Queues an entry for writing. Can be used as slot of the log signal and may be called from
+		/// any thread. If the queue of the calling thread is full, it waits for the writer thread so
+		/// that no entries are lost.
+		void push(LogEntry entry);
+		/// Blocks until every entry which has been pushed before this call has been written and flushed.
+		void flush();
+		/// Gets the current counters.
+		AsyncLogSinkStats getStats() const;
+
+	private:
+
+		class ProducerQueue;
+
+		/// Gets the queue of the calling thread, creating it on first use.
+		ProducerQueue &getQueue();
+		/// Wakes up the writer thread if it is waiting for entries.
+		void notifyWriter();
+		/// Entry point of the writer thread.
+		void run();
+		/// Writes all entries which are currently queued. Returns the number of written entries.
+		size_t drain();
+		/// Determines whether any queue contains entries. m_mutex has to be locked.
+		bool hasPendingEntries() const;
+
+	private:
+
+		WriteFunction m_write;
+		FlushFunction m_flush;
+		const size_t m_queueCapacity;
+		/// Unique id of this sink, used to validate the per thread queue cache.
+		const uint64 m_id;
+
+		/// Protects the list of queues and is used to wait for the writer thread.
+		mutable std::mutex m_mutex;
+		std::condition_variable m_writerCondition;
+		std::condition_variable m_flushedCondition;
+		std::vector<std::unique_ptr<ProducerQueue>> m_queues;
+		/// Number of entries in m_queues, read by the writer without locking.
+		std::atomic<size_t> m_queueCount;
+		/// Copy of m_queues which is only used by the writer thread.
+		std::vector<ProducerQueue *> m_writerQueues;
+
+		std::atomic<bool> m_isWriterWaiting;
+		std::atomic<bool> m_isStopping;
+		std::atomic<uint64> m_enqueuedEntries;
+		std::atomic<uint64> m_writtenEntries;
+		std::atomic<uint64> m_batches;
+		std::atomic<uint64> m_producerStalls;
+
+		std::thread m_writer;
+	};
+}
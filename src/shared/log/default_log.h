@@ -4,12 +4,15 @@
 
 #include "log.h"
 #include "log_entry.h"
+#include "log_format.h"
+#include "log_rate_limit.h"
+#include "base/clock.h"
 
 namespace mmo
 {
 	extern Log g_DefaultLog;
 
-#if defined(MMO_LOG) || defined(MMO_LOG_FORMATTER_NAME)
+#if defined(MMO_LOG) || defined(MMO_LOG_FORMATTER_NAME) || defined(MMO_LOG_FORMAT) || defined(MMO_LOG_RATE_LIMITED) || defined(MMO_LOG_SAMPLED)
 #error Something went wrong with the log macros
 #endif
 
@@ -25,4 +28,40 @@ namespace mmo
 		                                                 ) \
 		                              ); \
 	}
+
+	// Structured variant of MMO_LOG: The arguments are stored in binary next to the format string and
+	// are only formatted as text if a sink needs text. See makeLogEntry for the format syntax.
+#define MMO_LOG_FORMAT(level, ...) \
+	{ \
+		::mmo::g_DefaultLog.signal()( \
+		                                ::mmo::makeLogEntry(level, \
+		                                        ::std::chrono::system_clock::now(), \
+		                                        __VA_ARGS__ \
+		                                                   ) \
+		                              ); \
+	}
+
+	// Writes at most perSecond messages per second from this call site. The next written message
+	// reports how many have been suppressed in the meantime.
+#define MMO_LOG_LIMITER_NAME _mmo_log_limiter_
+#define MMO_LOG_RATE_LIMITED(level, perSecond, message) \
+	{ \
+		static ::mmo::LogRateLimiter MMO_LOG_LIMITER_NAME{ perSecond }; \
+		::mmo::uint64 _mmo_log_suppressed_ = 0; \
+		if (MMO_LOG_LIMITER_NAME.tryAcquire(::mmo::GetMonotonicTimeNs(), _mmo_log_suppressed_)) \
+		{ \
+			if (_mmo_log_suppressed_ > 0) \
+				MMO_LOG(level, message << ::std::dec << " (" << _mmo_log_suppressed_ << " similar messages suppressed)") \
+			else \
+				MMO_LOG(level, message) \
+		} \
+	}
+
+	// Writes only one of every "every" messages from this call site.
+#define MMO_LOG_SAMPLED(level, every, message) \
+	{ \
+		static ::mmo::LogSampler MMO_LOG_LIMITER_NAME{ every }; \
+		if (MMO_LOG_LIMITER_NAME.sample()) \
+			MMO_LOG(level, message << ::std::dec << " (sampled 1 of " << MMO_LOG_LIMITER_NAME.getEvery() << ")") \
+	}
 }
@@ -26,8 +26,69 @@ namespace mmo
 	extern const LogLevel ErrorLevel;
 
 
-#define DLOG(message) MMO_LOG(::mmo::DebugLevel, message)
-#define ILOG(message) MMO_LOG(::mmo::InfoLevel, message)
-#define WLOG(message) MMO_LOG(::mmo::WarningLevel, message)
+// Compile time log level filter. Log statements below MMO_LOG_MIN_LEVEL are removed by the compiler,
+// so that they neither format their message nor fire the log signal. The message expression is still
+// compiled, so that it can not break unnoticed. Debug output is removed in release builds by default.
+#define MMO_LOG_LEVEL_DEBUG 0
+#define MMO_LOG_LEVEL_INFO 1
+#define MMO_LOG_LEVEL_WARNING 2
+#define MMO_LOG_LEVEL_ERROR 3
+
+#ifndef MMO_LOG_MIN_LEVEL
+#	ifdef NDEBUG
+#		define MMO_LOG_MIN_LEVEL MMO_LOG_LEVEL_INFO
+#	else
+#		define MMO_LOG_MIN_LEVEL MMO_LOG_LEVEL_DEBUG
+#	endif
+#endif
+
+#define MMO_LOG_DISABLED(level, message) \
+	{ \
+		if (false) MMO_LOG(level, message) \
+	}
+#define MMO_LOG_FORMAT_DISABLED(level, ...) \
+	{ \
+		if (false) MMO_LOG_FORMAT(level, __VA_ARGS__) \
+	}
+
+#if MMO_LOG_MIN_LEVEL <= MMO_LOG_LEVEL_DEBUG
+#	define DLOG(message) MMO_LOG(::mmo::DebugLevel, message)
+#	define DLOGF(...) MMO_LOG_FORMAT(::mmo::DebugLevel, __VA_ARGS__)
+#	define DLOG_RATE(perSecond, message) MMO_LOG_RATE_LIMITED(::mmo::DebugLevel, perSecond, message)
+#	define DLOG_SAMPLED(every, message) MMO_LOG_SAMPLED(::mmo::DebugLevel, every, message)
+#else
+#	define DLOG(message) MMO_LOG_DISABLED(::mmo::DebugLevel, message)
+#	define DLOGF(...) MMO_LOG_FORMAT_DISABLED(::mmo::DebugLevel, __VA_ARGS__)
+#	define DLOG_RATE(perSecond, message) MMO_LOG_DISABLED(::mmo::DebugLevel, message)
+#	define DLOG_SAMPLED(every, message) MMO_LOG_DISABLED(::mmo::DebugLevel, message)
+#endif
+
+#if MMO_LOG_MIN_LEVEL <= MMO_LOG_LEVEL_INFO
+#	define ILOG(message) MMO_LOG(::mmo::InfoLevel, message)
+#	define ILOGF(...) MMO_LOG_FORMAT(::mmo::InfoLevel, __VA_ARGS__)
+#	define ILOG_RATE(perSecond, message) MMO_LOG_RATE_LIMITED(::mmo::InfoLevel, perSecond, message)
+#	define ILOG_SAMPLED(every, message) MMO_LOG_SAMPLED(::mmo::InfoLevel, every, message)
+#else
+#	define ILOG(message) MMO_LOG_DISABLED(::mmo::InfoLevel, message)
+#	define ILOGF(...) MMO_LOG_FORMAT_DISABLED(::mmo::InfoLevel, __VA_ARGS__)
+#	define ILOG_RATE(perSecond, message) MMO_LOG_DISABLED(::mmo::InfoLevel, message)
+#	define ILOG_SAMPLED(every, message) MMO_LOG_DISABLED(::mmo::InfoLevel, message)
+#endif
+
+#if MMO_LOG_MIN_LEVEL <= MMO_LOG_LEVEL_WARNING
+#	define WLOG(message) MMO_LOG(::mmo::WarningLevel, message)
+#	define WLOGF(...) MMO_LOG_FORMAT(::mmo::WarningLevel, __VA_ARGS__)
+#	define WLOG_RATE(perSecond, message) MMO_LOG_RATE_LIMITED(::mmo::WarningLevel, perSecond, message)
+#	define WLOG_SAMPLED(every, message) MMO_LOG_SAMPLED(::mmo::WarningLevel, every, message)
+#else
+#	define WLOG(message) MMO_LOG_DISABLED(::mmo::WarningLevel, message)
+#	define WLOGF(...) MMO_LOG_FORMAT_DISABLED(::mmo::WarningLevel, __VA_ARGS__)
+#	define WLOG_RATE(perSecond, message) MMO_LOG_DISABLED(::mmo::WarningLevel, message)
+#	define WLOG_SAMPLED(every, message) MMO_LOG_DISABLED(::mmo::WarningLevel, message)
+#endif
+
 #define ELOG(message) MMO_LOG(::mmo::ErrorLevel, message)
+#define ELOGF(...) MMO_LOG_FORMAT(::mmo::ErrorLevel, __VA_ARGS__)
+#define ELOG_RATE(perSecond, message) MMO_LOG_RATE_LIMITED(::mmo::ErrorLevel, perSecond, message)
+#define ELOG_SAMPLED(every, message) MMO_LOG_SAMPLED(::mmo::ErrorLevel, every, message)
 }
@@ -0,0 +1,287 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "log_binary_stream.h"
+#include "log_format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+namespace mmo
+{
+	namespace
+	{
+		/// Identifies a binary log file.
+		const char Magic[] = { 'M', 'M', 'O', 'L', 'O', 'G' };
+		/// Version of the record layout.
+		constexpr uint8 Version = 1;
+
+		/// Every record starts with its type and its payload size as variable length integer.
+		struct log_record_type
+		{
+			enum Enum
+			{
+				/// id, importance, color, name
+				LevelDefinition = 1,
+				/// id, format string
+				FormatDefinition,
+				/// level id, time delta, message
+				TextEntry,
+				/// level id, format id, time delta, encoded arguments
+				FormatEntry
+			};
+		};
+
+		typedef log_record_type::Enum LogRecordType;
+
+
+		int64 toNanoseconds(const LogTime &time)
+		{
+			return static_cast<int64>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+		}
+
+		LogTime fromNanoseconds(int64 timeNs)
+		{
+			return LogTime(std::chrono::duration_cast<LogTime::duration>(std::chrono::nanoseconds(timeNs)));
+		}
+
+		void appendString(String &buffer, const String &string)
+		{
+			appendLogVarInt(buffer, string.size());
+			buffer.append(string);
+		}
+
+		bool readString(const char *&position, const char *end, String &string)
+		{
+			uint64 length = 0;
+			if (!readLogVarInt(position, end, length) || static_cast<uint64>(end - position) < length)
+			{
+				return false;
+			}
+
+			string.assign(position, static_cast<size_t>(length));
+			position += length;
+			return true;
+		}
+	}
+
+
+	BinaryLogWriter::BinaryLogWriter(std::ostream &stream)
+		: m_stream(stream)
+		, m_previousTimeNs(0)
+	{
+		m_stream.write(Magic, sizeof(Magic));
+		m_stream.put(static_cast<char>(Version));
+	}
+
+	void BinaryLogWriter::write(const LogEntry &entry)
+	{
+		const uint64 levelId = getLevelId(*entry.level);
+
+		const int64 timeNs = toNanoseconds(entry.time);
+		const uint64 timeDelta = zigZagEncode(timeNs - m_previousTimeNs);
+		m_previousTimeNs = timeNs;
+
+		if (entry.format)
+		{
+			const uint64 formatId = getFormatId(entry.format);
+
+			m_record.push_back(static_cast<char>(log_record_type::FormatEntry));
+			appendLogVarInt(m_record, levelId);
+			appendLogVarInt(m_record, formatId);
+			appendLogVarInt(m_record, timeDelta);
+			appendString(m_record, entry.arguments);
+		}
+		else
+		{
+			m_record.push_back(static_cast<char>(log_record_type::TextEntry));
+			appendLogVarInt(m_record, levelId);
+			appendLogVarInt(m_record, timeDelta);
+			appendString(m_record, entry.message);
+		}
+
+		commit();
+	}
+
+	uint64 BinaryLogWriter::getLevelId(const LogLevel &level)
+	{
+		const auto it = m_levelIds.find(&level);
+		if (it != m_levelIds.end())
+		{
+			return it->second;
+		}
+
+		const uint64 id = m_levelIds.size();
+		m_levelIds.emplace(&level, id);
+
+		m_record.push_back(static_cast<char>(log_record_type::LevelDefinition));
+		appendLogVarInt(m_record, id);
+		m_record.push_back(static_cast<char>(level.importance));
+		m_record.push_back(static_cast<char>(level.color));
+		appendString(m_record, level.name);
+		commit();
+
+		return id;
+	}
+
+	uint64 BinaryLogWriter::getFormatId(const char *format)
+	{
+		const auto it = m_formatIds.find(format);
+		if (it != m_formatIds.end())
+		{
+			return it->second;
+		}
+
+		const uint64 id = m_formatIds.size();
+		m_formatIds.emplace(format, id);
+
+		m_record.push_back(static_cast<char>(log_record_type::FormatDefinition));
+		appendLogVarInt(m_record, id);
+		appendString(m_record, format);
+		commit();
+
+		return id;
+	}
+
+	void BinaryLogWriter::commit()
+	{
+		// The record type is already the first byte of the buffer, insert the payload size behind it
+		String header;
+		header.push_back(m_record[0]);
+		appendLogVarInt(header, m_record.size() - 1);
+
+		m_stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+		m_stream.write(m_record.data() + 1, static_cast<std::streamsize>(m_record.size() - 1));
+		m_record.clear();
+	}
+
+
+	BinaryLogReader::BinaryLogReader(std::istream &stream)
+		: m_stream(stream)
+		, m_isValid(false)
+		, m_previousTimeNs(0)
+	{
+		char header[sizeof(Magic) + 1];
+		if (m_stream.read(header, sizeof(header)) &&
+			std::equal(std::begin(Magic), std::end(Magic), header) &&
+			static_cast<uint8>(header[sizeof(Magic)]) == Version)
+		{
+			m_isValid = true;
+		}
+	}
+
+	bool BinaryLogReader::isValid() const
+	{
+		return m_isValid;
+	}
+
+	bool BinaryLogReader::read(LogEntry &entry)
+	{
+		while (m_isValid && readRecord())
+		{
+			const char *position = m_record.data() + 1;
+			const char *const end = m_record.data() + m_record.size();
+
+			switch (static_cast<uint8>(m_record[0]))
+			{
+			case log_record_type::LevelDefinition:
+			{
+				uint64 id = 0;
+				if (!readLogVarInt(position, end, id) || id != m_levels.size() || end - position < 2)
+				{
+					m_isValid = false;
+					break;
+				}
+
+				const auto importance = static_cast<LogImportance>(static_cast<uint8>(*position++));
+				const auto color = static_cast<LogColor>(static_cast<uint8>(*position++));
+				String name;
+				if (!readString(position, end, name))
+				{
+					m_isValid = false;
+					break;
+				}
+
+				m_levels.push_back(std::make_unique<LogLevel>(std::move(name), importance, color));
+				break;
+			}
+			case log_record_type::FormatDefinition:
+			{
+				uint64 id = 0;
+				auto format = std::make_unique<String>();
+				if (!readLogVarInt(position, end, id) || id != m_formats.size() || !readString(position, end, *format))
+				{
+					m_isValid = false;
+					break;
+				}
+
+				m_formats.push_back(std::move(format));
+				break;
+			}
+			case log_record_type::TextEntry:
+			case log_record_type::FormatEntry:
+			{
+				const bool isFormatted = static_cast<uint8>(m_record[0]) == log_record_type::FormatEntry;
+
+				uint64 levelId = 0, formatId = 0, timeDelta = 0;
+				String payload;
+				if (!readLogVarInt(position, end, levelId) || levelId >= m_levels.size() ||
+					(isFormatted && (!readLogVarInt(position, end, formatId) || formatId >= m_formats.size())) ||
+					!readLogVarInt(position, end, timeDelta) ||
+					!readString(position, end, payload))
+				{
+					m_isValid = false;
+					break;
+				}
+
+				m_previousTimeNs += zigZagDecode(timeDelta);
+
+				if (isFormatted)
+				{
+					entry = LogEntry(*m_levels[levelId], m_formats[formatId]->c_str(), std::move(payload), fromNanoseconds(m_previousTimeNs));
+				}
+				else
+				{
+					entry = LogEntry(*m_levels[levelId], std::move(payload), fromNanoseconds(m_previousTimeNs));
+				}
+				return true;
+			}
+			default:
+				// Unknown records of newer versions are skipped
+				break;
+			}
+		}
+
+		return false;
+	}
+
+	bool BinaryLogReader::readRecord()
+	{
+		const int type = m_stream.get();
+		if (type == std::char_traits<char>::eof())
+		{
+			return false;
+		}
+
+		uint64 size = 0;
+		for (uint32 shift = 0; ; shift += 7)
+		{
+			const int byte = m_stream.get();
+			if (byte == std::char_traits<char>::eof() || shift >= 64)
+			{
+				// A truncated record at the end is expected if the server crashed while writing
+				return false;
+			}
+
+			size |= static_cast<uint64>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				break;
+			}
+		}
+
+		m_record.resize(static_cast<size_t>(size) + 1);
+		m_record[0] = static_cast<char>(type);
+		return size == 0 || static_cast<bool>(m_stream.read(&m_record[1], static_cast<std::streamsize>(size)));
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "base/non_copyable.h"
+#include "log_entry.h"
+#include "log_level.h"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace mmo
+{
+	/// Writes log entries as compact binary records instead of text. Log levels and format strings are
+	/// written once when they are used for the first time and are referenced by id afterwards, so a
+	/// structured entry only consists of a few ids, the time stamp delta and its raw arguments. Text
+	/// entries are stored with their message. Use BinaryLogReader or the log_decoder tool to read them.
+	/// This class is not thread safe, use it from a single thread like the writer of an AsyncLogSink.
+	class BinaryLogWriter final : public NonCopyable
+	{
+	public:
+		/// Writes the file header.
+		explicit BinaryLogWriter(std::ostream &stream);
+
+	public:
+		/// Writes a single entry.
+		void write(const LogEntry &entry);
+
+	private:
+
+		/// Gets the id of a level, writing its definition first if it is new.
+		uint64 getLevelId(const LogLevel &level);
+		/// Gets the id of a format string, writing its definition first if it is new.
+		uint64 getFormatId(const char *format);
+		/// Writes the record buffer to the stream.
+		void commit();
+
+	private:
+
+		std::ostream &m_stream;
+		/// Buffer of the record which is currently written.
+		String m_record;
+		std::unordered_map<const LogLevel *, uint64> m_levelIds;
+		std::unordered_map<const char *, uint64> m_formatIds;
+		/// Time stamp of the previous entry in nanoseconds since the epoch.
+		int64 m_previousTimeNs;
+	};
+
+
+	/// Reads log entries written by a BinaryLogWriter.
+	class BinaryLogReader final : public NonCopyable
+	{
+	public:
+		/// Reads the file header.
+		explicit BinaryLogReader(std::istream &stream);
+
+	public:
+		/// Determines whether the stream contains a binary log which has been read without errors so far.
+		bool isValid() const;
+		/// Reads the next entry. The level and format of the entry point into this reader and stay
+		/// valid as long as it exists.
+		/// @returns false at the end of the log or if the log is damaged, see isValid.
+		bool read(LogEntry &entry);
+
+	private:
+
+		/// Reads the type and payload of the next record into m_record.
+		bool readRecord();
+
+	private:
+
+		std::istream &m_stream;
+		bool m_isValid;
+		String m_record;
+		std::vector<std::unique_ptr<LogLevel>> m_levels;
+		std::vector<std::unique_ptr<String>> m_formats;
+		int64 m_previousTimeNs;
+	};
+}
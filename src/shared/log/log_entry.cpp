@@ -1,11 +1,13 @@
 // Copyright (C) 2019, Robin Klimonow. All rights reserved.
 
 #include "log_entry.h"
+#include "log_format.h"
 
 namespace mmo
 {
 	LogEntry::LogEntry()
 		: level(nullptr)
+		, format(nullptr)
 	{
 	}
 
@@ -16,6 +18,19 @@ namespace mmo
 		: level(&level)
 		, message(std::move(message))
 		, time(time)
+		, format(nullptr)
+	{
+	}
+
+	LogEntry::LogEntry(
+	    const LogLevel &level,
+	    const char *format,
+	    String arguments,
+	    const LogTime &time)
+		: level(&level)
+		, time(time)
+		, format(format)
+		, arguments(std::move(arguments))
 	{
 	}
 
@@ -23,10 +38,14 @@ namespace mmo
 		: level(other.level)
 		, message(other.message)
 		, time(other.time)
+		, format(other.format)
+		, arguments(other.arguments)
 	{
 	}
 
 	LogEntry::LogEntry(LogEntry  &&other)
+		: level(nullptr)
+		, format(nullptr)
 	{
 		swap(other);
 	}
@@ -42,6 +61,20 @@ namespace mmo
 		std::swap(level, other.level);
 		std::swap(message, other.message);
 		std::swap(time, other.time);
+		std::swap(format, other.format);
+		std::swap(arguments, other.arguments);
+	}
+
+	String LogEntry::getMessage() const
+	{
+		if (!format)
+		{
+			return message;
+		}
+
+		std::ostringstream formatter;
+		writeLogMessage(formatter, *this);
+		return formatter.str();
 	}
 
 
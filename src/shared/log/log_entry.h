@@ -17,8 +17,13 @@ namespace mmo
 	public:
 
 		const LogLevel *level;
+		/// Text of the entry. Empty for structured entries.
 		String message;
 		LogTime time;
+		/// Format string of a structured entry (see log_format.h), nullptr for text entries.
+		const char *format;
+		/// Encoded arguments of a structured entry.
+		String arguments;
 
 
 		LogEntry();
@@ -26,10 +31,17 @@ namespace mmo
 		    const LogLevel &level,
 		    String message,
 		    const LogTime &time);
+		explicit LogEntry(
+		    const LogLevel &level,
+		    const char *format,
+		    String arguments,
+		    const LogTime &time);
 		LogEntry(const LogEntry &other);
 		LogEntry(LogEntry  &&other);
 		LogEntry &operator = (LogEntry other);
 		void swap(LogEntry &other);
+		/// Gets the text of the entry, formatting the arguments of structured entries.
+		String getMessage() const;
 	};
 
 
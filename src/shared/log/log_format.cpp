@@ -0,0 +1,165 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "log_format.h"
+
+#include <ios>
+
+namespace mmo
+{
+	namespace
+	{
+		/// Writes the next encoded argument and advances position. Returns false if the argument buffer is damaged.
+		bool writeNextArgument(std::ostream &stream, const char *&position, const char *end, bool hex)
+		{
+			if (position == end)
+			{
+				return false;
+			}
+
+			const auto type = static_cast<LogArgumentType>(static_cast<uint8>(*position++));
+			switch (type)
+			{
+			case log_argument_type::Int:
+			case log_argument_type::UInt:
+			{
+				uint64 value = 0;
+				if (!readLogVarInt(position, end, value))
+				{
+					return false;
+				}
+
+				if (hex)
+				{
+					stream << std::hex;
+				}
+
+				if (type == log_argument_type::Int)
+				{
+					stream << zigZagDecode(value);
+				}
+				else
+				{
+					stream << value;
+				}
+
+				if (hex)
+				{
+					stream << std::dec;
+				}
+				return true;
+			}
+			case log_argument_type::Double:
+			{
+				double value = 0.0;
+				if (static_cast<size_t>(end - position) < sizeof(value))
+				{
+					return false;
+				}
+
+				std::memcpy(&value, position, sizeof(value));
+				position += sizeof(value);
+				stream << value;
+				return true;
+			}
+			case log_argument_type::String:
+			{
+				uint64 length = 0;
+				if (!readLogVarInt(position, end, length) || static_cast<uint64>(end - position) < length)
+				{
+					return false;
+				}
+
+				stream.write(position, static_cast<std::streamsize>(length));
+				position += length;
+				return true;
+			}
+			case log_argument_type::Bool:
+			case log_argument_type::Char:
+			{
+				if (position == end)
+				{
+					return false;
+				}
+
+				const char value = *position++;
+				if (type == log_argument_type::Bool)
+				{
+					stream << (value != 0 ? "true" : "false");
+				}
+				else
+				{
+					stream.put(value);
+				}
+				return true;
+			}
+			}
+
+			return false;
+		}
+	}
+
+	bool readLogVarInt(const char *&position, const char *end, uint64 &value)
+	{
+		value = 0;
+		for (uint32 shift = 0; shift < 64; shift += 7)
+		{
+			if (position == end)
+			{
+				return false;
+			}
+
+			const auto byte = static_cast<uint8>(*position++);
+			value |= static_cast<uint64>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void writeLogMessage(std::ostream &stream, const char *format, const String &arguments)
+	{
+		const char *position = arguments.data();
+		const char *const end = position + arguments.size();
+
+		for (const char *c = format; *c != '\0'; ++c)
+		{
+			if (c[0] == '{' && c[1] == '}')
+			{
+				if (!writeNextArgument(stream, position, end, false))
+				{
+					stream << "{?}";
+					position = end;
+				}
+				++c;
+			}
+			else if (c[0] == '{' && c[1] == ':' && c[2] == 'x' && c[3] == '}')
+			{
+				if (!writeNextArgument(stream, position, end, true))
+				{
+					stream << "{?}";
+					position = end;
+				}
+				c += 3;
+			}
+			else
+			{
+				stream.put(*c);
+			}
+		}
+	}
+
+	void writeLogMessage(std::ostream &stream, const LogEntry &entry)
+	{
+		if (entry.format)
+		{
+			writeLogMessage(stream, entry.format, entry.arguments);
+		}
+		else
+		{
+			stream << entry.message;
+		}
+	}
+}
@@ -0,0 +1,145 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "log_entry.h"
+
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+
+namespace mmo
+{
+	/// Type tags of encoded log arguments.
+	struct log_argument_type
+	{
+		enum Enum
+		{
+			/// Signed integer, zig zag encoded variable length integer.
+			Int,
+			/// Unsigned integer, variable length integer.
+			UInt,
+			/// Floating point value, 8 bytes.
+			Double,
+			/// Length as variable length integer followed by the characters.
+			String,
+			/// Single byte, 0 or 1.
+			Bool,
+			/// Single character.
+			Char
+		};
+	};
+
+	typedef log_argument_type::Enum LogArgumentType;
+
+
+	/// Appends an unsigned variable length integer (7 bits per byte, least significant first).
+	inline void appendLogVarInt(String &buffer, uint64 value)
+	{
+		while (value >= 0x80)
+		{
+			buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+			value >>= 7;
+		}
+
+		buffer.push_back(static_cast<char>(value));
+	}
+
+	/// Reads a variable length integer written by appendLogVarInt.
+	/// @returns false if the buffer ends before the integer.
+	bool readLogVarInt(const char *&position, const char *end, uint64 &value);
+
+	/// Maps signed integers to unsigned ones so that small negative values stay small.
+	inline uint64 zigZagEncode(int64 value)
+	{
+		return (static_cast<uint64>(value) << 1) ^ static_cast<uint64>(value >> 63);
+	}
+
+	inline int64 zigZagDecode(uint64 value)
+	{
+		return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+	}
+
+
+	/// Appends a single raw log argument to an argument buffer. Integers, floating point values,
+	/// characters, booleans, enums and strings are stored in binary. Other types are formatted using
+	/// their stream operator and stored as string.
+	template <class T>
+	void appendLogArgument(String &buffer, const T &value)
+	{
+		if constexpr (std::is_same_v<T, bool>)
+		{
+			buffer.push_back(static_cast<char>(log_argument_type::Bool));
+			buffer.push_back(value ? 1 : 0);
+		}
+		else if constexpr (std::is_same_v<T, char>)
+		{
+			buffer.push_back(static_cast<char>(log_argument_type::Char));
+			buffer.push_back(value);
+		}
+		else if constexpr (std::is_enum_v<T>)
+		{
+			appendLogArgument(buffer, static_cast<std::underlying_type_t<T>>(value));
+		}
+		else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+		{
+			buffer.push_back(static_cast<char>(log_argument_type::Int));
+			appendLogVarInt(buffer, zigZagEncode(static_cast<int64>(value)));
+		}
+		else if constexpr (std::is_integral_v<T>)
+		{
+			buffer.push_back(static_cast<char>(log_argument_type::UInt));
+			appendLogVarInt(buffer, static_cast<uint64>(value));
+		}
+		else if constexpr (std::is_floating_point_v<T>)
+		{
+			const double converted = static_cast<double>(value);
+			char bytes[sizeof(converted)];
+			std::memcpy(bytes, &converted, sizeof(converted));
+
+			buffer.push_back(static_cast<char>(log_argument_type::Double));
+			buffer.append(bytes, sizeof(bytes));
+		}
+		else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+		{
+			const std::string_view string{ value };
+
+			buffer.push_back(static_cast<char>(log_argument_type::String));
+			appendLogVarInt(buffer, string.size());
+			buffer.append(string.data(), string.size());
+		}
+		else
+		{
+			std::ostringstream formatter;
+			formatter << value;
+			appendLogArgument(buffer, formatter.str());
+		}
+	}
+
+	/// Encodes all arguments of a log statement.
+	template <class... Args>
+	String encodeLogArguments(const Args &... args)
+	{
+		String buffer;
+		(appendLogArgument(buffer, args), ...);
+		return buffer;
+	}
+
+	/// Creates a structured log entry. The format string has to outlive the entry, which is why only
+	/// string literals are accepted. "{}" is replaced by the next argument, "{:x}" prints the next
+	/// integer argument in hexadecimal.
+	template <size_t N, class... Args>
+	LogEntry makeLogEntry(const LogLevel &level, const LogTime &time, const char (&format)[N], const Args &... args)
+	{
+		return LogEntry(level, format, encodeLogArguments(args...), time);
+	}
+
+	/// Writes a format string with its encoded arguments as text.
+	void writeLogMessage(std::ostream &stream, const char *format, const String &arguments);
+
+	/// Writes the message of a log entry as text, no matter whether it is structured or not.
+	void writeLogMessage(std::ostream &stream, const LogEntry &entry);
+}
@@ -0,0 +1,126 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+
+#include <atomic>
+
+namespace mmo
+{
+	/// Limits how often a single log statement may write per second. Used by the *LOG_RATE macros,
+	/// which create one limiter per call site, so that a client which triggers the same log statement
+	/// over and over again can not turn log output into a cpu or disk bottleneck. Messages which are
+	/// suppressed are counted and reported together with the next message which is written.
+	/// This class is thread safe.
+	class LogRateLimiter final
+	{
+	public:
+
+		/// Length of a rate limiting window in nanoseconds.
+		static constexpr uint64 WindowNs = 1000000000;
+		/// Maximum number of messages per window which can be counted.
+		static constexpr uint32 MaxPerWindow = (1u << 24) - 1;
+
+	public:
+		/// @param maxPerSecond Number of messages which may be written per second, at most MaxPerWindow.
+		explicit LogRateLimiter(uint32 maxPerSecond)
+			: m_maxPerWindow(maxPerSecond < MaxPerWindow ? maxPerSecond : MaxPerWindow)
+			, m_window(0)
+			, m_suppressed(0)
+		{
+		}
+
+	public:
+		/// Determines whether a message may be written now.
+		/// @param nowNs The current monotonic time in nanoseconds.
+		/// @param suppressed Receives the number of messages which have been suppressed since the last
+		///        written message, if the message may be written.
+		/// @returns true if the message should be written, false if it has been suppressed.
+		bool tryAcquire(uint64 nowNs, uint64 &suppressed)
+		{
+			const uint64 nowMs = (nowNs / 1000000) & StartMask;
+
+			// The window start and its message count are replaced together, so that starting a new window
+			// can't drop messages which other threads counted at the same time
+			uint64 window = m_window.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				const uint64 startMs = window >> CountBits;
+				const uint64 count = window & CountMask;
+
+				// Threads which read the clock just before the window started count towards it as well
+				const uint64 elapsedMs = (nowMs - startMs) & StartMask;
+
+				uint64 next = window + 1;
+				if (elapsedMs >= WindowNs / 1000000 && elapsedMs <= StartMask / 2)
+				{
+					next = (nowMs << CountBits) | 1;
+				}
+				else if (count >= m_maxPerWindow)
+				{
+					m_suppressed.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+
+				if (m_window.compare_exchange_weak(window, next, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+
+			suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+			return true;
+		}
+		/// Gets the number of messages which have been suppressed and not reported yet.
+		uint64 getSuppressed() const
+		{
+			return m_suppressed.load(std::memory_order_relaxed);
+		}
+
+	private:
+
+		/// Number of low bits of m_window which count the messages of the window.
+		static constexpr uint64 CountBits = 24;
+		static constexpr uint64 CountMask = (uint64(1) << CountBits) - 1;
+		/// Mask of the window start in milliseconds, which wraps after more than 30 years.
+		static constexpr uint64 StartMask = (uint64(1) << (64 - CountBits)) - 1;
+
+		const uint32 m_maxPerWindow;
+		/// Start of the current window in milliseconds in the high bits and the number of messages which
+		/// have been written in it in the low CountBits bits.
+		std::atomic<uint64> m_window;
+		std::atomic<uint64> m_suppressed;
+	};
+
+
+	/// Writes only every n-th message of a single log statement. Used by the *LOG_SAMPLED macros.
+	/// This class is thread safe.
+	class LogSampler final
+	{
+	public:
+		/// @param every Only one of this many messages is written.
+		explicit LogSampler(uint32 every)
+			: m_every(every > 0 ? every : 1)
+			, m_count(0)
+		{
+		}
+
+	public:
+		/// Determines whether the current message is part of the sample. The first message always is.
+		bool sample()
+		{
+			return m_count.fetch_add(1, std::memory_order_relaxed) % m_every == 0;
+		}
+		/// Gets the sample rate.
+		uint32 getEvery() const
+		{
+			return m_every;
+		}
+
+	private:
+
+		const uint32 m_every;
+		std::atomic<uint64> m_count;
+	};
+}
@@ -2,6 +2,7 @@
 
 #include "log_std_stream.h"
 #include "log_entry.h"
+#include "log_format.h"
 #include "log_level.h"
 #include "base/console.h"
 #include <ctime>
@@ -93,9 +94,8 @@ namespace mmo
 			        << stream.widen(' ');
 		}
 
-		stream
-		        << entry.message
-		        << '\n';
+		writeLogMessage(stream, entry);
+		stream << '\n';
 
 		if (options.alwaysFlush)
 		{
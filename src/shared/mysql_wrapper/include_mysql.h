@@ -5,8 +5,12 @@
 #if defined(WIN32) || defined(_WIN32)
 #	include <winsock2.h>
 #	include <mysql.h>
+#	include <errmsg.h>
+#	include <mysqld_error.h>
 #else
 #	include <mysql/mysql.h>
+#	include <mysql/errmsg.h>
+#	include <mysql/mysqld_error.h>
 #endif
 
 #if MYSQL_VERSION_ID >= 80000
@@ -25,8 +25,9 @@ namespace mmo
 		}
 
 
-		StatementException::StatementException(const std::string &message)
+		StatementException::StatementException(const std::string &message, unsigned errorCode)
 			: Exception(message)
+			, m_errorCode(errorCode)
 		{
 		}
 	}
@@ -42,7 +42,14 @@ namespace mmo
 
 		struct StatementException : Exception
 		{
-			explicit StatementException(const std::string &message);
+			explicit StatementException(const std::string &message, unsigned errorCode = 0);
+
+			/// Gets the MySQL error code of the failed statement call or 0 if the error was not reported by MySQL.
+			unsigned GetErrorCode() const { return m_errorCode; }
+
+		private:
+
+			unsigned m_errorCode;
 		};
 	}
 }
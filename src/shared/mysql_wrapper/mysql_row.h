@@ -5,7 +5,9 @@
 #include "include_mysql.h"
 #include "base/typedefs.h"
 #include "mysql_exception.h"
-#include <sstream>
+#include <charconv>
+#include <cstring>
+#include <type_traits>
 
 namespace mmo
 {
@@ -14,6 +16,35 @@ namespace mmo
 		struct Select;
 
 
+		/// Converts the text of a result field into a string.
+		inline bool ParseField(const char *field, String &value)
+		{
+			value.assign(field);
+			return true;
+		}
+
+		/// Converts the text of a result field into a number without allocating memory.
+		/// @returns false if the field is not a number of the given type or contains additional characters.
+		template <class T>
+		typename std::enable_if<std::is_arithmetic<T>::value, bool>::type ParseField(const char *field, T &value)
+		{
+			const char *const end = field + std::strlen(field);
+
+			if constexpr (std::is_same<T, bool>::value)
+			{
+				int number = 0;
+				const auto result = std::from_chars(field, end, number);
+				value = (number != 0);
+				return result.ec == std::errc() && result.ptr == end;
+			}
+			else
+			{
+				const auto result = std::from_chars(field, end, value);
+				return result.ec == std::errc() && result.ptr == end;
+			}
+		}
+
+
 		struct Row
 		{
 			explicit Row(Select &select);
@@ -24,27 +55,19 @@ namespace mmo
 			template <class T, class F = T>
 			bool GetField(std::size_t index, T &value) const
 			{
-				try
+				const char *const field = GetField(index);
+				if (!field)
 				{
-					const char *const field = GetField(index);
-					if (!field)
-					{
-						return false;
-					}
-
-					std::istringstream iss;
-					iss.str(field);
-
-					F tmp;
-					iss >> tmp;
-
-					value = static_cast<T>(tmp);
+					return false;
 				}
-				catch(...)
+
+				F tmp;
+				if (!ParseField(field, tmp))
 				{
 					return false;
 				}
 
+				value = static_cast<T>(tmp);
 				return true;
 			}
 
@@ -17,7 +17,8 @@ namespace mmo
 				const auto rc = mysql_stmt_errno(&statement);
 				throw StatementException(
 					std::to_string(rc) + ", " +
-				    mysql_stmt_error(&statement)
+				    mysql_stmt_error(&statement),
+					rc
 				);
 			}
 
@@ -411,6 +412,73 @@ namespace mmo
 			return result;
 		}
 
+		void StatementResult::GetString(std::size_t index, std::string &value,
+		                                std::size_t maxLengthInBytes)
+		{
+			//The first try uses the whole capacity of the string, which is
+			//enough if the same string is reused for the same column of every
+			//row. Only longer values need another fetch.
+			value.resize(value.capacity());
+
+			unsigned long realLength = 0;
+			my_bool isNull = 0;
+			my_bool isTruncated = 0;
+			MYSQL_BIND bind = {};
+			bind.buffer_type = MYSQL_TYPE_STRING;
+			bind.buffer = &value[0];
+			bind.buffer_length = value.size();
+			bind.is_null = &isNull;
+			bind.length = &realLength;
+			bind.error = &isTruncated;
+			int rc = mysql_stmt_fetch_column(
+			             m_statement, &bind, static_cast<unsigned>(index), 0);
+			CheckResultCode(*m_statement, rc);
+
+			if (isNull)
+			{
+				value.clear();
+				return;
+			}
+
+			if (!isTruncated)
+			{
+				if (realLength > value.size())
+				{
+					throw StatementException(
+					    "MySQL C API returned an invalid string length");
+				}
+				value.resize(static_cast<std::size_t>(realLength));
+				return;
+			}
+
+			if (realLength > maxLengthInBytes)
+			{
+				throw StatementException(
+					std::string("Maximum string length exceeded(") + std::to_string(realLength) + " > " + std::to_string(maxLengthInBytes));
+			}
+
+			value.resize(static_cast<std::size_t>(realLength));
+
+			isTruncated = 0;
+			bind.buffer = &value[0];
+			bind.buffer_length = value.size();
+			rc = mysql_stmt_fetch_column(
+			         m_statement, &bind, static_cast<unsigned>(index), 0);
+			CheckResultCode(*m_statement, rc);
+
+			if (isTruncated)
+			{
+				throw StatementException(
+				    "MySQL C API reported an unexpected truncation");
+			}
+
+			if (realLength != value.size())
+			{
+				throw StatementException(
+				    "MySQL C API returned an unexpected string length");
+			}
+		}
+
 		int64 StatementResult::GetInt(std::size_t index)
 		{
 			int64 result = 0;
@@ -5,6 +5,7 @@
 #include "include_mysql.h"
 #include "base/typedefs.h"
 #include <optional>
+#include <type_traits>
 #include <variant>
 #include <vector>
 
@@ -85,10 +86,44 @@ namespace mmo
 			bool FetchResultRow();
 			std::string GetString(std::size_t index,
 			                      std::size_t maxLengthInBytes = 1024 * 1024);
+			/// Reads a string column into an existing string, which only allocates memory if its
+			/// capacity is too small for the value. A NULL value results in an empty string.
+			void GetString(std::size_t index, std::string &value,
+			               std::size_t maxLengthInBytes = 1024 * 1024);
 			int64 GetInt(std::size_t index);
 			double GetDouble(std::size_t index);
 			bool GetBoolean(std::size_t index);
 
+			/// Reads a column of the current row into a variable. Numbers are read from the binary
+			/// protocol buffers, so there is no text conversion involved.
+			void Read(std::size_t index, std::string &value) { GetString(index, value); }
+			void Read(std::size_t index, double &value) { value = GetDouble(index); }
+			void Read(std::size_t index, float &value) { value = static_cast<float>(GetDouble(index)); }
+			void Read(std::size_t index, bool &value) { value = (GetInt(index) != 0); }
+			template <class T>
+			typename std::enable_if<std::is_integral<T>::value>::type Read(std::size_t index, T &value)
+			{
+				value = static_cast<T>(GetInt(index));
+			}
+
+			/// Reads the columns of the current row, beginning with the first one, into the given
+			/// variables in order.
+			template <class... T>
+			void ReadColumns(T &... values)
+			{
+				std::size_t index = 0;
+				(Read(index++, values), ...);
+			}
+
+			/// Reads the columns of the current row, beginning with the first one, into the given
+			/// members of a struct in order. Example:
+			/// result.ReadRow(data, &AccountData::id, &AccountData::name);
+			template <class Struct, class... T>
+			void ReadRow(Struct &row, T Struct::*... members)
+			{
+				ReadColumns((row.*members)...);
+			}
+
 		private:
 
 			MYSQL_STMT *m_statement;
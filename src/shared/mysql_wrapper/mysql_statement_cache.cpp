@@ -0,0 +1,86 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#include "mysql_statement_cache.h"
+#include "mysql_connection.h"
+
+#include <cassert>
+
+namespace mmo
+{
+	namespace mysql
+	{
+		bool IsConnectionLostError(unsigned errorCode)
+		{
+			switch (errorCode)
+			{
+			case CR_SERVER_GONE_ERROR:
+			case CR_SERVER_LOST:
+			case CR_NO_PREPARE_STMT:
+			case ER_UNKNOWN_STMT_HANDLER:
+				return true;
+
+			default:
+				return false;
+			}
+		}
+
+
+		StatementCache::StatementCache(Connection &connection, std::vector<String> queries)
+			: m_connection(connection)
+			, m_queries(std::move(queries))
+		{
+		}
+
+		void StatementCache::Prepare()
+		{
+			m_statements.clear();
+			prepareMissing();
+		}
+
+		std::size_t StatementCache::Add(String query)
+		{
+			m_queries.emplace_back(std::move(query));
+			return m_queries.size() - 1;
+		}
+
+		Statement &StatementCache::getStatement(std::size_t index)
+		{
+			assert(index < m_queries.size());
+
+			if (index >= m_statements.size())
+			{
+				prepareMissing();
+			}
+
+			return m_statements[index];
+		}
+
+		void StatementCache::prepareMissing()
+		{
+			// Statements are prepared in query order, so a failure leaves only the failed query and the
+			// ones after it unprepared
+			m_statements.reserve(m_queries.size());
+			while (m_statements.size() < m_queries.size())
+			{
+				m_statements.emplace_back(m_connection, m_queries[m_statements.size()]);
+			}
+		}
+
+		void StatementCache::reconnect()
+		{
+			// Statements of the old session are gone on the server side, and closing their handles
+			// might still need the connection, so drop them before reconnecting
+			m_statements.clear();
+
+			// The connection is configured to reconnect automatically, which is triggered by a ping
+			if (!m_connection.KeepAlive())
+			{
+				throw StatementException(
+					std::string("Could not reconnect to the MySQL server: ") + m_connection.GetErrorMessage(),
+					static_cast<unsigned>(m_connection.GetErrorCode()));
+			}
+
+			Prepare();
+		}
+	}
+}
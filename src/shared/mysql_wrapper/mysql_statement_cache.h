@@ -0,0 +1,86 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "mysql_statement.h"
+#include "mysql_exception.h"
+#include "base/typedefs.h"
+
+#include <utility>
+#include <vector>
+
+namespace mmo
+{
+	namespace mysql
+	{
+		struct Connection;
+
+
+		/// Returns true if a MySQL error code means that the connection to the server has been lost or
+		/// that the server forgot the prepared statements of the connection because it reconnected.
+		bool IsConnectionLostError(unsigned errorCode);
+
+
+		/// A set of prepared statements which belong to one connection. Each query is prepared once and
+		/// reused for every execution, so the server parses it only once and parameters and results are
+		/// transferred with the binary protocol instead of being converted to and from text.
+		/// Queries are identified by their index in the list which has been passed to the constructor,
+		/// queries added later on follow in the order they have been added.
+		/// Just like the connection it belongs to, this class is not thread safe.
+		struct StatementCache
+		{
+		private:
+
+			StatementCache(const StatementCache &Other) = delete;
+			StatementCache &operator=(const StatementCache &Other) = delete;
+
+		public:
+
+			explicit StatementCache(Connection &connection, std::vector<String> queries);
+			/// Prepares all queries. Has to be called after the connection has been established.
+			/// @throws StatementException if a query could not be prepared.
+			void Prepare();
+			/// Returns true if all queries have been prepared.
+			bool IsPrepared() const { return m_statements.size() == m_queries.size(); }
+			/// Adds a query which is prepared when it is executed for the first time, for example a statement
+			/// which is built for a specific number of rows.
+			/// @returns Index of the query.
+			std::size_t Add(String query);
+
+			/// Calls func with the prepared statement of a query and returns its result. If the statement
+			/// fails because the connection has been lost, the connection is reestablished, all queries are
+			/// prepared again and func is called a second time, so func has to set all parameters itself and
+			/// the query has to be safe to repeat.
+			template <class Func>
+			auto Execute(std::size_t index, Func &&func) -> decltype(func(std::declval<Statement &>()))
+			{
+				try
+				{
+					return func(getStatement(index));
+				}
+				catch (const StatementException &e)
+				{
+					if (!IsConnectionLostError(e.GetErrorCode()))
+					{
+						throw;
+					}
+				}
+
+				reconnect();
+				return func(getStatement(index));
+			}
+
+		private:
+
+			Statement &getStatement(std::size_t index);
+			void prepareMissing();
+			void reconnect();
+
+		private:
+
+			Connection &m_connection;
+			std::vector<String> m_queries;
+			std::vector<Statement> m_statements;
+		};
+	}
+}
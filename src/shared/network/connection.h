@@ -4,15 +4,26 @@
 
 #include "base/typedefs.h"
 #include "buffer.h"
+#include "receive_buffer.h"
+#include "send_queue.h"
+#include "send_cork.h"
+#include "send_backpressure.h"
+#include "packet_statistics.h"
 #include "receive_state.h"
 #include "base/assign_on_exit.h"
+#include "base/clock.h"
 #include "binary_io/string_sink.h"
 #include "binary_io/memory_source.h"
 
 #include "asio/io_service.hpp"
 #include "asio/ip/tcp.hpp"
 #include "asio/write.hpp"
+#include "asio/strand.hpp"
+#include "asio/bind_executor.hpp"
+#include "asio/post.hpp"
+#include "asio/steady_timer.hpp"
 
+#include <chrono>
 #include <functional>
 #include <cassert>
 
@@ -42,6 +53,10 @@ namespace mmo
 		virtual void connectionMalformedPacket() = 0;
 		virtual PacketParseResult connectionPacketReceived(typename Protocol::IncomingPacket &packet) = 0;
 		virtual void connectionDataSent(size_t size) {};
+		/// Called when the amount of queued outgoing data reached the high send watermark.
+		virtual void connectionSendBufferHigh(size_t /*queuedSize*/) {};
+		/// Called when the amount of queued outgoing data dropped to the low send watermark again.
+		virtual void connectionSendBufferLow(size_t /*queuedSize*/) {};
 	};
 
 
@@ -63,10 +78,28 @@ namespace mmo
 		virtual void resetListener() = 0;
 		virtual asio::ip::address getRemoteAddress() const = 0;
 		virtual Buffer &getSendBuffer() = 0;
+		/// Queues a shared, immutable buffer behind the current send buffer contents without copying it.
+		virtual void sendSharedBuffer(SharedBuffer buffer) = 0;
 		virtual void startReceiving() = 0;
 		virtual void resumeParsing() = 0;
 		virtual void flush() = 0;
+		/// Flushes the send buffer, or defers the flush to the end of the current io batch if the
+		/// connection is corked.
+		virtual void requestFlush() = 0;
+		/// Enables or disables cork mode. While corked, packets are collected and flushed once at the
+		/// end of the current io batch instead of one write per packet.
+		/// @param maxLatency Maximum time a packet may wait for its flush. Zero disables the cap.
+		virtual void setCorked(bool corked, std::chrono::microseconds maxLatency) = 0;
+		/// Sets the limits for the amount of outgoing data which may be queued on this connection.
+		virtual void setSendWatermarks(const SendWatermarks &watermarks) = 0;
+		/// Gets the number of outgoing bytes which have not been sent yet.
+		virtual size_t getQueuedSendSize() const = 0;
+		/// Gets the maximum number of outgoing bytes which have been queued at once.
+		virtual size_t getPeakQueuedSendSize() const = 0;
 		virtual void close() = 0;
+		/// Executes a handler on the strand of this connection, so that it never runs concurrently
+		/// with any other handler of this connection.
+		virtual void post(std::function<void()> handler) = 0;
 
 		template<class F>
 		void sendSinglePacket(F generator)
@@ -74,11 +107,23 @@ namespace mmo
 			io::StringSink sink(getSendBuffer());
 			typename Protocol::OutgoingPacket packet(sink);
 			generator(packet);
-			flush();
+			requestFlush();
 		}
 	};
 
 
+	/// Wraps a handler so that it is executed on the strand of a connection when invoked. This is
+	/// used for callbacks which are invoked by other threads, like database request results.
+	template<class C, class Handler>
+	auto bindToConnection(std::shared_ptr<C> connection, Handler handler)
+	{
+		return [connection = std::move(connection), handler = std::move(handler)](auto... args)
+		{
+			connection->post([handler, args...]() { handler(args...); });
+		};
+	}
+
+
 	///
 	template<class P, class MySocket = asio::ip::tcp::socket>
 	class Connection
@@ -100,11 +145,15 @@ namespace mmo
 
 		explicit Connection(std::unique_ptr<Socket> Socket_, Listener *Listener_)
 			: m_socket(std::move(Socket_))
+			, m_strand(m_socket->get_executor())
 			, m_listener(Listener_)
+			, m_slowConsumerTimer(m_socket->get_executor())
 			, m_isParsingIncomingData(false)
 			, m_isClosedOnParsing(false)
 			, m_isClosedOnSend(false)
 			, m_isReceiving(false)
+			, m_isBlockedByListener(false)
+			, m_isDroppingSlowConsumer(false)
 		{
 		}
 
@@ -146,33 +195,125 @@ namespace mmo
 
 		void resumeParsing() override
 		{
+			m_isBlockedByListener = false;
 			parsePackets();
 		}
 
-		void flush() override
+		void sendSharedBuffer(SharedBuffer buffer) override
 		{
-			if (m_sendBuffer.empty())
+			if (m_isDroppingSlowConsumer)
 			{
+				m_sendBuffer.clear();
 				return;
 			}
 
-			if (!m_sending.empty())
+			// Keep the order of data which has been written to the send buffer before
+			m_sendQueue.push(m_sendBuffer);
+			m_sendQueue.push(std::move(buffer));
+			updateBackpressure();
+		}
+
+		void flush() override
+		{
+			m_cork.flushed();
+
+			// Data written while a send is in progress is collected in the send buffer
+			// and sent as a whole as soon as the current send completed
+			if (m_sendQueue.isSending())
 			{
 				return;
 			}
 
-			m_sending = m_sendBuffer;
-			m_sendBuffer.clear();
+			m_sendQueue.push(m_sendBuffer);
+			if (!m_sendQueue.hasPending())
+			{
+				return;
+			}
 
 			assert(m_sendBuffer.empty());
-			assert(!m_sending.empty());
 
 			beginSend();
 		}
 
+		void requestFlush() override
+		{
+			// Nothing is sent anymore to a slow consumer which is being dropped
+			if (m_isDroppingSlowConsumer)
+			{
+				m_sendBuffer.clear();
+				return;
+			}
+
+			if (!m_cork.isEnabled())
+			{
+				flush();
+				updateBackpressure();
+				return;
+			}
+
+			switch (m_cork.packetWritten(GetMonotonicTimeNs()))
+			{
+			case SendCork::Action::FlushNow:
+				flush();
+				break;
+			case SendCork::Action::ScheduleFlush:
+				// Queued behind all handlers which are already ready to run, so packets written by
+				// them are sent together
+				asio::post(m_strand, std::bind(&Connection<P, Socket>::corkedFlush, this->shared_from_this()));
+				break;
+			case SendCork::Action::None:
+				break;
+			}
+
+			updateBackpressure();
+		}
+
+		void setCorked(bool corked, std::chrono::microseconds maxLatency) override
+		{
+			if (corked)
+			{
+				m_cork.enable(maxLatency);
+			}
+			else
+			{
+				m_cork.disable();
+				flush();
+			}
+		}
+
+		void setSendWatermarks(const SendWatermarks &watermarks) override
+		{
+			m_backpressure.setWatermarks(watermarks);
+		}
+
+		size_t getQueuedSendSize() const override
+		{
+			return m_sendBuffer.size() + m_sendQueue.getQueuedSize();
+		}
+
+		size_t getPeakQueuedSendSize() const override
+		{
+			return m_backpressure.getPeakSize();
+		}
+
+		void post(std::function<void()> handler) override
+		{
+			asio::post(m_strand, [handler = std::move(handler)]()
+			{
+				UpdateTickTime();
+				handler();
+			});
+		}
+
 		void close() override
 		{
-			if (!m_sending.empty())
+			// Corked packets have to be sent before the connection is closed
+			if (m_cork.isPending())
+			{
+				flush();
+			}
+
+			if (m_sendQueue.isSending())
 			{
 				m_isClosedOnSend = true;
 			}
@@ -232,51 +373,167 @@ namespace mmo
 
 	private:
 
-		typedef std::array<char, 4096> ReceiveBuffer;
-
 		std::unique_ptr<Socket> m_socket;
+		asio::strand<typename Socket::executor_type> m_strand;
 		Listener *m_listener;
-		Buffer m_sending;
+		SendQueue m_sendQueue;
 		Buffer m_sendBuffer;
-		Buffer m_received;
-		ReceiveBuffer m_receiving;
+		SendCork m_cork;
+		SendBackpressure m_backpressure;
+		asio::steady_timer m_slowConsumerTimer;
+		ReceiveBuffer m_received;
 		bool m_isParsingIncomingData;
 		bool m_isClosedOnParsing;
 		bool m_isClosedOnSend;
 		bool m_isReceiving;
+		bool m_isBlockedByListener;
+		bool m_isDroppingSlowConsumer;
+
+		void corkedFlush()
+		{
+			if (m_cork.scheduledFlushExecuted())
+			{
+				flush();
+			}
+		}
+
+		void updateBackpressure()
+		{
+			if (!m_backpressure.isEnabled())
+			{
+				return;
+			}
+
+			const size_t queuedSize = getQueuedSendSize();
+			switch (m_backpressure.update(queuedSize, GetTickTimeNs()))
+			{
+			case SendBackpressure::Event::HighWatermarkReached:
+				if (PacketStatistics::isEnabled())
+				{
+					PacketStatistics::get<P>().recordHighWatermark();
+				}
+
+				if (m_backpressure.getWatermarks().slowConsumerTimeout.count() > 0)
+				{
+					m_slowConsumerTimer.expires_after(m_backpressure.getWatermarks().slowConsumerTimeout);
+					m_slowConsumerTimer.async_wait(
+						asio::bind_executor(m_strand, std::bind(&Connection<P, Socket>::slowConsumerTimerExpired, this->shared_from_this(), std::placeholders::_1)));
+				}
+
+				if (m_listener)
+				{
+					m_listener->connectionSendBufferHigh(queuedSize);
+				}
+				break;
+			case SendBackpressure::Event::LowWatermarkReached:
+				m_slowConsumerTimer.cancel();
+
+				if (m_listener)
+				{
+					m_listener->connectionSendBufferLow(queuedSize);
+				}
+
+				// Continue with the packets which have been received while parsing was paused
+				if (m_backpressure.getWatermarks().pauseParsing && !m_isBlockedByListener && !m_isParsingIncomingData)
+				{
+					parsePackets();
+				}
+				break;
+			case SendBackpressure::Event::LimitExceeded:
+				dropSlowConsumer();
+				break;
+			case SendBackpressure::Event::None:
+				break;
+			}
+		}
+
+		void slowConsumerTimerExpired(const asio::error_code &error)
+		{
+			if (error)
+			{
+				return;
+			}
+
+			// The timer might have expired right before the connection has been drained
+			if (m_backpressure.isSlowConsumer(GetMonotonicTimeNs()))
+			{
+				dropSlowConsumer();
+			}
+		}
+
+		void dropSlowConsumer()
+		{
+			// The limit is exceeded by every packet which is written until the connection is closed
+			if (m_isDroppingSlowConsumer)
+			{
+				return;
+			}
+
+			m_isDroppingSlowConsumer = true;
+
+			WLOG("Dropping slow consumer connection with " << getQueuedSendSize() << " bytes of unsent data");
+
+			if (PacketStatistics::isEnabled())
+			{
+				PacketStatistics::get<P>().recordSlowConsumerDropped();
+			}
+
+			m_sendBuffer.clear();
+
+			// Disconnecting would destroy the listener while its packet handler is still running
+			if (m_isParsingIncomingData)
+			{
+				m_isClosedOnParsing = true;
+				return;
+			}
+
+			// Packets are also sent outside of the parse loop, for example by database callbacks, and the
+			// listener which is sending might be destroyed by the disconnect as well
+			asio::post(m_strand, std::bind(&Connection<P, Socket>::disconnected, this->shared_from_this()));
+		}
 
 		void beginSend()
 		{
-			assert(!m_sending.empty());
+			assert(m_sendQueue.hasPending());
 
 			if (!m_socket)
 				return;
 
+			// Write all pending segments at once using a single vectored write
 			asio::async_write(
 			    *m_socket,
-			    asio::buffer(m_sending),
-			    std::bind(&Connection<P, Socket>::sent, this->shared_from_this(), std::placeholders::_1));
+			    m_sendQueue.beginSend(),
+			    asio::bind_executor(m_strand, std::bind(&Connection<P, Socket>::sent, this->shared_from_this(), std::placeholders::_1)));
 		}
 
 		void sent(const asio::system_error &error)
 		{
+			UpdateTickTime();
+
 			if (error.code())
 			{
 				disconnected();
 				return;
 			}
 
+			if (PacketStatistics::isEnabled())
+			{
+				PacketStatistics::get<P>().recordDataSent(m_sendQueue.getSendingSize());
+			}
+
 			if (m_listener)
 			{
-				m_listener->connectionDataSent(m_sending.size());
+				m_listener->connectionDataSent(m_sendQueue.getSendingSize());
 			}
 
-			m_sending.clear();
+			m_sendQueue.sendCompleted();
 			flush();
+			updateBackpressure();
 
-			if (m_isClosedOnSend && m_sending.empty())
+			if (m_isClosedOnSend && !m_sendQueue.isSending())
 			{
 				disconnected();
+				m_sendQueue.clear();
 				m_sendBuffer.clear();
 				return;
 			}
@@ -292,31 +549,39 @@ namespace mmo
 
 			m_isReceiving = true;
 
+			// Read directly into the free space at the end of the receive buffer
+			char *const receiveBegin = m_received.prepare();
 			m_socket->async_read_some(
-			    asio::buffer(m_receiving.data(), m_receiving.size()),
-			    std::bind(&Connection<P, Socket>::received, this->shared_from_this(), std::placeholders::_2));
+			    asio::buffer(receiveBegin, m_received.getWritableSize()),
+			    asio::bind_executor(m_strand, std::bind(&Connection<P, Socket>::received, this->shared_from_this(), std::placeholders::_2)));
 		}
 
 		void received(std::size_t size)
 		{
+			UpdateTickTime();
+
 			m_isReceiving = false;
 
-			assert(size <= m_receiving.size());
+			assert(size <= m_received.getWritableSize());
 			if (size == 0)
 			{
 				disconnected();
 				return;
 			}
 
-			m_received.append(
-			    m_receiving.begin(),
-			    m_receiving.begin() + size);
+			m_received.commit(size);
 
 			parsePackets();
 		}
 
 		void parsePackets()
 		{
+			// Neither parse nor receive anything until the peer read the data which is queued already
+			if (m_backpressure.isParsingPaused())
+			{
+				return;
+			}
+
 			m_isParsingIncomingData = true;
 			AssignOnExit<bool> isParsingIncomingDataResetter(
 				m_isParsingIncomingData, false);
@@ -328,7 +593,7 @@ namespace mmo
 				nextPacket = false;
 
 				const size_t availableSize = (m_received.size() - parsedUntil);
-				const char *const packetBegin = &m_received[0] + parsedUntil;
+				const char *const packetBegin = m_received.data() + parsedUntil;
 				const char *const streamEnd = packetBegin + availableSize;
 
 				io::MemorySource source(packetBegin, streamEnd);
@@ -343,13 +608,25 @@ namespace mmo
 					case receive_state::Complete:
 						if (m_listener)
 						{
+							// Measure the handler only if statistics are enabled to keep the cost near zero otherwise
+							const bool recordStatistics = PacketStatistics::isEnabled();
+							const auto handlerStart = recordStatistics ? PacketStatistics::Clock::now() : PacketStatistics::Clock::time_point();
+
 							auto result = m_listener->connectionPacketReceived(packet);
+
+							if (recordStatistics)
+							{
+								PacketStatistics::get<P>().recordPacketReceived(packet.GetId(), static_cast<size_t>(source.getPosition() - source.getBegin()),
+									PacketStatistics::Clock::now() - handlerStart);
+							}
+
 							switch (result)
 							{
 							case PacketParseResult::Pass:
 								nextPacket = true;
 								break;
 							case PacketParseResult::Block:
+								m_isBlockedByListener = true;
 								nextPacket = false;
 								break;
 							case PacketParseResult::Disconnect:
@@ -357,6 +634,11 @@ namespace mmo
 								nextPacket = false;
 								break;
 							}
+
+							if (m_backpressure.isParsingPaused())
+							{
+								nextPacket = false;
+							}
 						}
 
 						parsedUntil += static_cast<std::size_t>(source.getPosition() - source.getBegin());
@@ -389,16 +671,19 @@ namespace mmo
 			{
 				assert(parsedUntil <= m_received.size());
 
-				m_received.erase(
-					m_received.begin(),
-					m_received.begin() + static_cast<std::ptrdiff_t>(parsedUntil));
+				m_received.consume(parsedUntil);
 			}
 
-			beginReceive();
+			if (!m_backpressure.isParsingPaused())
+			{
+				beginReceive();
+			}
 		}
 
 		void disconnected()
 		{
+			m_slowConsumerTimer.cancel();
+
 			if (m_listener)
 			{
 				m_listener->connectionLost();
@@ -0,0 +1,120 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+
+#include "asio/io_service.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cassert>
+
+namespace mmo
+{
+	/// Manages a number of io services which are each run by a single thread. This allows network
+	/// code to scale across multiple cores without sharing a single io service and its handler queue
+	/// between all threads, as every connection is bound to the io service it has been created on.
+	class IoServicePool final
+	{
+	private:
+
+		IoServicePool(const IoServicePool &Other) = delete;
+		IoServicePool &operator=(const IoServicePool &Other) = delete;
+
+	public:
+
+		typedef std::vector<asio::io_service*> ServiceList;
+
+	public:
+
+		/// Creates the io services of this pool.
+		/// @param size Number of io services and threads to use. If 0, one io service per
+		///        available hardware thread is created.
+		explicit IoServicePool(size_t size)
+		{
+			if (size == 0)
+			{
+				size = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+			}
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				auto service = std::make_unique<asio::io_service>();
+				m_works.emplace_back(std::make_unique<asio::io_service::work>(*service));
+				m_serviceList.push_back(service.get());
+				m_services.emplace_back(std::move(service));
+			}
+		}
+
+		~IoServicePool()
+		{
+			stop();
+			join();
+		}
+
+	public:
+		/// Gets the number of io services in this pool.
+		size_t size() const
+		{
+			return m_services.size();
+		}
+		/// Gets an io service of this pool by index.
+		asio::io_service &getService(size_t index)
+		{
+			assert(index < m_services.size());
+			return *m_services[index];
+		}
+		/// Gets all io services of this pool, for example to pass them to a server instance.
+		const ServiceList &getServices() const
+		{
+			return m_serviceList;
+		}
+		/// Launches one thread per io service which runs that service.
+		void run()
+		{
+			assert(m_threads.empty());
+
+			for (auto &service : m_services)
+			{
+				asio::io_service &ioService = *service;
+				m_threads.emplace_back([&ioService]() { ioService.run(); });
+			}
+		}
+		/// Allows the io services to return once they ran out of work.
+		void release()
+		{
+			m_works.clear();
+		}
+		/// Stops all io services immediately.
+		void stop()
+		{
+			for (auto &service : m_services)
+			{
+				service->stop();
+			}
+		}
+		/// Waits for all threads of this pool to finish.
+		void join()
+		{
+			for (auto &thread : m_threads)
+			{
+				if (thread.joinable())
+				{
+					thread.join();
+				}
+			}
+
+			m_threads.clear();
+		}
+
+	private:
+
+		std::vector<std::unique_ptr<asio::io_service>> m_services;
+		std::vector<std::unique_ptr<asio::io_service::work>> m_works;
+		std::vector<std::thread> m_threads;
+		ServiceList m_serviceList;
+	};
+}
@@ -0,0 +1,143 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "connection.h"
+
+#include <array>
+#include <bitset>
+#include <functional>
+#include <limits>
+#include <cassert>
+
+namespace mmo
+{
+	/// Fixed size, op code indexed table of packet handlers. Every op code has an enabled bit, so
+	/// handlers can be switched on and off depending on the connection state without touching the
+	/// handler itself. Dispatching a packet neither locks nor copies the handler. This class is not
+	/// thread safe: It has to be used on the strand of the connection whose packets it dispatches.
+	template<class Packet, size_t OpCodeCount>
+	class PacketDispatcher final
+	{
+	private:
+
+		PacketDispatcher(const PacketDispatcher &Other) = delete;
+		PacketDispatcher &operator=(const PacketDispatcher &Other) = delete;
+
+	public:
+
+		typedef std::function<PacketParseResult(Packet &)> Handler;
+
+	public:
+
+		PacketDispatcher()
+			: m_dispatchedOpCode(NoOpCode)
+			, m_deferredOpCode(NoOpCode)
+		{
+		}
+
+	public:
+		/// Sets the handler of an op code and enables it.
+		void registerHandler(size_t opCode, Handler handler)
+		{
+			assert(opCode < OpCodeCount);
+			assert(handler);
+
+			// Replacing the handler which is currently executed would destroy it while it is still
+			// running, so the replacement is applied after the handler returned.
+			if (opCode == m_dispatchedOpCode)
+			{
+				m_deferredHandler = std::move(handler);
+				m_deferredOpCode = opCode;
+			}
+			else
+			{
+				m_handlers[opCode] = std::move(handler);
+			}
+
+			m_enabled.set(opCode);
+		}
+		/// Syntactic sugar implementation of registerHandler to avoid having to use std::bind.
+		template <class Instance, class Class>
+		void registerHandler(size_t opCode, Instance &object, PacketParseResult(Class::*method)(Packet &))
+		{
+			registerHandler(opCode, [&object, method](Packet &packet) {
+				return (object.*method)(packet);
+			});
+		}
+		/// Disables the handler of an op code. The handler itself is kept, so it may be re-enabled.
+		void clearHandler(size_t opCode)
+		{
+			assert(opCode < OpCodeCount);
+			m_enabled.reset(opCode);
+		}
+		/// Disables all handlers.
+		void clearHandlers()
+		{
+			m_enabled.reset();
+		}
+		/// Enables or disables the existing handler of an op code.
+		void setEnabled(size_t opCode, bool enabled)
+		{
+			assert(opCode < OpCodeCount);
+			assert(!enabled || m_handlers[opCode] || m_deferredOpCode == opCode);
+			m_enabled.set(opCode, enabled);
+		}
+		/// Determines whether a handler is enabled for an op code.
+		bool isEnabled(size_t opCode) const
+		{
+			return opCode < OpCodeCount && m_enabled.test(opCode);
+		}
+		/// Executes the handler of a packet's op code if it is enabled.
+		/// @param packet The packet to handle.
+		/// @param out_result Receives the result of the handler if it has been executed.
+		/// @returns false if the op code is not handled, true otherwise.
+		bool dispatch(Packet &packet, PacketParseResult &out_result)
+		{
+			const size_t opCode = packet.GetId();
+			if (!isEnabled(opCode))
+			{
+				return false;
+			}
+
+			// Handlers must not be dispatched recursively
+			assert(m_dispatchedOpCode == NoOpCode);
+			m_dispatchedOpCode = opCode;
+
+			// The dispatch also ends if the handler throws, so that later packets can still be dispatched
+			const DispatchScope scope{ *this };
+			out_result = m_handlers[opCode](packet);
+
+			return true;
+		}
+
+	private:
+
+		/// Ends the dispatch of a handler when it is left, and applies a handler which has been registered
+		/// for the dispatched op code in the meantime.
+		struct DispatchScope final
+		{
+			PacketDispatcher &dispatcher;
+
+			~DispatchScope()
+			{
+				dispatcher.m_dispatchedOpCode = NoOpCode;
+				if (dispatcher.m_deferredOpCode != NoOpCode)
+				{
+					dispatcher.m_handlers[dispatcher.m_deferredOpCode] = std::move(dispatcher.m_deferredHandler);
+					dispatcher.m_deferredHandler = nullptr;
+					dispatcher.m_deferredOpCode = NoOpCode;
+				}
+			}
+		};
+
+		static constexpr size_t NoOpCode = std::numeric_limits<size_t>::max();
+
+		std::array<Handler, OpCodeCount> m_handlers;
+		std::bitset<OpCodeCount> m_enabled;
+		size_t m_dispatchedOpCode;
+		Handler m_deferredHandler;
+		size_t m_deferredOpCode;
+	};
+}
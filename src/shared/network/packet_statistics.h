@@ -0,0 +1,381 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "log/default_log_levels.h"
+
+#include "asio/io_service.hpp"
+#include "asio/steady_timer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mmo
+{
+	/// Statistics of a single op code, copied out of the live counters.
+	struct OpCodeStatisticsSnapshot
+	{
+		/// The op code.
+		uint16 opCode;
+		/// Number of received packets.
+		uint64 packetCount;
+		/// Number of received bytes including packet headers.
+		uint64 byteCount;
+		/// Average handler execution time in nanoseconds.
+		uint64 averageNs;
+		/// Approximated median handler execution time in nanoseconds.
+		uint64 p50Ns;
+		/// Approximated 99th percentile of the handler execution time in nanoseconds.
+		uint64 p99Ns;
+		/// Maximum handler execution time in nanoseconds.
+		uint64 maxNs;
+	};
+
+	/// Statistics of a single protocol, copied out of the live counters.
+	struct ProtocolStatisticsSnapshot
+	{
+		/// Name of the protocol.
+		String protocol;
+		/// Number of completed sends.
+		uint64 sendCount;
+		/// Number of sent bytes.
+		uint64 sentBytes;
+		/// Number of times a connection reached its high send watermark.
+		uint64 highWatermarkCount;
+		/// Number of connections which have been dropped because they did not read their data.
+		uint64 slowConsumerDrops;
+		/// Statistics of all op codes which have been received at least once.
+		std::vector<OpCodeStatisticsSnapshot> opCodes;
+	};
+
+
+	/// Collects packet counts, byte counts and handler latency histograms per op code of a protocol.
+	/// Recording is thread safe and lock free. It is disabled by default, in which case connections
+	/// only pay for a single relaxed atomic load per received packet and completed send.
+	class PacketStatistics final
+	{
+	private:
+
+		PacketStatistics(const PacketStatistics &Other) = delete;
+		PacketStatistics &operator=(const PacketStatistics &Other) = delete;
+
+	public:
+
+		/// Number of tracked op codes. Higher op codes are accumulated in the last slot.
+		static constexpr size_t MaxOpCodes = 256;
+		/// Number of latency histogram buckets. Bucket i counts latencies below 2^(i+1) ns.
+		static constexpr size_t LatencyBucketCount = 32;
+
+		typedef std::chrono::steady_clock Clock;
+
+	public:
+
+		explicit PacketStatistics(String protocolName)
+			: m_protocolName(std::move(protocolName))
+		{
+			reset();
+
+			std::scoped_lock lock{ getRegistryMutex() };
+			getRegistry().push_back(this);
+		}
+
+		~PacketStatistics()
+		{
+			std::scoped_lock lock{ getRegistryMutex() };
+
+			auto &registry = getRegistry();
+			registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+		}
+
+	public:
+		/// Determines whether packet statistics are currently recorded.
+		static bool isEnabled()
+		{
+			return getEnabledFlag().load(std::memory_order_relaxed);
+		}
+		/// Enables or disables recording of packet statistics for all protocols.
+		static void setEnabled(bool enabled)
+		{
+			getEnabledFlag().store(enabled, std::memory_order_relaxed);
+		}
+		/// Gets the statistics instance of a protocol. The protocol has to provide a Name constant.
+		template<class P>
+		static PacketStatistics &get()
+		{
+			static PacketStatistics instance{ P::Name };
+			return instance;
+		}
+		/// Gets snapshots of all protocols which have been used so far.
+		static std::vector<ProtocolStatisticsSnapshot> getAllSnapshots()
+		{
+			std::vector<ProtocolStatisticsSnapshot> snapshots;
+
+			std::scoped_lock lock{ getRegistryMutex() };
+			for (const auto *statistics : getRegistry())
+			{
+				snapshots.push_back(statistics->getSnapshot());
+			}
+
+			return snapshots;
+		}
+		/// Writes a summary of all protocols to the log.
+		/// @param resetAfterwards If true, all counters are reset after they have been logged so that
+		///        the next summary only contains the packets of the following period.
+		static void logSummary(bool resetAfterwards)
+		{
+			std::scoped_lock lock{ getRegistryMutex() };
+			for (auto *statistics : getRegistry())
+			{
+				const ProtocolStatisticsSnapshot snapshot = statistics->getSnapshot();
+				if (snapshot.opCodes.empty() && snapshot.sendCount == 0 && snapshot.slowConsumerDrops == 0)
+				{
+					continue;
+				}
+
+				ILOG("Packet statistics [" << snapshot.protocol << "]: " << snapshot.sentBytes << " bytes sent in " << snapshot.sendCount << " writes, "
+					<< snapshot.highWatermarkCount << " times congested, " << snapshot.slowConsumerDrops << " slow consumers dropped");
+				for (const auto &opCode : snapshot.opCodes)
+				{
+					ILOG("\t0x" << std::hex << opCode.opCode << std::dec
+						<< ": " << opCode.packetCount << " packets, " << opCode.byteCount << " bytes, handler avg "
+						<< opCode.averageNs << " ns, p50 " << opCode.p50Ns << " ns, p99 " << opCode.p99Ns << " ns, max " << opCode.maxNs << " ns");
+				}
+
+				if (resetAfterwards)
+				{
+					statistics->reset();
+				}
+			}
+		}
+
+	public:
+		/// Gets the name of the protocol.
+		const String &getProtocolName() const
+		{
+			return m_protocolName;
+		}
+		/// Records a received packet and the time its handler took to execute.
+		void recordPacketReceived(uint16 opCode, size_t size, Clock::duration handlerTime)
+		{
+			OpCodeCounters &counters = m_opCodes[std::min<size_t>(opCode, MaxOpCodes - 1)];
+
+			const uint64 ns = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(handlerTime).count());
+			counters.packetCount.fetch_add(1, std::memory_order_relaxed);
+			counters.byteCount.fetch_add(size, std::memory_order_relaxed);
+			counters.totalNs.fetch_add(ns, std::memory_order_relaxed);
+			counters.latencyBuckets[getLatencyBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+
+			uint64 maxNs = counters.maxNs.load(std::memory_order_relaxed);
+			while (ns > maxNs && !counters.maxNs.compare_exchange_weak(maxNs, ns, std::memory_order_relaxed))
+			{
+			}
+		}
+		/// Records a completed send.
+		void recordDataSent(size_t size)
+		{
+			m_sendCount.fetch_add(1, std::memory_order_relaxed);
+			m_sentBytes.fetch_add(size, std::memory_order_relaxed);
+		}
+		/// Records that a connection reached its high send watermark.
+		void recordHighWatermark()
+		{
+			m_highWatermarkCount.fetch_add(1, std::memory_order_relaxed);
+		}
+		/// Records that a connection has been dropped because it did not read its data.
+		void recordSlowConsumerDropped()
+		{
+			m_slowConsumerDrops.fetch_add(1, std::memory_order_relaxed);
+		}
+		/// Copies the current counters.
+		ProtocolStatisticsSnapshot getSnapshot() const
+		{
+			ProtocolStatisticsSnapshot snapshot;
+			snapshot.protocol = m_protocolName;
+			snapshot.sendCount = m_sendCount.load(std::memory_order_relaxed);
+			snapshot.sentBytes = m_sentBytes.load(std::memory_order_relaxed);
+			snapshot.highWatermarkCount = m_highWatermarkCount.load(std::memory_order_relaxed);
+			snapshot.slowConsumerDrops = m_slowConsumerDrops.load(std::memory_order_relaxed);
+
+			for (size_t i = 0; i < MaxOpCodes; ++i)
+			{
+				const OpCodeCounters &counters = m_opCodes[i];
+
+				OpCodeStatisticsSnapshot opCode;
+				opCode.packetCount = counters.packetCount.load(std::memory_order_relaxed);
+				if (opCode.packetCount == 0)
+				{
+					continue;
+				}
+
+				std::array<uint64, LatencyBucketCount> buckets;
+				for (size_t b = 0; b < LatencyBucketCount; ++b)
+				{
+					buckets[b] = counters.latencyBuckets[b].load(std::memory_order_relaxed);
+				}
+
+				opCode.opCode = static_cast<uint16>(i);
+				opCode.byteCount = counters.byteCount.load(std::memory_order_relaxed);
+				opCode.averageNs = counters.totalNs.load(std::memory_order_relaxed) / opCode.packetCount;
+				opCode.p50Ns = getPercentile(buckets, 0.5);
+				opCode.p99Ns = getPercentile(buckets, 0.99);
+				opCode.maxNs = counters.maxNs.load(std::memory_order_relaxed);
+				snapshot.opCodes.push_back(opCode);
+			}
+
+			return snapshot;
+		}
+		/// Resets all counters to zero.
+		void reset()
+		{
+			m_sendCount = 0;
+			m_sentBytes = 0;
+			m_highWatermarkCount = 0;
+			m_slowConsumerDrops = 0;
+
+			for (auto &counters : m_opCodes)
+			{
+				counters.packetCount = 0;
+				counters.byteCount = 0;
+				counters.totalNs = 0;
+				counters.maxNs = 0;
+
+				for (auto &bucket : counters.latencyBuckets)
+				{
+					bucket = 0;
+				}
+			}
+		}
+
+	private:
+
+		struct OpCodeCounters
+		{
+			std::atomic<uint64> packetCount;
+			std::atomic<uint64> byteCount;
+			std::atomic<uint64> totalNs;
+			std::atomic<uint64> maxNs;
+			std::array<std::atomic<uint64>, LatencyBucketCount> latencyBuckets;
+		};
+
+		static size_t getLatencyBucket(uint64 ns)
+		{
+			size_t bucket = 0;
+			while (ns > 1 && bucket < LatencyBucketCount - 1)
+			{
+				ns >>= 1;
+				++bucket;
+			}
+
+			return bucket;
+		}
+
+		/// Approximates a percentile by the upper bound of the bucket which contains it.
+		static uint64 getPercentile(const std::array<uint64, LatencyBucketCount> &buckets, double percentile)
+		{
+			uint64 total = 0;
+			for (const uint64 count : buckets)
+			{
+				total += count;
+			}
+
+			const uint64 rank = static_cast<uint64>(static_cast<double>(total) * percentile);
+
+			uint64 accumulated = 0;
+			for (size_t b = 0; b < LatencyBucketCount; ++b)
+			{
+				accumulated += buckets[b];
+				if (accumulated > rank)
+				{
+					return (static_cast<uint64>(1) << (b + 1)) - 1;
+				}
+			}
+
+			return (static_cast<uint64>(1) << LatencyBucketCount) - 1;
+		}
+
+		static std::atomic<bool> &getEnabledFlag()
+		{
+			static std::atomic<bool> enabled{ false };
+			return enabled;
+		}
+
+		static std::vector<PacketStatistics*> &getRegistry()
+		{
+			static std::vector<PacketStatistics*> registry;
+			return registry;
+		}
+
+		static std::mutex &getRegistryMutex()
+		{
+			static std::mutex mutex;
+			return mutex;
+		}
+
+	private:
+
+		String m_protocolName;
+		std::atomic<uint64> m_sendCount;
+		std::atomic<uint64> m_sentBytes;
+		std::atomic<uint64> m_highWatermarkCount;
+		std::atomic<uint64> m_slowConsumerDrops;
+		std::array<OpCodeCounters, MaxOpCodes> m_opCodes;
+	};
+
+
+	/// Periodically writes the packet statistics of all protocols to the log and resets them.
+	class PacketStatisticsReporter final
+	{
+	private:
+
+		PacketStatisticsReporter(const PacketStatisticsReporter &Other) = delete;
+		PacketStatisticsReporter &operator=(const PacketStatisticsReporter &Other) = delete;
+
+	public:
+
+		/// Enables packet statistics and starts reporting them.
+		/// @param ioService The io service which executes the report timer.
+		/// @param interval Time between two reports.
+		explicit PacketStatisticsReporter(asio::io_service &ioService, std::chrono::seconds interval)
+			: m_timer(std::make_shared<asio::steady_timer>(ioService))
+			, m_interval(interval)
+		{
+			PacketStatistics::setEnabled(true);
+			scheduleReport(m_timer, m_interval);
+		}
+
+		~PacketStatisticsReporter()
+		{
+			m_timer->cancel();
+		}
+
+	private:
+
+		static void scheduleReport(std::shared_ptr<asio::steady_timer> timer, std::chrono::seconds interval)
+		{
+			timer->expires_after(interval);
+			timer->async_wait([timer, interval](const asio::error_code &error)
+			{
+				if (error)
+				{
+					return;
+				}
+
+				PacketStatistics::logSummary(true);
+				scheduleReport(timer, interval);
+			});
+		}
+
+	private:
+
+		std::shared_ptr<asio::steady_timer> m_timer;
+		std::chrono::seconds m_interval;
+	};
+}
@@ -0,0 +1,172 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+
+#include <algorithm>
+#include <memory>
+#include <cstring>
+#include <cassert>
+
+namespace mmo
+{
+	/// Linear receive buffer used by connections to read incoming data. The socket reads directly
+	/// into the spare capacity at the end of the buffer, and parsed packets are consumed in place
+	/// by advancing a read offset. Unparsed data is only moved to the front of the buffer when the
+	/// remaining tail space is too small for the next read.
+	class ReceiveBuffer final
+	{
+	private:
+
+		ReceiveBuffer(const ReceiveBuffer &Other) = delete;
+		ReceiveBuffer &operator=(const ReceiveBuffer &Other) = delete;
+
+	public:
+
+		/// Number of bytes requested per socket read by default.
+		static constexpr size_t DefaultReadSize = 4096;
+		/// Upper limit for the read size in case of bulk traffic.
+		static constexpr size_t DefaultMaxReadSize = 64 * 1024;
+
+	public:
+
+		/// Initializes an empty receive buffer.
+		/// @param initialReadSize Number of bytes that are requested per read initially.
+		/// @param maxReadSize Maximum number of bytes that are requested per read. The read size
+		///        grows up to this value while reads keep filling the whole prepared area.
+		explicit ReceiveBuffer(size_t initialReadSize = DefaultReadSize, size_t maxReadSize = DefaultMaxReadSize)
+			: m_capacity(0)
+			, m_readPos(0)
+			, m_writePos(0)
+			, m_initialReadSize(initialReadSize)
+			, m_maxReadSize(std::max(initialReadSize, maxReadSize))
+			, m_readSize(initialReadSize)
+		{
+			assert(m_initialReadSize > 0);
+		}
+
+	public:
+		/// Makes sure that there are at least getReadSize() bytes of free space at the end of the
+		/// buffer and returns a pointer to the start of that free space. Must not be called while
+		/// a previously prepared area is still being written to.
+		char *prepare()
+		{
+			// Everything has been consumed, so we can start at the beginning again without moving anything
+			if (m_readPos == m_writePos)
+			{
+				m_readPos = m_writePos = 0;
+
+				// Release memory that was only needed for a burst of bulk traffic
+				if (m_readSize == m_initialReadSize && m_capacity > m_initialReadSize * 4)
+				{
+					m_storage.reset();
+					m_capacity = 0;
+				}
+			}
+
+			if (m_capacity - m_writePos < m_readSize)
+			{
+				const size_t pending = size();
+				if (m_readPos > 0 && m_capacity - pending >= m_readSize)
+				{
+					// Compact: Move the unparsed tail to the front of the buffer
+					std::memmove(m_storage.get(), m_storage.get() + m_readPos, pending);
+				}
+				else
+				{
+					// Grow the buffer since compacting would not free enough space
+					const size_t newCapacity = std::max(m_capacity * 2, pending + m_readSize);
+					std::unique_ptr<char[]> newStorage{ new char[newCapacity] };
+					if (pending > 0)
+					{
+						std::memcpy(newStorage.get(), m_storage.get() + m_readPos, pending);
+					}
+
+					m_storage = std::move(newStorage);
+					m_capacity = newCapacity;
+				}
+
+				m_readPos = 0;
+				m_writePos = pending;
+			}
+
+			return m_storage.get() + m_writePos;
+		}
+		/// Gets the number of bytes that can be written to the area returned by prepare().
+		size_t getWritableSize() const
+		{
+			return m_capacity - m_writePos;
+		}
+		/// Gets the number of bytes that should be requested by the next socket read.
+		size_t getReadSize() const
+		{
+			return m_readSize;
+		}
+		/// Marks a number of bytes in the prepared area as written, making them readable.
+		/// @param written Number of bytes that have been written to the prepared area.
+		void commit(size_t written)
+		{
+			assert(written <= getWritableSize());
+			m_writePos += written;
+
+			// Adapt the read size: Reads which fill the whole request hint at bulk traffic, while
+			// small reads let the read size decay back to the initial value
+			if (written >= m_readSize)
+			{
+				m_readSize = std::min(m_readSize * 2, m_maxReadSize);
+			}
+			else if (written < m_readSize / 4)
+			{
+				m_readSize = std::max(m_readSize / 2, m_initialReadSize);
+			}
+		}
+		/// Gets a pointer to the first readable (not yet consumed) byte.
+		const char *data() const
+		{
+			return m_storage.get() + m_readPos;
+		}
+		/// Gets a pointer to the first readable (not yet consumed) byte.
+		char *data()
+		{
+			return m_storage.get() + m_readPos;
+		}
+		/// Gets the number of readable bytes.
+		size_t size() const
+		{
+			return m_writePos - m_readPos;
+		}
+		/// Determines whether there are any readable bytes.
+		bool empty() const
+		{
+			return m_writePos == m_readPos;
+		}
+		/// Gets the number of bytes allocated by this buffer.
+		size_t capacity() const
+		{
+			return m_capacity;
+		}
+		/// Marks a number of readable bytes as consumed. This does not move any memory.
+		/// @param consumed Number of bytes at the front of the readable area to consume.
+		void consume(size_t consumed)
+		{
+			assert(consumed <= size());
+			m_readPos += consumed;
+		}
+		/// Discards all readable data.
+		void clear()
+		{
+			m_readPos = m_writePos = 0;
+		}
+
+	private:
+
+		std::unique_ptr<char[]> m_storage;
+		size_t m_capacity;
+		size_t m_readPos;
+		size_t m_writePos;
+		size_t m_initialReadSize;
+		size_t m_maxReadSize;
+		size_t m_readSize;
+	};
+}
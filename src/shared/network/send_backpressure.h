@@ -0,0 +1,160 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+
+namespace mmo
+{
+	/// Limits for the amount of outgoing data which may be queued on a single connection.
+	struct SendWatermarks
+	{
+		/// Queued bytes at which the connection is considered congested. 0 disables all limits.
+		size_t high;
+		/// Queued bytes at which a congested connection is considered drained again.
+		size_t low;
+		/// Queued bytes at which the connection is dropped immediately. 0 means no hard limit.
+		size_t limit;
+		/// If true, incoming packets of a congested connection are not parsed and no more data is
+		/// received until it has been drained, so that a client can not make the server produce
+		/// more data than it reads.
+		bool pauseParsing;
+		/// Time after which a connection which is still congested is dropped. 0 means never.
+		std::chrono::milliseconds slowConsumerTimeout;
+
+		SendWatermarks()
+			: high(0)
+			, low(0)
+			, limit(0)
+			, pauseParsing(false)
+			, slowConsumerTimeout(0)
+		{
+		}
+
+		explicit SendWatermarks(size_t high_, size_t low_, size_t limit_, bool pauseParsing_, std::chrono::milliseconds slowConsumerTimeout_)
+			: high(high_)
+			, low(low_)
+			, limit(limit_)
+			, pauseParsing(pauseParsing_)
+			, slowConsumerTimeout(slowConsumerTimeout_)
+		{
+			assert(low <= high);
+			assert(limit == 0 || limit >= high);
+		}
+	};
+
+
+	/// Tracks the amount of queued outgoing data of a connection against its watermarks.
+	/// This class is not thread safe: It has to be used on the strand of its connection.
+	class SendBackpressure final
+	{
+	public:
+
+		/// Enumerates watermark transitions.
+		enum class Event
+		{
+			/// Nothing changed.
+			None,
+			/// The queued size reached the high watermark.
+			HighWatermarkReached,
+			/// The queued size dropped to the low watermark after the high watermark was reached.
+			LowWatermarkReached,
+			/// The queued size exceeds the hard limit.
+			LimitExceeded
+		};
+
+	public:
+
+		SendBackpressure()
+			: m_isCongested(false)
+			, m_congestedSinceNs(0)
+			, m_peakSize(0)
+		{
+		}
+
+	public:
+		/// Replaces the watermarks.
+		void setWatermarks(const SendWatermarks &watermarks)
+		{
+			m_watermarks = watermarks;
+		}
+		/// Gets the current watermarks.
+		const SendWatermarks &getWatermarks() const
+		{
+			return m_watermarks;
+		}
+		/// Determines whether watermarks are checked at all.
+		bool isEnabled() const
+		{
+			return m_watermarks.high > 0;
+		}
+		/// Determines whether the high watermark has been reached and the low watermark not yet.
+		bool isCongested() const
+		{
+			return m_isCongested;
+		}
+		/// Determines whether parsing of incoming packets is paused due to congestion.
+		bool isParsingPaused() const
+		{
+			return m_isCongested && m_watermarks.pauseParsing;
+		}
+		/// Determines whether the connection has been congested for longer than the slow consumer timeout.
+		/// @param nowNs The current monotonic time in nanoseconds.
+		bool isSlowConsumer(uint64 nowNs) const
+		{
+			const uint64 timeoutNs = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(m_watermarks.slowConsumerTimeout).count());
+			return m_isCongested &&
+				timeoutNs > 0 &&
+				nowNs - m_congestedSinceNs >= timeoutNs;
+		}
+		/// Gets the maximum number of bytes which have been queued at once.
+		size_t getPeakSize() const
+		{
+			return m_peakSize;
+		}
+		/// Updates the state after the number of queued bytes changed.
+		/// @param queuedSize Number of bytes which have not been sent yet.
+		/// @param nowNs The current monotonic time in nanoseconds.
+		/// @returns The watermark transition which occurred, if any.
+		Event update(size_t queuedSize, uint64 nowNs)
+		{
+			m_peakSize = std::max(m_peakSize, queuedSize);
+
+			if (!isEnabled())
+			{
+				return Event::None;
+			}
+
+			if (m_watermarks.limit > 0 && queuedSize > m_watermarks.limit)
+			{
+				return Event::LimitExceeded;
+			}
+
+			if (!m_isCongested && queuedSize >= m_watermarks.high)
+			{
+				m_isCongested = true;
+				m_congestedSinceNs = nowNs;
+				return Event::HighWatermarkReached;
+			}
+
+			if (m_isCongested && queuedSize <= m_watermarks.low)
+			{
+				m_isCongested = false;
+				return Event::LowWatermarkReached;
+			}
+
+			return Event::None;
+		}
+
+	private:
+
+		SendWatermarks m_watermarks;
+		bool m_isCongested;
+		uint64 m_congestedSinceNs;
+		size_t m_peakSize;
+	};
+}
@@ -0,0 +1,121 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+
+#include <chrono>
+
+namespace mmo
+{
+	/// Decides when a corked connection flushes its send buffer. While corking is enabled, packets
+	/// are not flushed one by one but collected until the end of the current io batch, so that all
+	/// packets written by one or more handlers are sent with a single write. A latency cap forces
+	/// an immediate flush once the oldest unflushed packet has been waiting for too long, which
+	/// bounds the delay if a single handler keeps writing packets for a long time.
+	/// This class is not thread safe: It has to be used on the strand of its connection.
+	class SendCork final
+	{
+	public:
+
+		/// Enumerates what a connection has to do after a packet has been written.
+		enum class Action
+		{
+			/// Flush the send buffer right away.
+			FlushNow,
+			/// Schedule a deferred flush at the end of the current io batch.
+			ScheduleFlush,
+			/// Nothing, a deferred flush has already been scheduled.
+			None
+		};
+
+	public:
+
+		SendCork()
+			: m_isEnabled(false)
+			, m_maxLatencyNs(0)
+			, m_isPending(false)
+			, m_isScheduled(false)
+			, m_pendingSinceNs(0)
+		{
+		}
+
+	public:
+		/// Enables corking.
+		/// @param maxLatency Maximum time a written packet may wait for its flush. Zero means that
+		///        packets are only flushed at the end of the io batch.
+		void enable(std::chrono::nanoseconds maxLatency)
+		{
+			m_isEnabled = true;
+			m_maxLatencyNs = static_cast<uint64>(maxLatency.count());
+		}
+		/// Disables corking. The connection should flush afterwards to send pending packets.
+		void disable()
+		{
+			m_isEnabled = false;
+		}
+		/// Determines whether corking is enabled.
+		bool isEnabled() const
+		{
+			return m_isEnabled;
+		}
+		/// Gets the latency cap.
+		std::chrono::nanoseconds getMaxLatency() const
+		{
+			return std::chrono::nanoseconds(m_maxLatencyNs);
+		}
+		/// Determines whether there are written packets which have not been flushed yet.
+		bool isPending() const
+		{
+			return m_isPending;
+		}
+		/// Called after a packet has been written to the send buffer.
+		/// @param nowNs The current monotonic time in nanoseconds, only used if corking is enabled.
+		/// @returns What the connection has to do.
+		Action packetWritten(uint64 nowNs)
+		{
+			if (!m_isEnabled)
+			{
+				return Action::FlushNow;
+			}
+
+			if (!m_isPending)
+			{
+				m_isPending = true;
+				m_pendingSinceNs = nowNs;
+			}
+			else if (m_maxLatencyNs > 0 && nowNs - m_pendingSinceNs >= m_maxLatencyNs)
+			{
+				return Action::FlushNow;
+			}
+
+			if (m_isScheduled)
+			{
+				return Action::None;
+			}
+
+			m_isScheduled = true;
+			return Action::ScheduleFlush;
+		}
+		/// Called when the scheduled flush is executed.
+		/// @returns true if there still are unflushed packets, false if they have been flushed already.
+		bool scheduledFlushExecuted()
+		{
+			m_isScheduled = false;
+			return m_isPending;
+		}
+		/// Called whenever the send buffer has been flushed.
+		void flushed()
+		{
+			m_isPending = false;
+		}
+
+	private:
+
+		bool m_isEnabled;
+		uint64 m_maxLatencyNs;
+		bool m_isPending;
+		bool m_isScheduled;
+		uint64 m_pendingSinceNs;
+	};
+}
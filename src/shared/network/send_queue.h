@@ -0,0 +1,170 @@
+// Copyright (C) 2019, Robin Klimonow. All rights reserved.
+
+#pragma once
+
+#include "base/typedefs.h"
+#include "buffer.h"
+
+#include "asio/buffer.hpp"
+
+#include <memory>
+#include <vector>
+#include <cassert>
+
+namespace mmo
+{
+	/// Immutable, reference counted buffer which can be queued on multiple connections at once
+	/// without being copied.
+	typedef std::shared_ptr<const Buffer> SharedBuffer;
+
+	/// Queue of outgoing buffer segments of a connection. Segments are either buffers owned by the
+	/// queue (the connection's send buffer is moved in, not copied) or shared immutable buffers.
+	/// All pending segments are written at once using a single vectored write.
+	class SendQueue final
+	{
+	private:
+
+		SendQueue(const SendQueue &Other) = delete;
+		SendQueue &operator=(const SendQueue &Other) = delete;
+
+	public:
+
+		/// Maximum number of emptied owned buffers which are kept for reuse.
+		static constexpr size_t MaxSpareBuffers = 4;
+
+		/// Buffer sequence type which is passed to asio::async_write.
+		typedef std::vector<asio::const_buffer> BufferSequence;
+
+	public:
+
+		SendQueue()
+			: m_pendingSize(0)
+			, m_sendingSize(0)
+		{
+		}
+
+	public:
+		/// Moves the contents of a buffer into the queue. The buffer is replaced by an empty
+		/// buffer which, if possible, has been used before and thus already has some capacity.
+		/// @param buffer The buffer whose contents to enqueue. Will be empty afterwards.
+		void push(Buffer &buffer)
+		{
+			if (buffer.empty())
+			{
+				return;
+			}
+
+			m_pendingSize += buffer.size();
+			m_pending.emplace_back();
+			m_pending.back().owned.swap(buffer);
+
+			if (!m_spare.empty())
+			{
+				buffer.swap(m_spare.back());
+				m_spare.pop_back();
+			}
+
+			assert(buffer.empty());
+		}
+		/// Enqueues a shared buffer. The buffer is referenced until it has been sent.
+		void push(SharedBuffer buffer)
+		{
+			if (!buffer || buffer->empty())
+			{
+				return;
+			}
+
+			m_pendingSize += buffer->size();
+			m_pending.emplace_back();
+			m_pending.back().shared = std::move(buffer);
+		}
+		/// Determines whether there are segments waiting to be sent.
+		bool hasPending() const
+		{
+			return !m_pending.empty();
+		}
+		/// Determines whether a write is currently in progress.
+		bool isSending() const
+		{
+			return !m_sending.empty();
+		}
+		/// Moves all pending segments into the in-flight batch and returns the buffer sequence
+		/// to write. The sequence stays valid until sendCompleted() has been called.
+		const BufferSequence &beginSend()
+		{
+			assert(!isSending());
+			assert(hasPending());
+
+			m_sending.swap(m_pending);
+			m_pendingSize = 0;
+
+			m_buffers.clear();
+			m_sendingSize = 0;
+			for (const auto &segment : m_sending)
+			{
+				const Buffer &data = segment.get();
+				m_buffers.emplace_back(data.data(), data.size());
+				m_sendingSize += data.size();
+			}
+
+			return m_buffers;
+		}
+		/// Gets the total number of bytes of the in-flight batch.
+		size_t getSendingSize() const
+		{
+			return m_sendingSize;
+		}
+		/// Gets the total number of bytes of all pending and in-flight segments.
+		size_t getQueuedSize() const
+		{
+			return m_pendingSize + m_sendingSize;
+		}
+		/// Releases the in-flight batch after it has been written. Owned buffers are kept for
+		/// reuse so that the send buffer does not need to reallocate on every flush.
+		void sendCompleted()
+		{
+			for (auto &segment : m_sending)
+			{
+				if (!segment.shared && m_spare.size() < MaxSpareBuffers)
+				{
+					segment.owned.clear();
+					m_spare.emplace_back(std::move(segment.owned));
+				}
+			}
+
+			m_sending.clear();
+			m_buffers.clear();
+			m_sendingSize = 0;
+		}
+		/// Discards all pending and in-flight segments.
+		void clear()
+		{
+			m_pending.clear();
+			m_sending.clear();
+			m_buffers.clear();
+			m_pendingSize = 0;
+			m_sendingSize = 0;
+		}
+
+	private:
+
+		/// A single segment of outgoing data.
+		struct Segment
+		{
+			Buffer owned;
+			SharedBuffer shared;
+
+			const Buffer &get() const
+			{
+				return shared ? *shared : owned;
+			}
+		};
+
+		std::vector<Segment> m_pending;
+		std::vector<Segment> m_sending;
+		std::vector<Buffer> m_spare;
+		BufferSequence m_buffers;
+		size_t m_pendingSize;
+		size_t m_sendingSize;
+	};
+}
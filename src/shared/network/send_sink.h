@@ -24,7 +24,7 @@ namespace mmo
 
 		virtual void flush()
 		{
-			m_connection.flush();
+			m_connection.requestFlush();
 		}
 
 	private:
@@ -7,9 +7,11 @@
 
 #include "asio/ip/tcp.hpp"
 
+#include <atomic>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <vector>
 #include <cassert>
 
 namespace mmo
@@ -35,6 +37,10 @@ namespace mmo
 		typedef asio::ip::tcp::acceptor AcceptorType;
 		typedef signal<void(const std::shared_ptr<Connection> &)> ConnectionSignal;
 		typedef std::function<std::shared_ptr<Connection>(asio::io_service &)> ConnectionFactory;
+		typedef std::vector<asio::io_service*> ServiceList;
+
+		/// Default number of pending connections the kernel queues per acceptor.
+		static constexpr int DefaultBacklog = 16;
 
 	public:
 
@@ -43,23 +49,49 @@ namespace mmo
 		virtual ~Server() { }
 
 		/// Initializes a new server instance and binds it to a specific port.
-		Server(asio::io_service &IOService, uint16 Port, ConnectionFactory CreateConnection)
-			: m_ioService(IOService)
-			, m_createConn(std::move(CreateConnection))
-			, m_state(new State(std::unique_ptr<AcceptorType>(new AcceptorType(IOService))))
+		Server(asio::io_service &IOService, uint16 Port, ConnectionFactory CreateConnection, int Backlog = DefaultBacklog)
+			: Server(ServiceList{ &IOService }, Port, std::move(CreateConnection), Backlog)
+		{
+		}
+		/// Initializes a new server instance which accepts connections on multiple io services and
+		/// binds it to a specific port. If the platform supports SO_REUSEPORT, every io service gets
+		/// its own acceptor and the kernel balances new connections between them. Otherwise, a single
+		/// acceptor is used and accepted connections are distributed between the io services.
+		Server(const ServiceList &IOServices, uint16 Port, ConnectionFactory CreateConnection, int Backlog = DefaultBacklog)
+			: m_createConn(std::move(CreateConnection))
+			, m_state(new State(IOServices))
 		{
 			assert(m_createConn);
+			assert(!IOServices.empty());
+
+#if defined(SO_REUSEPORT)
+			const size_t acceptorCount = IOServices.size();
+#else
+			const size_t acceptorCount = 1;
+#endif
 
 			try
 			{
-				m_state->Acceptor->open(asio::ip::tcp::v4());
+				for (size_t i = 0; i < acceptorCount; ++i)
+				{
+					auto acceptor = std::make_unique<AcceptorType>(*IOServices[i]);
+					acceptor->open(asio::ip::tcp::v4());
 #if !defined(WIN32) && !defined(_WIN32)
-				m_state->Acceptor->set_option(typename AcceptorType::reuse_address(true));
+					acceptor->set_option(typename AcceptorType::reuse_address(true));
 #endif
-				m_state->Acceptor->bind(asio::ip::tcp::endpoint(
-				                           asio::ip::tcp::v4(),
-				                           static_cast<uint16>(Port)));
-				m_state->Acceptor->listen(16);
+#if defined(SO_REUSEPORT)
+					if (acceptorCount > 1)
+					{
+						acceptor->set_option(ReusePort(true));
+					}
+#endif
+					acceptor->bind(asio::ip::tcp::endpoint(
+					                   asio::ip::tcp::v4(),
+					                   static_cast<uint16>(Port)));
+					acceptor->listen(Backlog);
+
+					m_state->Acceptors.emplace_back(std::move(acceptor));
+				}
 			}
 			catch (const asio::system_error &)
 			{
@@ -83,40 +115,67 @@ namespace mmo
 			std::swap(m_createConn, Other.m_createConn);
 			std::swap(m_state, Other.m_state);
 		}
-		/// Gets the signal which is fired if a new connection was accepted.
+		/// Gets the signal which is fired if a new connection was accepted. If the server uses
+		/// multiple io services, this is fired by the threads running these io services.
 		ConnectionSignal &connected()
 		{
 			return m_state->Connected;
 		}
+		/// Gets the number of acceptors listening for incoming connections.
+		size_t getAcceptorCount() const
+		{
+			return m_state ? m_state->Acceptors.size() : 0;
+		}
 		/// Starts waiting for incoming connections to accept.
 		void startAccept()
 		{
 			assert(m_state);
-			const std::shared_ptr<Connection> Conn = m_createConn(m_ioService);
 
-			m_state->Acceptor->async_accept(
-			    Conn->getSocket().lowest_layer(),
-			    std::bind(&Server<C>::Accepted, this, Conn, std::placeholders::_1));
+			for (size_t i = 0; i < m_state->Acceptors.size(); ++i)
+			{
+				startAccept(i);
+			}
 		}
 
 	private:
 
+#if defined(SO_REUSEPORT)
+		typedef asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT> ReusePort;
+#endif
+
 		struct State
 		{
-			std::unique_ptr<AcceptorType> Acceptor;
+			ServiceList Services;
+			std::vector<std::unique_ptr<AcceptorType>> Acceptors;
+			std::atomic<size_t> NextService;
 			ConnectionSignal Connected;
 
-			explicit State(std::unique_ptr<AcceptorType> Acceptor_)
-				: Acceptor(std::move(Acceptor_))
+			explicit State(ServiceList Services_)
+				: Services(std::move(Services_))
+				, NextService(0)
 			{
 			}
 		};
 
-		asio::io_service& m_ioService;
 		ConnectionFactory m_createConn;
 		std::unique_ptr<State> m_state;
 
-		void Accepted(std::shared_ptr<Connection> Conn, const asio::system_error &Error)
+		void startAccept(size_t AcceptorIndex)
+		{
+			// With one acceptor per io service, connections stay on the io service of their acceptor.
+			// A single shared acceptor distributes connections round robin instead.
+			const size_t serviceIndex = (m_state->Acceptors.size() == m_state->Services.size())
+				? AcceptorIndex
+				: (m_state->NextService++ % m_state->Services.size());
+
+			const std::shared_ptr<Connection> Conn = m_createConn(*m_state->Services[serviceIndex]);
+
+			m_state->Acceptors[AcceptorIndex]->async_accept(
+			    Conn->getSocket().lowest_layer(),
+			    std::bind(&Server<C>::Accepted, this, AcceptorIndex, Conn, std::placeholders::_1));
+		}
+
+		void Accepted(size_t AcceptorIndex, std::shared_ptr<Connection> Conn, const asio::system_error &Error)
 		{
 			assert(Conn);
 			assert(m_state);
@@ -128,7 +187,7 @@ namespace mmo
 			}
 
 			m_state->Connected(Conn);
-			startAccept();
+			startAccept(AcceptorIndex);
 		}
 	};
 }
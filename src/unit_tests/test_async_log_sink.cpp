@@ -0,0 +1,105 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "log/async_log_sink.h"
+#include "log/default_log_levels.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mmo;
+
+
+// This test ensures that all entries of all producers are written exactly once and in per thread order.
+TEST_CASE("AsyncLogSinkWritesAllEntries", "[log]")
+{
+	constexpr size_t ThreadCount = 4;
+	constexpr size_t EntriesPerThread = 5000;
+
+	std::map<size_t, std::vector<size_t>> written;
+	size_t flushCount = 0;
+
+	{
+		// Small queues force producers to wait for the writer
+		AsyncLogSink sink{ [&](const LogEntry &entry)
+		{
+			const size_t separator = entry.message.find(':');
+			written[std::stoul(entry.message.substr(0, separator))].push_back(std::stoul(entry.message.substr(separator + 1)));
+		}, [&]() { ++flushCount; }, 16 };
+
+		std::vector<std::thread> producers;
+		for (size_t thread = 0; thread < ThreadCount; ++thread)
+		{
+			producers.emplace_back([&sink, thread]()
+			{
+				for (size_t i = 0; i < EntriesPerThread; ++i)
+				{
+					sink.push(LogEntry(InfoLevel, std::to_string(thread) + ":" + std::to_string(i), std::chrono::system_clock::now()));
+				}
+			});
+		}
+
+		for (auto &producer : producers)
+		{
+			producer.join();
+		}
+
+		sink.flush();
+
+		const AsyncLogSinkStats stats = sink.getStats();
+		CHECK(stats.enqueuedEntries == ThreadCount * EntriesPerThread);
+		CHECK(stats.writtenEntries == ThreadCount * EntriesPerThread);
+		CHECK(stats.batches == flushCount);
+	}
+
+	REQUIRE(written.size() == ThreadCount);
+	for (const auto &thread : written)
+	{
+		REQUIRE(thread.second.size() == EntriesPerThread);
+		for (size_t i = 0; i < EntriesPerThread; ++i)
+		{
+			CHECK(thread.second[i] == i);
+		}
+	}
+	CHECK(flushCount > 0);
+}
+
+// This test ensures that entries which are still queued are written when the sink is destroyed.
+TEST_CASE("AsyncLogSinkDrainsOnDestruction", "[log]")
+{
+	std::vector<std::string> written;
+	{
+		AsyncLogSink sink{ [&](const LogEntry &entry) { written.push_back(entry.message); } };
+		for (size_t i = 0; i < 100; ++i)
+		{
+			sink.push(LogEntry(WarningLevel, std::to_string(i), std::chrono::system_clock::now()));
+		}
+	}
+
+	REQUIRE(written.size() == 100);
+	CHECK(written.front() == "0");
+	CHECK(written.back() == "99");
+}
+
+// This test ensures that log statements below the compile time minimum level are not executed.
+TEST_CASE("LogCompileTimeLevelFilter", "[log]")
+{
+	size_t received = 0;
+	scoped_connection connection{ g_DefaultLog.signal().connect([&received](const LogEntry &) { ++received; }) };
+
+	size_t evaluated = 0;
+	DLOG("debug " << ++evaluated);
+	ELOG("error " << ++evaluated);
+
+#if MMO_LOG_MIN_LEVEL <= MMO_LOG_LEVEL_DEBUG
+	CHECK(received == 2);
+	CHECK(evaluated == 2);
+#else
+	CHECK(received == 1);
+	CHECK(evaluated == 1);
+#endif
+}
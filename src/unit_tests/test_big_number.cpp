@@ -0,0 +1,133 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "base/big_number.h"
+#include "base/constants.h"
+#include "base/srp6.h"
+
+using namespace mmo;
+
+
+// This test ensures that the montgomery and fixed base exponentiations match the generic one.
+TEST_CASE("BigNumberSrp6ModExp", "[big_number]")
+{
+	const BigNumber &N = constants::srp::N;
+	const BigNumber &g = constants::srp::g;
+
+	CHECK(srp6::ModExpG(BigNumber(0u)) == BigNumber(1u));
+	CHECK(srp6::ModExpG(BigNumber(1u)) == g);
+	CHECK(srp6::ModExpG(BigNumber(16u)) == g.modExp(BigNumber(16u), N));
+
+	for (const int bits : { 8, 152, 160, 255, 256, 300, 512 })
+	{
+		for (int i = 0; i < 10; ++i)
+		{
+			BigNumber exponent;
+			exponent.setRand(bits);
+
+			CHECK(srp6::ModExpG(exponent) == g.modExp(exponent, N));
+
+			BigNumber base;
+			base.setRand(256);
+			CHECK(srp6::ModExpN(base, exponent) == base.modExp(exponent, N));
+		}
+	}
+}
+
+// This test ensures that a fixed base exponentiation works with other window sizes and bases larger than the modulus.
+TEST_CASE("BigNumberFixedBaseWindows", "[big_number]")
+{
+	const MontgomeryModulus modulus{ BigNumber(1000003u) };
+	const BigNumber base{ 123456789u };
+
+	for (const int windowBits : { 1, 3, 5, 8 })
+	{
+		const FixedBaseExponentiation exponentiation{ base, modulus, 64, windowBits };
+		for (const uint32 exponent : { 0u, 1u, 2u, 255u, 65537u, 4294967295u })
+		{
+			CHECK(exponentiation.modExp(BigNumber(exponent)) == base.modExp(BigNumber(exponent), modulus.getModulus()));
+		}
+	}
+}
+
+// This test ensures that padded byte arrays keep the value and only add zeros as most significant bytes.
+TEST_CASE("BigNumberByteArrayPadding", "[big_number]")
+{
+	const BigNumber value{ 0x0102u };
+	CHECK(value.asByteArray() == std::vector<uint8>{ 0x02, 0x01 });
+	CHECK(value.asByteArray(4) == std::vector<uint8>{ 0x02, 0x01, 0x00, 0x00 });
+
+	const auto padded = value.asByteArray(32);
+	CHECK(BigNumber(padded.data(), padded.size()) == value);
+}
+
+// This test ensures that client and server calculate the same proofs and session key, including values
+// with leading zero bytes, and that a wrong password is detected.
+TEST_CASE("Srp6ClientServerHandshake", "[big_number]")
+{
+	const String userName = "TEST";
+	const String authString = userName + ":" + userName;
+	const SHA1Hash authHash = sha1(authString.c_str(), authString.size());
+
+	for (int i = 0; i < 300; ++i)
+	{
+		BigNumber s;
+		s.setRand(32 * 8);
+		const BigNumber v = srp6::CalculateVerifier(s, authHash);
+
+		BigNumber b;
+		b.setRand(19 * 8);
+		const BigNumber B = ((v * 3) + srp6::ModExpG(b)) % constants::srp::N;
+
+		// Transfer B and A like the packets do
+		const auto B_ = B.asByteArray(32);
+		const srp6::ClientProof clientProof = srp6::CalculateClientProof(userName, authHash, s, BigNumber(B_.data(), B_.size()));
+		const auto A_ = clientProof.A.asByteArray(32);
+
+		const auto serverProof = srp6::CalculateServerProof(userName, s, v, b, B, BigNumber(A_.data(), A_.size()), clientProof.M1);
+		REQUIRE(serverProof);
+		CHECK(serverProof->sessionKey == clientProof.sessionKey);
+		CHECK(serverProof->M2 == clientProof.M2);
+
+		const String wrongAuthString = userName + ":WRONG";
+		const SHA1Hash wrongAuthHash = sha1(wrongAuthString.c_str(), wrongAuthString.size());
+		const srp6::ClientProof wrongProof = srp6::CalculateClientProof(userName, wrongAuthHash, s, B);
+		CHECK(!srp6::CalculateServerProof(userName, s, v, b, B, wrongProof.A, wrongProof.M1));
+	}
+}
+
+// This test ensures that a reconnect proof calculated by a client with the session key of its logon is
+// accepted, and that proofs with another key, nonce or account name are not.
+TEST_CASE("Srp6ReconnectProof", "[big_number]")
+{
+	const String userName = "TEST";
+	const String authString = userName + ":" + userName;
+	const SHA1Hash authHash = sha1(authString.c_str(), authString.size());
+
+	BigNumber s;
+	s.setRand(32 * 8);
+	const BigNumber v = srp6::CalculateVerifier(s, authHash);
+
+	BigNumber b;
+	b.setRand(19 * 8);
+	const BigNumber B = ((v * 3) + srp6::ModExpG(b)) % constants::srp::N;
+
+	const srp6::ClientProof clientProof = srp6::CalculateClientProof(userName, authHash, s, B);
+	const auto serverProof = srp6::CalculateServerProof(userName, s, v, b, B, clientProof.A, clientProof.M1);
+	REQUIRE(serverProof);
+
+	const srp6::ReconnectNonce serverNonce = srp6::GenerateReconnectNonce();
+	const srp6::ReconnectNonce clientNonce = srp6::GenerateReconnectNonce();
+	CHECK(serverNonce != clientNonce);
+
+	const std::vector<uint8> serverKey = serverProof->sessionKey.asByteArray();
+	const HMACHash proof = srp6::CalculateReconnectProof(userName, clientNonce, serverNonce, clientProof.sessionKey.asByteArray());
+	CHECK(srp6::VerifyReconnectProof(userName, clientNonce, serverNonce, serverKey, proof));
+
+	std::vector<uint8> wrongKey = serverKey;
+	wrongKey[0] ^= 1;
+	CHECK(!srp6::VerifyReconnectProof(userName, clientNonce, serverNonce, wrongKey, proof));
+	CHECK(!srp6::VerifyReconnectProof(userName, clientNonce, srp6::GenerateReconnectNonce(), serverKey, proof));
+	CHECK(!srp6::VerifyReconnectProof("OTHER", clientNonce, serverNonce, serverKey, proof));
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "base/clock.h"
+
+using namespace mmo;
+
+
+namespace
+{
+	/// Reads the monotonic clock repeatedly and checks that it never goes backwards.
+	void CheckMonotonic(size_t readCount)
+	{
+		uint64 previous = GetMonotonicTimeNs();
+		for (size_t i = 0; i < readCount; ++i)
+		{
+			const uint64 now = GetMonotonicTimeNs();
+			REQUIRE(now >= previous);
+			previous = now;
+		}
+	}
+}
+
+// This test ensures that the monotonic clock never goes backwards and that all of its units agree.
+TEST_CASE("MonotonicClockNeverGoesBackwards", "[clock]")
+{
+	CheckMonotonic(10000);
+
+	const GameTime asyncBefore = GetAsyncTimeMs();
+	const uint64 monotonicMs = GetMonotonicTimeMs();
+	const GameTime asyncAfter = GetAsyncTimeMs();
+	CHECK(asyncBefore <= static_cast<GameTime>(monotonicMs));
+	CHECK(static_cast<GameTime>(monotonicMs) <= asyncAfter);
+}
+
+// This test ensures that the cached tick time only changes when it is updated.
+TEST_CASE("TickTimeIsCached", "[clock]")
+{
+	UpdateTickTime();
+	const uint64 tickTime = GetTickTimeNs();
+
+	// Wait until the clock advanced past the cached time
+	while (GetMonotonicTimeNs() <= tickTime)
+	{
+	}
+	CHECK(GetTickTimeNs() == tickTime);
+
+	UpdateTickTime();
+	CHECK(GetTickTimeNs() > tickTime);
+}
+
+// This test ensures that the time stamp counter clock, if available, continues the operating system
+// clock without going backwards. The previous clock source is restored afterwards, as it is shared
+// by all tests.
+TEST_CASE("TscClockContinuesSystemClock", "[clock]")
+{
+	const bool wasEnabled = IsTscClockEnabled();
+
+	const uint64 before = GetMonotonicTimeNs();
+	if (!EnableTscClock())
+	{
+		CHECK(!IsTscClockEnabled());
+		return;
+	}
+
+	CHECK(IsTscClockEnabled());
+	CHECK(GetMonotonicTimeNs() >= before);
+	CheckMonotonic(10000);
+
+	// Enabling the clock again reuses its calibration, so counter timestamps stay ordered across the switch
+	const uint64 beforeSwitch = GetMonotonicTimeNs();
+	DisableTscClock();
+	CHECK(!IsTscClockEnabled());
+	CHECK(EnableTscClock());
+	CHECK(GetMonotonicTimeNs() >= beforeSwitch);
+
+	if (!wasEnabled)
+	{
+		DisableTscClock();
+		CHECK(!IsTscClockEnabled());
+	}
+}
@@ -3,9 +3,11 @@
 #include "catch.hpp"
 
 #include "base/big_number.h"
+#include "base/hmac.h"
 #include "game_protocol/game_crypt.h"
 
 #include <array>
+#include <sstream>
 
 using namespace mmo;
 
@@ -59,3 +61,21 @@ TEST_CASE("DecryptionCheck", "[crypt]")
 	const std::array<uint8, 6> expected{ 0x00, 0x10, 0xfe, 0xdd, 0xaa, 0xbe };
 	CHECK(header == expected);
 }
+
+// This test ensures that HMAC hashes with a custom key match the HMAC-SHA1 test vectors of RFC 2202, and that the
+// generator keeps its key after it has been finalized.
+TEST_CASE("HmacWithCustomKey", "[crypt]")
+{
+	const String key = "Jefe";
+	const String data = "what do ya want for nothing?";
+
+	HashGeneratorHmac generator{ reinterpret_cast<const unsigned char*>(key.data()), key.size() };
+	for (int i = 0; i < 2; ++i)
+	{
+		generator.Update(data.data(), data.size());
+
+		std::ostringstream hex;
+		HmacPrintHex(hex, generator.Finalize());
+		CHECK(hex.str() == "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79");
+	}
+}
@@ -0,0 +1,100 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "log/default_log_levels.h"
+#include "log/log_binary_stream.h"
+#include "log/log_format.h"
+
+#include <sstream>
+
+using namespace mmo;
+
+
+namespace
+{
+	enum class TestEnum : uint8
+	{
+		Value = 7
+	};
+}
+
+
+// This test ensures that structured entries render all supported argument types like the stream operators.
+TEST_CASE("LogFormatArguments", "[log]")
+{
+	const LogTime now = std::chrono::system_clock::now();
+	const String name = "Hans";
+
+	CHECK(makeLogEntry(InfoLevel, now, "Plain").getMessage() == "Plain");
+	CHECK(makeLogEntry(InfoLevel, now, "{} {} {} {}", -1234567, uint64(18446744073709551615ull), 2.5, 1.0f).getMessage() == "-1234567 18446744073709551615 2.5 1");
+	CHECK(makeLogEntry(InfoLevel, now, "{}/{}/{}", name, "literal", name.c_str()).getMessage() == "Hans/literal/Hans");
+	CHECK(makeLogEntry(InfoLevel, now, "{} {} {}", true, 'c', TestEnum::Value).getMessage() == "true c 7");
+	CHECK(makeLogEntry(InfoLevel, now, "Packet 0x{:x} from {}", uint16(0x1f), uint8(200)).getMessage() == "Packet 0x1f from 200");
+
+	// Missing arguments are marked, surplus arguments are ignored
+	CHECK(makeLogEntry(InfoLevel, now, "{} {}", 1).getMessage() == "1 {?}");
+	CHECK(makeLogEntry(InfoLevel, now, "{}", 1, 2).getMessage() == "1");
+}
+
+// This test ensures that text and structured entries survive a round trip through the binary format.
+TEST_CASE("LogBinaryStreamRoundTrip", "[log]")
+{
+	const LogTime start = std::chrono::system_clock::now();
+
+	std::vector<LogEntry> entries;
+	entries.push_back(LogEntry(InfoLevel, "Text entry", start));
+	entries.push_back(makeLogEntry(WarningLevel, start + std::chrono::microseconds(5), "Account {} failed {} times", String("test"), 3));
+	entries.push_back(makeLogEntry(ErrorLevel, start - std::chrono::seconds(2), "Error {:x}", 0xdead));
+	entries.push_back(makeLogEntry(WarningLevel, start + std::chrono::seconds(1), "Account {} failed {} times", String("other"), 12345678));
+
+	std::stringstream stream;
+	{
+		BinaryLogWriter writer{ stream };
+		for (const auto &entry : entries)
+		{
+			writer.write(entry);
+		}
+	}
+
+	BinaryLogReader reader{ stream };
+	REQUIRE(reader.isValid());
+
+	LogEntry decoded;
+	for (const auto &entry : entries)
+	{
+		REQUIRE(reader.read(decoded));
+		CHECK(decoded.level->name == entry.level->name);
+		CHECK(decoded.level->importance == entry.level->importance);
+		CHECK(decoded.getMessage() == entry.getMessage());
+		CHECK(std::chrono::duration_cast<std::chrono::nanoseconds>(decoded.time - entry.time).count() == 0);
+	}
+
+	CHECK(!reader.read(decoded));
+	CHECK(reader.isValid());
+}
+
+// This test ensures that a truncated log, as written by a crashed server, is read up to the last complete record.
+TEST_CASE("LogBinaryStreamTruncated", "[log]")
+{
+	const LogTime now = std::chrono::system_clock::now();
+
+	std::stringstream stream;
+	{
+		BinaryLogWriter writer{ stream };
+		writer.write(makeLogEntry(InfoLevel, now, "First {}", 1));
+		writer.write(makeLogEntry(InfoLevel, now, "Second {}", 2));
+	}
+
+	const String data = stream.str();
+	std::stringstream truncated{ data.substr(0, data.size() - 2) };
+
+	BinaryLogReader reader{ truncated };
+	LogEntry decoded;
+	REQUIRE(reader.read(decoded));
+	CHECK(decoded.getMessage() == "First 1");
+	CHECK(!reader.read(decoded));
+
+	std::stringstream garbage{ String("not a log file") };
+	CHECK(!BinaryLogReader{ garbage }.isValid());
+}
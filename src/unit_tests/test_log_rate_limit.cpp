@@ -0,0 +1,139 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "log/default_log_levels.h"
+#include "log/log_rate_limit.h"
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace mmo;
+
+
+// This test ensures that the limiter lets through the configured number of messages per window and
+// reports the suppressed ones with the first message of a later window.
+TEST_CASE("LogRateLimiterWindow", "[log]")
+{
+	LogRateLimiter limiter{ 3 };
+	const uint64 start = 5 * LogRateLimiter::WindowNs;
+
+	uint64 suppressed = 99;
+	for (uint64 i = 0; i < 3; ++i)
+	{
+		REQUIRE(limiter.tryAcquire(start + i, suppressed));
+		CHECK(suppressed == 0);
+	}
+
+	for (uint64 i = 0; i < 10; ++i)
+	{
+		CHECK(!limiter.tryAcquire(start + 100 + i, suppressed));
+	}
+	CHECK(limiter.getSuppressed() == 10);
+
+	// Still the same window
+	CHECK(!limiter.tryAcquire(start + LogRateLimiter::WindowNs - 1, suppressed));
+
+	REQUIRE(limiter.tryAcquire(start + LogRateLimiter::WindowNs, suppressed));
+	CHECK(suppressed == 11);
+	CHECK(limiter.getSuppressed() == 0);
+
+	REQUIRE(limiter.tryAcquire(start + LogRateLimiter::WindowNs + 1, suppressed));
+	CHECK(suppressed == 0);
+}
+
+// This test ensures that threads which log at the same time don't let through more messages than the limit,
+// neither within a window nor when they start a new window together.
+TEST_CASE("LogRateLimiterConcurrent", "[log]")
+{
+	constexpr uint32 MaxPerSecond = 50;
+	constexpr size_t WindowCount = 20;
+	constexpr size_t ThreadCount = 4;
+
+	LogRateLimiter limiter{ MaxPerSecond };
+	std::array<std::atomic<size_t>, WindowCount> written{};
+	std::atomic<size_t> arrived{ 0 };
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < ThreadCount; ++t)
+	{
+		threads.emplace_back([&limiter, &written, &arrived]()
+		{
+			uint64 suppressed = 0;
+			for (size_t window = 0; window < WindowCount; ++window)
+			{
+				// All threads enter the next window together, like threads which read the same clock
+				arrived++;
+				while (arrived < (window + 1) * ThreadCount)
+				{
+					std::this_thread::yield();
+				}
+
+				const uint64 now = (window + 1) * LogRateLimiter::WindowNs;
+				for (size_t i = 0; i < MaxPerSecond; ++i)
+				{
+					if (limiter.tryAcquire(now, suppressed))
+					{
+						written[window]++;
+					}
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	for (const auto &count : written)
+	{
+		CHECK(count == MaxPerSecond);
+	}
+}
+
+// This test ensures that the sampler writes the first and then every n-th message.
+TEST_CASE("LogSamplerEvery", "[log]")
+{
+	LogSampler sampler{ 4 };
+
+	std::vector<bool> sampled;
+	for (size_t i = 0; i < 9; ++i)
+	{
+		sampled.push_back(sampler.sample());
+	}
+
+	CHECK(sampled == std::vector<bool>{ true, false, false, false, true, false, false, false, true });
+}
+
+// This test ensures that the rate limited macro limits per call site and appends the summary.
+TEST_CASE("LogRateLimitedMacro", "[log]")
+{
+	std::vector<String> messages;
+	scoped_connection connection{ g_DefaultLog.signal().connect([&messages](const LogEntry &entry) { messages.push_back(entry.message); }) };
+
+	for (size_t i = 0; i < 100; ++i)
+	{
+		WLOG_RATE(2, "Packet 0x" << std::hex << 255);
+	}
+
+	// A different call site has its own limit
+	ELOG_RATE(2, "Other");
+
+	REQUIRE(messages.size() == 3);
+	CHECK(messages[0] == "Packet 0xff");
+	CHECK(messages[1] == "Packet 0xff");
+	CHECK(messages[2] == "Other");
+
+	messages.clear();
+	for (size_t i = 0; i < 10; ++i)
+	{
+		WLOG_SAMPLED(5, "Sampled " << i);
+	}
+
+	REQUIRE(messages.size() == 2);
+	CHECK(messages[0] == "Sampled 0 (sampled 1 of 5)");
+	CHECK(messages[1] == "Sampled 5 (sampled 1 of 5)");
+}
@@ -0,0 +1,274 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "realm_server/login_connector.h"
+
+#include "auth_protocol/auth_connection.h"
+#include "auth_protocol/auth_outgoing_packet.h"
+#include "base/constants.h"
+#include "base/srp6.h"
+#include "base/timer_queue.h"
+
+#include "asio.hpp"
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace mmo;
+
+
+namespace
+{
+	/// Hex string of the realm password hash which the fake login server accepts.
+	const std::string RealmPasswordHash = "0123456789ABCDEF0123456789ABCDEF01234567";
+
+	/// Login server which authenticates a realm and answers every client auth session request with the
+	/// number contained in the requested account name as account id.
+	struct FakeLoginServer final : auth::IConnectionListener
+	{
+		std::shared_ptr<auth::Connection> connection;
+		std::promise<void> authenticated;
+		std::atomic<size_t> batchCount{ 0 };
+		std::atomic<size_t> largestBatch{ 0 };
+		std::atomic<size_t> malformedRequests{ 0 };
+
+		String realmName;
+		BigNumber s, v, b, B;
+
+		void connectionLost() override {}
+		void connectionMalformedPacket() override {}
+		PacketParseResult connectionPacketReceived(auth::IncomingPacket &packet) override
+		{
+			switch (packet.GetId())
+			{
+			case auth::realm_login_packet::LogonChallenge:
+				return handleLogonChallenge(packet);
+			case auth::realm_login_packet::LogonProof:
+				return handleLogonProof(packet);
+			case auth::realm_login_packet::ClientAuthSessionBatch:
+				return handleClientAuthSessionBatch(packet);
+			default:
+				return PacketParseResult::Disconnect;
+			}
+		}
+
+		PacketParseResult handleLogonChallenge(auth::IncomingPacket &packet)
+		{
+			uint8 version1 = 0, version2 = 0, version3 = 0;
+			uint16 build = 0;
+			if (!(packet
+				>> io::read<uint8>(version1)
+				>> io::read<uint8>(version2)
+				>> io::read<uint8>(version3)
+				>> io::read<uint16>(build)
+				>> io::read_container<uint8>(realmName)))
+			{
+				return PacketParseResult::Disconnect;
+			}
+
+			std::string passwordHash = RealmPasswordHash;
+			s.setRand(32 * 8);
+			v = srp6::CalculateVerifier(s, sha1ParseHex(passwordHash));
+			b.setRand(19 * 8);
+			B = ((v * 3) + srp6::ModExpG(b)) % constants::srp::N;
+
+			connection->sendSinglePacket([this](auth::OutgoingPacket &outPacket)
+			{
+				outPacket.Start(auth::login_realm_packet::LogonChallenge);
+				outPacket
+					<< io::write<uint8>(auth::auth_result::Success)
+					<< io::write_range(B.asByteArray(32))
+					<< io::write<uint8>(constants::srp::g.asUInt32())
+					<< io::write_range(constants::srp::N.asByteArray(32))
+					<< io::write_range(s.asByteArray(32));
+				outPacket.Finish();
+			});
+
+			return PacketParseResult::Pass;
+		}
+
+		PacketParseResult handleLogonProof(auth::IncomingPacket &packet)
+		{
+			std::array<uint8, 32> A;
+			SHA1Hash M1;
+			if (!(packet >> io::read_range(A) >> io::read_range(M1)))
+			{
+				return PacketParseResult::Disconnect;
+			}
+
+			const auto proof = srp6::CalculateServerProof(realmName, s, v, b, B, BigNumber{ A.data(), A.size() }, M1);
+			if (!proof)
+			{
+				return PacketParseResult::Disconnect;
+			}
+
+			connection->sendSinglePacket([&proof](auth::OutgoingPacket &outPacket)
+			{
+				outPacket.Start(auth::login_realm_packet::LogonProof);
+				outPacket
+					<< io::write<uint8>(auth::auth_result::Success)
+					<< io::write_range(proof->M2);
+				outPacket.Finish();
+			});
+
+			authenticated.set_value();
+			return PacketParseResult::Pass;
+		}
+
+		PacketParseResult handleClientAuthSessionBatch(auth::IncomingPacket &packet)
+		{
+			uint16 requestCount = 0;
+			if (!(packet >> io::read<uint16>(requestCount)))
+			{
+				return PacketParseResult::Disconnect;
+			}
+
+			std::vector<std::pair<uint64, uint64>> results;
+			for (uint16 i = 0; i < requestCount; ++i)
+			{
+				uint64 requestId = 0;
+				String accountName;
+				uint32 clientSeed = 0, serverSeed = 0;
+				SHA1Hash clientHash;
+				if (!(packet
+					>> io::read<uint64>(requestId)
+					>> io::read_container<uint8>(accountName)
+					>> io::read<uint32>(clientSeed)
+					>> io::read<uint32>(serverSeed)
+					>> io::read_range(clientHash)))
+				{
+					return PacketParseResult::Disconnect;
+				}
+
+				// The seeds repeat the account id, so that interleaved writes would be noticed
+				const uint64 accountId = std::stoull(accountName.substr(7));
+				if (clientSeed != accountId || serverSeed != accountId)
+				{
+					malformedRequests++;
+				}
+
+				results.emplace_back(requestId, accountId);
+			}
+
+			batchCount++;
+			if (requestCount > largestBatch)
+			{
+				largestBatch = requestCount;
+			}
+
+			connection->sendSinglePacket([&results](auth::OutgoingPacket &outPacket)
+			{
+				outPacket.Start(auth::login_realm_packet::ClientAuthSessionBatchResponse);
+				outPacket << io::write<uint16>(results.size());
+				for (const auto &result : results)
+				{
+					outPacket
+						<< io::write<uint64>(result.first)
+						<< io::write<uint8>(auth::auth_result::Success)
+						<< io::write<uint64>(result.second)
+						<< io::write_dynamic_range<uint16>(std::vector<uint8>{ 1, 2, 3 });
+				}
+				outPacket.Finish();
+			});
+
+			return PacketParseResult::Pass;
+		}
+	};
+}
+
+// This test ensures that client auth session requests which are queued by several threads at once are all sent
+// in intact batches of at most MaxClientAuthSessionBatchSize requests and answered exactly once.
+TEST_CASE("LoginConnectorBatchesClientAuthSessionsOfSeveralThreads", "[login_connector]")
+{
+	asio::io_service service;
+	auto work = std::make_unique<asio::io_service::work>(service);
+	TimerQueue timerQueue{ service };
+
+	asio::ip::tcp::acceptor acceptor{ service, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0) };
+	FakeLoginServer server;
+	auto serverSocket = std::make_unique<asio::ip::tcp::socket>(service);
+	acceptor.async_accept(*serverSocket, [&](const asio::error_code &error)
+	{
+		if (error)
+		{
+			return;
+		}
+
+		server.connection = std::make_shared<auth::Connection>(std::move(serverSocket), &server);
+		server.connection->startReceiving();
+	});
+
+	auto connector = std::make_shared<LoginConnector>(service, timerQueue);
+	REQUIRE(connector->Login("127.0.0.1", acceptor.local_endpoint().port(), "realm", RealmPasswordHash));
+
+	std::vector<std::thread> networkThreads;
+	for (size_t i = 0; i < 2; ++i)
+	{
+		networkThreads.emplace_back([&service]() { service.run(); });
+	}
+
+	REQUIRE(server.authenticated.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+	// Queue the requests like the realm's network threads do during a restart burst
+	constexpr size_t ThreadCount = 4;
+	constexpr size_t RequestsPerThread = LoginConnector::MaxClientAuthSessionBatchSize * 3 + 5;
+	constexpr size_t RequestCount = ThreadCount * RequestsPerThread;
+
+	std::atomic<size_t> answered{ 0 };
+	std::atomic<size_t> wrongAnswers{ 0 };
+	std::atomic<size_t> rejected{ 0 };
+	std::promise<void> allAnswered;
+
+	std::vector<std::thread> playerThreads;
+	for (size_t t = 0; t < ThreadCount; ++t)
+	{
+		playerThreads.emplace_back([&, t]()
+		{
+			for (size_t i = 0; i < RequestsPerThread; ++i)
+			{
+				const uint32 accountId = static_cast<uint32>(t * RequestsPerThread + i);
+				const bool queued = connector->QueueClientAuthSession("ACCOUNT" + std::to_string(accountId), accountId, accountId, SHA1Hash(),
+					[&, accountId](bool success, uint64 resultAccountId, const BigNumber &)
+					{
+						if (!success || resultAccountId != accountId)
+						{
+							wrongAnswers++;
+						}
+
+						if (++answered == RequestCount)
+						{
+							allAnswered.set_value();
+						}
+					});
+
+				if (!queued)
+				{
+					rejected++;
+				}
+			}
+		});
+	}
+
+	for (auto &thread : playerThreads)
+	{
+		thread.join();
+	}
+
+	CHECK(rejected == 0);
+	CHECK(allAnswered.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+	CHECK(answered == RequestCount);
+	CHECK(wrongAnswers == 0);
+	CHECK(server.malformedRequests == 0);
+	CHECK(server.largestBatch <= LoginConnector::MaxClientAuthSessionBatchSize);
+	CHECK(server.batchCount >= RequestCount / LoginConnector::MaxClientAuthSessionBatchSize);
+
+	work.reset();
+	service.stop();
+	for (auto &thread : networkThreads)
+	{
+		thread.join();
+	}
+}
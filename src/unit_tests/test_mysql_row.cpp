@@ -0,0 +1,43 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "mysql_wrapper/mysql_row.h"
+
+using namespace mmo;
+
+
+// This test ensures that numeric result fields are converted completely and only if they fit into the target type.
+TEST_CASE("MySQLRowParsesNumericFields", "[mysql]")
+{
+	uint64 id = 0;
+	CHECK(mysql::ParseField("18446744073709551615", id));
+	CHECK(id == 18446744073709551615ull);
+
+	int32 delta = 0;
+	CHECK(mysql::ParseField("-42", delta));
+	CHECK(delta == -42);
+
+	uint16 level = 0;
+	CHECK(mysql::ParseField("255", level));
+	CHECK(level == 255);
+	CHECK_FALSE(mysql::ParseField("65536", level));
+	CHECK_FALSE(mysql::ParseField("12abc", level));
+	CHECK_FALSE(mysql::ParseField("", level));
+
+	double position = 0.0;
+	CHECK(mysql::ParseField("-1.5", position));
+	CHECK(position == -1.5);
+
+	bool dead = false;
+	CHECK(mysql::ParseField("1", dead));
+	CHECK(dead);
+}
+
+// This test ensures that string fields are copied as a whole, including white space.
+TEST_CASE("MySQLRowParsesStringFields", "[mysql]")
+{
+	String name;
+	CHECK(mysql::ParseField("Stormwind Guard", name));
+	CHECK(name == "Stormwind Guard");
+}
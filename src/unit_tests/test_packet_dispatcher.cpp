@@ -0,0 +1,104 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "network/packet_dispatcher.h"
+
+using namespace mmo;
+
+
+namespace
+{
+	/// Minimal packet type which only provides an op code.
+	struct TestPacket
+	{
+		uint16 id;
+
+		uint16 GetId() const { return id; }
+	};
+
+	typedef PacketDispatcher<TestPacket, 8> TestDispatcher;
+}
+
+// This test ensures that only enabled op codes are dispatched to their handlers.
+TEST_CASE("PacketDispatcherEnableBits", "[network]")
+{
+	TestDispatcher dispatcher;
+
+	int calls = 0;
+	dispatcher.registerHandler(2, [&calls](TestPacket &) { ++calls; return PacketParseResult::Pass; });
+
+	TestPacket packet{ 2 };
+	PacketParseResult result = PacketParseResult::Disconnect;
+	CHECK(dispatcher.dispatch(packet, result));
+	CHECK(result == PacketParseResult::Pass);
+	CHECK(calls == 1);
+
+	// Disabled handlers are not executed but kept for re-enabling
+	dispatcher.clearHandler(2);
+	CHECK_FALSE(dispatcher.isEnabled(2));
+	CHECK_FALSE(dispatcher.dispatch(packet, result));
+	CHECK(calls == 1);
+
+	dispatcher.setEnabled(2, true);
+	CHECK(dispatcher.dispatch(packet, result));
+	CHECK(calls == 2);
+
+	// Unregistered and out of range op codes are not handled
+	TestPacket unhandled{ 3 };
+	CHECK_FALSE(dispatcher.dispatch(unhandled, result));
+	TestPacket outOfRange{ 200 };
+	CHECK_FALSE(dispatcher.dispatch(outOfRange, result));
+
+	dispatcher.clearHandlers();
+	CHECK_FALSE(dispatcher.dispatch(packet, result));
+}
+
+// This test ensures that a handler may replace itself while it is being executed.
+TEST_CASE("PacketDispatcherReplaceRunningHandler", "[network]")
+{
+	TestDispatcher dispatcher;
+
+	int first = 0, second = 0;
+	dispatcher.registerHandler(1, [&](TestPacket &) {
+		++first;
+		dispatcher.registerHandler(1, [&second](TestPacket &) { ++second; return PacketParseResult::Block; });
+		return PacketParseResult::Pass;
+	});
+
+	TestPacket packet{ 1 };
+	PacketParseResult result = PacketParseResult::Disconnect;
+	CHECK(dispatcher.dispatch(packet, result));
+	CHECK(result == PacketParseResult::Pass);
+
+	CHECK(dispatcher.dispatch(packet, result));
+	CHECK(result == PacketParseResult::Block);
+	CHECK(first == 1);
+	CHECK(second == 1);
+}
+
+// This test ensures that a throwing handler doesn't block later dispatches and that a handler which it registered
+// before it threw is still applied.
+TEST_CASE("PacketDispatcherHandlerThrows", "[network]")
+{
+	TestDispatcher dispatcher;
+
+	dispatcher.registerHandler(1, [&dispatcher](TestPacket &)
+	{
+		dispatcher.registerHandler(1, [](TestPacket &) { return PacketParseResult::Disconnect; });
+		throw std::runtime_error("Handler failed");
+		return PacketParseResult::Pass;
+	});
+
+	TestPacket packet{ 1 };
+	PacketParseResult result = PacketParseResult::Pass;
+	CHECK_THROWS_AS(dispatcher.dispatch(packet, result), std::runtime_error);
+
+	CHECK(dispatcher.dispatch(packet, result));
+	CHECK(result == PacketParseResult::Disconnect);
+
+	// Handlers are replaced right away again outside of a dispatch
+	dispatcher.registerHandler(1, [](TestPacket &) { return PacketParseResult::Block; });
+	CHECK(dispatcher.dispatch(packet, result));
+	CHECK(result == PacketParseResult::Block);
+}
@@ -0,0 +1,58 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "network/packet_statistics.h"
+
+#include <algorithm>
+
+using namespace mmo;
+
+
+// This test ensures that packets are accumulated per op code and latencies are placed in the right buckets.
+TEST_CASE("PacketStatisticsPerOpCode", "[network]")
+{
+	PacketStatistics statistics{ "test" };
+
+	for (int i = 0; i < 99; ++i)
+	{
+		statistics.recordPacketReceived(0x01, 10, std::chrono::nanoseconds(100));
+	}
+	statistics.recordPacketReceived(0x01, 10, std::chrono::nanoseconds(100000));
+	statistics.recordPacketReceived(0x1234, 5, std::chrono::nanoseconds(1));
+	statistics.recordDataSent(64);
+
+	const ProtocolStatisticsSnapshot snapshot = statistics.getSnapshot();
+	CHECK(snapshot.protocol == "test");
+	CHECK(snapshot.sendCount == 1);
+	CHECK(snapshot.sentBytes == 64);
+	REQUIRE(snapshot.opCodes.size() == 2);
+
+	const OpCodeStatisticsSnapshot &opCode = snapshot.opCodes[0];
+	CHECK(opCode.opCode == 0x01);
+	CHECK(opCode.packetCount == 100);
+	CHECK(opCode.byteCount == 1000);
+	CHECK(opCode.maxNs == 100000);
+	CHECK(opCode.averageNs == (99 * 100 + 100000) / 100);
+
+	// 100 ns fall into the bucket [64, 128)
+	CHECK(opCode.p50Ns == 127);
+	CHECK(opCode.p99Ns >= 100000);
+
+	// Op codes out of range are accumulated in the last slot
+	CHECK(snapshot.opCodes[1].opCode == PacketStatistics::MaxOpCodes - 1);
+
+	statistics.reset();
+	CHECK(statistics.getSnapshot().opCodes.empty());
+}
+
+// This test ensures that all instances can be queried through the registry.
+TEST_CASE("PacketStatisticsRegistry", "[network]")
+{
+	PacketStatistics statistics{ "registry_test" };
+
+	const auto snapshots = PacketStatistics::getAllSnapshots();
+	CHECK(std::any_of(snapshots.begin(), snapshots.end(), [](const ProtocolStatisticsSnapshot &s) {
+		return s.protocol == "registry_test";
+	}));
+}
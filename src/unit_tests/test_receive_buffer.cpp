@@ -0,0 +1,149 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "network/receive_buffer.h"
+#include "auth_protocol/auth_protocol.h"
+#include "binary_io/vector_sink.h"
+#include "binary_io/writer.h"
+
+#include <cstring>
+
+using namespace mmo;
+
+
+namespace
+{
+	/// Copies a block of data into the receive buffer like a socket read would do.
+	void SimulateRead(ReceiveBuffer& buffer, const char* data, size_t size)
+	{
+		char* const dest = buffer.prepare();
+		REQUIRE(buffer.getWritableSize() >= size);
+		std::memcpy(dest, data, size);
+		buffer.commit(size);
+	}
+}
+
+// This test ensures that consumed data is skipped without moving the remaining data.
+TEST_CASE("ReceiveBufferConsumeInPlace", "[network]")
+{
+	ReceiveBuffer buffer{ 16, 64 };
+
+	const char data[] = "0123456789";
+	SimulateRead(buffer, data, 10);
+	CHECK(buffer.size() == 10);
+
+	const char* const begin = buffer.data();
+	buffer.consume(4);
+
+	// Remaining data should still be at the same memory location
+	CHECK(buffer.size() == 6);
+	CHECK(buffer.data() == begin + 4);
+	CHECK(std::memcmp(buffer.data(), "456789", 6) == 0);
+
+	// Consuming everything allows the next read to start at the front again
+	buffer.consume(6);
+	CHECK(buffer.empty());
+	buffer.prepare();
+	CHECK(buffer.data() == begin);
+}
+
+// This test ensures that the unparsed tail is compacted to the front if the free space is insufficient.
+TEST_CASE("ReceiveBufferCompaction", "[network]")
+{
+	ReceiveBuffer buffer{ 8, 8 };
+
+	// Fill the buffer twice without consuming, which forces it to grow once
+	SimulateRead(buffer, "abcdefgh", 8);
+	SimulateRead(buffer, "ijklmn", 6);
+
+	const size_t capacity = buffer.capacity();
+	const char* const begin = buffer.data();
+
+	// Consume most of the data, leaving two bytes which have to be kept. The free tail
+	// space is now too small for another read, but compacting frees enough space.
+	buffer.consume(12);
+	SimulateRead(buffer, "opqr", 4);
+
+	CHECK(buffer.capacity() == capacity);
+	CHECK(buffer.data() == begin);
+	CHECK(buffer.size() == 6);
+	CHECK(std::memcmp(buffer.data(), "mnopqr", 6) == 0);
+}
+
+// This test ensures that the read size grows on bulk traffic and decays back afterwards.
+TEST_CASE("ReceiveBufferAdaptiveReadSize", "[network]")
+{
+	ReceiveBuffer buffer{ 16, 64 };
+	std::vector<char> data(64, 'x');
+
+	CHECK(buffer.getReadSize() == 16);
+
+	// Reads filling the whole window let the read size grow up to the maximum
+	for (size_t i = 0; i < 4; ++i)
+	{
+		const size_t readSize = buffer.getReadSize();
+		SimulateRead(buffer, data.data(), readSize);
+		buffer.consume(buffer.size());
+	}
+	CHECK(buffer.getReadSize() == 64);
+
+	// Small reads let the read size decay back to the initial value
+	for (size_t i = 0; i < 4; ++i)
+	{
+		SimulateRead(buffer, data.data(), 1);
+		buffer.consume(buffer.size());
+	}
+	CHECK(buffer.getReadSize() == 16);
+}
+
+// This test ensures that multiple packets received in one read are parsed one after another.
+TEST_CASE("ReceiveBufferCoalescedPackets", "[network]")
+{
+	std::vector<char> stream;
+	io::VectorSink sink{ stream };
+
+	for (uint32 i = 0; i < 3; ++i)
+	{
+		auth::OutgoingPacket packet{ sink };
+		packet.Start(auth::client_login_packet::RealmList);
+		packet << io::write<uint32>(i);
+		packet.Finish();
+	}
+
+	// Deliver everything but the last byte in a single read
+	ReceiveBuffer buffer;
+	SimulateRead(buffer, stream.data(), stream.size() - 1);
+
+	uint32 expected = 0;
+	for (;;)
+	{
+		io::MemorySource source{ buffer.data(), buffer.data() + buffer.size() };
+		auth::IncomingPacket packet;
+		if (auth::IncomingPacket::Start(packet, source) != receive_state::Complete)
+		{
+			break;
+		}
+
+		uint32 value = 0;
+		CHECK(packet >> io::read<uint32>(value));
+		CHECK(value == expected++);
+
+		buffer.consume(source.getRead());
+	}
+
+	// Two packets are complete, the third one is still missing a byte
+	CHECK(expected == 2);
+	CHECK(buffer.size() == stream.size() / 3 - 1);
+
+	// Deliver the missing byte
+	SimulateRead(buffer, &stream.back(), 1);
+
+	io::MemorySource source{ buffer.data(), buffer.data() + buffer.size() };
+	auth::IncomingPacket packet;
+	REQUIRE(auth::IncomingPacket::Start(packet, source) == receive_state::Complete);
+
+	uint32 value = 0;
+	CHECK(packet >> io::read<uint32>(value));
+	CHECK(value == 2);
+}
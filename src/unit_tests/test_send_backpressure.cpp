@@ -0,0 +1,139 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "network/send_backpressure.h"
+#include "auth_protocol/auth_connection.h"
+#include "auth_protocol/auth_outgoing_packet.h"
+
+#include "asio.hpp"
+
+#include <memory>
+#include <vector>
+
+using namespace mmo;
+
+
+// This test ensures that nothing is limited without watermarks, while the peak size is still tracked.
+TEST_CASE("SendBackpressureDisabled", "[network]")
+{
+	SendBackpressure backpressure;
+
+	const uint64 now = 1000000;
+	CHECK(backpressure.update(1024 * 1024, now) == SendBackpressure::Event::None);
+	CHECK(!backpressure.isCongested());
+	CHECK(backpressure.getPeakSize() == 1024 * 1024);
+}
+
+// This test ensures that the high and low watermarks are reported once per transition.
+TEST_CASE("SendBackpressureWatermarkHysteresis", "[network]")
+{
+	SendBackpressure backpressure;
+	backpressure.setWatermarks(SendWatermarks{ 100, 20, 0, true, std::chrono::milliseconds(0) });
+
+	const uint64 now = 1000000;
+	CHECK(backpressure.update(99, now) == SendBackpressure::Event::None);
+	CHECK(backpressure.update(100, now) == SendBackpressure::Event::HighWatermarkReached);
+	CHECK(backpressure.isParsingPaused());
+	CHECK(backpressure.update(150, now) == SendBackpressure::Event::None);
+
+	// Still congested between the watermarks
+	CHECK(backpressure.update(50, now) == SendBackpressure::Event::None);
+	CHECK(backpressure.isCongested());
+
+	CHECK(backpressure.update(20, now) == SendBackpressure::Event::LowWatermarkReached);
+	CHECK(!backpressure.isParsingPaused());
+	CHECK(backpressure.update(0, now) == SendBackpressure::Event::None);
+	CHECK(backpressure.getPeakSize() == 150);
+
+	// No slow consumer timeout configured
+	CHECK(backpressure.update(100, now) == SendBackpressure::Event::HighWatermarkReached);
+	CHECK(!backpressure.isSlowConsumer(now + 3600000000000ull));
+}
+
+// This test ensures that congested connections are detected as slow consumers after the timeout and on the hard limit.
+TEST_CASE("SendBackpressureSlowConsumer", "[network]")
+{
+	SendBackpressure backpressure;
+	backpressure.setWatermarks(SendWatermarks{ 100, 20, 1000, false, std::chrono::milliseconds(50) });
+
+	const uint64 start = 1000000;
+	CHECK(backpressure.update(200, start) == SendBackpressure::Event::HighWatermarkReached);
+	CHECK(!backpressure.isParsingPaused());
+	CHECK(!backpressure.isSlowConsumer(start + 49000000));
+	CHECK(backpressure.isSlowConsumer(start + 50000000));
+
+	// Draining the connection resets the timeout
+	CHECK(backpressure.update(0, start) == SendBackpressure::Event::LowWatermarkReached);
+	CHECK(!backpressure.isSlowConsumer(start + 50000000));
+
+	CHECK(backpressure.update(1001, start) == SendBackpressure::Event::LimitExceeded);
+}
+
+namespace
+{
+	/// Records the disconnect of a connection and whether it happened while a packet was written.
+	struct DisconnectRecorder final : auth::IConnectionListener
+	{
+		bool isSending = false;
+		bool highWhileSending = false;
+		bool lost = false;
+		bool lostWhileSending = false;
+
+		void connectionLost() override
+		{
+			lost = true;
+			lostWhileSending = isSending;
+		}
+		void connectionSendBufferHigh(size_t) override
+		{
+			highWhileSending = isSending;
+		}
+		void connectionMalformedPacket() override {}
+		PacketParseResult connectionPacketReceived(auth::IncomingPacket &) override { return PacketParseResult::Pass; }
+	};
+}
+
+// This test ensures that an uncorked connection whose peer doesn't read is dropped as soon as the hard limit is
+// exceeded, and that the listener is not destroyed by a disconnect while it is still writing packets.
+TEST_CASE("SendBackpressureDropsUncorkedSlowConsumer", "[network]")
+{
+	asio::io_service service;
+	asio::ip::tcp::acceptor acceptor{ service, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0) };
+
+	// The client never reads, so the server side data piles up in its send queue
+	asio::ip::tcp::socket client{ service };
+	client.connect(acceptor.local_endpoint());
+	auto socket = std::make_unique<asio::ip::tcp::socket>(service);
+	acceptor.accept(*socket);
+
+	DisconnectRecorder listener;
+	auto connection = std::make_shared<auth::Connection>(std::move(socket), &listener);
+	connection->setSendWatermarks(SendWatermarks{ 64 * 1024, 16 * 1024, 1024 * 1024, false, std::chrono::milliseconds(0) });
+
+	const std::vector<uint8> payload(16 * 1024, 0xAB);
+	connection->post([&]()
+	{
+		// Written outside of the parse loop like the result of a database request
+		listener.isSending = true;
+		for (size_t i = 0; i < 256; ++i)
+		{
+			connection->sendSinglePacket([&payload](auth::OutgoingPacket &packet)
+			{
+				packet.Start(auth::login_client_packet::RealmList);
+				packet << io::write_range(payload);
+				packet.Finish();
+			});
+		}
+		listener.isSending = false;
+	});
+
+	service.run_for(std::chrono::seconds(10));
+
+	// The limit is checked with every packet, so no more than one packet is queued beyond it
+	CHECK(listener.highWhileSending);
+	CHECK(connection->getPeakQueuedSendSize() > 1024 * 1024);
+	CHECK(connection->getPeakQueuedSendSize() <= 1024 * 1024 + payload.size() + 16);
+	CHECK(listener.lost);
+	CHECK(!listener.lostWhileSending);
+}
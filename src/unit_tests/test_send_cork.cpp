@@ -0,0 +1,61 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "network/send_cork.h"
+
+using namespace mmo;
+
+
+// This test ensures that packets are flushed one by one if corking is disabled.
+TEST_CASE("SendCorkDisabledFlushesEveryPacket", "[network]")
+{
+	SendCork cork;
+
+	const uint64 now = 1000000;
+	CHECK(cork.packetWritten(now) == SendCork::Action::FlushNow);
+	CHECK(cork.packetWritten(now) == SendCork::Action::FlushNow);
+	CHECK(!cork.isPending());
+}
+
+// This test ensures that a corked connection schedules a single deferred flush for multiple packets.
+TEST_CASE("SendCorkSchedulesSingleFlush", "[network]")
+{
+	SendCork cork;
+	cork.enable(std::chrono::microseconds(500));
+
+	const uint64 now = 1000000;
+	CHECK(cork.packetWritten(now) == SendCork::Action::ScheduleFlush);
+	CHECK(cork.packetWritten(now) == SendCork::Action::None);
+	CHECK(cork.packetWritten(now) == SendCork::Action::None);
+	CHECK(cork.isPending());
+
+	// The scheduled flush sends all packets at once
+	CHECK(cork.scheduledFlushExecuted());
+	cork.flushed();
+	CHECK(!cork.isPending());
+
+	// The next packet schedules a new flush
+	CHECK(cork.packetWritten(now) == SendCork::Action::ScheduleFlush);
+}
+
+// This test ensures that the latency cap forces a flush and that the scheduled flush is skipped afterwards.
+TEST_CASE("SendCorkLatencyCap", "[network]")
+{
+	SendCork cork;
+	cork.enable(std::chrono::microseconds(100));
+
+	const uint64 start = 1000000;
+	CHECK(cork.packetWritten(start) == SendCork::Action::ScheduleFlush);
+	CHECK(cork.packetWritten(start + 99000) == SendCork::Action::None);
+	CHECK(cork.packetWritten(start + 100000) == SendCork::Action::FlushNow);
+	cork.flushed();
+
+	// Nothing left to send when the scheduled flush is executed
+	CHECK(!cork.scheduledFlushExecuted());
+
+	// Without a cap, packets only wait for the end of the io batch
+	cork.enable(std::chrono::nanoseconds::zero());
+	CHECK(cork.packetWritten(start) == SendCork::Action::ScheduleFlush);
+	CHECK(cork.packetWritten(start + 10000000000ull) == SendCork::Action::None);
+}
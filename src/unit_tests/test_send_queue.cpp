@@ -0,0 +1,118 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "network/send_queue.h"
+
+#include <memory>
+
+using namespace mmo;
+
+
+namespace
+{
+	/// Concatenates the buffer sequence of a send like the vectored write would transmit it.
+	Buffer Gather(const SendQueue::BufferSequence &buffers)
+	{
+		Buffer result;
+		for (const auto &buffer : buffers)
+		{
+			result.append(static_cast<const char*>(buffer.data()), buffer.size());
+		}
+
+		return result;
+	}
+}
+
+// This test ensures that owned and shared segments are sent in order with a single buffer sequence.
+TEST_CASE("SendQueueGathersSegmentsInOrder", "[network]")
+{
+	SendQueue queue;
+	CHECK_FALSE(queue.hasPending());
+
+	Buffer sendBuffer = "abc";
+	queue.push(sendBuffer);
+	CHECK(sendBuffer.empty());
+
+	const SharedBuffer shared = std::make_shared<const Buffer>("shared");
+	queue.push(shared);
+
+	sendBuffer = "xyz";
+	queue.push(sendBuffer);
+	REQUIRE(queue.hasPending());
+
+	const auto &buffers = queue.beginSend();
+	CHECK(buffers.size() == 3);
+	CHECK(queue.isSending());
+	CHECK_FALSE(queue.hasPending());
+	CHECK(queue.getSendingSize() == 12);
+	CHECK(Gather(buffers) == "abcsharedxyz");
+
+	// The shared buffer is referenced, not copied
+	CHECK(buffers[1].data() == shared->data());
+
+	queue.sendCompleted();
+	CHECK_FALSE(queue.isSending());
+	CHECK(queue.getSendingSize() == 0);
+}
+
+// This test ensures that a shared buffer can be queued on multiple queues at once.
+TEST_CASE("SendQueueSharedBufferOnMultipleQueues", "[network]")
+{
+	SharedBuffer shared = std::make_shared<const Buffer>("payload");
+	const char *const data = shared->data();
+
+	SendQueue first, second;
+	first.push(shared);
+	second.push(shared);
+	CHECK(shared.use_count() == 3);
+
+	CHECK(first.beginSend()[0].data() == data);
+	CHECK(second.beginSend()[0].data() == data);
+
+	first.sendCompleted();
+	second.sendCompleted();
+	CHECK(shared.use_count() == 1);
+}
+
+// This test ensures that the storage of sent owned buffers is reused for the send buffer.
+TEST_CASE("SendQueueReusesOwnedBuffers", "[network]")
+{
+	SendQueue queue;
+
+	Buffer sendBuffer(1024, 'x');
+	const size_t capacity = sendBuffer.capacity();
+	queue.push(sendBuffer);
+	queue.beginSend();
+	queue.sendCompleted();
+
+	sendBuffer = "y";
+	queue.push(sendBuffer);
+
+	// The send buffer now uses the storage of the first buffer
+	CHECK(sendBuffer.empty());
+	CHECK(sendBuffer.capacity() == capacity);
+}
+
+// This test ensures that the queued size covers pending and in-flight segments.
+TEST_CASE("SendQueueQueuedSize", "[network]")
+{
+	SendQueue queue;
+	CHECK(queue.getQueuedSize() == 0);
+
+	Buffer sendBuffer = "abcd";
+	queue.push(sendBuffer);
+	queue.push(std::make_shared<const Buffer>("ef"));
+	CHECK(queue.getQueuedSize() == 6);
+
+	queue.beginSend();
+	sendBuffer = "ghi";
+	queue.push(sendBuffer);
+	CHECK(queue.getQueuedSize() == 9);
+
+	queue.sendCompleted();
+	CHECK(queue.getQueuedSize() == 3);
+
+	queue.clear();
+	CHECK(queue.getQueuedSize() == 0);
+}
@@ -0,0 +1,61 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "realm_server/session_cache.h"
+
+#include <thread>
+
+using namespace mmo;
+
+
+// This test ensures that cached sessions are found case insensitive and that the session which expires
+// next is evicted when the cache is full.
+TEST_CASE("SessionCacheEvictsOldestSession", "[session_cache]")
+{
+	SessionCache cache{ 2, std::chrono::minutes(5) };
+	REQUIRE(cache.isEnabled());
+
+	cache.set("first", CachedSession{ 1, BigNumber(11) });
+	cache.set("second", CachedSession{ 2, BigNumber(22) });
+
+	const auto first = cache.get("FIRST");
+	REQUIRE(first);
+	CHECK(first->accountId == 1);
+	CHECK(first->sessionKey == BigNumber(11));
+
+	// Storing a session again renews it, so the second session is evicted instead of the first one
+	cache.set("First", CachedSession{ 1, BigNumber(33) });
+	cache.set("third", CachedSession{ 3, BigNumber(44) });
+	CHECK(cache.size() == 2);
+	CHECK_FALSE(cache.get("second"));
+	CHECK(cache.get("first")->sessionKey == BigNumber(33));
+	CHECK(cache.get("third"));
+
+	cache.erase("THIRD");
+	CHECK_FALSE(cache.get("third"));
+	CHECK(cache.size() == 1);
+}
+
+// This test ensures that sessions expire after their time to live.
+TEST_CASE("SessionCacheExpiresSessions", "[session_cache]")
+{
+	SessionCache cache{ 10, std::chrono::milliseconds(20) };
+	cache.set("account", CachedSession{ 1, BigNumber(11) });
+	CHECK(cache.get("account"));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(40));
+	CHECK_FALSE(cache.get("account"));
+	CHECK(cache.size() == 0);
+}
+
+// This test ensures that a cache without capacity or time to live doesn't store sessions.
+TEST_CASE("SessionCacheCanBeDisabled", "[session_cache]")
+{
+	SessionCache cache{ 0, std::chrono::minutes(5) };
+	CHECK_FALSE(cache.isEnabled());
+
+	cache.set("account", CachedSession{ 1, BigNumber(11) });
+	CHECK_FALSE(cache.get("account"));
+	CHECK(cache.size() == 0);
+}
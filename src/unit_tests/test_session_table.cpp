@@ -0,0 +1,91 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "session_table.h"
+
+using namespace mmo;
+
+
+namespace
+{
+	AccountSession MakeSession(uint64 accountId, const String &sessionKey)
+	{
+		return AccountSession{ accountId, sessionKey, std::vector<uint8>(sessionKey.begin(), sessionKey.end()) };
+	}
+}
+
+TEST_CASE("SessionTableKeepsPendingSessions", "[session_table]")
+{
+	SessionTable table{ 0, std::chrono::milliseconds(0) };
+
+	for (uint64 i = 0; i < 100; ++i)
+	{
+		table.set("ACCOUNT" + std::to_string(i), MakeSession(i, "KEY"));
+	}
+
+	// Sessions which have not been written yet may never be evicted, regardless of the limits
+	CHECK(table.size() == 100);
+	for (uint64 i = 0; i < 100; ++i)
+	{
+		const auto session = table.get("account" + std::to_string(i));
+		REQUIRE(session);
+		CHECK(session->accountId == i);
+	}
+}
+
+TEST_CASE("SessionTableEvictsWrittenSessionsOverCapacity", "[session_table]")
+{
+	// One written session per shard
+	SessionTable table{ SessionTable::ShardCount, std::chrono::hours(1) };
+
+	const size_t count = SessionTable::ShardCount * 8;
+	for (size_t i = 0; i < count; ++i)
+	{
+		table.set("ACCOUNT" + std::to_string(i), MakeSession(i, "KEY"));
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		table.sessionWritten("ACCOUNT" + std::to_string(i), "KEY");
+	}
+
+	CHECK(table.size() <= SessionTable::ShardCount);
+
+	// The session which has been written last is never the one which is evicted
+	CHECK(table.get("ACCOUNT" + std::to_string(count - 1)));
+}
+
+TEST_CASE("SessionTableExpiresWrittenSessions", "[session_table]")
+{
+	SessionTable table{ 1000, std::chrono::milliseconds(0) };
+
+	table.set("ACCOUNT", MakeSession(1, "KEY"));
+	table.sessionWritten("ACCOUNT", "KEY");
+	CHECK_FALSE(table.get("ACCOUNT"));
+
+	// The expired session is evicted by the next modification of its shard
+	table.set("ACCOUNT", MakeSession(1, "NEW"));
+	CHECK(table.size() == 1);
+	table.sessionWritten("ACCOUNT", "NEW");
+	table.set("ACCOUNT", MakeSession(1, "NEWER"));
+	CHECK(table.size() == 1);
+}
+
+TEST_CASE("SessionTableKeepsNewerSessionWhenOldKeyIsWritten", "[session_table]")
+{
+	SessionTable table{ 0, std::chrono::milliseconds(0) };
+
+	table.set("ACCOUNT", MakeSession(1, "OLD"));
+	table.set("ACCOUNT", MakeSession(1, "NEW"));
+
+	// The write of the old session key completes after the account logged in again
+	table.sessionWritten("ACCOUNT", "OLD");
+
+	const auto session = table.get("ACCOUNT");
+	REQUIRE(session);
+	CHECK(session->sessionKey == "NEW");
+
+	table.sessionWritten("ACCOUNT", "NEW");
+	CHECK_FALSE(table.get("ACCOUNT"));
+	CHECK(table.size() == 0);
+}
@@ -0,0 +1,95 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "base/sharded_map.h"
+
+#include <set>
+
+using namespace mmo;
+
+
+// This test ensures that values can be stored, replaced, looked up and removed across all shards.
+TEST_CASE("ShardedMapStoresValues", "[sharded_map]")
+{
+	ShardedMap<uint64, String> map;
+	for (uint64 i = 0; i < 1000; ++i)
+	{
+		map.set(i, std::to_string(i));
+	}
+	CHECK(map.size() == 1000);
+
+	map.set(7, "seven");
+	CHECK(map.size() == 1000);
+	REQUIRE(map.get(7));
+	CHECK(*map.get(7) == "seven");
+	CHECK(*map.get(999) == "999");
+	CHECK_FALSE(map.get(1000));
+
+	CHECK(map.erase(7));
+	CHECK_FALSE(map.erase(7));
+	CHECK_FALSE(map.get(7));
+
+	size_t visited = 0;
+	map.forEach([&visited](uint64 key, const String &value)
+	{
+		CHECK(std::to_string(key) == value);
+		visited++;
+	});
+	CHECK(visited == 999);
+}
+
+// This test ensures that removing an outdated entry doesn't remove a newer value of the same key, like a
+// disconnecting player whose account logged in again with another connection.
+TEST_CASE("ShardedMapErasesOnlyExpectedValue", "[sharded_map]")
+{
+	int first = 0, second = 0;
+
+	ShardedMap<String, int*> map;
+	map.set("ACCOUNT", &first);
+	map.set("ACCOUNT", &second);
+
+	CHECK_FALSE(map.erase("ACCOUNT", &first));
+	CHECK(map.get("ACCOUNT").value_or(nullptr) == &second);
+
+	CHECK(map.erase("ACCOUNT", &second));
+	CHECK(map.size() == 0);
+}
+
+// This test ensures that the shard is not picked from the low hash bits, which the inner maps use for their buckets:
+// Keys which share their low bits are spread across all shards, and the keys of one shard don't share their low bits.
+TEST_CASE("ShardedMapSpreadsLowHashBits", "[sharded_map]")
+{
+	typedef ShardedMap<uint64, int> Map;
+	constexpr size_t ShardCount = 16;
+
+	std::set<size_t> shardsOfAlignedKeys;
+	std::set<size_t> lowBitsInFirstShard;
+	for (uint64 i = 0; i < 4096; ++i)
+	{
+		shardsOfAlignedKeys.insert(Map::getShardIndex(std::hash<uint64>()(i * ShardCount)));
+		if (Map::getShardIndex(std::hash<uint64>()(i)) == 0)
+		{
+			lowBitsInFirstShard.insert(i % ShardCount);
+		}
+	}
+
+	CHECK(shardsOfAlignedKeys.size() == ShardCount);
+	CHECK(lowBitsInFirstShard.size() == ShardCount);
+}
+
+// This test ensures that a map with a single shard stores all keys in it.
+TEST_CASE("ShardedMapWithSingleShard", "[sharded_map]")
+{
+	typedef ShardedMap<uint64, int, std::hash<uint64>, 1> Map;
+
+	Map map;
+	for (uint64 i = 0; i < 64; ++i)
+	{
+		CHECK(Map::getShardIndex(std::hash<uint64>()(i)) == 0);
+		map.set(i, static_cast<int>(i));
+	}
+
+	CHECK(map.size() == 64);
+	CHECK(map.get(42) == 42);
+}
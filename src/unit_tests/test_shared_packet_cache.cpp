@@ -0,0 +1,44 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "auth_protocol/auth_shared_packet_cache.h"
+
+using namespace mmo;
+
+
+// This test ensures that the packet is only serialized again after it has been invalidated, and that all
+// requests in between share the same buffer.
+TEST_CASE("SharedPacketCacheRebuildsOnlyAfterInvalidation", "[auth_protocol]")
+{
+	size_t builds = 0;
+	uint16 value = 1;
+
+	auth::SharedPacketCache cache{ [&builds, &value](auth::OutgoingPacket &packet)
+	{
+		builds++;
+		packet.Start(1);
+		packet << io::write<uint16>(value);
+		packet.Finish();
+	} };
+
+	const SharedBuffer first = cache.Get();
+	REQUIRE(first);
+	CHECK(cache.Get() == first);
+	CHECK(builds == 1);
+
+	const uint64 version = cache.GetVersion();
+	value = 2;
+	cache.Invalidate();
+	CHECK(cache.GetVersion() == version + 1);
+
+	const SharedBuffer second = cache.Get();
+	CHECK(builds == 2);
+	CHECK(second != first);
+	CHECK(*second != *first);
+	CHECK(second->size() == first->size());
+
+	// Buffers which are still queued on connections stay valid and unchanged
+	CHECK(cache.Get() == second);
+	CHECK(builds == 2);
+}
@@ -0,0 +1,198 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "base/timer_wheel.h"
+
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace mmo;
+
+
+// This test ensures that timers expire exactly at their tick and in the order they have been added.
+TEST_CASE("TimerWheelExpiryOrder", "[timer]")
+{
+	TimerWheel wheel{ 1000 };
+
+	std::vector<int> expired;
+	wheel.add([&]() { expired.push_back(1); }, 1010);
+	wheel.add([&]() { expired.push_back(2); }, 1005);
+	wheel.add([&]() { expired.push_back(3); }, 1010);
+	CHECK(wheel.size() == 3);
+
+	CHECK(wheel.advance(1004) == 0);
+	CHECK(expired.empty());
+
+	CHECK(wheel.advance(1005) == 1);
+	CHECK(wheel.advance(1010) == 2);
+	CHECK(expired == std::vector<int>{ 2, 1, 3 });
+	CHECK(wheel.empty());
+
+	const TimerWheelStats stats = wheel.getStats();
+	CHECK(stats.scheduledTimers == 3);
+	CHECK(stats.expiredTimers == 3);
+	CHECK(stats.expiryBatches == 2);
+	CHECK(stats.largestBatch == 2);
+}
+
+// This test ensures that timers in coarser levels are cascaded down and do not expire early or late.
+TEST_CASE("TimerWheelCascading", "[timer]")
+{
+	const uint64 start = 123456;
+	const std::vector<uint64> delays = { 1, 255, 256, 300, 16383, 16384, 20000, 1048576, 3000000, 100000000 };
+
+	for (const uint64 delay : delays)
+	{
+		TimerWheel wheel{ start };
+
+		bool hasExpired = false;
+		wheel.add([&]() { hasExpired = true; }, start + delay);
+
+		wheel.advance(start + delay - 1);
+		CHECK(!hasExpired);
+
+		wheel.advance(start + delay);
+		CHECK(hasExpired);
+	}
+}
+
+// This test ensures that advancing to the next tick reported by the wheel never misses a timer.
+TEST_CASE("TimerWheelNextTick", "[timer]")
+{
+	TimerWheel wheel{ 0 };
+	CHECK(!wheel.getNextTick());
+
+	std::vector<uint64> expiredAt;
+	uint64 now = 0;
+	for (const uint64 expiry : { 70000u, 5u, 1000u, 300u, 20000u })
+	{
+		wheel.add([&, expiry]() { CHECK(now == expiry); expiredAt.push_back(expiry); }, expiry);
+	}
+
+	// Simulates an io timer which always sleeps until the next reported tick
+	size_t wakeUps = 0;
+	while (const auto nextTick = wheel.getNextTick())
+	{
+		REQUIRE(*nextTick >= now);
+		now = *nextTick;
+		wheel.advance(now);
+		++wakeUps;
+	}
+
+	CHECK(expiredAt == std::vector<uint64>{ 5, 300, 1000, 20000, 70000 });
+	CHECK(wakeUps < 20);
+}
+
+// This test ensures that cancelled timers do not expire and that stale handles are rejected.
+TEST_CASE("TimerWheelCancel", "[timer]")
+{
+	TimerWheel wheel{ 0 };
+
+	int expiredCount = 0;
+	const TimerHandle first = wheel.add([&]() { ++expiredCount; }, 10);
+	const TimerHandle second = wheel.add([&]() { ++expiredCount; }, 50000);
+	CHECK(wheel.isScheduled(first));
+
+	CHECK(wheel.cancel(first));
+	CHECK(!wheel.cancel(first));
+	CHECK(!wheel.isScheduled(first));
+	CHECK(wheel.cancel(second));
+	CHECK(wheel.empty());
+
+	// The freed entry is reused, but the old handle must not cancel the new timer
+	const TimerHandle third = wheel.add([&]() { ++expiredCount; }, 20);
+	CHECK(!wheel.cancel(first));
+	CHECK(wheel.isScheduled(third));
+
+	wheel.advance(100000);
+	CHECK(expiredCount == 1);
+	CHECK(!wheel.cancel(third));
+	CHECK(!wheel.cancel(TimerHandle()));
+	CHECK(wheel.getStats().cancelledTimers == 2);
+}
+
+// This test ensures that callbacks may cancel timers of the same batch and add timers which are already due.
+TEST_CASE("TimerWheelModifyFromCallback", "[timer]")
+{
+	TimerWheel wheel{ 0 };
+
+	bool secondExpired = false;
+	bool addedExpired = false;
+
+	TimerHandle second;
+	wheel.add([&]()
+	{
+		CHECK(wheel.cancel(second));
+		wheel.add([&]() { addedExpired = true; }, 0);
+	}, 10);
+	second = wheel.add([&]() { secondExpired = true; }, 10);
+
+	CHECK(wheel.advance(10) == 1);
+	CHECK(!secondExpired);
+	CHECK(!addedExpired);
+
+	// Timers added for ticks which have already been processed expire with the next tick
+	CHECK(wheel.getNextTick() == 11);
+	CHECK(wheel.advance(11) == 1);
+	CHECK(addedExpired);
+}
+
+// This test compares the wheel against a simple ordered reference with random operations.
+TEST_CASE("TimerWheelRandomized", "[timer]")
+{
+	std::mt19937 random{ 1234 };
+	std::uniform_int_distribution<uint64> delayDistribution{ 0, 3000000 };
+	std::uniform_int_distribution<uint64> stepDistribution{ 0, 50000 };
+
+	TimerWheel wheel{ 0 };
+	std::map<uint32, std::pair<TimerHandle, uint64>> pending;
+
+	uint64 now = 0;
+	uint32 nextId = 0;
+	size_t failures = 0;
+
+	for (size_t round = 0; round < 300; ++round)
+	{
+		for (size_t i = 0; i < 20; ++i)
+		{
+			const uint32 id = nextId++;
+			const uint64 expiry = now + delayDistribution(random);
+			const TimerHandle handle = wheel.add([&, id, expiry]()
+			{
+				// Must not expire early, expiring late is detected below
+				if (expiry > now)
+				{
+					++failures;
+				}
+				pending.erase(id);
+			}, expiry);
+			pending[id] = std::make_pair(handle, expiry);
+		}
+
+		// Cancel a few random timers
+		for (size_t i = 0; i < 5 && !pending.empty(); ++i)
+		{
+			auto it = pending.begin();
+			std::advance(it, random() % pending.size());
+			CHECK(wheel.cancel(it->second.first));
+			pending.erase(it);
+		}
+
+		now += stepDistribution(random);
+		wheel.advance(now);
+
+		for (const auto &timer : pending)
+		{
+			if (timer.second.second <= now)
+			{
+				++failures;
+			}
+		}
+
+		REQUIRE(wheel.size() == pending.size());
+	}
+
+	CHECK(failures == 0);
+}
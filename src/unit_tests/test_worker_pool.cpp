@@ -0,0 +1,92 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "base/worker_pool.h"
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace mmo;
+
+
+// This test ensures that all accepted tasks are executed, even if the pool is stopped right away.
+TEST_CASE("WorkerPoolExecutesAllTasks", "[worker_pool]")
+{
+	std::atomic<size_t> executed{ 0 };
+
+	WorkerPool pool{ 4, 1000 };
+	REQUIRE(pool.size() == 4);
+
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		REQUIRE(pool.tryPost([&executed]() { executed++; }));
+	}
+
+	pool.stop();
+	CHECK(executed == 1000);
+
+	const WorkerPoolStats stats = pool.getStats();
+	CHECK(stats.acceptedTasks == 1000);
+	CHECK(stats.completedTasks == 1000);
+	CHECK(stats.rejectedTasks == 0);
+
+	// A stopped pool rejects new tasks
+	CHECK(!pool.tryPost([&executed]() { executed++; }));
+	CHECK(pool.getStats().rejectedTasks == 1);
+}
+
+// This test ensures that tasks are rejected while the queue is full and accepted again once it drained.
+TEST_CASE("WorkerPoolAdmissionControl", "[worker_pool]")
+{
+	std::promise<void> started, release;
+	std::shared_future<void> released = release.get_future().share();
+	std::atomic<size_t> executed{ 0 };
+
+	WorkerPool pool{ 1, 2 };
+
+	// Block the only worker thread
+	REQUIRE(pool.tryPost([&started, released]() { started.set_value(); released.wait(); }));
+	started.get_future().wait();
+
+	REQUIRE(pool.tryPost([&executed]() { executed++; }));
+	REQUIRE(pool.tryPost([&executed]() { executed++; }));
+	CHECK(pool.getQueueSize() == 2);
+	CHECK(!pool.tryPost([&executed]() { executed++; }));
+
+	release.set_value();
+	pool.stop();
+
+	CHECK(executed == 2);
+
+	const WorkerPoolStats stats = pool.getStats();
+	CHECK(stats.acceptedTasks == 3);
+	CHECK(stats.rejectedTasks == 1);
+	CHECK(stats.peakQueueSize == 2);
+}
+
+// This test ensures that stopping a pool from several threads at once joins every worker thread only once.
+TEST_CASE("WorkerPoolConcurrentStop", "[worker_pool]")
+{
+	for (size_t run = 0; run < 20; ++run)
+	{
+		WorkerPool pool{ 4, 16 };
+		REQUIRE(pool.tryPost([]() {}));
+
+		std::vector<std::thread> stoppers;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			stoppers.emplace_back([&pool]() { pool.stop(); });
+		}
+
+		for (auto &thread : stoppers)
+		{
+			thread.join();
+		}
+
+		CHECK(pool.size() == 4);
+		CHECK(!pool.tryPost([]() {}));
+	}
+}
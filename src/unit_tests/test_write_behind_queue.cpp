@@ -0,0 +1,98 @@
+// Copyright (C) 2020, Robin Klimonow. All rights reserved.
+
+#include "catch.hpp"
+
+#include "write_behind_queue.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+using namespace mmo;
+
+
+namespace
+{
+	/// Records the written login updates and fails a configurable number of batch writes.
+	class RecordingDatabase final : public IDatabase
+	{
+	public:
+		std::optional<AccountData> getAccountDataByName(std::string name) override { return {}; }
+		std::optional<RealmAuthData> getRealmAuthData(std::string name) override { return {}; }
+		std::optional<std::pair<uint64, std::string>> getAccountSessionKey(std::string accountName) override { return {}; }
+		std::vector<std::optional<std::pair<uint64, std::string>>> getAccountSessionKeys(const std::vector<std::string> &accountNames) override { return {}; }
+
+		void playerLogins(const std::vector<PlayerLoginUpdate> &updates) override
+		{
+			if (failures > 0)
+			{
+				failures--;
+				throw std::runtime_error("Database unavailable");
+			}
+
+			std::lock_guard<std::mutex> lock{ mutex };
+			for (const auto &update : updates)
+			{
+				sessionKeys[update.accountId] = update.sessionKey;
+			}
+			writtenUpdates += updates.size();
+		}
+
+		void realmLogins(const std::vector<RealmLoginUpdate> &updates) override
+		{
+		}
+
+	public:
+		std::atomic<size_t> failures{ 0 };
+		std::mutex mutex;
+		std::map<uint64, std::string> sessionKeys;
+		size_t writtenUpdates = 0;
+	};
+}
+
+// This test ensures that all queued updates are written when the queue is stopped, with the newest session key
+// of an account winning over older ones.
+TEST_CASE("WriteBehindQueueWritesAllUpdatesOnStop", "[write_behind_queue]")
+{
+	RecordingDatabase database;
+
+	// The interval is long enough that all updates end up in the final batch
+	WriteBehindQueue queue{ database, std::chrono::hours(1) };
+	for (uint64 i = 0; i < 100; ++i)
+	{
+		queue.playerLogin(PlayerLoginUpdate{ i, "OLD", "127.0.0.1" });
+	}
+	for (uint64 i = 0; i < 100; i += 2)
+	{
+		queue.playerLogin(PlayerLoginUpdate{ i, "NEW", "127.0.0.1" });
+	}
+	CHECK(queue.getPendingCount() == 100);
+
+	REQUIRE(queue.stop());
+	CHECK(queue.getPendingCount() == 0);
+
+	REQUIRE(database.sessionKeys.size() == 100);
+	CHECK(database.writtenUpdates == 100);
+	CHECK(database.sessionKeys[0] == "NEW");
+	CHECK(database.sessionKeys[1] == "OLD");
+
+	const WriteBehindStats stats = queue.getStats();
+	CHECK(stats.queuedUpdates == 150);
+	CHECK(stats.coalescedUpdates == 50);
+	CHECK(stats.writtenUpdates == 100);
+	CHECK(stats.batches == 1);
+}
+
+// This test ensures that updates of a failed batch are kept and written by a later batch.
+TEST_CASE("WriteBehindQueueRetriesFailedBatches", "[write_behind_queue]")
+{
+	RecordingDatabase database;
+	database.failures = 2;
+
+	WriteBehindQueue queue{ database, std::chrono::milliseconds(1) };
+	queue.playerLogin(PlayerLoginUpdate{ 1, "KEY", "127.0.0.1" });
+
+	REQUIRE(queue.stop());
+	CHECK(database.sessionKeys[1] == "KEY");
+	CHECK(queue.getStats().failedBatches == 2);
+}
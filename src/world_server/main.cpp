@@ -4,11 +4,11 @@
 #include "base/service.h"
 #include "log/default_log_levels.h"
 #include "log/log_std_stream.h"
+#include "log/async_log_sink.h"
 
 #include "program.h"
 
 #include <iostream>
-#include <mutex>
 #include <cstring>
 
 /// Procedural entry point of the application.
@@ -45,12 +45,15 @@ int main(int argc, const char* argv[])
 	auto options = mmo::g_DefaultConsoleLogOptions;
 	options.alwaysFlush = false;
 
-	// Add cout to the list of log output streams
-	std::mutex coutLogMutex;
-	mmo::g_DefaultLog.signal().connect([&coutLogMutex, &options](const mmo::LogEntry & entry) {
-		std::scoped_lock lock{ coutLogMutex };
-		mmo::printLogEntry(std::cout, entry, options);
-	});
+	// Add cout to the list of log output streams. Entries are printed by a background thread, so that
+	// logging threads neither wait for the console nor for each other.
+	mmo::AsyncLogSink coutLogSink{
+		[&options](const mmo::LogEntry & entry) { mmo::printLogEntry(std::cout, entry, options); },
+		[]() { std::cout.flush(); }
+	};
+	mmo::scoped_connection coutLogConnection{ mmo::g_DefaultLog.signal().connect([&coutLogSink](const mmo::LogEntry & entry) {
+		coutLogSink.push(entry);
+	}) };
 
 	// Notify about the start of the login server application
 	if (runAsService)